@@ -96,6 +96,8 @@ struct _capture_session {
 #endif
     gboolean  session_will_restart;       /**< Set when session will restart */
     guint32   count;                      /**< Total number of frames captured */
+    guint64   queue_max_packets;          /**< Most packets dumpcap has had queued for writing, with -t */
+    guint64   queue_max_bytes;            /**< Most bytes dumpcap has had queued for writing, with -t */
     capture_options *capture_opts;        /**< options for this capture */
     capture_file *cf;                     /**< handle to cfile */
     wtap_rec rec;                         /**< record we're reading packet metadata into */
@@ -131,6 +131,8 @@ capture_session_init(capture_session *cap_session, capture_file *cf,
     cap_session->group                           = getgid();
 #endif
     cap_session->count                           = 0;
+    cap_session->queue_max_packets               = 0;
+    cap_session->queue_max_bytes                 = 0;
     cap_session->session_will_restart            = FALSE;
 
     cap_session->new_file                        = new_file;
@@ -1742,6 +1744,24 @@ sync_pipe_input_cb(gint source, gpointer user_data)
         cap_session->drops(cap_session, num, name);
         break;
         }
+    case SP_QUEUE_STATS: {
+        guint64 packets = 0, bytes = 0, max_packets = 0, max_bytes = 0;
+        const gchar* end = buffer;
+
+        if (ws_strtou64(end, &end, &packets) && end[0] == ':' &&
+            ws_strtou64(end + 1, &end, &bytes) && end[0] == ':' &&
+            ws_strtou64(end + 1, &end, &max_packets) && end[0] == ':' &&
+            ws_strtou64(end + 1, &end, &max_bytes)) {
+            cap_session->queue_max_packets = max_packets;
+            cap_session->queue_max_bytes = max_bytes;
+        } else {
+            g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_WARNING, "Invalid queue statistics: %s", buffer);
+        }
+        g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_DEBUG,
+              "sync_pipe_input_cb: queue %" G_GINT64_MODIFIER "u packets/%" G_GINT64_MODIFIER "u bytes, at most %" G_GINT64_MODIFIER "u/%" G_GINT64_MODIFIER "u",
+              packets, bytes, max_packets, max_bytes);
+        break;
+        }
     default:
         g_assert_not_reached();
     }
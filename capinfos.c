@@ -80,8 +80,11 @@
 #include "wsutil/wsgetopt.h"
 #endif
 
+#include "ui/clopts_common.h"
 #include "ui/failure_message.h"
 
+#include "ws_attributes.h"
+
 #define INVALID_OPTION 1
 #define BAD_FLAG 1
 
@@ -97,6 +100,16 @@
 
 static gboolean stop_after_failure = FALSE;
 
+/*
+ * With --threads, files are scanned by that many threads at once, and
+ * up to SCAN_AHEAD files per thread are scanned ahead of the file whose
+ * information is being printed, as the information is printed in the
+ * order in which the files were given.
+ */
+#define SCAN_AHEAD 4
+
+static int scan_threads = 1;
+
 /*
  * table report variables
  */
@@ -154,13 +167,10 @@ static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 #define HASH_BUF_SIZE (1024 * 1024)
 
 
-static gchar file_sha256[HASH_STR_SIZE];
-static gchar file_rmd160[HASH_STR_SIZE];
-static gchar file_sha1[HASH_STR_SIZE];
-
-static guint num_ipv4_addresses;
-static guint num_ipv6_addresses;
-static guint num_decryption_secrets;
+/* Counted by the callbacks for the file being scanned by the thread */
+static WS_THREAD_LOCAL guint num_ipv4_addresses;
+static WS_THREAD_LOCAL guint num_ipv6_addresses;
+static WS_THREAD_LOCAL guint num_decryption_secrets;
 
 /*
  * If we have at least two packets with time stamps, and they're not in
@@ -214,6 +224,19 @@ typedef struct _capture_info {
   GArray               *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
   guint32               pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
   GArray               *idb_info_strings;         /* array of IDB info strings */
+
+  guint                 num_ipv4_addresses;
+  guint                 num_ipv6_addresses;
+  guint                 num_decryption_secrets;
+
+  gchar                 file_sha256[HASH_STR_SIZE];
+  gchar                 file_rmd160[HASH_STR_SIZE];
+  gchar                 file_sha1[HASH_STR_SIZE];
+
+  /* Errors from scan_cap_file(), reported by report_cap_file() */
+  int                   err;                      /* opening (if wth is NULL) or reading the file */
+  gchar                *err_info;
+  int                   size_err;                 /* getting the file size */
 } capture_info;
 
 static char *decimal_point;
@@ -738,9 +761,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
     }
   }
   if (cap_file_hashes) {
-    printf     ("SHA256:              %s\n", file_sha256);
-    printf     ("RIPEMD160:           %s\n", file_rmd160);
-    printf     ("SHA1:                %s\n", file_sha1);
+    printf     ("SHA256:              %s\n", cf_info->file_sha256);
+    printf     ("RIPEMD160:           %s\n", cf_info->file_rmd160);
+    printf     ("SHA1:                %s\n", cf_info->file_sha1);
   }
   if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -793,14 +816,14 @@ print_stats(const gchar *filename, capture_info *cf_info)
     }
 
     if (cap_file_nrb) {
-      if (num_ipv4_addresses != 0)
-        printf   ("Number of resolved IPv4 addresses in file: %u\n", num_ipv4_addresses);
-      if (num_ipv6_addresses != 0)
-        printf   ("Number of resolved IPv6 addresses in file: %u\n", num_ipv6_addresses);
+      if (cf_info->num_ipv4_addresses != 0)
+        printf   ("Number of resolved IPv4 addresses in file: %u\n", cf_info->num_ipv4_addresses);
+      if (cf_info->num_ipv6_addresses != 0)
+        printf   ("Number of resolved IPv6 addresses in file: %u\n", cf_info->num_ipv6_addresses);
     }
     if (cap_file_dsb) {
-      if (num_decryption_secrets != 0)
-        printf   ("Number of decryption secrets in file: %u\n", num_decryption_secrets);
+      if (cf_info->num_decryption_secrets != 0)
+        printf   ("Number of decryption secrets in file: %u\n", cf_info->num_decryption_secrets);
     }
   }
 }
@@ -1020,17 +1043,17 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
   if (cap_file_hashes) {
     putsep();
     putquote();
-    printf("%s", file_sha256);
+    printf("%s", cf_info->file_sha256);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_rmd160);
+    printf("%s", cf_info->file_rmd160);
     putquote();
 
     putsep();
     putquote();
-    printf("%s", file_sha1);
+    printf("%s", cf_info->file_sha1);
     putquote();
   }
 
@@ -1158,10 +1181,63 @@ count_decryption_secret(guint32 secrets_type _U_, const void *secrets _U_, guint
   num_decryption_secrets++;
 }
 
-static int
-process_cap_file(const char *filename, gboolean need_separator)
+static void
+hash_to_str(const unsigned char *hash, size_t length, char *str) {
+  int i;
+
+  for (i = 0; i < (int) length; i++) {
+    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
+  }
+}
+
+static void
+hash_cap_file(capture_info *cf_info)
+{
+  FILE         *fh;
+  char         *hash_buf;
+  gcry_md_hd_t  hd = NULL;
+  size_t        hash_bytes;
+
+  g_strlcpy(cf_info->file_sha256, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(cf_info->file_rmd160, "<unknown>", HASH_STR_SIZE);
+  g_strlcpy(cf_info->file_sha1, "<unknown>", HASH_STR_SIZE);
+
+  if (!cap_file_hashes)
+    return;
+
+  gcry_md_open(&hd, GCRY_MD_SHA256, 0);
+  if (hd) {
+    gcry_md_enable(hd, GCRY_MD_RMD160);
+    gcry_md_enable(hd, GCRY_MD_SHA1);
+  }
+  fh = ws_fopen(cf_info->filename, "rb");
+  if (fh && hd) {
+    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
+    while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
+      gcry_md_write(hd, hash_buf, hash_bytes);
+    }
+    g_free(hash_buf);
+    gcry_md_final(hd);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, cf_info->file_sha256);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, cf_info->file_rmd160);
+    hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
+  }
+  if (fh) fclose(fh);
+  gcry_md_close(hd);
+}
+
+/*
+ * Gather the information about the file named by cf_info->filename.
+ * Nothing is printed here, so that files can be scanned in parallel;
+ * errors are left in cf_info for report_cap_file().
+ *
+ * Only the metadata of the records is looked at, so wiretap is asked
+ * to skip over their data where the file type allows it.
+ */
+static void
+scan_cap_file(capture_info *cf_info)
 {
-  int                   status = 0;
+  const char           *filename = cf_info->filename;
   int                   err;
   gchar                *err_info;
   gint64                size;
@@ -1173,7 +1249,6 @@ process_cap_file(const char *filename, gboolean need_separator)
   guint32               snaplen_max_inferred =          0;
   wtap_rec              rec;
   Buffer                buf;
-  capture_info          cf_info;
   gboolean              have_times = TRUE;
   nstime_t              start_time;
   int                   start_time_tsprec;
@@ -1186,15 +1261,20 @@ process_cap_file(const char *filename, gboolean need_separator)
   guint                 i;
   wtapng_iface_descriptions_t *idb_info;
 
-  cf_info.wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
-  if (!cf_info.wth) {
-    cfile_open_failure_message("capinfos", filename, err, err_info);
-    return 2;
-  }
+  hash_cap_file(cf_info);
 
-  if (need_separator && long_report) {
-    printf("\n");
+  cf_info->wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+  if (!cf_info->wth) {
+    cf_info->err = err;
+    cf_info->err_info = err_info;
+    return;
   }
+  /*
+   * Nothing we report depends on the data of a record, or on the options
+   * of a pcapng packet block, so they needn't be read; a file that's been
+   * cut short in them is still noticed.
+   */
+  wtap_set_metadata_only(cf_info->wth, TRUE);
 
   nstime_set_zero(&start_time);
   start_time_tsprec = WTAP_TSPREC_UNKNOWN;
@@ -1203,25 +1283,25 @@ process_cap_file(const char *filename, gboolean need_separator)
   nstime_set_zero(&cur_time);
   nstime_set_zero(&prev_time);
 
-  cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+  cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
 
-  idb_info = wtap_file_get_idb_info(cf_info.wth);
+  idb_info = wtap_file_get_idb_info(cf_info->wth);
 
   g_assert(idb_info->interface_data != NULL);
 
-  cf_info.num_interfaces = idb_info->interface_data->len;
-  cf_info.interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info.num_interfaces);
-  g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-  cf_info.pkt_interface_id_unknown = 0;
+  cf_info->num_interfaces = idb_info->interface_data->len;
+  cf_info->interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info->num_interfaces);
+  g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+  cf_info->pkt_interface_id_unknown = 0;
 
   g_free(idb_info);
   idb_info = NULL;
 
   /* Register callbacks for new name<->address maps from the file and
      decryption secrets from the file. */
-  wtap_set_cb_new_ipv4(cf_info.wth, count_ipv4_address);
-  wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
-  wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
+  wtap_set_cb_new_ipv4(cf_info->wth, count_ipv4_address);
+  wtap_set_cb_new_ipv6(cf_info->wth, count_ipv6_address);
+  wtap_set_cb_new_secrets(cf_info->wth, count_decryption_secret);
 
   /* Zero out the counters for the callbacks. */
   num_ipv4_addresses = 0;
@@ -1231,7 +1311,7 @@ process_cap_file(const char *filename, gboolean need_separator)
   /* Tally up data that we need to parse through the file to find */
   wtap_rec_init(&rec);
   ws_buffer_init(&buf, 1514);
-  while (wtap_read(cf_info.wth, &rec, &buf, &err, &err_info, &data_offset))  {
+  while (wtap_read(cf_info->wth, &rec, &buf, &err, &err_info, &data_offset))  {
     if (rec.presence_flags & WTAP_HAS_TS) {
       prev_time = cur_time;
       cur_time = rec.ts;
@@ -1276,7 +1356,7 @@ process_cap_file(const char *filename, gboolean need_separator)
 
       if ((rec.rec_header.packet_header.pkt_encap > 0) &&
           (rec.rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-        cf_info.encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
+        cf_info->encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
       } else {
         fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
                 rec.rec_header.packet_header.pkt_encap, packet, filename);
@@ -1284,37 +1364,37 @@ process_cap_file(const char *filename, gboolean need_separator)
 
       /* Packet interface_id info */
       if (rec.presence_flags & WTAP_HAS_INTERFACE_ID) {
-        /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-        if (rec.rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
+        /* cf_info->num_interfaces is size, not index, so it's one more than max index */
+        if (rec.rec_header.packet_header.interface_id >= cf_info->num_interfaces) {
           /*
            * OK, re-fetch the number of interfaces, as there might have
            * been an interface that was in the middle of packets, and
            * grow the array to be big enough for the new number of
            * interfaces.
            */
-          idb_info = wtap_file_get_idb_info(cf_info.wth);
+          idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-          cf_info.num_interfaces = idb_info->interface_data->len;
-          g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
+          cf_info->num_interfaces = idb_info->interface_data->len;
+          g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
 
           g_free(idb_info);
           idb_info = NULL;
         }
-        if (rec.rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-          g_array_index(cf_info.interface_packet_counts, guint32,
+        if (rec.rec_header.packet_header.interface_id < cf_info->num_interfaces) {
+          g_array_index(cf_info->interface_packet_counts, guint32,
                         rec.rec_header.packet_header.interface_id) += 1;
         }
         else {
-          cf_info.pkt_interface_id_unknown += 1;
+          cf_info->pkt_interface_id_unknown += 1;
         }
       }
       else {
         /* it's for interface_id 0 */
-        if (cf_info.num_interfaces != 0) {
-          g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+        if (cf_info->num_interfaces != 0) {
+          g_array_index(cf_info->interface_packet_counts, guint32, 0) += 1;
         }
         else {
-          cf_info.pkt_interface_id_unknown += 1;
+          cf_info->pkt_interface_id_unknown += 1;
         }
       }
     }
@@ -1323,6 +1403,10 @@ process_cap_file(const char *filename, gboolean need_separator)
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
+  cf_info->num_ipv4_addresses = num_ipv4_addresses;
+  cf_info->num_ipv6_addresses = num_ipv6_addresses;
+  cf_info->num_decryption_secrets = num_decryption_secrets;
+
   /*
    * Get IDB info strings.
    * We do this at the end, so we can get information for all IDBs in
@@ -1330,114 +1414,177 @@ process_cap_file(const char *filename, gboolean need_separator)
    * we get, for example, a count of the number of statistics entries
    * for each interface as of the *end* of the file.
    */
-  idb_info = wtap_file_get_idb_info(cf_info.wth);
+  idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-  cf_info.idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info.num_interfaces);
-  cf_info.num_interfaces = idb_info->interface_data->len;
-  for (i = 0; i < cf_info.num_interfaces; i++) {
+  cf_info->idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info->num_interfaces);
+  cf_info->num_interfaces = idb_info->interface_data->len;
+  for (i = 0; i < cf_info->num_interfaces; i++) {
     const wtap_block_t if_descr = g_array_index(idb_info->interface_data, wtap_block_t, i);
     gchar *s = wtap_get_debug_if_descr(if_descr, 21, "\n");
-    g_array_append_val(cf_info.idb_info_strings, s);
+    g_array_append_val(cf_info->idb_info_strings, s);
   }
 
   g_free(idb_info);
   idb_info = NULL;
 
+  /* # of packets, also needed to report a read error */
+  cf_info->packet_count = packet;
+
   if (err != 0) {
-    fprintf(stderr,
-        "capinfos: An error occurred after reading %u packets from \"%s\".\n",
-        packet, filename);
-    cfile_read_failure_message("capinfos", filename, err, err_info);
-    if (err == WTAP_ERR_SHORT_READ) {
-        /* Don't give up completely with this one. */
-        status = 1;
-        fprintf(stderr,
-          "  (will continue anyway, checksums might be incorrect)\n");
-    } else {
-        cleanup_capture_info(&cf_info);
-        wtap_close(cf_info.wth);
-        return 2;
-    }
+    cf_info->err = err;
+    cf_info->err_info = err_info;
+    if (err != WTAP_ERR_SHORT_READ)
+      return;
   }
 
   /* File size */
-  size = wtap_file_size(cf_info.wth, &err);
+  size = wtap_file_size(cf_info->wth, &err);
   if (size == -1) {
-    fprintf(stderr,
-        "capinfos: Can't get size of \"%s\": %s.\n",
-        filename, g_strerror(err));
-    cleanup_capture_info(&cf_info);
-    wtap_close(cf_info.wth);
-    return 2;
+    cf_info->size_err = err;
+    return;
   }
 
-  cf_info.filesize = size;
+  cf_info->filesize = size;
 
   /* File Type */
-  cf_info.file_type = wtap_file_type_subtype(cf_info.wth);
-  cf_info.compression_type = wtap_get_compression_type(cf_info.wth);
+  cf_info->file_type = wtap_file_type_subtype(cf_info->wth);
+  cf_info->compression_type = wtap_get_compression_type(cf_info->wth);
 
   /* File Encapsulation */
-  cf_info.file_encap = wtap_file_encap(cf_info.wth);
+  cf_info->file_encap = wtap_file_encap(cf_info->wth);
 
-  cf_info.file_tsprec = wtap_file_tsprec(cf_info.wth);
+  cf_info->file_tsprec = wtap_file_tsprec(cf_info->wth);
 
   /* Packet size limit (snaplen) */
-  cf_info.snaplen = wtap_snapshot_length(cf_info.wth);
-  if (cf_info.snaplen > 0)
-    cf_info.snap_set = TRUE;
+  cf_info->snaplen = wtap_snapshot_length(cf_info->wth);
+  if (cf_info->snaplen > 0)
+    cf_info->snap_set = TRUE;
   else
-    cf_info.snap_set = FALSE;
+    cf_info->snap_set = FALSE;
 
-  cf_info.snaplen_min_inferred = snaplen_min_inferred;
-  cf_info.snaplen_max_inferred = snaplen_max_inferred;
-
-  /* # of packets */
-  cf_info.packet_count = packet;
+  cf_info->snaplen_min_inferred = snaplen_min_inferred;
+  cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
   /* File Times */
-  cf_info.times_known = have_times;
-  cf_info.start_time = start_time;
-  cf_info.start_time_tsprec = start_time_tsprec;
-  cf_info.stop_time = stop_time;
-  cf_info.stop_time_tsprec = stop_time_tsprec;
-  nstime_delta(&cf_info.duration, &stop_time, &start_time);
+  cf_info->times_known = have_times;
+  cf_info->start_time = start_time;
+  cf_info->start_time_tsprec = start_time_tsprec;
+  cf_info->stop_time = stop_time;
+  cf_info->stop_time_tsprec = stop_time_tsprec;
+  nstime_delta(&cf_info->duration, &stop_time, &start_time);
   /* Duration precision is the higher of the start and stop time precisions. */
-  if (cf_info.stop_time_tsprec > cf_info.start_time_tsprec)
-    cf_info.duration_tsprec = cf_info.stop_time_tsprec;
+  if (cf_info->stop_time_tsprec > cf_info->start_time_tsprec)
+    cf_info->duration_tsprec = cf_info->stop_time_tsprec;
   else
-    cf_info.duration_tsprec = cf_info.start_time_tsprec;
-  cf_info.know_order = know_order;
-  cf_info.order = order;
+    cf_info->duration_tsprec = cf_info->start_time_tsprec;
+  cf_info->know_order = know_order;
+  cf_info->order = order;
 
   /* Number of packet bytes */
-  cf_info.packet_bytes = bytes;
+  cf_info->packet_bytes = bytes;
 
-  cf_info.data_rate   = 0.0;
-  cf_info.packet_rate = 0.0;
-  cf_info.packet_size = 0.0;
+  cf_info->data_rate   = 0.0;
+  cf_info->packet_rate = 0.0;
+  cf_info->packet_size = 0.0;
 
   if (packet > 0) {
     double delta_time = nstime_to_sec(&stop_time) - nstime_to_sec(&start_time);
     if (delta_time > 0.0) {
-      cf_info.data_rate   = (double)bytes  / delta_time; /* Data rate per second */
-      cf_info.packet_rate = (double)packet / delta_time; /* packet rate per second */
+      cf_info->data_rate   = (double)bytes  / delta_time; /* Data rate per second */
+      cf_info->packet_rate = (double)packet / delta_time; /* packet rate per second */
+    }
+    cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
+  }
+}
+
+/* Free what scan_cap_file() allocated, and close the file. */
+static void
+discard_capture_info(capture_info *cf_info)
+{
+  if (cf_info->wth != NULL) {
+    cleanup_capture_info(cf_info);
+    wtap_close(cf_info->wth);
+    cf_info->wth = NULL;
+  }
+}
+
+/*
+ * Report the information gathered by scan_cap_file(), or the error that
+ * stopped it; return 0 on success, 1 if the file was cut short but the
+ * information was printed anyway, and 2 on failure.
+ */
+static int
+report_cap_file(capture_info *cf_info, gboolean need_separator)
+{
+  const char *filename = cf_info->filename;
+  int         status = 0;
+
+  if (!cf_info->wth) {
+    cfile_open_failure_message("capinfos", filename, cf_info->err, cf_info->err_info);
+    return 2;
+  }
+
+  if (need_separator && long_report) {
+    printf("\n");
+  }
+
+  if (cf_info->err != 0) {
+    fprintf(stderr,
+        "capinfos: An error occurred after reading %u packets from \"%s\".\n",
+        cf_info->packet_count, filename);
+    cfile_read_failure_message("capinfos", filename, cf_info->err, cf_info->err_info);
+    if (cf_info->err == WTAP_ERR_SHORT_READ) {
+        /* Don't give up completely with this one. */
+        status = 1;
+        fprintf(stderr,
+          "  (will continue anyway, checksums might be incorrect)\n");
+    } else {
+        discard_capture_info(cf_info);
+        return 2;
     }
-    cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+  }
+
+  if (cf_info->size_err != 0) {
+    fprintf(stderr,
+        "capinfos: Can't get size of \"%s\": %s.\n",
+        filename, g_strerror(cf_info->size_err));
+    discard_capture_info(cf_info);
+    return 2;
   }
 
   if (long_report) {
-    print_stats(filename, &cf_info);
+    print_stats(filename, cf_info);
   } else {
-    print_stats_table(filename, &cf_info);
+    print_stats_table(filename, cf_info);
   }
 
-  cleanup_capture_info(&cf_info);
-  wtap_close(cf_info.wth);
+  discard_capture_info(cf_info);
 
   return status;
 }
 
+/* A file being scanned by the thread pool */
+typedef struct {
+  capture_info cf_info;
+  gboolean     done;
+} scan_job_t;
+
+static GMutex scan_mutex;
+static GCond  scan_cond;
+
+static void
+scan_job_func(gpointer data, gpointer user_data _U_)
+{
+  scan_job_t *job = (scan_job_t *)data;
+
+  scan_cap_file(&job->cf_info);
+
+  g_mutex_lock(&scan_mutex);
+  job->done = TRUE;
+  g_cond_broadcast(&scan_cond);
+  g_mutex_unlock(&scan_mutex);
+}
+
 static void
 print_usage(FILE *output)
 {
@@ -1497,6 +1644,9 @@ print_usage(FILE *output)
   fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
   fprintf(output, "  -A generate all infos (default)\n");
   fprintf(output, "  -K disable displaying the capture comment\n");
+  fprintf(output, "  --threads <n>\n");
+  fprintf(output, "     scan up to <n> files at once; the infos are still displayed\n");
+  fprintf(output, "     in the order in which the files are given\n");
   fprintf(output, "\n");
   fprintf(output, "Options are processed from left to right order with later options superseding\n");
   fprintf(output, "or adding to earlier options.\n");
@@ -1527,15 +1677,6 @@ failure_message_cont(const char *msg_format, va_list ap)
   fprintf(stderr, "\n");
 }
 
-static void
-hash_to_str(const unsigned char *hash, size_t length, char *str) {
-  int i;
-
-  for (i = 0; i < (int) length; i++) {
-    g_snprintf(str+(i*2), 3, "%02x", hash[i]);
-  }
-}
-
 int
 main(int argc, char *argv[])
 {
@@ -1543,17 +1684,19 @@ main(int argc, char *argv[])
   gboolean need_separator = FALSE;
   int    opt;
   int    overall_error_status = EXIT_SUCCESS;
+#define LONGOPT_THREADS LONGOPT_BASE_APPLICATION+1
   static const struct option long_options[] = {
       {"help", no_argument, NULL, 'h'},
       {"version", no_argument, NULL, 'v'},
+      {"threads", required_argument, NULL, LONGOPT_THREADS},
       {0, 0, 0, 0 }
   };
 
   int status = 0;
-  FILE  *fh;
-  char  *hash_buf = NULL;
-  gcry_md_hd_t hd = NULL;
-  size_t hash_bytes;
+  capture_info single_cf_info;
+  scan_job_t *jobs = NULL;
+  GThreadPool *pool = NULL;
+  int next_job = 0;
 
   /*
    * Set the C-language locale to the native environment and set the
@@ -1716,6 +1859,10 @@ main(int argc, char *argv[])
         stop_after_failure = TRUE;
         break;
 
+      case LONGOPT_THREADS:
+        scan_threads = get_positive_int(optarg, "number of threads");
+        break;
+
       case 'A':
         enable_all_infos();
         break;
@@ -1795,38 +1942,40 @@ main(int argc, char *argv[])
 
   if (cap_file_hashes) {
     gcry_check_version(NULL);
-    gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-    if (hd) {
-      gcry_md_enable(hd, GCRY_MD_RMD160);
-      gcry_md_enable(hd, GCRY_MD_SHA1);
-    }
-    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
   }
 
   overall_error_status = 0;
 
+  if (scan_threads > 1 && argc - optind > 1) {
+    jobs = g_new0(scan_job_t, argc - optind);
+    pool = g_thread_pool_new(scan_job_func, NULL, scan_threads, TRUE, NULL);
+    next_job = optind;
+  }
+
   for (opt = optind; opt < argc; opt++) {
+    capture_info *cf_info;
 
-    g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_rmd160, "<unknown>", HASH_STR_SIZE);
-    g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+    if (pool != NULL) {
+      scan_job_t *job = &jobs[opt - optind];
 
-    if (cap_file_hashes) {
-      fh = ws_fopen(argv[opt], "rb");
-      if (fh && hd) {
-        while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-          gcry_md_write(hd, hash_buf, hash_bytes);
-        }
-        gcry_md_final(hd);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_RMD160), HASH_SIZE_RMD160, file_rmd160);
-        hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
+      while (next_job < argc && next_job - opt < scan_threads * SCAN_AHEAD) {
+        jobs[next_job - optind].cf_info.filename = argv[next_job];
+        g_thread_pool_push(pool, &jobs[next_job - optind], NULL);
+        next_job++;
       }
-      if (fh) fclose(fh);
-      if (hd) gcry_md_reset(hd);
+      g_mutex_lock(&scan_mutex);
+      while (!job->done)
+        g_cond_wait(&scan_cond, &scan_mutex);
+      g_mutex_unlock(&scan_mutex);
+      cf_info = &job->cf_info;
+    } else {
+      memset(&single_cf_info, 0, sizeof single_cf_info);
+      single_cf_info.filename = argv[opt];
+      scan_cap_file(&single_cf_info);
+      cf_info = &single_cf_info;
     }
 
-    status = process_cap_file(argv[opt], need_separator);
+    status = report_cap_file(cf_info, need_separator);
     if (status) {
       /* Something failed.  It's been reported; remember that processing
          one file failed and, if -C was specified, stop. */
@@ -1844,8 +1993,16 @@ main(int argc, char *argv[])
   }
 
 exit:
-  g_free(hash_buf);
-  gcry_md_close(hd);
+  if (pool != NULL) {
+    /* Drop the files not yet being scanned, wait for the others, and
+       close any that haven't been reported because of -C. */
+    g_thread_pool_free(pool, TRUE, TRUE);
+    for (opt = optind; opt < next_job; opt++) {
+      if (jobs[opt - optind].done)
+        discard_capture_info(&jobs[opt - optind].cf_info);
+    }
+    g_free(jobs);
+  }
   wtap_cleanup();
   free_progdirs();
   return overall_error_status;
@@ -28,6 +28,7 @@
 #include <ui/cmdarg_err.h>
 #include <wsutil/file_util.h>
 #include <wsutil/ws_pipe.h>
+#include <wiretap/wtap.h>
 
 #include "caputils/capture_ifinfo.h"
 #include "caputils/capture-pcap-util.h"
@@ -984,12 +985,15 @@ capture_opts_add_opt(capture_options *capture_opts, int opt, const char *optarg_
             cmdarg_err("--compress-type can be set only once");
             return 1;
         }
-        if (strcmp(optarg_str_p, "none") == 0) {
-            ;
-        } else if (strcmp(optarg_str_p, "gzip") == 0) {
-            ;
-        } else {
-            cmdarg_err("parameter of --compress-type can be 'none' or 'gzip'");
+        if (wtap_name_to_compression_type(optarg_str_p) == WTAP_UNKNOWN_COMPRESSION) {
+            GSList *names = wtap_get_all_compression_type_names_list();
+            GString *valid = g_string_new("'none'");
+
+            for (GSList *name = names; name != NULL; name = g_slist_next(name))
+                g_string_append_printf(valid, ", '%s'", (const char *)name->data);
+            g_slist_free(names);
+            cmdarg_err("parameter of --compress-type can be %s", valid->str);
+            g_string_free(valid, TRUE);
             return 1;
         }
         capture_opts->compress_type = g_strdup(optarg_str_p);
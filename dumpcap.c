@@ -48,6 +48,11 @@
 # include <sys/capability.h>
 #endif
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/if_packet.h>        /* PACKET_FANOUT */
+#endif
+
 #include "ringbuffer.h"
 
 #include "caputils/capture_ifinfo.h"
@@ -111,9 +116,25 @@ FILE *debug_log;   /* for logging debug messages to  */
                    /*  is defined                    */
 #endif
 
-static GAsyncQueue *pcap_queue;
-static gint64 pcap_queue_bytes;
+/*
+ * With -t, the capture threads copy packets into pcap_queue_fill and the
+ * main thread swaps it with pcap_queue_drain and writes out everything in
+ * it, so that a slow write or a file switch holds up the writing but not
+ * the reading.  The two buffers are kept between batches, so once they've
+ * grown to the queue limit no memory is allocated per packet.
+ *
+ * pcap_queue_bytes and pcap_queue_packets count what's in both buffers
+ * and hasn't been written yet, so that the -C and -N limits apply to the
+ * two of them together.
+ */
+static GMutex pcap_queue_mutex;
+static GCond pcap_queue_cond;
+static GByteArray *pcap_queue_fill;
+static GByteArray *pcap_queue_drain;
+static gint64 pcap_queue_bytes;         /* queued and not yet written */
 static gint64 pcap_queue_packets;
+static gint64 pcap_queue_max_bytes;     /* high-water marks */
+static gint64 pcap_queue_max_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
 
@@ -197,6 +218,9 @@ typedef struct _capture_src {
     int                          snaplen;
     int                          linktype;
     gboolean                     ts_nsec;                /**< TRUE if we're using nanosecond precision. */
+#ifdef PACKET_FANOUT
+    gint64                       fanout_join_time;       /**< When the socket joined our fanout group, in microseconds since the epoch; 0 once packets after that are being read */
+#endif
                                                          /**< capture pipe (unix only "input file") */
     gboolean                     from_cap_pipe;          /**< TRUE if we are capturing data from a capture pipe */
     gboolean                     from_cap_socket;        /**< TRUE if we're capturing from socket */
@@ -269,15 +293,18 @@ typedef struct _loop_data {
     int      interval_s;
 } loop_data;
 
+/* In the packet queue, each of these is followed by the data, padded
+   to a multiple of 8 bytes. */
 typedef struct _pcap_queue_element {
     capture_src        *pcap_src;
     union {
         struct pcap_pkthdr  phdr;
         pcapng_block_header_t  bh;
     } u;
-    u_char             *pd;
 } pcap_queue_element;
 
+#define PCAP_QUEUE_DATA_LEN(len)    (((len) + 7) & ~7)
+
 /*
  * This needs to be static, so that the SIGINT handler can clear the "go"
  * flag and for saved_shb_idb_lock.
@@ -328,6 +355,21 @@ static capture_options global_capture_opts;
 static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
 static guint64 start_time;
+#ifdef PACKET_FANOUT
+static guint fanout_count = 0;  /* --fanout: sockets on the interface, 0 if not used */
+
+/* The kernel's limit on the number of sockets in a fanout group. */
+#define MAX_FANOUT_COUNT 256
+
+#define LONGOPT_FANOUT LONGOPT_BASE_APPLICATION+1
+
+/* Not in the headers before Linux 4.20. */
+#ifndef PACKET_FANOUT_FLAG_UNIQUEID
+#define PACKET_FANOUT_FLAG_UNIQUEID 0x2000
+#endif
+
+static int fanout_group_id = -1;    /* the ID the kernel gave our fanout group, -1 before the first socket joins */
+#endif
 
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                          const u_char *pd);
@@ -346,6 +388,8 @@ static void WS_NORETURN exit_main(int err);
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_queue_stats(void);
+static void report_compress_stats(void);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -422,6 +466,8 @@ print_usage(FILE *output)
     fprintf(output, "                                          an exact multiple of NUM secs\n");
     fprintf(output, "                          printname:FILE - print filename to FILE when written\n");
     fprintf(output, "                                           (can use 'stdout' or 'stderr')\n");
+    fprintf(output, "  --compress-type <type>   compress each finished ring buffer file with\n");
+    fprintf(output, "                           gzip, zstd or lz4 (def: none)\n");
     fprintf(output, "  -n                       use pcapng format instead of pcap (default)\n");
     fprintf(output, "  -P                       use libpcap format instead of pcapng\n");
     fprintf(output, "  --capture-comment <comment>\n");
@@ -433,6 +479,11 @@ print_usage(FILE *output)
     fprintf(output, "  -C <byte_limit>          maximum number of bytes used for buffering packets\n");
     fprintf(output, "                           within dumpcap\n");
     fprintf(output, "  -t                       use a separate thread per interface\n");
+#ifdef PACKET_FANOUT
+    fprintf(output, "  --fanout <count>         capture on the interface with <count> sockets,\n");
+    fprintf(output, "                           each in its own thread, sharing out the packets\n");
+    fprintf(output, "                           by flow\n");
+#endif
     fprintf(output, "  -q                       don't report packet capture counts\n");
     fprintf(output, "  -v, --version            print version information and exit\n");
     fprintf(output, "  -h, --help               display this help and exit\n");
@@ -1100,6 +1151,8 @@ exit_main(int status)
          * avoid capture_opts_cleanup from double-freeing 'save_file'. */
         ringbuf_free();
         global_capture_opts.save_file = NULL;
+        if (!quiet)
+            report_compress_stats();
     }
 
     capture_opts_cleanup(&global_capture_opts);
@@ -2756,6 +2809,86 @@ pcapng_pipe_dispatch(loop_data *ld, capture_src *pcap_src, char *errmsg, size_t
     return -1;
 }
 
+#ifdef PACKET_FANOUT
+/* Add a copy of the options of the first interface, for the nth socket on it */
+static void
+add_fanout_socket(capture_options *capture_opts, guint n)
+{
+    interface_options interface_opts;
+
+    interface_opts = g_array_index(capture_opts->ifaces, interface_options, 0);
+    interface_opts.name = g_strdup(interface_opts.name);
+    interface_opts.descr = g_strdup(interface_opts.descr);
+    interface_opts.hardware = g_strdup(interface_opts.hardware);
+    interface_opts.display_name = g_strdup_printf("%s (socket %u)",
+                                                  interface_opts.display_name, n);
+    interface_opts.cfilter = g_strdup(interface_opts.cfilter);
+    interface_opts.timestamp_type = g_strdup(interface_opts.timestamp_type);
+    interface_opts.extcap = g_strdup(interface_opts.extcap);
+    interface_opts.extcap_fifo = g_strdup(interface_opts.extcap_fifo);
+    if (interface_opts.extcap_args)
+        g_hash_table_ref(interface_opts.extcap_args);
+    interface_opts.extcap_pid = WS_INVALID_PID;
+    interface_opts.extcap_pipedata = NULL;
+    interface_opts.extcap_control_in = g_strdup(interface_opts.extcap_control_in);
+    interface_opts.extcap_control_out = g_strdup(interface_opts.extcap_control_out);
+#ifdef HAVE_PCAP_REMOTE
+    interface_opts.remote_host = g_strdup(interface_opts.remote_host);
+    interface_opts.remote_port = g_strdup(interface_opts.remote_port);
+    interface_opts.auth_username = g_strdup(interface_opts.auth_username);
+    interface_opts.auth_password = g_strdup(interface_opts.auth_password);
+#endif
+    g_array_append_val(capture_opts->ifaces, interface_opts);
+}
+
+/*
+ * Make a socket a member of our fanout group, in which the kernel
+ * hands each packet to one of the sockets, picked by a hash of its flow,
+ * so that the packets of a flow stay in order.
+ */
+static gboolean
+join_fanout_group(pcap_t *pcap_h, const char *name,
+                  char *errmsg, size_t errmsg_len,
+                  char *secondary_errmsg, size_t secondary_errmsg_len)
+{
+    int       fd = pcap_fileno(pcap_h);
+    int       arg;
+    socklen_t arg_len = sizeof arg;
+
+    if (fanout_group_id == -1) {
+        /*
+         * The first socket has the kernel pick an ID that no other group
+         * has, so that we can't end up sharing the packets with another
+         * process's sockets; the others join with the ID it was given.
+         */
+        arg = (PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG |
+               PACKET_FANOUT_FLAG_UNIQUEID) << 16;
+        if (setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof arg) == -1 ||
+            getsockopt(fd, SOL_PACKET, PACKET_FANOUT, &arg, &arg_len) == -1) {
+            g_snprintf(errmsg, (gulong) errmsg_len,
+                       "Could not create a fanout group for the capture socket on %s: %s.",
+                       name, g_strerror(errno));
+            g_snprintf(secondary_errmsg, (gulong) secondary_errmsg_len,
+                       "--fanout requires a Linux network interface, and Linux 4.20 or later.");
+            return FALSE;
+        }
+        fanout_group_id = arg & 0xffff;
+    } else {
+        arg = fanout_group_id |
+              ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+        if (setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof arg) == -1) {
+            g_snprintf(errmsg, (gulong) errmsg_len,
+                       "Could not add the capture socket on %s to its fanout group: %s.",
+                       name, g_strerror(errno));
+            g_snprintf(secondary_errmsg, (gulong) secondary_errmsg_len,
+                       "--fanout requires a Linux network interface.");
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+#endif
+
 /** Open the capture input sources; each one is either a pcap device,
  *  a capture pipe, or a capture socket.
  *  Returns TRUE if it succeeds, FALSE otherwise. */
@@ -2827,6 +2960,27 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
         if (pcap_src->pcap_h != NULL) {
             /* we've opened "iface" as a network device */
 
+#ifdef PACKET_FANOUT
+            if (fanout_count > 1 &&
+                !join_fanout_group(pcap_src->pcap_h, interface_opts->name,
+                                   errmsg, errmsg_len,
+                                   secondary_errmsg, secondary_errmsg_len)) {
+                return FALSE;
+            }
+            /*
+             * Until it joined, the socket was handed every packet, so
+             * what it has queued is also being captured by the sockets
+             * that joined before it; those packets are skipped by
+             * capture_loop_queue_packet_cb().  That's only possible if
+             * they're time stamped by the host, as the join time is.
+             */
+            if (fanout_count > 1 &&
+                (interface_opts->timestamp_type == NULL ||
+                 strcmp(interface_opts->timestamp_type, "host") == 0)) {
+                pcap_src->fanout_join_time = g_get_real_time();
+            }
+#endif
+
 #ifdef HAVE_PCAP_SET_TSTAMP_PRECISION
             /* Find out if we're getting nanosecond-precision time stamps */
             pcap_src->ts_nsec = have_high_resolution_timestamp(pcap_src->pcap_h);
@@ -2875,6 +3029,19 @@ capture_loop_open_input(capture_options *capture_opts, loop_data *ld,
             /* We couldn't open "iface" as a network device. */
             /* Try to open it as a pipe */
             gboolean pipe_err = FALSE;
+
+#ifdef PACKET_FANOUT
+            if (fanout_count > 1) {
+                get_capture_device_open_failure_messages(open_err,
+                                                         open_err_str,
+                                                         interface_opts->name,
+                                                         errmsg,
+                                                         errmsg_len,
+                                                         secondary_errmsg,
+                                                         secondary_errmsg_len);
+                return FALSE;
+            }
+#endif
             cap_pipe_open_live(interface_opts->name, pcap_src,
                                &pcap_src->cap_pipe_info.pcap.hdr,
                                errmsg, errmsg_len,
@@ -3794,46 +3961,64 @@ pcap_read_handler(void* arg)
     return (NULL);
 }
 
-/* Try to pop an item off the packet queue and if it exists, write it */
-static gboolean
-capture_loop_dequeue_packet(void) {
+/* Wait for packets in the queue and write out all of them; returns the
+   number written */
+static int
+capture_loop_dequeue_packets(void) {
+    GByteArray         *batch;
     pcap_queue_element *queue_element;
-
-    g_async_queue_lock(pcap_queue);
-    queue_element = (pcap_queue_element *)g_async_queue_timeout_pop_unlocked(pcap_queue, WRITER_THREAD_TIMEOUT);
-    if (queue_element) {
-        if (queue_element->pcap_src->from_pcapng) {
-            pcap_queue_bytes -= queue_element->u.bh.block_total_length;
-        } else {
-            pcap_queue_bytes -= queue_element->u.phdr.caplen;
+    guint               offset;
+    guint32             len = 0;
+    guint               element_size = 0;
+    int                 count = 0;
+    gint64              end_time;
+
+    g_mutex_lock(&pcap_queue_mutex);
+    if (pcap_queue_fill->len == 0) {
+        end_time = g_get_monotonic_time() + WRITER_THREAD_TIMEOUT;
+        while (pcap_queue_fill->len == 0) {
+            if (!g_cond_wait_until(&pcap_queue_cond, &pcap_queue_mutex, end_time))
+                break;
         }
-        pcap_queue_packets -= 1;
     }
-    g_async_queue_unlock(pcap_queue);
-    if (queue_element) {
+    batch = pcap_queue_fill;
+    pcap_queue_fill = pcap_queue_drain;
+    pcap_queue_drain = batch;
+    g_mutex_unlock(&pcap_queue_mutex);
+
+    for (offset = 0; offset < batch->len; offset += element_size) {
+        queue_element = (pcap_queue_element *)(void *)(batch->data + offset);
         if (queue_element->pcap_src->from_pcapng) {
+            len = queue_element->u.bh.block_total_length;
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                   "Dequeued a block of type 0x%08x of length %d captured on interface %d.",
-                  queue_element->u.bh.block_type, queue_element->u.bh.block_total_length,
+                  queue_element->u.bh.block_type, len,
                   queue_element->pcap_src->interface_id);
 
             capture_loop_write_pcapng_cb(queue_element->pcap_src,
                                         &queue_element->u.bh,
-                                        queue_element->pd);
+                                        (u_char *)(queue_element + 1));
         } else {
+            len = queue_element->u.phdr.caplen;
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
                 "Dequeued a packet of length %d captured on interface %d.",
-                queue_element->u.phdr.caplen, queue_element->pcap_src->interface_id);
+                len, queue_element->pcap_src->interface_id);
 
             capture_loop_write_packet_cb((u_char *) queue_element->pcap_src,
                                         &queue_element->u.phdr,
-                                        queue_element->pd);
+                                        (u_char *)(queue_element + 1));
         }
-        g_free(queue_element->pd);
-        g_free(queue_element);
-        return TRUE;
+        count++;
+
+        /* It's been written; make room for another. */
+        element_size = (guint)sizeof(pcap_queue_element) + PCAP_QUEUE_DATA_LEN(len);
+        g_mutex_lock(&pcap_queue_mutex);
+        pcap_queue_bytes -= element_size;
+        pcap_queue_packets -= 1;
+        g_mutex_unlock(&pcap_queue_mutex);
     }
-    return FALSE;
+    g_byte_array_set_size(batch, 0);
+    return count;
 }
 
 /* Do the low-level work of a capture.
@@ -3982,9 +4167,15 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     /* WOW, everything is prepared! */
     /* please fasten your seat belts, we will enter now the actual capture loop */
     if (use_threads) {
-        pcap_queue = g_async_queue_new();
+        /* The limit is for the two buffers together. */
+        guint reserve = (guint)MIN(pcap_queue_byte_limit / 2, G_MAXINT);
+
+        pcap_queue_fill = g_byte_array_sized_new(reserve);
+        pcap_queue_drain = g_byte_array_sized_new(reserve);
         pcap_queue_bytes = 0;
         pcap_queue_packets = 0;
+        pcap_queue_max_bytes = 0;
+        pcap_queue_max_packets = 0;
         for (i = 0; i < global_ld.pcaps->len; i++) {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
             /* XXX - Add an interface name here? */
@@ -3994,13 +4185,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     while (global_ld.go) {
         /* dispatch incoming packets */
         if (use_threads) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-
-            if (dequeued) {
-                inpkts = 1;
-            } else {
-                inpkts = 0;
-            }
+            inpkts = capture_loop_dequeue_packets();
         } else {
             pcap_src = g_array_index(global_ld.pcaps, capture_src *, 0);
             inpkts = capture_loop_dispatch(&global_ld, errmsg,
@@ -4079,6 +4264,8 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
 
                 global_ld.inpkts_to_sync_pipe = 0;
             }
+            if (use_threads && capture_child && !quiet)
+                report_queue_stats();
 
             /* check capture duration condition */
             if (autostop_duration_timer != NULL && g_timer_elapsed(autostop_duration_timer, NULL) >= capture_opts->autostop_duration) {
@@ -4114,16 +4301,18 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO, "Thread of interface %u terminated.",
                   pcap_src->interface_id);
         }
-        while (1) {
-            gboolean dequeued = capture_loop_dequeue_packet();
-            if (!dequeued) {
-                break;
-            }
-            global_ld.inpkts_to_sync_pipe += 1;
+        while ((inpkts = capture_loop_dequeue_packets()) > 0) {
+            global_ld.inpkts_to_sync_pipe += inpkts;
             if (capture_opts->output_to_pipe) {
                 fflush(global_ld.pdh);
             }
         }
+        if (!quiet)
+            report_queue_stats();
+        g_byte_array_free(pcap_queue_fill, TRUE);
+        g_byte_array_free(pcap_queue_drain, TRUE);
+        pcap_queue_fill = NULL;
+        pcap_queue_drain = NULL;
     }
 
 
@@ -4513,14 +4702,46 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
     }
 }
 
+/* Append a packet or block to the packet queue; returns FALSE if the
+   queue is full */
+static gboolean
+capture_loop_queue_element(const pcap_queue_element *queue_element,
+                           const u_char *pd, guint32 len)
+{
+    guint    offset;
+    guint    element_size = (guint)sizeof *queue_element + PCAP_QUEUE_DATA_LEN(len);
+    gboolean was_empty;
+
+    g_mutex_lock(&pcap_queue_mutex);
+    if (((pcap_queue_byte_limit != 0) && (pcap_queue_bytes >= pcap_queue_byte_limit)) ||
+        ((pcap_queue_packet_limit != 0) && (pcap_queue_packets >= pcap_queue_packet_limit))) {
+        g_mutex_unlock(&pcap_queue_mutex);
+        return FALSE;
+    }
+    was_empty = (pcap_queue_fill->len == 0);
+    offset = pcap_queue_fill->len;
+    g_byte_array_set_size(pcap_queue_fill, offset + element_size);
+    memcpy(pcap_queue_fill->data + offset, queue_element, sizeof *queue_element);
+    memcpy(pcap_queue_fill->data + offset + sizeof *queue_element, pd, len);
+    pcap_queue_bytes += element_size;
+    pcap_queue_packets += 1;
+    if (pcap_queue_bytes > pcap_queue_max_bytes)
+        pcap_queue_max_bytes = pcap_queue_bytes;
+    if (pcap_queue_packets > pcap_queue_max_packets)
+        pcap_queue_max_packets = pcap_queue_packets;
+    if (was_empty)
+        g_cond_signal(&pcap_queue_cond);
+    g_mutex_unlock(&pcap_queue_mutex);
+    return TRUE;
+}
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                              const u_char *pd)
 {
     capture_src        *pcap_src = (capture_src *) (void *) pcap_src_p;
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    pcap_queue_element  queue_element;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4530,35 +4751,22 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.phdr = *phdr;
-    queue_element->pd = (u_char *)g_malloc(phdr->caplen);
-    if (queue_element->pd == NULL) {
-        pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, phdr->caplen);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += phdr->caplen;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
+#ifdef PACKET_FANOUT
+    /* Skip what the socket was handed before it joined the fanout group. */
+    if (pcap_src->fanout_join_time != 0) {
+        gint64 ts = (gint64)phdr->ts.tv_sec * 1000000 +
+                    (pcap_src->ts_nsec ? phdr->ts.tv_usec / 1000 : phdr->ts.tv_usec);
+
+        if (ts < pcap_src->fanout_join_time)
+            return;
+        pcap_src->fanout_join_time = 0;
     }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
+#endif
+
+    queue_element.pcap_src = pcap_src;
+    queue_element.u.phdr = *phdr;
+    if (!capture_loop_queue_element(&queue_element, pd, phdr->caplen)) {
         pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               phdr->caplen, pcap_src->interface_id);
@@ -4579,8 +4787,7 @@ capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
 static void
 capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
 {
-    pcap_queue_element *queue_element;
-    gboolean            limit_reached;
+    pcap_queue_element  queue_element;
 
     /* We may be called multiple times from pcap_dispatch(); if we've set
        the "stop capturing" flag, ignore this packet, as we're not
@@ -4590,35 +4797,10 @@ capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
         return;
     }
 
-    queue_element = g_new(pcap_queue_element, 1);
-    if (queue_element == NULL) {
-       pcap_src->dropped++;
-       return;
-    }
-    queue_element->pcap_src = pcap_src;
-    queue_element->u.bh = *bh;
-    queue_element->pd = (u_char *)g_malloc(bh->block_total_length);
-    if (queue_element->pd == NULL) {
+    queue_element.pcap_src = pcap_src;
+    queue_element.u.bh = *bh;
+    if (!capture_loop_queue_element(&queue_element, pd, bh->block_total_length)) {
         pcap_src->dropped++;
-        g_free(queue_element);
-        return;
-    }
-    memcpy(queue_element->pd, pd, bh->block_total_length);
-    g_async_queue_lock(pcap_queue);
-    if (((pcap_queue_byte_limit == 0) || (pcap_queue_bytes < pcap_queue_byte_limit)) &&
-        ((pcap_queue_packet_limit == 0) || (pcap_queue_packets < pcap_queue_packet_limit))) {
-        limit_reached = FALSE;
-        g_async_queue_push_unlocked(pcap_queue, queue_element);
-        pcap_queue_bytes += bh->block_total_length;
-        pcap_queue_packets += 1;
-    } else {
-        limit_reached = TRUE;
-    }
-    g_async_queue_unlock(pcap_queue);
-    if (limit_reached) {
-        pcap_src->dropped++;
-        g_free(queue_element->pd);
-        g_free(queue_element);
         g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_INFO,
               "Dropped a packet of length %d captured on interface %u.",
               bh->block_total_length, pcap_src->interface_id);
@@ -4720,6 +4902,9 @@ main(int argc, char *argv[])
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         LONGOPT_CAPTURE_COMMON
+#ifdef PACKET_FANOUT
+        {"fanout", required_argument, NULL, LONGOPT_FANOUT},
+#endif
         {0, 0, 0, 0 }
     };
 
@@ -5157,6 +5342,15 @@ main(int argc, char *argv[])
         case 'N':
             pcap_queue_packet_limit = get_positive_int(optarg, "packet_limit");
             break;
+#ifdef PACKET_FANOUT
+        case LONGOPT_FANOUT:
+            fanout_count = get_positive_int(optarg, "fanout socket count");
+            if (fanout_count > MAX_FANOUT_COUNT) {
+                cmdarg_err("At most %u fanout sockets can be used.", MAX_FANOUT_COUNT);
+                arg_error = TRUE;
+            }
+            break;
+#endif
         default:
             cmdarg_err("Invalid Option: %s", argv[optind-1]);
             /* FALLTHROUGH */
@@ -5184,6 +5378,14 @@ main(int argc, char *argv[])
         }
     }
 
+#ifdef PACKET_FANOUT
+    /* The sockets are written as interfaces of their own, which pcap can't do. */
+    if (fanout_count > 1 && !global_capture_opts.use_pcapng) {
+        cmdarg_err("--fanout writes pcapng; it can't be used with -P.");
+        arg_error = TRUE;
+    }
+#endif
+
     if ((pcap_queue_byte_limit > 0) || (pcap_queue_packet_limit > 0)) {
         use_threads = TRUE;
     }
@@ -5426,6 +5628,24 @@ main(int argc, char *argv[])
         exit_main(0);
     }
 
+#ifdef PACKET_FANOUT
+    if (fanout_count > 1) {
+        /*
+         * Each socket is captured on as if it were an interface of its
+         * own, with its own thread and its own IDB and statistics in the
+         * pcapng output.
+         */
+        if (global_capture_opts.ifaces->len != 1) {
+            cmdarg_err("--fanout can only be used when capturing on one interface.");
+            exit_main(1);
+        }
+        for (j = 1; j <= fanout_count; j++)
+            add_fanout_socket(&global_capture_opts, j);
+        capture_opts_del_iface(&global_capture_opts, 0);
+        use_threads = TRUE;
+    }
+#endif
+
     /* We're supposed to do a capture.  Process the ring buffer arguments. */
     capture_opts_trim_ring_num_files(&global_capture_opts);
 
@@ -5555,6 +5775,59 @@ report_packet_count(unsigned int packet_count)
     }
 }
 
+/* how full the packet queue is, and has been at most, with -t */
+static void
+report_queue_stats(void)
+{
+    char   tmp[4*(SP_DECISIZE+1)+1];
+    gint64 bytes, packets, max_bytes, max_packets;
+
+    g_mutex_lock(&pcap_queue_mutex);
+    bytes = pcap_queue_bytes;
+    packets = pcap_queue_packets;
+    max_bytes = pcap_queue_max_bytes;
+    max_packets = pcap_queue_max_packets;
+    g_mutex_unlock(&pcap_queue_mutex);
+
+    if (capture_child) {
+        g_snprintf(tmp, sizeof(tmp),
+                   "%" G_GINT64_MODIFIER "d:%" G_GINT64_MODIFIER "d:%" G_GINT64_MODIFIER "d:%" G_GINT64_MODIFIER "d",
+                   packets, bytes, max_packets, max_bytes);
+        g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG, "Queue: %s", tmp);
+        pipe_write_block(2, SP_QUEUE_STATS, tmp);
+    } else {
+        fprintf(stderr,
+            "Packet queue high-water mark: %" G_GINT64_MODIFIER "d packets, %" G_GINT64_MODIFIER "d bytes (limits %" G_GINT64_MODIFIER "d, %" G_GINT64_MODIFIER "d)\n",
+            max_packets, max_bytes, pcap_queue_packet_limit, pcap_queue_byte_limit);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
+/* how the compression of finished ring buffer files kept up */
+static void
+report_compress_stats(void)
+{
+    ringbuf_compress_stats stats;
+
+    ringbuf_get_compress_stats(&stats);
+    if (stats.compressed + stats.failed + stats.skipped == 0)
+        return;
+
+    g_log(LOG_DOMAIN_CAPTURE_CHILD, G_LOG_LEVEL_DEBUG,
+          "Compressed files: %u, failed: %u, skipped: %u, most queued: %u, longest lag: %" G_GINT64_MODIFIER "d us",
+          stats.compressed, stats.failed, stats.skipped, stats.max_queued, stats.max_lag);
+    if (!capture_child) {
+        fprintf(stderr,
+            "Compressed %u file%s (%u failed, %u skipped as too many were waiting); "
+            "at most %u waiting, longest wait %.1f s\n",
+            stats.compressed, plurality(stats.compressed, "", "s"),
+            stats.failed, stats.skipped, stats.max_queued, stats.max_lag / 1e6);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
 static void
 report_new_capture_file(const char *filename)
 {
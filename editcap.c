@@ -102,19 +102,44 @@ struct select_item {
 
 /*
  * Duplicate frame detection
+ *
+ * The digests of the packets in the window are kept in fd_hash[], which
+ * is used as a ring: new entries go in after the newest one, and entries
+ * leave from the oldest end when the ring is full.  fd_hash_index counts
+ * the entries in the ring for each digest and length, so that a packet
+ * is looked up without scanning the window, and points to the newest of
+ * them; each entry points to the one before it with the same digest.
  */
-typedef struct _fd_hash_t {
+typedef struct _fd_hash_key_t {
     guint8     digest[16];
     guint32    len;
+} fd_hash_key_t;
+
+typedef struct _fd_hash_t {
+    fd_hash_key_t key;
     nstime_t   frame_time;
+    int        prev_same;   /* the entry before it with this key, if count says there is one */
 } fd_hash_t;
 
-#define DEFAULT_DUP_DEPTH       5   /* Used with -d */
-#define MAX_DUP_DEPTH     1000000   /* the maximum window (and actual size of fd_hash[]) for de-duplication */
+/* Value of fd_hash_index, which is also its own key */
+typedef struct _fd_hash_count_t {
+    fd_hash_key_t key;
+    guint      count;       /* entries in the ring with this key */
+    int        newest;      /* the newest of them */
+} fd_hash_count_t;
 
-static fd_hash_t fd_hash[MAX_DUP_DEPTH];
-static int       dup_window    = DEFAULT_DUP_DEPTH;
-static int       cur_dup_entry = 0;
+#define DEFAULT_DUP_DEPTH       5   /* Used with -d */
+#define MAX_DUP_DEPTH     1000000   /* the maximum window (and size of fd_hash[]) for de-duplication */
+
+static fd_hash_t  *fd_hash       = NULL;
+static GHashTable *fd_hash_index = NULL;
+static int         dup_window    = DEFAULT_DUP_DEPTH;
+static int         fd_hash_size  = 0;  /* dup_window, but at least 1 */
+static int         cur_dup_entry = 0;  /* the newest entry */
+static int         old_dup_entry = 0;  /* the oldest entry */
+static int         dup_entries   = 0;
+static gboolean    dup_times_in_order = TRUE;  /* no packet so far is older than one before it */
+static nstime_t    dup_newest_time;            /* the time of the newest packet so far */
 
 static guint32   ignored_bytes  = 0;  /* Used with -I */
 
@@ -158,6 +183,7 @@ static guint                  max_selected              = 0;
 static gboolean               keep_em                   = FALSE;
 static int                    out_file_type_subtype     = WTAP_FILE_TYPE_SUBTYPE_PCAPNG; /* default to pcapng   */
 static int                    out_frame_type            = -2; /* Leave frame type alone */
+static wtap_compression_type  out_compression_type      = WTAP_UNCOMPRESSED;
 static gboolean               verbose                   = FALSE; /* Not so verbose         */
 static struct time_adjustment time_adj                  = {NSTIME_INIT_ZERO, 0}; /* no adjustment */
 static nstime_t               relative_time_window      = NSTIME_INIT_ZERO; /* de-dup time window */
@@ -586,15 +612,84 @@ remove_vlan_info(const wtap_packet_header *phdr, guint8* fd, guint32* len) {
     }
 }
 
+static guint
+fd_hash_key_hash(gconstpointer k)
+{
+    const fd_hash_key_t *key = (const fd_hash_key_t *)k;
+    guint h;
+
+    /* The digest is already well mixed */
+    memcpy(&h, key->digest, sizeof h);
+    return h ^ key->len;
+}
+
 static gboolean
-is_duplicate(guint8* fd, guint32 len) {
-    int i;
-    const struct ieee80211_radiotap_header* tap_header;
+fd_hash_key_equal(gconstpointer a, gconstpointer b)
+{
+    const fd_hash_key_t *key_a = (const fd_hash_key_t *)a;
+    const fd_hash_key_t *key_b = (const fd_hash_key_t *)b;
+
+    return key_a->len == key_b->len
+        && memcmp(key_a->digest, key_b->digest, 16) == 0;
+}
+
+static void
+fd_hash_init(void)
+{
+    fd_hash_size = dup_window > 0 ? dup_window : 1;
+    fd_hash = g_new0(fd_hash_t, fd_hash_size);
+    fd_hash_index = g_hash_table_new_full(fd_hash_key_hash, fd_hash_key_equal,
+                                          NULL, g_free);
+    cur_dup_entry = 0;
+    old_dup_entry = 0;
+    dup_entries = 0;
+    dup_times_in_order = TRUE;
+    nstime_set_unset(&dup_newest_time);
+}
+
+static void
+fd_hash_cleanup(void)
+{
+    if (fd_hash_index != NULL) {
+        g_hash_table_destroy(fd_hash_index);
+        fd_hash_index = NULL;
+    }
+    g_free(fd_hash);
+    fd_hash = NULL;
+}
+
+/* Drops the oldest entry of the ring. */
+static void
+fd_hash_remove_oldest(void)
+{
+    fd_hash_count_t *hc;
+
+    hc = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_index,
+                                                 &fd_hash[old_dup_entry].key);
+    if (hc != NULL && --hc->count == 0)
+        g_hash_table_remove(fd_hash_index, hc);
+
+    old_dup_entry++;
+    if (old_dup_entry >= fd_hash_size)
+        old_dup_entry = 0;
+    dup_entries--;
+}
 
+/*
+ * Adds the digest of a packet as the newest entry of the ring, making
+ * room for it if the ring is full, and returns what the index holds for
+ * that digest (a count of 1 if none of the other packets in the window
+ * have it).
+ */
+static const fd_hash_count_t *
+fd_hash_add(guint8* fd, guint32 len, const nstime_t *current)
+{
     /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
     guint32 offset = ignored_bytes;
     guint32 new_len;
     guint8 *new_fd;
+    const struct ieee80211_radiotap_header* tap_header;
+    fd_hash_count_t *hc;
 
     if (len <= ignored_bytes) {
         offset = 0;
@@ -611,137 +706,85 @@ is_duplicate(guint8* fd, guint32 len) {
     new_fd  = &fd[offset];
     new_len = len - (offset);
 
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
+    if (dup_entries == fd_hash_size)
+        fd_hash_remove_oldest();
 
-    /* Look for duplicates */
-    for (i = 0; i < dup_window; i++) {
-        if (i == cur_dup_entry)
-            continue;
+    cur_dup_entry = old_dup_entry + dup_entries;
+    if (cur_dup_entry >= fd_hash_size)
+        cur_dup_entry -= fd_hash_size;
+    dup_entries++;
 
-        if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-            && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
-        }
+    /* Calculate our digest */
+    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].key.digest, new_fd, new_len);
+
+    fd_hash[cur_dup_entry].key.len = len;
+    if (current != NULL)
+        fd_hash[cur_dup_entry].frame_time = *current;
+    else
+        nstime_set_unset(&fd_hash[cur_dup_entry].frame_time);
+
+    hc = (fd_hash_count_t *)g_hash_table_lookup(fd_hash_index,
+                                                 &fd_hash[cur_dup_entry].key);
+    if (hc == NULL) {
+        hc = g_new0(fd_hash_count_t, 1);
+        hc->key = fd_hash[cur_dup_entry].key;
+        g_hash_table_add(fd_hash_index, hc);
     }
+    fd_hash[cur_dup_entry].prev_same = hc->newest;
+    hc->newest = cur_dup_entry;
+    hc->count++;
 
-    return FALSE;
+    return hc;
+}
+
+static gboolean
+is_duplicate(guint8* fd, guint32 len) {
+    /*
+     * With a window of N, the packet is compared with the N - 1 packets
+     * before it, which are the other entries of the ring.
+     */
+    return fd_hash_add(fd, len, NULL)->count > 1;
 }
 
 static gboolean
 is_duplicate_rel_time(guint8* fd, guint32 len, const nstime_t *current) {
+    const fd_hash_count_t *hc;
+    guint n;
     int i;
-
-    /*Hint to ignore some bytes at the start of the frame for the digest calculation(-I option) */
-    guint32 offset = ignored_bytes;
-    guint32 new_len;
-    guint8 *new_fd;
-
-    if (len <= ignored_bytes) {
-        offset = 0;
-    }
-
-    new_fd  = &fd[offset];
-    new_len = len - (offset);
-
-    cur_dup_entry++;
-    if (cur_dup_entry >= dup_window)
-        cur_dup_entry = 0;
-
-    /* Calculate our digest */
-    gcry_md_hash_buffer(GCRY_MD_MD5, fd_hash[cur_dup_entry].digest, new_fd, new_len);
-
-    fd_hash[cur_dup_entry].len = len;
-    fd_hash[cur_dup_entry].frame_time.secs = current->secs;
-    fd_hash[cur_dup_entry].frame_time.nsecs = current->nsecs;
+    nstime_t delta;
 
     /*
-     * Look for relative time related duplicates.
-     * This is hopefully a reasonably efficient mechanism for
-     * finding duplicates by rel time in the fd_hash[] cache.
-     * We check starting from the most recently added hash
-     * entries and work backwards towards older packets.
-     * This approach allows the dup test to be terminated
-     * when the relative time of a cached entry is found to
-     * be beyond the dup time window.
-     *
-     * Of course this assumes that the input trace file is
-     * "well-formed" in the sense that the packet timestamps are
-     * in strict chronologically increasing order (which is NOT
-     * always the case!!).
-     *
-     * The fd_hash[] table was deliberately created large (1,000,000).
-     * Looking for time related duplicates in large trace files with
-     * non-fractional dup time window values can potentially take
-     * a long time to complete.
+     * Trace files usually have their packets in chronological order
+     * (oldest to newest), but that's NOT always the case, so the entries
+     * aren't dropped when they fall out of the time window: a packet
+     * that comes later could still be older than them.  Only the size
+     * of the ring limits how far back we look.
      */
+    if (!nstime_is_unset(&dup_newest_time) &&
+        nstime_cmp(current, &dup_newest_time) < 0)
+        dup_times_in_order = FALSE;
+    else
+        dup_newest_time = *current;
 
-    for (i = cur_dup_entry - 1;; i--) {
-        nstime_t delta;
-        int cmp;
-
-        if (i < 0)
-            i = dup_window - 1;
-
-        if (i == cur_dup_entry) {
-            /*
-             * We've decremented back to where we started.
-             * Check no more!
-             */
-            break;
-        }
-
-        if (nstime_is_unset(&(fd_hash[i].frame_time))) {
-            /*
-             * We've decremented to an unused fd_hash[] entry.
-             * Check no more!
-             */
-            break;
-        }
+    hc = fd_hash_add(fd, len, current);
 
+    /*
+     * Look at the other packets with the same digest, newest first.
+     * The packet is a duplicate if one of them is no more than the
+     * window before it; one that's later than it (a negative delta)
+     * doesn't make it a duplicate.  While all of the packets are in
+     * order, the ones after an entry that's too old are older still.
+     */
+    i = fd_hash[hc->newest].prev_same;
+    for (n = 1; n < hc->count; n++) {
         nstime_delta(&delta, current, &fd_hash[i].frame_time);
-
-        if (delta.secs < 0 || delta.nsecs < 0) {
-            /*
-             * A negative delta implies that the current packet
-             * has an absolute timestamp less than the cached packet
-             * that it is being compared to.  This is NOT a normal
-             * situation since trace files usually have packets in
-             * chronological order (oldest to newest).
-             *
-             * There are several possible ways to deal with this:
-             * 1. 'continue' dup checking with the next cached frame.
-             * 2. 'break' from looking for a duplicate of the current frame.
-             * 3. Take the absolute value of the delta and see if that
-             * falls within the specifed dup time window.
-             *
-             * Currently this code does option 1.  But it would pretty
-             * easy to add yet-another-editcap-option to select one of
-             * the other behaviors for dealing with out-of-sequence
-             * packets.
-             */
-            continue;
-        }
-
-        cmp = nstime_cmp(&delta, &relative_time_window);
-
-        if (cmp > 0) {
-            /*
-             * The delta time indicates that we are now looking at
-             * cached packets beyond the specified dup time window.
-             * Check no more!
-             */
-            break;
-        } else if (fd_hash[i].len == fd_hash[cur_dup_entry].len
-                   && memcmp(fd_hash[i].digest, fd_hash[cur_dup_entry].digest, 16) == 0) {
-            return TRUE;
+        if (delta.secs >= 0 && delta.nsecs >= 0) {
+            if (nstime_cmp(&delta, &relative_time_window) <= 0)
+                return TRUE;
+            if (dup_times_in_order)
+                break;
         }
+        i = fd_hash[i].prev_same;
     }
 
     return FALSE;
@@ -838,6 +881,9 @@ print_usage(FILE *output)
     fprintf(output, "  -T <encap type>        set the output file encapsulation type; default is the\n");
     fprintf(output, "                         same as the input file. An empty \"-T\" option will\n");
     fprintf(output, "                         list the encapsulation types.\n");
+    fprintf(output, "  --compress <type>      compress the output file(s) with <type>; default is\n");
+    fprintf(output, "                         none. An empty \"--compress\" option will list the\n");
+    fprintf(output, "                         types of compression.\n");
     fprintf(output, "  --inject-secrets <type>,<file>  Insert decryption secrets from <file>. List\n");
     fprintf(output, "                         supported secret types with \"--inject-secrets help\".\n");
     fprintf(output, "  --discard-all-secrets  Discard all decryption secrets from the input file\n");
@@ -853,6 +899,8 @@ print_usage(FILE *output)
     fprintf(output, "                         command line.\n");
     fprintf(output, "\n");
     fprintf(output, "Miscellaneous:\n");
+    fprintf(output, "  --read-ahead <MB>      read up to <MB> megabytes ahead of the input file\n");
+    fprintf(output, "                         in a separate thread; default is 0, off.\n");
     fprintf(output, "  -h                     display this help and exit.\n");
     fprintf(output, "  -v                     verbose output.\n");
     fprintf(output, "                         If -v is used with any of the 'Duplicate Packet\n");
@@ -908,6 +956,18 @@ list_capture_types(FILE *stream) {
     g_free(captypes);
 }
 
+static void
+list_compression_types(FILE *stream) {
+    GSList *names, *name;
+
+    fprintf(stream, "editcap: The available types of compression for the \"--compress\" flag are:\n");
+    fprintf(stream, "    none\n");
+    names = wtap_get_all_compression_type_names_list();
+    for (name = names; name != NULL; name = g_slist_next(name))
+        fprintf(stream, "    %s\n", (const char *)name->data);
+    g_slist_free(names);
+}
+
 static void
 list_encap_types(FILE *stream) {
     int i;
@@ -1007,10 +1067,10 @@ editcap_dump_open(const char *filename, const wtap_dump_params *params,
 
     if (strcmp(filename, "-") == 0) {
         /* Write to the standard output. */
-        pdh = wtap_dump_open_stdout(out_file_type_subtype, WTAP_UNCOMPRESSED,
+        pdh = wtap_dump_open_stdout(out_file_type_subtype, out_compression_type,
                                     params, err, err_info);
     } else {
-        pdh = wtap_dump_open(filename, out_file_type_subtype, WTAP_UNCOMPRESSED,
+        pdh = wtap_dump_open(filename, out_file_type_subtype, out_compression_type,
                              params, err, err_info);
     }
     if (pdh == NULL)
@@ -1090,6 +1150,8 @@ main(int argc, char *argv[])
 #define LONGOPT_DISCARD_ALL_SECRETS  LONGOPT_BASE_APPLICATION+5
 #define LONGOPT_CAPTURE_COMMENT      LONGOPT_BASE_APPLICATION+6
 #define LONGOPT_DISCARD_CAPTURE_COMMENT LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_READ_AHEAD           LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_COMPRESS             LONGOPT_BASE_APPLICATION+9
 
     static const struct option long_options[] = {
         {"novlan", no_argument, NULL, LONGOPT_NO_VLAN},
@@ -1101,6 +1163,8 @@ main(int argc, char *argv[])
         {"version", no_argument, NULL, 'V'},
         {"capture-comment", required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
         {"discard-capture-comment", no_argument, NULL, LONGOPT_DISCARD_CAPTURE_COMMENT},
+        {"read-ahead", required_argument, NULL, LONGOPT_READ_AHEAD},
+        {"compress", required_argument, NULL, LONGOPT_COMPRESS},
         {0, 0, 0, 0 }
     };
 
@@ -1257,6 +1321,25 @@ main(int argc, char *argv[])
             break;
         }
 
+        case LONGOPT_READ_AHEAD:
+        {
+            wtap_set_read_ahead(get_guint32(optarg, "read-ahead size"));
+            break;
+        }
+
+        case LONGOPT_COMPRESS:
+        {
+            out_compression_type = wtap_name_to_compression_type(optarg);
+            if (out_compression_type == WTAP_UNKNOWN_COMPRESSION) {
+                fprintf(stderr, "editcap: \"%s\" isn't a valid type of compression\n\n",
+                        optarg);
+                list_compression_types(stderr);
+                ret = INVALID_OPTION;
+                goto clean_exit;
+            }
+            break;
+        }
+
         case 'a':
         {
             guint frame_number;
@@ -1489,6 +1572,9 @@ main(int argc, char *argv[])
             case'T':
                 list_encap_types(stdout);
                 break;
+            case LONGOPT_COMPRESS:
+                list_compression_types(stdout);
+                break;
             default:
                 if (opt == '?') {
                     fprintf(stderr, "editcap: invalid option -- '%c'\n", optopt);
@@ -1515,6 +1601,14 @@ main(int argc, char *argv[])
 
     }
 
+    if (out_compression_type != WTAP_UNCOMPRESSED &&
+        !wtap_dump_can_compress(out_file_type_subtype)) {
+        fprintf(stderr, "editcap: %s files can't be written compressed\n",
+                wtap_file_type_subtype_string(out_file_type_subtype));
+        ret = INVALID_OPTION;
+        goto clean_exit;
+    }
+
     if (err_prob >= 0.0) {
         if (!valid_seed) {
             seed = (unsigned int) (time(NULL) + ws_getpid());
@@ -1679,11 +1773,7 @@ main(int argc, char *argv[])
         max_packet_number = G_MAXUINT;
 
     if (dup_detect || dup_detect_by_time) {
-        for (i = 0; i < dup_window; i++) {
-            memset(&fd_hash[i].digest, 0, 16);
-            fd_hash[i].len = 0;
-            nstime_set_unset(&fd_hash[i].frame_time);
-        }
+        fd_hash_init();
     }
 
     /* Set up an array of all IDBs seen */
@@ -2006,7 +2096,7 @@ main(int argc, char *argv[])
                                     rec->rec_header.packet_header.caplen);
                             for (i = 0; i < 16; i++)
                                 fprintf(stderr, "%02x",
-                                        (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                        (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                             fprintf(stderr, "\n");
                         }
                         duplicate_count++;
@@ -2019,7 +2109,7 @@ main(int argc, char *argv[])
                                     rec->rec_header.packet_header.caplen);
                             for (i = 0; i < 16; i++)
                                 fprintf(stderr, "%02x",
-                                        (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                        (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                             fprintf(stderr, "\n");
                         }
                     }
@@ -2042,7 +2132,7 @@ main(int argc, char *argv[])
                                         rec->rec_header.packet_header.caplen);
                                 for (i = 0; i < 16; i++)
                                     fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                            (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                                 fprintf(stderr, "\n");
                             }
                             duplicate_count++;
@@ -2055,7 +2145,7 @@ main(int argc, char *argv[])
                                         rec->rec_header.packet_header.caplen);
                                 for (i = 0; i < 16; i++)
                                     fprintf(stderr, "%02x",
-                                            (unsigned char)fd_hash[cur_dup_entry].digest[i]);
+                                            (unsigned char)fd_hash[cur_dup_entry].key.digest[i]);
                                 fprintf(stderr, "\n");
                             }
                         }
@@ -2270,6 +2360,7 @@ clean_exit:
         wtap_close(wth);
     wtap_cleanup();
     free_progdirs();
+    fd_hash_cleanup();
     if (capture_comments != NULL) {
         g_ptr_array_free(capture_comments, TRUE);
         capture_comments = NULL;
@@ -27,6 +27,8 @@ struct epan_dfilter {
 	int		*interesting_fields;
 	int		num_interesting_fields;
 	GPtrArray	*deprecated;
+	int		*memo_slots;	/* per instruction; see dfilter-memo.h */
+	int		result_slot;
 };
 
 typedef struct {
@@ -0,0 +1,400 @@
+/* dfilter-memo.c
+ * Results shared by the display filters applied to the same proto_tree
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "dfilter-memo.h"
+#include "dfvm.h"
+#include <ftypes/ftypes-int.h>
+
+/*
+ * Fields that can be added to the tree after filters have been applied
+ * to it: the columns, which are filled in after the packet has been
+ * dissected, and the coloring rule fields, which are added after the
+ * coloring rules have been applied.  A remembered result for a test of
+ * one of them could be stale.
+ */
+static const char *const late_field_prefixes[] = {
+	"_ws.col.",
+	"frame.coloring_rule.",
+};
+
+/* Signatures of the tests that have a slot. */
+typedef struct {
+	char	*signature;
+	guint	refs;		/* filters that use the slot */
+} memo_slot_t;
+
+static GMutex		memo_mutex;
+static GHashTable	*slots_by_signature;	/* signature -> slot + 1 */
+static GPtrArray	*slots;			/* memo_slot_t, NULL if free */
+static GArray		*free_slots;		/* int */
+static gint		num_slots;
+static gint		generation;
+
+static gboolean
+field_is_memoizable(header_field_info *hfinfo)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(late_field_prefixes); i++) {
+		if (strncmp(hfinfo->abbrev, late_field_prefixes[i],
+				strlen(late_field_prefixes[i])) == 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/* The string representation of a constant, if two constants with the same
+ * representation are always equal. */
+static char *
+constant_repr(fvalue_t *fv)
+{
+	switch (fvalue_type_ftenum(fv)) {
+		/* Not all the digits of floats and times are shown. */
+		case FT_FLOAT:
+		case FT_DOUBLE:
+		case FT_ABSOLUTE_TIME:
+		case FT_RELATIVE_TIME:
+		case FT_PCRE:
+			return NULL;
+
+		default:
+			return fvalue_to_string_repr(NULL, fv, FTREPR_DFILTER, BASE_NONE);
+	}
+}
+
+static void
+append_constant(GString *sig, fvalue_t *fv, gboolean *ok)
+{
+	char *repr;
+
+	if (fv == NULL || (repr = constant_repr(fv)) == NULL) {
+		*ok = FALSE;
+		return;
+	}
+	g_string_append_printf(sig, " %d:%s", fvalue_type_ftenum(fv), repr);
+	wmem_free(NULL, repr);
+
+	/* The representation of an address leaves out the netmask. */
+	switch (fvalue_type_ftenum(fv)) {
+		case FT_IPv4:
+			g_string_append_printf(sig, "/%08x", fv->value.ipv4.nmask);
+			break;
+		case FT_IPv6:
+			g_string_append_printf(sig, "/%u", fv->value.ipv6.prefix);
+			break;
+		default:
+			break;
+	}
+}
+
+static void
+append_field_tests(GString *sig, dfvm_insn_t *insn)
+{
+	GArray			*tests = insn->arg2->value.tests;
+	dfvm_field_test_t	*test;
+	dfvm_slice_test_t	*slice;
+	guint			i, j;
+
+	for (i = 0; i < tests->len; i++) {
+		if (insn->op == FIELD_SLICE_TEST) {
+			slice = &g_array_index(tests, dfvm_slice_test_t, i);
+			g_string_append_printf(sig, " %d@%d:", slice->op, slice->offset);
+			for (j = 0; j < slice->bytes->len; j++)
+				g_string_append_printf(sig, "%02x", slice->bytes->data[j]);
+		}
+		else {
+			test = &g_array_index(tests, dfvm_field_test_t, i);
+			if (insn->op == FIELD_IPV4_TEST) {
+				g_string_append_printf(sig, " %d:%08x/%08x:%08x/%08x",
+						test->op,
+						test->value.ipv4.addr, test->value.ipv4.nmask,
+						test->high.ipv4.addr, test->high.ipv4.nmask);
+			}
+			else {
+				g_string_append_printf(sig, " %d:%08x:%08x", test->op,
+						test->value.uinteger, test->high.uinteger);
+			}
+		}
+	}
+}
+
+/* Returns the signature of an instruction whose result only depends on
+ * the tree, or NULL.  fields[reg] is the field read into a register, or
+ * NULL; constants[reg] is the constant in a register, or NULL. */
+static char *
+insn_signature(dfvm_insn_t *insn, header_field_info **fields,
+		fvalue_t **constants)
+{
+	GString			*sig;
+	header_field_info	*hfinfo;
+	guint32			reg1, reg2, reg3;
+	gboolean		ok = TRUE;
+
+	switch (insn->op) {
+		case CHECK_EXISTS:
+		case READ_TREE:
+			/* Both are TRUE if the field is present. */
+			hfinfo = insn->arg1->value.hfinfo;
+			if (!field_is_memoizable(hfinfo))
+				return NULL;
+			return g_strdup_printf("E %s", hfinfo->abbrev);
+
+		case FIELD_UINT_TEST:
+		case FIELD_SINT_TEST:
+		case FIELD_IPV4_TEST:
+		case FIELD_SLICE_TEST:
+			hfinfo = insn->arg1->value.hfinfo;
+			if (!field_is_memoizable(hfinfo))
+				return NULL;
+			sig = g_string_new(NULL);
+			g_string_printf(sig, "T%d %s", insn->op, hfinfo->abbrev);
+			append_field_tests(sig, insn);
+			return g_string_free(sig, FALSE);
+
+		case ANY_EQ:
+		case ANY_NE:
+		case ANY_GT:
+		case ANY_GE:
+		case ANY_LT:
+		case ANY_LE:
+		case ANY_BITWISE_AND:
+		case ANY_CONTAINS:
+			/* A field and a constant, either way round. */
+			reg1 = insn->arg1->value.numeric;
+			reg2 = insn->arg2->value.numeric;
+			sig = g_string_new(NULL);
+			if (fields[reg1] && constants[reg2]) {
+				hfinfo = fields[reg1];
+				g_string_printf(sig, "A%d %s", insn->op, hfinfo->abbrev);
+				append_constant(sig, constants[reg2], &ok);
+			}
+			else if (constants[reg1] && fields[reg2]) {
+				hfinfo = fields[reg2];
+				g_string_printf(sig, "A%d' %s", insn->op, hfinfo->abbrev);
+				append_constant(sig, constants[reg1], &ok);
+			}
+			else {
+				hfinfo = NULL;
+			}
+			if (!hfinfo || !ok || !field_is_memoizable(hfinfo)) {
+				g_string_free(sig, TRUE);
+				return NULL;
+			}
+			return g_string_free(sig, FALSE);
+
+		case ANY_IN_RANGE:
+			reg1 = insn->arg1->value.numeric;
+			reg2 = insn->arg2->value.numeric;
+			reg3 = insn->arg3->value.numeric;
+			hfinfo = fields[reg1];
+			if (!hfinfo || !field_is_memoizable(hfinfo))
+				return NULL;
+			sig = g_string_new(NULL);
+			g_string_printf(sig, "R %s", hfinfo->abbrev);
+			append_constant(sig, constants[reg2], &ok);
+			append_constant(sig, constants[reg3], &ok);
+			if (!ok) {
+				g_string_free(sig, TRUE);
+				return NULL;
+			}
+			return g_string_free(sig, FALSE);
+
+		default:
+			/* Including FIELD_SET_TEST and FIELD_CONTAINS_TEST,
+			 * whose signatures would be as big as their sets. */
+			return NULL;
+	}
+}
+
+/* Called with memo_mutex held. */
+static int
+slot_ref(char *signature)
+{
+	memo_slot_t	*slot;
+	int		id;
+
+	if (slots_by_signature == NULL) {
+		slots_by_signature = g_hash_table_new(g_str_hash, g_str_equal);
+		slots = g_ptr_array_new();
+		free_slots = g_array_new(FALSE, FALSE, sizeof(int));
+	}
+
+	id = GPOINTER_TO_INT(g_hash_table_lookup(slots_by_signature, signature)) - 1;
+	if (id >= 0) {
+		slot = (memo_slot_t *)g_ptr_array_index(slots, id);
+		slot->refs++;
+		g_free(signature);
+		return id;
+	}
+
+	slot = g_new(memo_slot_t, 1);
+	slot->signature = signature;
+	slot->refs = 1;
+	if (free_slots->len > 0) {
+		id = g_array_index(free_slots, int, free_slots->len - 1);
+		g_array_set_size(free_slots, free_slots->len - 1);
+		g_ptr_array_index(slots, id) = slot;
+	}
+	else {
+		id = (int)slots->len;
+		g_ptr_array_add(slots, slot);
+		g_atomic_int_set(&num_slots, (gint)slots->len);
+	}
+	g_hash_table_insert(slots_by_signature, slot->signature, GINT_TO_POINTER(id + 1));
+	return id;
+}
+
+/* Called with memo_mutex held. */
+static void
+slot_unref(int id)
+{
+	memo_slot_t *slot;
+
+	if (id < 0)
+		return;
+
+	slot = (memo_slot_t *)g_ptr_array_index(slots, id);
+	if (--slot->refs > 0)
+		return;
+
+	g_hash_table_remove(slots_by_signature, slot->signature);
+	g_free(slot->signature);
+	g_free(slot);
+	g_ptr_array_index(slots, id) = NULL;
+	g_array_append_val(free_slots, id);
+
+	/* The slot can be given to another test, so the results that trees
+	 * have for it aren't valid any more. */
+	g_atomic_int_inc(&generation);
+}
+
+void
+dfilter_memo_assign(dfilter_t *df, const char *text)
+{
+	header_field_info	**fields;
+	fvalue_t		**constants;
+	dfvm_insn_t		*insn;
+	header_field_info	*hfinfo;
+	char			*signature;
+	gboolean		whole = TRUE;
+	guint			i;
+
+	fields = g_new0(header_field_info *, df->max_registers);
+	constants = g_new0(fvalue_t *, df->max_registers);
+	for (i = 0; i < df->insns->len; i++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, i);
+		if (insn->op == READ_TREE)
+			fields[insn->arg2->value.numeric] = insn->arg1->value.hfinfo;
+	}
+	for (i = 0; i < df->consts->len; i++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->consts, i);
+		if (insn->op == PUT_FVALUE)
+			constants[insn->arg2->value.numeric] = insn->arg1->value.fvalue;
+	}
+
+	/* The filter as a whole is a test too, unless it refers to a field
+	 * whose results can't be remembered. */
+	for (i = 0; i < (guint)df->num_interesting_fields; i++) {
+		hfinfo = proto_registrar_get_nth(df->interesting_fields[i]);
+		if (hfinfo && !field_is_memoizable(hfinfo))
+			whole = FALSE;
+	}
+
+	df->memo_slots = g_new(int, df->insns->len);
+	g_mutex_lock(&memo_mutex);
+	for (i = 0; i < df->insns->len; i++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(df->insns, i);
+		signature = insn_signature(insn, fields, constants);
+		df->memo_slots[i] = signature ? slot_ref(signature) : -1;
+	}
+	df->result_slot = whole ? slot_ref(g_strdup_printf("F %s", text)) : -1;
+	g_mutex_unlock(&memo_mutex);
+
+	g_free(fields);
+	g_free(constants);
+}
+
+void
+dfilter_memo_release(dfilter_t *df)
+{
+	guint i;
+
+	if (df->memo_slots == NULL)
+		return;
+
+	g_mutex_lock(&memo_mutex);
+	for (i = 0; i < df->insns->len; i++)
+		slot_unref(df->memo_slots[i]);
+	slot_unref(df->result_slot);
+	g_mutex_unlock(&memo_mutex);
+
+	g_free(df->memo_slots);
+	df->memo_slots = NULL;
+	df->result_slot = -1;
+}
+
+dfilter_memo_t *
+dfilter_memo_get(proto_tree *tree)
+{
+	tree_data_t	*tree_data = PTREE_DATA(tree);
+	dfilter_memo_t	*memo = (dfilter_memo_t *)tree_data->dfilter_results;
+	guint		cur_slots = (guint)g_atomic_int_get(&num_slots);
+	guint		cur_generation = (guint)g_atomic_int_get(&generation);
+
+	if (cur_slots == 0)
+		return NULL;
+
+	if (memo != NULL && memo->generation != cur_generation) {
+		g_free(memo);
+		memo = NULL;
+	}
+
+	if (memo == NULL) {
+		memo = (dfilter_memo_t *)g_malloc0(sizeof(dfilter_memo_t) + cur_slots);
+		memo->generation = cur_generation;
+		memo->num_slots = cur_slots;
+	}
+	else if (memo->num_slots < cur_slots) {
+		/* Filters were compiled since the results were made. */
+		memo = (dfilter_memo_t *)g_realloc(memo, sizeof(dfilter_memo_t) + cur_slots);
+		memset((guint8 *)(memo + 1) + memo->num_slots, 0,
+				cur_slots - memo->num_slots);
+		memo->num_slots = cur_slots;
+	}
+	memo->results = (guint8 *)(memo + 1);
+	tree_data->dfilter_results = memo;
+	return memo;
+}
+
+void
+dfilter_memo_clear(proto_tree *tree)
+{
+	tree_data_t *tree_data = PTREE_DATA(tree);
+
+	g_free(tree_data->dfilter_results);
+	tree_data->dfilter_results = NULL;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,93 @@
+/* dfilter-memo.h
+ * Results shared by the display filters applied to the same proto_tree
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef DFILTER_MEMO_H
+#define DFILTER_MEMO_H
+
+#include <glib.h>
+
+#include <epan/proto.h>
+#include "dfilter-int.h"
+
+/*
+ * The coloring rules, the display filter and the tap filters are all
+ * applied to the tree of a packet, and many of them test the same
+ * things: whether "tcp" is present, "ip.addr == 10.0.0.1", and so on.
+ *
+ * When a filter is compiled, each of its tests that only depends on the
+ * tree (an existence check, a comparison of a field with a constant, a
+ * FIELD_*_TEST instruction) is given a slot, and so is the filter as a
+ * whole; tests that are the same in different filters share a slot.
+ * While a filter runs, the result of each of those tests is remembered
+ * in the tree, so that the other filters applied to the same tree don't
+ * have to read the fields and compare the values again, and applying a
+ * filter twice (e.g. for several tap listeners with the same filter)
+ * costs nothing.  The results are forgotten when the tree is reset for
+ * the next packet.
+ */
+
+#define DFILTER_MEMO_UNKNOWN	0
+#define DFILTER_MEMO_FALSE	1
+#define DFILTER_MEMO_TRUE	2
+
+typedef struct {
+	guint	generation;	/* slots that were in use when the results were
+				   made; see dfilter_memo_get() */
+	guint	num_slots;
+	guint8	*results;	/* DFILTER_MEMO_ value per slot */
+} dfilter_memo_t;
+
+/* Gives slots to the tests of a compiled filter; text is the filter
+ * string, with macros expanded. */
+void
+dfilter_memo_assign(dfilter_t *df, const char *text);
+
+/* Gives the slots of a filter back. */
+void
+dfilter_memo_release(dfilter_t *df);
+
+/* Returns the results for a tree, or NULL if no filter has slots. */
+dfilter_memo_t *
+dfilter_memo_get(proto_tree *tree);
+
+/* Forgets the results for a tree. */
+void
+dfilter_memo_clear(proto_tree *tree);
+
+static inline guint8
+dfilter_memo_lookup(const dfilter_memo_t *memo, int slot)
+{
+	if (memo == NULL || slot < 0 || (guint)slot >= memo->num_slots)
+		return DFILTER_MEMO_UNKNOWN;
+	return memo->results[slot];
+}
+
+static inline void
+dfilter_memo_store(dfilter_memo_t *memo, int slot, gboolean result)
+{
+	if (memo == NULL || slot < 0 || (guint)slot >= memo->num_slots)
+		return;
+	memo->results[slot] = result ? DFILTER_MEMO_TRUE : DFILTER_MEMO_FALSE;
+}
+
+#endif /* DFILTER_MEMO_H */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -16,6 +16,7 @@
 #include "gencode.h"
 #include "semcheck.h"
 #include "dfvm.h"
+#include "dfilter-memo.h"
 #include <epan/epan_dissect.h>
 #include "dfilter.h"
 #include "dfilter-macro.h"
@@ -97,6 +98,8 @@ dfilter_new(void)
 	df = g_new0(dfilter_t, 1);
 	df->insns = NULL;
 	df->deprecated = NULL;
+	df->memo_slots = NULL;
+	df->result_slot = -1;
 
 	return df;
 }
@@ -124,6 +127,8 @@ dfilter_free(dfilter_t *df)
 	if (!df)
 		return;
 
+	dfilter_memo_release(df);
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -356,6 +361,9 @@ dfilter_compile(const gchar *text, dfilter_t **dfp, gchar **err_msg)
 		/* Initialize constants */
 		dfvm_init_const(dfilter);
 
+		/* Share the results of its tests with other filters */
+		dfilter_memo_assign(dfilter, expanded_text);
+
 		/* Add any deprecated items */
 		dfilter->deprecated = deprecated;
 
@@ -410,6 +418,12 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 	return dfvm_apply(df, edt->tree);
 }
 
+void
+dfilter_forget_results(proto_tree *tree)
+{
+	dfilter_memo_clear(tree);
+}
+
 
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
@@ -427,6 +441,15 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+void
+dfilter_get_interesting_fields(const dfilter_t *df, GArray *hfids)
+{
+	if (df->num_interesting_fields > 0) {
+		g_array_append_vals(hfids, df->interesting_fields,
+		    df->num_interesting_fields);
+	}
+}
+
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df) {
 	if (df->deprecated && df->deprecated->len > 0) {
@@ -64,6 +64,13 @@ dfilter_apply_edt(dfilter_t *df, struct epan_dissect *edt);
 gboolean
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* The results of the tests the filters applied to a proto_tree have in
+ * common are remembered until the tree is reset, so that each test is
+ * only done once per packet.  Forget them, e.g. to time a filter. */
+WS_DLL_PUBLIC
+void
+dfilter_forget_results(proto_tree *tree);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
@@ -72,6 +79,11 @@ dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
 gboolean
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Append the hfids of the fields/protocols used in a dfilter to a GArray of ints. */
+WS_DLL_PUBLIC
+void
+dfilter_get_interesting_fields(const dfilter_t *df, GArray *hfids);
+
 WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
@@ -0,0 +1,229 @@
+/* dfilter_bench.c
+ * Times the application of display filters to a protocol tree
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Usage: dfilter_bench [iterations] [filter ...]
+ *
+ * Builds the protocol tree of an Ethernet/IPv4/TCP packet once, then
+ * applies each filter to it the given number of times and prints the
+ * time taken by one application.  Run "dftest <filter>" to see the code
+ * a filter is compiled to.
+ *
+ * The results of tests that filters have in common are shared by the
+ * filters applied to a tree, so they are forgotten before each
+ * application; the last line is the time taken to apply all the filters,
+ * one after the other, as is done with the coloring rules.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
+#include <epan/dfilter/dfilter.h>
+
+#include <wsutil/filesystem.h>
+#include <wsutil/privileges.h>
+
+#include <wiretap/wtap.h>
+
+#define DEFAULT_ITERATIONS	1000000
+
+static const char *default_filters[] = {
+	"tcp.port == 443",
+	"tcp.port == 80 || tcp.port == 443 || tcp.port == 8080",
+	"tcp.port in {80 443 8000..8080}",
+	"tcp.flags.syn == 1 && tcp.window_size_value > 1000",
+	"ip.src == 10.0.0.0/8",
+	"ip.addr == 192.168.1.1 || ip.addr == 192.168.1.2",
+	"eth.src[0:3] == 00:1b:21",
+	"frame[12:2] == 08:00",
+	"ip.ttl != 64 && !(ip.proto == 17)",
+};
+
+/* Ethernet, IPv4 and TCP headers of a SYN from 10.1.2.3:51000 to
+ * 192.168.1.2:443. */
+static const guint8 packet[] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x00, 0x1b,
+	0x21, 0x01, 0x02, 0x03, 0x08, 0x00, 0x45, 0x00,
+	0x00, 0x28, 0x12, 0x34, 0x40, 0x00, 0x40, 0x06,
+	0x00, 0x00, 0x0a, 0x01, 0x02, 0x03, 0xc0, 0xa8,
+	0x01, 0x02, 0xc7, 0x38, 0x01, 0xbb, 0x00, 0x00,
+	0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x50, 0x02,
+	0xfa, 0xf0, 0x00, 0x00, 0x00, 0x00
+};
+
+typedef struct {
+	const char	*name;
+	gint		start;
+	gint		length;
+} bench_field_t;
+
+/* The fields of the tree, in the order a dissector would add them. */
+static const bench_field_t fields[] = {
+	{ "frame",			0,	-1 },
+	{ "eth",			0,	14 },
+	{ "eth.dst",			0,	6 },
+	{ "eth.src",			6,	6 },
+	{ "eth.type",			12,	2 },
+	{ "ip",				14,	20 },
+	{ "ip.version",			14,	1 },
+	{ "ip.len",			16,	2 },
+	{ "ip.id",			18,	2 },
+	{ "ip.ttl",			22,	1 },
+	{ "ip.proto",			23,	1 },
+	{ "ip.src",			26,	4 },
+	{ "ip.addr",			26,	4 },
+	{ "ip.dst",			30,	4 },
+	{ "ip.addr",			30,	4 },
+	{ "tcp",			34,	20 },
+	{ "tcp.srcport",		34,	2 },
+	{ "tcp.dstport",		36,	2 },
+	{ "tcp.port",			34,	2 },
+	{ "tcp.port",			36,	2 },
+	{ "tcp.seq",			38,	4 },
+	{ "tcp.flags.syn",		47,	1 },
+	{ "tcp.window_size_value",	48,	2 },
+};
+
+static void
+add_fields(proto_tree *tree, tvbuff_t *tvb)
+{
+	guint	i;
+	int	hf_id;
+
+	for (i = 0; i < G_N_ELEMENTS(fields); i++) {
+		hf_id = proto_registrar_get_id_byname(fields[i].name);
+		if (hf_id == -1) {
+			fprintf(stderr, "dfilter_bench: no field \"%s\"\n", fields[i].name);
+			continue;
+		}
+		proto_tree_add_item(tree, hf_id, tvb, fields[i].start,
+				fields[i].length, ENC_BIG_ENDIAN);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	char		*init_progfile_dir_error;
+	const char	**filters = default_filters;
+	int		num_filters = G_N_ELEMENTS(default_filters);
+	long		iterations = DEFAULT_ITERATIONS;
+	dfilter_t	**dfs;
+	gchar		*err_msg;
+	epan_dissect_t	*edt;
+	tvbuff_t	*tvb;
+	gint64		start, elapsed;
+	long		n, passed;
+	int		i;
+
+	if (argc > 1) {
+		iterations = strtol(argv[1], NULL, 10);
+		if (iterations <= 0) {
+			fprintf(stderr, "Usage: dfilter_bench [iterations] [filter ...]\n");
+			return 1;
+		}
+	}
+	if (argc > 2) {
+		filters = (const char **)&argv[2];
+		num_filters = argc - 2;
+	}
+
+	init_process_policies();
+	init_progfile_dir_error = init_progfile_dir(argv[0]);
+	if (init_progfile_dir_error != NULL) {
+		fprintf(stderr, "dfilter_bench: Can't get pathname of directory containing the dfilter_bench program: %s.\n",
+			init_progfile_dir_error);
+		g_free(init_progfile_dir_error);
+	}
+
+	wtap_init(TRUE);
+	if (!epan_init(NULL, NULL, FALSE))
+		return 2;
+
+	dfs = g_new0(dfilter_t *, num_filters);
+	for (i = 0; i < num_filters; i++) {
+		if (!dfilter_compile(filters[i], &dfs[i], &err_msg)) {
+			fprintf(stderr, "dfilter_bench: %s: %s\n", filters[i], err_msg);
+			g_free(err_msg);
+			return 2;
+		}
+	}
+
+	/* Only the fields the filters refer to are looked up, so the tree
+	 * has to be primed with them before it is built. */
+	edt = epan_dissect_new(NULL, TRUE, TRUE);
+	for (i = 0; i < num_filters; i++) {
+		if (dfs[i])
+			epan_dissect_prime_with_dfilter(edt, dfs[i]);
+	}
+	tvb = tvb_new_real_data(packet, sizeof packet, sizeof packet);
+	add_fields(edt->tree, tvb);
+
+	printf("%ld iterations\n\n", iterations);
+	for (i = 0; i < num_filters; i++) {
+		if (!dfs[i])
+			continue;
+
+		passed = 0;
+		start = g_get_monotonic_time();
+		for (n = 0; n < iterations; n++) {
+			dfilter_forget_results(edt->tree);
+			if (dfilter_apply_edt(dfs[i], edt))
+				passed++;
+		}
+		elapsed = g_get_monotonic_time() - start;
+
+		printf("%8.1f ns  %s  %s\n",
+			(double)elapsed * 1000.0 / (double)iterations,
+			passed ? "pass" : "fail", filters[i]);
+	}
+
+	start = g_get_monotonic_time();
+	for (n = 0; n < iterations; n++) {
+		dfilter_forget_results(edt->tree);
+		for (i = 0; i < num_filters; i++) {
+			if (dfs[i])
+				dfilter_apply_edt(dfs[i], edt);
+		}
+	}
+	elapsed = g_get_monotonic_time() - start;
+	printf("%8.1f ns  all filters\n",
+		(double)elapsed * 1000.0 / (double)iterations);
+
+	epan_dissect_free(edt);
+	tvb_free(tvb);
+	for (i = 0; i < num_filters; i++)
+		dfilter_free(dfs[i]);
+	g_free(dfs);
+	epan_cleanup();
+	wtap_cleanup();
+	return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -9,8 +9,14 @@
 #include "config.h"
 
 #include "dfvm.h"
+#include "dfilter-memo.h"
+
+#include <string.h>
 
 #include <ftypes/ftypes-int.h>
+#include <wsutil/bits_count_ones.h>
+#include <wsutil/inet_addr.h>
+#include <wsutil/pint.h>
 
 dfvm_insn_t*
 dfvm_insn_new(dfvm_opcode_t op)
@@ -29,6 +35,8 @@ dfvm_insn_new(dfvm_opcode_t op)
 static void
 dfvm_value_free(dfvm_value_t *v)
 {
+	guint	i;
+
 	switch (v->type) {
 		case FVALUE:
 			FVALUE_FREE(v->value.fvalue);
@@ -36,6 +44,28 @@ dfvm_value_free(dfvm_value_t *v)
 		case DRANGE:
 			drange_free(v->value.drange);
 			break;
+		case FIELD_TESTS:
+			g_array_free(v->value.tests, TRUE);
+			break;
+		case SLICE_TESTS:
+			for (i = 0; i < v->value.tests->len; i++) {
+				g_byte_array_free(g_array_index(v->value.tests,
+						dfvm_slice_test_t, i).bytes, TRUE);
+			}
+			g_array_free(v->value.tests, TRUE);
+			break;
+		case VALUE_SET:
+			value_set_free(v->value.set);
+			break;
+		case PATTERN_SET:
+			pattern_set_free(v->value.patterns);
+			break;
+		case FVALUES:
+			for (i = 0; i < v->value.fvalues->len; i++) {
+				FVALUE_FREE((fvalue_t *)g_ptr_array_index(v->value.fvalues, i));
+			}
+			g_ptr_array_free(v->value.fvalues, TRUE);
+			break;
 		default:
 			/* nothing */
 			;
@@ -72,6 +102,115 @@ dfvm_value_new(dfvm_value_type_t type)
 	return v;
 }
 
+static const char *
+test_op_symbol(dfvm_opcode_t op)
+{
+	switch (op) {
+		case ANY_EQ:		return "==";
+		case ANY_NE:		return "!=";
+		case ANY_GT:		return ">";
+		case ANY_GE:		return ">=";
+		case ANY_LT:		return "<";
+		case ANY_LE:		return "<=";
+		case ANY_BITWISE_AND:	return "&";
+		case ANY_IN_RANGE:	return "in";
+		default:
+			g_assert_not_reached();
+			return "?";
+	}
+}
+
+static void
+dump_immediate(FILE *f, dfvm_opcode_t op, const dfvm_immediate_t *imm)
+{
+	char	buf[WS_INET_ADDRSTRLEN];
+	guint32	addr;
+
+	switch (op) {
+		case FIELD_UINT_TEST:
+			fprintf(f, "%u", imm->uinteger);
+			break;
+		case FIELD_SINT_TEST:
+			fprintf(f, "%d", imm->sinteger);
+			break;
+		case FIELD_IPV4_TEST:
+			addr = g_htonl(imm->ipv4.addr);
+			ws_inet_ntop4(&addr, buf, sizeof(buf));
+			fprintf(f, "%s/%d", buf, ws_count_ones(imm->ipv4.nmask));
+			break;
+		default:
+			g_assert_not_reached();
+			break;
+	}
+}
+
+/* Prints the tests of a FIELD_*_TEST instruction the way they would be
+ * written in a filter. */
+static void
+dump_field_tests(FILE *f, dfvm_insn_t *insn)
+{
+	const char		*abbrev = insn->arg1->value.hfinfo->abbrev;
+	GArray			*tests = insn->arg2->value.tests;
+	dfvm_field_test_t	*test;
+	dfvm_slice_test_t	*slice;
+	guint			i, j;
+
+	for (i = 0; i < tests->len; i++) {
+		if (i > 0) {
+			fprintf(f, " || ");
+		}
+		if (insn->op == FIELD_SLICE_TEST) {
+			slice = &g_array_index(tests, dfvm_slice_test_t, i);
+			fprintf(f, "%s[%d:%u] %s ", abbrev, slice->offset,
+					slice->bytes->len, test_op_symbol(slice->op));
+			for (j = 0; j < slice->bytes->len; j++) {
+				fprintf(f, j > 0 ? ":%02x" : "%02x", slice->bytes->data[j]);
+			}
+			continue;
+		}
+		test = &g_array_index(tests, dfvm_field_test_t, i);
+		fprintf(f, "%s %s ", abbrev, test_op_symbol(test->op));
+		dump_immediate(f, insn->op, &test->value);
+		if (test->op == ANY_IN_RANGE) {
+			fprintf(f, "..");
+			dump_immediate(f, insn->op, &test->high);
+		}
+	}
+	if (insn->arg3) {
+		fprintf(f, " (%u hashed)", value_set_size(insn->arg3->value.set));
+	}
+}
+
+/* Prints the constants of a FIELD_SET_TEST or FIELD_CONTAINS_TEST
+ * instruction. */
+static void
+dump_fvalues(FILE *f, dfvm_insn_t *insn)
+{
+	const char	*abbrev = insn->arg1->value.hfinfo->abbrev;
+	GPtrArray	*fvalues = insn->arg3->value.fvalues;
+	char		*value_str;
+	guint		i;
+
+	if (insn->op == FIELD_SET_TEST) {
+		fprintf(f, "%s in {", abbrev);
+	}
+	for (i = 0; i < fvalues->len; i++) {
+		value_str = fvalue_to_string_repr(NULL,
+				(fvalue_t *)g_ptr_array_index(fvalues, i),
+				FTREPR_DFILTER, BASE_NONE);
+		if (insn->op == FIELD_SET_TEST) {
+			fprintf(f, i > 0 ? " %s" : "%s", value_str);
+		}
+		else {
+			fprintf(f, i > 0 ? " || %s contains %s" : "%s contains %s",
+					abbrev, value_str);
+		}
+		wmem_free(NULL, value_str);
+	}
+	if (insn->op == FIELD_SET_TEST) {
+		fprintf(f, "}");
+	}
+}
 
 void
 dfvm_dump(FILE *f, dfilter_t *df)
@@ -119,6 +258,12 @@ dfvm_dump(FILE *f, dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case FIELD_UINT_TEST:
+			case FIELD_SINT_TEST:
+			case FIELD_IPV4_TEST:
+			case FIELD_SLICE_TEST:
+			case FIELD_SET_TEST:
+			case FIELD_CONTAINS_TEST:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
@@ -259,6 +404,42 @@ dfvm_dump(FILE *f, dfilter_t *df)
 					arg3->value.numeric);
 				break;
 
+			case FIELD_UINT_TEST:
+				fprintf(f, "%05d FIELD_UINT_TEST\t", id);
+				dump_field_tests(f, insn);
+				fprintf(f, "\n");
+				break;
+
+			case FIELD_SINT_TEST:
+				fprintf(f, "%05d FIELD_SINT_TEST\t", id);
+				dump_field_tests(f, insn);
+				fprintf(f, "\n");
+				break;
+
+			case FIELD_IPV4_TEST:
+				fprintf(f, "%05d FIELD_IPV4_TEST\t", id);
+				dump_field_tests(f, insn);
+				fprintf(f, "\n");
+				break;
+
+			case FIELD_SLICE_TEST:
+				fprintf(f, "%05d FIELD_SLICE_TEST\t", id);
+				dump_field_tests(f, insn);
+				fprintf(f, "\n");
+				break;
+
+			case FIELD_SET_TEST:
+				fprintf(f, "%05d FIELD_SET_TEST\t", id);
+				dump_fvalues(f, insn);
+				fprintf(f, "\n");
+				break;
+
+			case FIELD_CONTAINS_TEST:
+				fprintf(f, "%05d FIELD_CONTAINS_TEST\t", id);
+				dump_fvalues(f, insn);
+				fprintf(f, "\n");
+				break;
+
 			case NOT:
 				fprintf(f, "%05d NOT\n", id);
 				break;
@@ -336,6 +517,81 @@ read_tree(dfilter_t *df, proto_tree *tree, header_field_info *hfinfo, int reg)
 	return TRUE;
 }
 
+/* Like read_tree(), but gets the values from a field cache.  Sets
+ * *cache_miss if the cache doesn't have the values. */
+static gboolean
+read_field_cache(dfilter_t *df, field_cache_t *fc, guint32 framenum,
+		header_field_info *hfinfo, int reg, gboolean *cache_miss)
+{
+	fvalue_t	**values;
+	guint		i, count;
+	GList		*fvalues = NULL;
+	gboolean	found_something = FALSE;
+
+	if (df->attempted_load[reg]) {
+		if (df->registers[reg]) {
+			return TRUE;
+		}
+		else {
+			return FALSE;
+		}
+	}
+
+	df->attempted_load[reg] = TRUE;
+
+	while (hfinfo) {
+		if (!field_cache_lookup(fc, hfinfo->id, framenum, &values, &count)) {
+			g_list_free(fvalues);
+			*cache_miss = TRUE;
+			return FALSE;
+		}
+		if (count > 0) {
+			found_something = TRUE;
+		}
+
+		for (i = 0; i < count; i++) {
+			fvalues = g_list_prepend(fvalues, values[i]);
+		}
+
+		hfinfo = hfinfo->same_name_next;
+	}
+
+	if (!found_something) {
+		return FALSE;
+	}
+
+	df->registers[reg] = fvalues;
+	/* The values belong to the cache. */
+	df->owns_memory[reg] = FALSE;
+	return TRUE;
+}
+
+/* Checks whether a field is present, in the proto_tree or, if fc isn't
+ * NULL, in the field cache. */
+static gboolean
+check_exists(proto_tree *tree, field_cache_t *fc, guint32 framenum,
+		header_field_info *hfinfo, gboolean *cache_miss)
+{
+	guint	count;
+
+	while (hfinfo) {
+		if (fc) {
+			if (!field_cache_lookup(fc, hfinfo->id, framenum, NULL, &count)) {
+				*cache_miss = TRUE;
+				return FALSE;
+			}
+			if (count > 0) {
+				return TRUE;
+			}
+		}
+		else if (proto_check_for_protocol_or_field(tree, hfinfo->id)) {
+			return TRUE;
+		}
+		hfinfo = hfinfo->same_name_next;
+	}
+	return FALSE;
+}
+
 
 /* Put a constant value in a register. These will not be cleared by
  * free_register_overhead. */
@@ -458,22 +714,302 @@ mk_range(dfilter_t *df, int from_reg, int to_reg, drange_t *d_range)
 
 
 
-gboolean
-dfvm_apply(dfilter_t *df, proto_tree *tree)
+static gboolean
+uint_test(const dfvm_field_test_t *test, guint32 value)
+{
+	switch (test->op) {
+		case ANY_EQ:		return value == test->value.uinteger;
+		case ANY_NE:		return value != test->value.uinteger;
+		case ANY_GT:		return value > test->value.uinteger;
+		case ANY_GE:		return value >= test->value.uinteger;
+		case ANY_LT:		return value < test->value.uinteger;
+		case ANY_LE:		return value <= test->value.uinteger;
+		case ANY_BITWISE_AND:	return (value & test->value.uinteger) != 0;
+		case ANY_IN_RANGE:
+			return value >= test->value.uinteger && value <= test->high.uinteger;
+		default:
+			g_assert_not_reached();
+			return FALSE;
+	}
+}
+
+static gboolean
+sint_test(const dfvm_field_test_t *test, gint32 value)
+{
+	switch (test->op) {
+		case ANY_EQ:		return value == test->value.sinteger;
+		case ANY_NE:		return value != test->value.sinteger;
+		case ANY_GT:		return value > test->value.sinteger;
+		case ANY_GE:		return value >= test->value.sinteger;
+		case ANY_LT:		return value < test->value.sinteger;
+		case ANY_LE:		return value <= test->value.sinteger;
+		case ANY_BITWISE_AND:
+			return ((guint32)value & test->value.uinteger) != 0;
+		case ANY_IN_RANGE:
+			return value >= test->value.sinteger && value <= test->high.sinteger;
+		default:
+			g_assert_not_reached();
+			return FALSE;
+	}
+}
+
+/* Compares addresses with the less restrictive of the two netmasks, as
+ * ftype-ipv4.c does. */
+static int
+ipv4_cmp(const ipv4_addr_and_mask *a, const ipv4_addr_and_mask *b)
+{
+	guint32	nmask, addr_a, addr_b;
+
+	nmask = MIN(a->nmask, b->nmask);
+	addr_a = a->addr & nmask;
+	addr_b = b->addr & nmask;
+	return addr_a < addr_b ? -1 : (addr_a > addr_b ? 1 : 0);
+}
+
+static gboolean
+ipv4_test(const dfvm_field_test_t *test, const ipv4_addr_and_mask *value)
+{
+	switch (test->op) {
+		case ANY_EQ:	return ipv4_cmp(value, &test->value.ipv4) == 0;
+		case ANY_NE:	return ipv4_cmp(value, &test->value.ipv4) != 0;
+		case ANY_GT:	return ipv4_cmp(value, &test->value.ipv4) > 0;
+		case ANY_GE:	return ipv4_cmp(value, &test->value.ipv4) >= 0;
+		case ANY_LT:	return ipv4_cmp(value, &test->value.ipv4) < 0;
+		case ANY_LE:	return ipv4_cmp(value, &test->value.ipv4) <= 0;
+		case ANY_BITWISE_AND:
+			return ((value->addr & value->nmask) &
+				(test->value.ipv4.addr & test->value.ipv4.nmask)) != 0;
+		case ANY_IN_RANGE:
+			return ipv4_cmp(value, &test->value.ipv4) >= 0 &&
+				ipv4_cmp(value, &test->high.ipv4) <= 0;
+		default:
+			g_assert_not_reached();
+			return FALSE;
+	}
+}
+
+/* A slice that doesn't fit in the value is empty, as with fvalue_slice(),
+ * so it differs from any constant. */
+static gboolean
+slice_test(const dfvm_slice_test_t *test, const fvalue_t *fv)
+{
+	tvbuff_t	*tvb = NULL;
+	const guint8	*data = NULL;
+	gint		start, length;
+	gboolean	equal = FALSE;
+
+	if (fv->ftype->ftype == FT_PROTOCOL) {
+		tvb = fv->value.protocol.tvb;
+		length = tvb ? (gint)tvb_captured_length(tvb) : 0;
+	}
+	else {
+		data = fv->value.bytes->data;
+		length = (gint)fv->value.bytes->len;
+	}
+
+	start = test->offset;
+	if (start < 0) {
+		start += length;
+	}
+	if (start >= 0 && start + (gint)test->bytes->len <= length) {
+		if (tvb) {
+			equal = tvb_memeql(tvb, start, test->bytes->data,
+					test->bytes->len) == 0;
+		}
+		else {
+			equal = memcmp(data + start, test->bytes->data,
+					test->bytes->len) == 0;
+		}
+	}
+	return test->op == ANY_EQ ? equal : !equal;
+}
+
+void
+dfvm_immediate_key(dfvm_opcode_t op, const dfvm_immediate_t *imm,
+		guint8 buf[4], value_set_key_t *key)
+{
+	key->data = buf;
+	key->len = 4;
+	key->prefix = VALUE_SET_WHOLE;
+
+	switch (op) {
+		case FIELD_UINT_TEST:
+		case FIELD_SINT_TEST:
+			memcpy(buf, &imm->uinteger, 4);
+			break;
+		case FIELD_IPV4_TEST:
+			/* Most significant bit first, for the prefix. */
+			phton32(buf, imm->ipv4.addr);
+			if (imm->ipv4.nmask != 0xffffffff) {
+				key->prefix = ws_count_ones(imm->ipv4.nmask);
+			}
+			break;
+		default:
+			g_assert_not_reached();
+			break;
+	}
+}
+
+/* Checks whether a value is in the set of a FIELD_SET_TEST instruction. */
+static gboolean
+value_in_set(dfvm_insn_t *insn, const fvalue_t *fv)
+{
+	GPtrArray	*fvalues;
+	value_set_key_t	key;
+	guint		i;
+
+	value_set_key_from_fvalue(fv, &key);
+	if (key.prefix == VALUE_SET_WHOLE) {
+		return value_set_contains(insn->arg2->value.set, &key);
+	}
+
+	/* An address with a prefix; the shorter of the two prefixes is
+	 * compared, so the hashed keys are no use. */
+	fvalues = insn->arg3->value.fvalues;
+	for (i = 0; i < fvalues->len; i++) {
+		if (fvalue_eq(fv, (fvalue_t *)g_ptr_array_index(fvalues, i))) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Checks whether a value passes any of the tests of a FIELD_*_TEST
+ * instruction. */
+static gboolean
+value_passes(dfvm_insn_t *insn, const fvalue_t *fv)
+{
+	GArray		*tests;
+	guint		i, num_tests;
+	guint8		buf[4];
+	value_set_key_t	key;
+	dfvm_immediate_t imm;
+
+	switch (insn->op) {
+		case FIELD_SET_TEST:
+			return value_in_set(insn, fv);
+		case FIELD_CONTAINS_TEST:
+			value_set_key_from_fvalue(fv, &key);
+			return pattern_set_search(insn->arg2->value.patterns,
+					key.data, key.len);
+		default:
+			break;
+	}
+
+	tests = insn->arg2->value.tests;
+	num_tests = tests->len;
+
+	/* The ANY_EQ tests at the end are in a hashed set, unless the value
+	 * is an address with a netmask, for which the shorter netmask of the
+	 * two is used. */
+	if (insn->arg3 &&
+	    (insn->op != FIELD_IPV4_TEST || fv->value.ipv4.nmask == 0xffffffff)) {
+		if (insn->op == FIELD_IPV4_TEST) {
+			imm.ipv4 = fv->value.ipv4;
+		}
+		else {
+			imm.uinteger = fv->value.uinteger;
+		}
+		dfvm_immediate_key(insn->op, &imm, buf, &key);
+		if (value_set_contains(insn->arg3->value.set, &key)) {
+			return TRUE;
+		}
+		num_tests = insn->arg4->value.numeric;
+	}
+
+	for (i = 0; i < num_tests; i++) {
+		switch (insn->op) {
+			case FIELD_UINT_TEST:
+				if (uint_test(&g_array_index(tests, dfvm_field_test_t, i),
+						fv->value.uinteger))
+					return TRUE;
+				break;
+			case FIELD_SINT_TEST:
+				if (sint_test(&g_array_index(tests, dfvm_field_test_t, i),
+						fv->value.sinteger))
+					return TRUE;
+				break;
+			case FIELD_IPV4_TEST:
+				if (ipv4_test(&g_array_index(tests, dfvm_field_test_t, i),
+						&fv->value.ipv4))
+					return TRUE;
+				break;
+			case FIELD_SLICE_TEST:
+				if (slice_test(&g_array_index(tests, dfvm_slice_test_t, i),
+						fv))
+					return TRUE;
+				break;
+			default:
+				g_assert_not_reached();
+				break;
+		}
+	}
+	return FALSE;
+}
+
+/* Runs a FIELD_*_TEST instruction on the values of its field in the
+ * proto_tree or, if fc isn't NULL, in the field cache. */
+static gboolean
+field_test(dfvm_insn_t *insn, proto_tree *tree, field_cache_t *fc,
+		guint32 framenum, gboolean *cache_miss)
+{
+	header_field_info	*hfinfo = insn->arg1->value.hfinfo;
+	GPtrArray		*finfos;
+	fvalue_t		**values;
+	guint			i, count;
+
+	while (hfinfo) {
+		if (fc) {
+			if (!field_cache_lookup(fc, hfinfo->id, framenum, &values, &count)) {
+				*cache_miss = TRUE;
+				return FALSE;
+			}
+			for (i = 0; i < count; i++) {
+				if (value_passes(insn, values[i])) {
+					return TRUE;
+				}
+			}
+		}
+		else {
+			finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+			if (finfos) {
+				for (i = 0; i < finfos->len; i++) {
+					field_info *finfo = (field_info *)g_ptr_array_index(finfos, i);
+					if (value_passes(insn, &finfo->value)) {
+						return TRUE;
+					}
+				}
+			}
+		}
+		hfinfo = hfinfo->same_name_next;
+	}
+	return FALSE;
+}
+
+
+/* Runs the filter on the proto_tree or, if fc isn't NULL, on the values
+ * recorded in the field cache for a frame.  In the latter case, if the
+ * cache doesn't have a value the filter needs, *cache_miss is set and
+ * the result is meaningless.
+ *
+ * If memo isn't NULL, the results of tests that other filters have done
+ * on the tree are used, and the results of the tests done are stored. */
+static gboolean
+dfvm_run(dfilter_t *df, proto_tree *tree, dfilter_memo_t *memo,
+		field_cache_t *fc, guint32 framenum, gboolean *cache_miss)
 {
 	int		id, length;
+	int		memo_slot = -1;
+	guint8		known;
 	gboolean	accum = TRUE;
 	dfvm_insn_t	*insn;
 	dfvm_value_t	*arg1;
 	dfvm_value_t	*arg2;
 	dfvm_value_t	*arg3 = NULL;
 	dfvm_value_t	*arg4 = NULL;
-	header_field_info	*hfinfo;
 	GList		*param1;
 	GList		*param2;
 
-	g_assert(tree);
-
 	length = df->insns->len;
 
 	for (id = 0; id < length; id++) {
@@ -483,24 +1019,42 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 		arg1 = insn->arg1;
 		arg2 = insn->arg2;
 
+		if (memo && df->memo_slots) {
+			memo_slot = df->memo_slots[id];
+			known = dfilter_memo_lookup(memo, memo_slot);
+			/* READ_TREE still has to load the field if it's
+			 * present. */
+			if (known == DFILTER_MEMO_FALSE ||
+			    (known == DFILTER_MEMO_TRUE && insn->op != READ_TREE)) {
+				accum = (known == DFILTER_MEMO_TRUE);
+				continue;
+			}
+		}
+
 		switch (insn->op) {
 			case CHECK_EXISTS:
-				hfinfo = arg1->value.hfinfo;
-				while(hfinfo) {
-					accum = proto_check_for_protocol_or_field(tree,
-							hfinfo->id);
-					if (accum) {
-						break;
-					}
-					else {
-						hfinfo = hfinfo->same_name_next;
-					}
+				accum = check_exists(tree, fc, framenum,
+						arg1->value.hfinfo, cache_miss);
+				if (fc && *cache_miss) {
+					free_register_overhead(df);
+					return FALSE;
 				}
 				break;
 
 			case READ_TREE:
-				accum = read_tree(df, tree,
-						arg1->value.hfinfo, arg2->value.numeric);
+				if (fc) {
+					accum = read_field_cache(df, fc, framenum,
+							arg1->value.hfinfo, arg2->value.numeric,
+							cache_miss);
+					if (*cache_miss) {
+						free_register_overhead(df);
+						return FALSE;
+					}
+				}
+				else {
+					accum = read_tree(df, tree,
+							arg1->value.hfinfo, arg2->value.numeric);
+				}
 				break;
 
 			case CALL_FUNCTION:
@@ -579,6 +1133,19 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 						arg3->value.numeric);
 				break;
 
+			case FIELD_UINT_TEST:
+			case FIELD_SINT_TEST:
+			case FIELD_IPV4_TEST:
+			case FIELD_SLICE_TEST:
+			case FIELD_SET_TEST:
+			case FIELD_CONTAINS_TEST:
+				accum = field_test(insn, tree, fc, framenum, cache_miss);
+				if (fc && *cache_miss) {
+					free_register_overhead(df);
+					return FALSE;
+				}
+				break;
+
 			case NOT:
 				accum = !accum;
 				break;
@@ -613,12 +1180,53 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				g_assert_not_reached();
 				break;
 		}
+
+		if (memo_slot >= 0) {
+			dfilter_memo_store(memo, memo_slot, accum);
+		}
 	}
 
 	g_assert_not_reached();
 	return FALSE; /* to appease the compiler */
 }
 
+gboolean
+dfvm_apply(dfilter_t *df, proto_tree *tree)
+{
+	dfilter_memo_t	*memo;
+	guint8		known;
+	gboolean	result;
+
+	g_assert(tree);
+
+	memo = dfilter_memo_get(tree);
+	known = dfilter_memo_lookup(memo, df->result_slot);
+	if (known != DFILTER_MEMO_UNKNOWN) {
+		return known == DFILTER_MEMO_TRUE;
+	}
+
+	result = dfvm_run(df, tree, memo, NULL, 0, NULL);
+	dfilter_memo_store(memo, df->result_slot, result);
+	return result;
+}
+
+gboolean
+dfvm_apply_field_cache(dfilter_t *df, field_cache_t *fc, guint32 framenum,
+		gboolean *passed)
+{
+	gboolean	cache_miss = FALSE;
+	gboolean	result;
+
+	g_assert(fc);
+
+	result = dfvm_run(df, NULL, NULL, fc, framenum, &cache_miss);
+	if (cache_miss) {
+		return FALSE;
+	}
+	*passed = result;
+	return TRUE;
+}
+
 void
 dfvm_init_const(dfilter_t *df)
 {
@@ -654,6 +1262,10 @@ dfvm_init_const(dfilter_t *df)
 			case ANY_CONTAINS:
 			case ANY_MATCHES:
 			case ANY_IN_RANGE:
+			case FIELD_UINT_TEST:
+			case FIELD_SINT_TEST:
+			case FIELD_IPV4_TEST:
+			case FIELD_SLICE_TEST:
 			case NOT:
 			case RETURN:
 			case IF_TRUE_GOTO:
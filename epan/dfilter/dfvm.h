@@ -14,6 +14,9 @@
 #include "syntax-tree.h"
 #include "drange.h"
 #include "dfunctions.h"
+#include "field-cache.h"
+#include "value-set.h"
+#include "pattern-set.h"
 
 typedef enum {
 	EMPTY,
@@ -23,7 +26,12 @@ typedef enum {
 	REGISTER,
 	INTEGER,
 	DRANGE,
-	FUNCTION_DEF
+	FUNCTION_DEF,
+	FIELD_TESTS,
+	SLICE_TESTS,
+	VALUE_SET,
+	PATTERN_SET,
+	FVALUES
 } dfvm_value_type_t;
 
 typedef struct {
@@ -35,6 +43,10 @@ typedef struct {
 		drange_t		*drange;
 		header_field_info	*hfinfo;
         df_func_def_t   *funcdef;
+		GArray			*tests;
+		value_set_t		*set;
+		pattern_set_t		*patterns;
+		GPtrArray		*fvalues;
 	} value;
 
 } dfvm_value_t;
@@ -60,10 +72,56 @@ typedef enum {
 	ANY_MATCHES,
 	MK_RANGE,
 	CALL_FUNCTION,
-	ANY_IN_RANGE
+	ANY_IN_RANGE,
+	FIELD_UINT_TEST,
+	FIELD_SINT_TEST,
+	FIELD_IPV4_TEST,
+	FIELD_SLICE_TEST,
+	FIELD_SET_TEST,
+	FIELD_CONTAINS_TEST
 
 } dfvm_opcode_t;
 
+/*
+ * The FIELD_*_TEST instructions compare the values of a field directly
+ * with constants, without loading them into a register.  The result is
+ * TRUE if any value of the field passes any of the tests; that is how
+ * "field == 1 || field == 2" and "field in {1 2}" are evaluated.
+ *
+ * FIELD_UINT_TEST, FIELD_SINT_TEST and FIELD_IPV4_TEST have a
+ * FIELD_TESTS argument, an array of dfvm_field_test_t; FIELD_SLICE_TEST
+ * has a SLICE_TESTS argument, an array of dfvm_slice_test_t.
+ *
+ * If FIELD_UINT_TEST, FIELD_SINT_TEST or FIELD_IPV4_TEST have many ANY_EQ
+ * tests, those come last, and the instruction also has a VALUE_SET
+ * argument with their constants and an INTEGER argument with the number
+ * of tests that come before them.
+ *
+ * FIELD_SET_TEST is TRUE if any value of the field is in a VALUE_SET;
+ * it's used for large "in" sets of other types.  FIELD_CONTAINS_TEST is
+ * TRUE if any value of the field contains any pattern of a PATTERN_SET.
+ * Both also have an FVALUES argument with the constants, to show them
+ * and, for IPv6 addresses with a prefix, to compare them one by one.
+ */
+typedef union {
+	guint32			uinteger;
+	gint32			sinteger;
+	ipv4_addr_and_mask	ipv4;
+} dfvm_immediate_t;
+
+typedef struct {
+	dfvm_opcode_t		op;	/* ANY_EQ ... ANY_BITWISE_AND, or ANY_IN_RANGE */
+	dfvm_immediate_t	value;	/* the constant, or the lower bound */
+	dfvm_immediate_t	high;	/* ANY_IN_RANGE: the upper bound */
+} dfvm_field_test_t;
+
+/* Compares field[offset:bytes->len] with bytes. */
+typedef struct {
+	dfvm_opcode_t		op;	/* ANY_EQ or ANY_NE */
+	gint			offset;	/* negative: from the end */
+	GByteArray		*bytes;
+} dfvm_slice_test_t;
+
 typedef struct {
 	int		id;
 	dfvm_opcode_t	op;
@@ -88,7 +146,20 @@ dfvm_dump(FILE *f, dfilter_t *df);
 gboolean
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
+/* Runs the filter on a frame's values in a field cache instead of on a
+ * proto_tree.  Returns FALSE if the filter needs a field that the cache
+ * doesn't have for that frame. */
+gboolean
+dfvm_apply_field_cache(dfilter_t *df, field_cache_t *fc, guint32 framenum,
+		gboolean *passed);
+
 void
 dfvm_init_const(dfilter_t *df);
 
+/* Makes the key of the constant of a FIELD_UINT_TEST, FIELD_SINT_TEST or
+ * FIELD_IPV4_TEST test, for its VALUE_SET. */
+void
+dfvm_immediate_key(dfvm_opcode_t op, const dfvm_immediate_t *imm,
+		guint8 buf[4], value_set_key_t *key);
+
 #endif
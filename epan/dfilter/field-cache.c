@@ -0,0 +1,379 @@
+/* field-cache.c
+ * Per-frame cache of field values for re-applying display filters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "field-cache.h"
+#include "dfvm.h"
+#include <ftypes/ftypes-int.h>
+
+/*
+ * Fields whose value depends on what the user does with the file, or on
+ * which frames are displayed, rather than on the frame's contents.  They
+ * can change without the frames being dissected again, so a cached value
+ * could be stale.
+ */
+static const char *const volatile_fields[] = {
+	"frame.marked",
+	"frame.ignored",
+	"frame.ref_time",
+	"frame.time_relative",
+	"frame.time_delta_displayed",
+	"frame.comment",
+	"frame.comment.expert",
+	"frame.coloring_rule.name",
+	"frame.coloring_rule.string",
+};
+
+/* Columns whose name starts with this are only present if the columns are
+ * being constructed. */
+#define COLUMN_FIELD_PREFIX	"_ws.col."
+
+typedef struct {
+	int		hfid;
+	guint		uses;		/* filters that referred to the field */
+	gboolean	keep_values;	/* FALSE if only occurrences are counted */
+	guint32		recorded;	/* frames 1..recorded are in the column */
+	GArray		*offsets;	/* guint32 per frame, plus one: index of the
+					   frame's first value in values */
+	GPtrArray	*values;	/* fvalue_t copies, in frame order */
+	gsize		size;		/* memory used by the column */
+} field_column_t;
+
+struct field_cache {
+	gsize		budget;
+	gsize		size;
+	GHashTable	*columns;	/* hfid -> field_column_t */
+	guint32		deps_recorded;	/* frames 1..deps_recorded are in dependents */
+	GHashTable	*dependents;	/* frame number -> GSList of frame numbers */
+	guint64		hits;
+	guint64		misses;
+};
+
+static void
+column_reset(field_column_t *col)
+{
+	guint i;
+
+	for (i = 0; i < col->values->len; i++) {
+		fvalue_t *fv = (fvalue_t *)g_ptr_array_index(col->values, i);
+		FVALUE_FREE(fv);
+	}
+	g_ptr_array_set_size(col->values, 0);
+	g_array_set_size(col->offsets, 0);
+	col->recorded = 0;
+	col->size = 0;
+}
+
+static void
+column_free(gpointer data)
+{
+	field_column_t *col = (field_column_t *)data;
+
+	column_reset(col);
+	g_ptr_array_free(col->values, TRUE);
+	g_array_free(col->offsets, TRUE);
+	g_free(col);
+}
+
+static void
+dependents_free(gpointer data)
+{
+	g_slist_free((GSList *)data);
+}
+
+field_cache_t *
+field_cache_new(gsize budget)
+{
+	field_cache_t *fc = g_new0(field_cache_t, 1);
+
+	fc->budget = budget;
+	fc->columns = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, column_free);
+	fc->dependents = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, dependents_free);
+	return fc;
+}
+
+void
+field_cache_free(field_cache_t *fc)
+{
+	if (!fc)
+		return;
+
+	g_hash_table_destroy(fc->columns);
+	g_hash_table_destroy(fc->dependents);
+	g_free(fc);
+}
+
+void
+field_cache_clear(field_cache_t *fc)
+{
+	GHashTableIter	iter;
+	gpointer	value;
+
+	g_hash_table_iter_init(&iter, fc->columns);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		column_reset((field_column_t *)value);
+	}
+	g_hash_table_remove_all(fc->dependents);
+	fc->deps_recorded = 0;
+	fc->size = 0;
+}
+
+static gboolean
+field_is_cacheable(header_field_info *hfinfo)
+{
+	guint i;
+
+	if (strncmp(hfinfo->abbrev, COLUMN_FIELD_PREFIX, strlen(COLUMN_FIELD_PREFIX)) == 0)
+		return FALSE;
+
+	for (i = 0; i < G_N_ELEMENTS(volatile_fields); i++) {
+		if (strcmp(hfinfo->abbrev, volatile_fields[i]) == 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static field_column_t *
+add_column(field_cache_t *fc, header_field_info *hfinfo)
+{
+	field_column_t *col;
+
+	col = (field_column_t *)g_hash_table_lookup(fc->columns, GINT_TO_POINTER(hfinfo->id));
+	if (col)
+		return col;
+
+	col = g_new0(field_column_t, 1);
+	col->hfid = hfinfo->id;
+	/* Protocols and FT_NONE fields have nothing to compare; for those we
+	 * only need to know whether they're present. */
+	switch (hfinfo->type) {
+		case FT_NONE:
+		case FT_PROTOCOL:
+		case FT_PCRE:
+			col->keep_values = FALSE;
+			break;
+
+		default:
+			col->keep_values = TRUE;
+			break;
+	}
+	col->offsets = g_array_new(FALSE, FALSE, sizeof(guint32));
+	col->values = g_ptr_array_new();
+	g_hash_table_insert(fc->columns, GINT_TO_POINTER(hfinfo->id), col);
+	return col;
+}
+
+gboolean
+field_cache_add_field(field_cache_t *fc, const char *field_name)
+{
+	header_field_info *hfinfo;
+
+	hfinfo = proto_registrar_get_byname(field_name);
+	if (!hfinfo || !field_is_cacheable(hfinfo))
+		return FALSE;
+
+	/* Go back to the first field with that name. */
+	while (hfinfo->same_name_prev_id != -1)
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+
+	for (; hfinfo; hfinfo = hfinfo->same_name_next)
+		add_column(fc, hfinfo);
+	return TRUE;
+}
+
+void
+field_cache_note_filter(field_cache_t *fc, const dfilter_t *df)
+{
+	GArray			*hfids;
+	header_field_info	*hfinfo;
+	field_column_t		*col;
+	guint			i;
+
+	hfids = g_array_new(FALSE, FALSE, sizeof(int));
+	dfilter_get_interesting_fields(df, hfids);
+	for (i = 0; i < hfids->len; i++) {
+		hfinfo = proto_registrar_get_nth(g_array_index(hfids, int, i));
+		if (!hfinfo || !field_is_cacheable(hfinfo))
+			continue;
+		col = add_column(fc, hfinfo);
+		col->uses++;
+	}
+	g_array_free(hfids, TRUE);
+}
+
+void
+field_cache_prime_proto_tree(field_cache_t *fc, proto_tree *tree)
+{
+	GHashTableIter	iter;
+	gpointer	key;
+
+	g_hash_table_iter_init(&iter, fc->columns);
+	while (g_hash_table_iter_next(&iter, &key, NULL)) {
+		proto_tree_prime_with_hfid(tree, GPOINTER_TO_INT(key));
+	}
+}
+
+/* Drops the column of the least used field, preferring the biggest one if
+ * several are used equally often. */
+static gboolean
+evict_column(field_cache_t *fc)
+{
+	GHashTableIter	iter;
+	gpointer	value;
+	field_column_t	*col, *victim = NULL;
+
+	g_hash_table_iter_init(&iter, fc->columns);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		col = (field_column_t *)value;
+		if (!victim || col->uses < victim->uses ||
+		    (col->uses == victim->uses && col->size > victim->size))
+			victim = col;
+	}
+	if (!victim)
+		return FALSE;
+
+	fc->size -= victim->size;
+	g_hash_table_remove(fc->columns, GINT_TO_POINTER(victim->hfid));
+	return TRUE;
+}
+
+static void
+record_column(field_cache_t *fc, field_column_t *col, guint32 framenum, proto_tree *tree)
+{
+	GPtrArray	*finfos;
+	field_info	*finfo;
+	fvalue_t	*fv;
+	guint32		offset;
+	guint		i;
+	gsize		size = 0;
+
+	if (col->recorded != framenum - 1)
+		return;
+
+	if (col->offsets->len == 0) {
+		offset = 0;
+		g_array_append_val(col->offsets, offset);
+		size += sizeof(guint32);
+	}
+	offset = g_array_index(col->offsets, guint32, col->offsets->len - 1);
+
+	finfos = proto_get_finfo_ptr_array(tree, col->hfid);
+	if (finfos) {
+		for (i = 0; i < finfos->len; i++) {
+			finfo = (field_info *)g_ptr_array_index(finfos, i);
+			if (col->keep_values) {
+				fv = fvalue_dup(&finfo->value);
+				g_ptr_array_add(col->values, fv);
+				size += sizeof(fvalue_t) + sizeof(gpointer);
+				if (fv->ftype->free_value)
+					size += fvalue_length(fv);
+			}
+			offset++;
+		}
+	}
+	g_array_append_val(col->offsets, offset);
+	size += sizeof(guint32);
+
+	col->recorded = framenum;
+	col->size += size;
+	fc->size += size;
+}
+
+void
+field_cache_record(field_cache_t *fc, guint32 framenum, proto_tree *tree,
+		GSList *dependent_frames)
+{
+	GHashTableIter	iter;
+	gpointer	value;
+
+	if (tree) {
+		g_hash_table_iter_init(&iter, fc->columns);
+		while (g_hash_table_iter_next(&iter, NULL, &value)) {
+			record_column(fc, (field_column_t *)value, framenum, tree);
+		}
+	}
+
+	if (fc->deps_recorded == framenum - 1) {
+		if (dependent_frames) {
+			g_hash_table_insert(fc->dependents, GUINT_TO_POINTER(framenum),
+					g_slist_copy(dependent_frames));
+			fc->size += g_slist_length(dependent_frames) * sizeof(GSList);
+		}
+		fc->deps_recorded = framenum;
+	}
+
+	while (fc->size > fc->budget && evict_column(fc))
+		;
+}
+
+gboolean
+field_cache_lookup(field_cache_t *fc, int hfid, guint32 framenum,
+		fvalue_t ***values, guint *count)
+{
+	field_column_t	*col;
+	guint32		first;
+
+	col = (field_column_t *)g_hash_table_lookup(fc->columns, GINT_TO_POINTER(hfid));
+	if (!col || framenum == 0 || framenum > col->recorded)
+		return FALSE;
+	if (values && !col->keep_values)
+		return FALSE;
+
+	first = g_array_index(col->offsets, guint32, framenum - 1);
+	*count = g_array_index(col->offsets, guint32, framenum) - first;
+	if (values)
+		*values = (fvalue_t **)&g_ptr_array_index(col->values, first);
+	return TRUE;
+}
+
+gboolean
+field_cache_apply_dfilter(field_cache_t *fc, dfilter_t *df, guint32 framenum,
+		gboolean *passed, GSList **dependent_frames)
+{
+	if (framenum > fc->deps_recorded ||
+	    !dfvm_apply_field_cache(df, fc, framenum, passed)) {
+		fc->misses++;
+		return FALSE;
+	}
+
+	fc->hits++;
+	if (dependent_frames)
+		*dependent_frames = (GSList *)g_hash_table_lookup(fc->dependents,
+				GUINT_TO_POINTER(framenum));
+	return TRUE;
+}
+
+void
+field_cache_get_stats(const field_cache_t *fc, field_cache_stats_t *stats)
+{
+	stats->hits = fc->hits;
+	stats->misses = fc->misses;
+	stats->size = fc->size;
+	stats->budget = fc->budget;
+	stats->num_fields = g_hash_table_size(fc->columns);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,124 @@
+/* field-cache.h
+ * Per-frame cache of field values for re-applying display filters
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef FIELD_CACHE_H
+#define FIELD_CACHE_H
+
+#include <glib.h>
+#include "ws_symbol_export.h"
+
+#include <epan/proto.h>
+#include <epan/ftypes/ftypes.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * A field cache keeps, for a set of fields, the values each frame of
+ * a capture file had for them, one column per field.  A display filter
+ * that only refers to cached fields can then be applied to a frame
+ * without reading and dissecting it again.
+ *
+ * Values are recorded from the proto_tree while the frames are being
+ * dissected in order, starting with frame 1, on any pass but the first:
+ * on the first pass a frame's tree lacks the fields that are only known
+ * once later frames have been dissected, such as dns.response_in, so its
+ * values could differ from those of any later dissection.  A field that
+ * is added to the cache later is recorded the next time all the frames
+ * are dissected, which happens anyway when a filter that refers to a
+ * field that isn't cached is applied.
+ *
+ * The memory used by the cache is limited; if recording values would
+ * exceed the budget, the column for the least used field is dropped.
+ */
+typedef struct field_cache field_cache_t;
+
+typedef struct {
+	guint64	hits;		/* frames filtered from the cache */
+	guint64	misses;		/* frames that had to be dissected */
+	gsize	size;		/* memory in use, in bytes */
+	gsize	budget;		/* memory limit, in bytes */
+	guint	num_fields;	/* number of cached fields */
+} field_cache_stats_t;
+
+/* Creates an empty cache that uses at most budget bytes. */
+WS_DLL_PUBLIC
+field_cache_t *
+field_cache_new(gsize budget);
+
+WS_DLL_PUBLIC
+void
+field_cache_free(field_cache_t *fc);
+
+/* Forgets all recorded values but keeps the set of cached fields, e.g.
+ * because the frames are going to be dissected from scratch. */
+WS_DLL_PUBLIC
+void
+field_cache_clear(field_cache_t *fc);
+
+/* Adds a field, and all fields with the same name, to the cache.
+ * Returns FALSE if there's no such field or if its value can depend on
+ * something other than the frame's contents (e.g. frame.marked). */
+WS_DLL_PUBLIC
+gboolean
+field_cache_add_field(field_cache_t *fc, const char *field_name);
+
+/* Notes that a display filter is in use, adding the fields it refers
+ * to to the cache and counting a use of each of them. */
+WS_DLL_PUBLIC
+void
+field_cache_note_filter(field_cache_t *fc, const dfilter_t *df);
+
+/* Primes a proto_tree with the cached fields, so that their values can
+ * be recorded after dissection. */
+WS_DLL_PUBLIC
+void
+field_cache_prime_proto_tree(field_cache_t *fc, proto_tree *tree);
+
+/* Records the cached fields' values for a frame from its proto_tree,
+ * along with the frames it depends on.  Frames must be recorded in
+ * order; a frame that isn't the next one for a column is ignored.
+ * The frame must have been visited before, i.e. this must not be the
+ * first pass over the frames. */
+WS_DLL_PUBLIC
+void
+field_cache_record(field_cache_t *fc, guint32 framenum, proto_tree *tree,
+		GSList *dependent_frames);
+
+/* Looks up the values of a field in a frame.  If values is NULL only the
+ * number of occurrences of the field is returned.  The values belong to
+ * the cache.
+ *
+ * Returns FALSE if the field isn't cached, the frame hasn't been
+ * recorded, or values are wanted and only occurrences are cached. */
+gboolean
+field_cache_lookup(field_cache_t *fc, int hfid, guint32 framenum,
+		fvalue_t ***values, guint *count);
+
+/* Applies a display filter to a frame using only the cache.  Returns
+ * FALSE if the frame has to be dissected instead; otherwise *passed is
+ * set to the result of the filter and, if dependent_frames isn't NULL,
+ * *dependent_frames to the list of frames that frame depends on. */
+WS_DLL_PUBLIC
+gboolean
+field_cache_apply_dfilter(field_cache_t *fc, dfilter_t *df, guint32 framenum,
+		gboolean *passed, GSList **dependent_frames);
+
+WS_DLL_PUBLIC
+void
+field_cache_get_stats(const field_cache_t *fc, field_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* FIELD_CACHE_H */
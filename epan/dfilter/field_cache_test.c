@@ -0,0 +1,323 @@
+/* field_cache_test.c
+ * Checks that filtering with the field cache gives the same results as
+ * filtering freshly dissected frames
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Usage: field_cache_test <capture file> [filter ...]
+ *
+ * Dissects the frames of the capture file twice, as Wireshark does when
+ * it reads a file and then applies a display filter, recording the
+ * values of the fields the filters refer to in a field cache.  Each
+ * frame is then dissected once more, as it would be if it were selected,
+ * and the result of each filter is compared with the one obtained from
+ * the cache.  Fails if they differ, or if the cache couldn't be used.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/frame_data.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
+#include <epan/dfilter/dfilter.h>
+#include <epan/dfilter/field-cache.h>
+
+#include <wsutil/filesystem.h>
+#include <wsutil/privileges.h>
+
+#include <wiretap/wtap.h>
+
+/* Filters on fields that a frame only has once the frames after it have
+ * been dissected, and on ones it has from the start. */
+static const char *default_filters[] = {
+	"dns.response_in",
+	"dns.response_to",
+	"dns.time > 0",
+	"dns.flags.response == 1",
+	"dns.qry.name contains \"a\"",
+	"icmp",
+};
+
+struct packet_provider_data {
+	wtap		*wth;
+	frame_data	*frames;
+	guint32		count;
+	const frame_data *ref;
+	frame_data	*prev_dis;
+	nstime_t	elapsed_time;
+	guint32		cum_bytes;
+};
+
+static const nstime_t *
+get_frame_ts(struct packet_provider_data *prov, guint32 frame_num)
+{
+	if (frame_num == 0 || frame_num > prov->count)
+		return NULL;
+	return &prov->frames[frame_num - 1].abs_ts;
+}
+
+static gboolean
+read_frames(struct packet_provider_data *prov)
+{
+	GArray		*frames;
+	wtap_rec	rec;
+	Buffer		buf;
+	frame_data	fd;
+	gint64		offset;
+	int		err;
+	gchar		*err_info = NULL;
+	guint32		cum_bytes = 0;
+
+	frames = g_array_new(FALSE, FALSE, sizeof(frame_data));
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	while (wtap_read(prov->wth, &rec, &buf, &err, &err_info, &offset)) {
+		frame_data_init(&fd, frames->len + 1, &rec, offset, cum_bytes);
+		cum_bytes += fd.pkt_len;
+		g_array_append_val(frames, fd);
+	}
+	wtap_rec_cleanup(&rec);
+	ws_buffer_free(&buf);
+
+	prov->count = frames->len;
+	prov->frames = (frame_data *)g_array_free(frames, FALSE);
+	if (err != 0) {
+		fprintf(stderr, "field_cache_test: %s%s%s\n", wtap_strerror(err),
+			err_info ? ": " : "", err_info ? err_info : "");
+		g_free(err_info);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* Dissects a frame with its tree primed with the filters and, if fc isn't
+ * NULL, with the cached fields. */
+static gboolean
+dissect_frame(struct packet_provider_data *prov, epan_dissect_t *edt,
+		frame_data *fd, dfilter_t **dfs, int num_filters,
+		field_cache_t *fc, wtap_rec *rec, Buffer *buf)
+{
+	int	err;
+	gchar	*err_info = NULL;
+	int	i;
+
+	if (!wtap_seek_read(prov->wth, fd->file_off, rec, buf, &err, &err_info)) {
+		fprintf(stderr, "field_cache_test: frame %u: %s\n", fd->num,
+			wtap_strerror(err));
+		g_free(err_info);
+		return FALSE;
+	}
+
+	for (i = 0; i < num_filters; i++)
+		epan_dissect_prime_with_dfilter(edt, dfs[i]);
+	if (fc)
+		field_cache_prime_proto_tree(fc, edt->tree);
+
+	frame_data_set_before_dissect(fd, &prov->elapsed_time, &prov->ref,
+			prov->prev_dis);
+	epan_dissect_run(edt, wtap_file_type_subtype(prov->wth), rec,
+			tvb_new_real_data(ws_buffer_start_ptr(buf), fd->cap_len,
+				fd->pkt_len),
+			fd, NULL);
+	frame_data_set_after_dissect(fd, &prov->cum_bytes);
+	prov->prev_dis = fd;
+	return TRUE;
+}
+
+/* Dissects all the frames in order, recording them in fc if it isn't
+ * NULL. */
+static gboolean
+dissect_frames(struct packet_provider_data *prov, epan_t *session,
+		dfilter_t **dfs, int num_filters, field_cache_t *fc)
+{
+	epan_dissect_t	*edt;
+	wtap_rec	rec;
+	Buffer		buf;
+	guint32		i;
+	gboolean	ok = TRUE;
+
+	prov->ref = NULL;
+	prov->prev_dis = NULL;
+	prov->cum_bytes = 0;
+
+	edt = epan_dissect_new(session, TRUE, FALSE);
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	for (i = 0; i < prov->count && ok; i++) {
+		ok = dissect_frame(prov, edt, &prov->frames[i], dfs, num_filters,
+				fc, &rec, &buf);
+		if (ok && fc)
+			field_cache_record(fc, i + 1, edt->tree,
+					edt->pi.dependent_frames);
+		epan_dissect_reset(edt);
+	}
+	wtap_rec_cleanup(&rec);
+	ws_buffer_free(&buf);
+	epan_dissect_free(edt);
+	return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct packet_provider_funcs funcs = {
+		get_frame_ts,
+		NULL,
+		NULL,
+		NULL,
+	};
+	char		*init_progfile_dir_error;
+	const char	**filters = default_filters;
+	int		num_filters = G_N_ELEMENTS(default_filters);
+	struct packet_provider_data prov;
+	epan_t		*session;
+	field_cache_t	*fc;
+	dfilter_t	**dfs;
+	guint		*num_passed;
+	gchar		*err_msg;
+	int		err;
+	gchar		*err_info = NULL;
+	epan_dissect_t	*edt;
+	wtap_rec	rec;
+	Buffer		buf;
+	gboolean	passed, cached_passed;
+	guint32		framenum;
+	int		i;
+	int		failed = 0;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: field_cache_test <capture file> [filter ...]\n");
+		return 1;
+	}
+	if (argc > 2) {
+		filters = (const char **)&argv[2];
+		num_filters = argc - 2;
+	}
+
+	init_process_policies();
+	init_progfile_dir_error = init_progfile_dir(argv[0]);
+	if (init_progfile_dir_error != NULL) {
+		fprintf(stderr, "field_cache_test: Can't get pathname of directory containing the field_cache_test program: %s.\n",
+			init_progfile_dir_error);
+		g_free(init_progfile_dir_error);
+	}
+
+	wtap_init(TRUE);
+	if (!epan_init(NULL, NULL, FALSE))
+		return 2;
+
+	memset(&prov, 0, sizeof prov);
+	prov.wth = wtap_open_offline(argv[1], WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+	if (!prov.wth) {
+		fprintf(stderr, "field_cache_test: %s: %s\n", argv[1], wtap_strerror(err));
+		g_free(err_info);
+		return 2;
+	}
+	if (!read_frames(&prov))
+		return 2;
+
+	dfs = g_new0(dfilter_t *, num_filters);
+	num_passed = g_new0(guint, num_filters);
+	for (i = 0; i < num_filters; i++) {
+		if (!dfilter_compile(filters[i], &dfs[i], &err_msg) || !dfs[i]) {
+			fprintf(stderr, "field_cache_test: %s: %s\n", filters[i],
+				err_msg ? err_msg : "empty filter");
+			g_free(err_msg);
+			return 2;
+		}
+	}
+
+	fc = field_cache_new(64 * 1024 * 1024);
+	for (i = 0; i < num_filters; i++)
+		field_cache_note_filter(fc, dfs[i]);
+
+	/* The first pass, when the file is read, and the second one, when a
+	 * filter is applied; file.c only records the latter. */
+	session = epan_new(&prov, &funcs);
+	if (!dissect_frames(&prov, session, dfs, num_filters, NULL) ||
+	    !dissect_frames(&prov, session, dfs, num_filters, fc))
+		return 2;
+
+	edt = epan_dissect_new(session, TRUE, FALSE);
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	prov.ref = NULL;
+	prov.prev_dis = NULL;
+	prov.cum_bytes = 0;
+	for (framenum = 1; framenum <= prov.count; framenum++) {
+		if (!dissect_frame(&prov, edt, &prov.frames[framenum - 1], dfs,
+				num_filters, NULL, &rec, &buf))
+			return 2;
+
+		for (i = 0; i < num_filters; i++) {
+			passed = dfilter_apply_edt(dfs[i], edt);
+			if (passed)
+				num_passed[i]++;
+			if (!field_cache_apply_dfilter(fc, dfs[i], framenum,
+					&cached_passed, NULL)) {
+				printf("frame %u: \"%s\" couldn't be applied from the cache\n",
+					framenum, filters[i]);
+				failed++;
+			} else if (cached_passed != passed) {
+				printf("frame %u: \"%s\" %s, but %s from the cache\n",
+					framenum, filters[i],
+					passed ? "passed" : "failed",
+					cached_passed ? "passed" : "failed");
+				failed++;
+			}
+		}
+		epan_dissect_reset(edt);
+	}
+	wtap_rec_cleanup(&rec);
+	ws_buffer_free(&buf);
+	epan_dissect_free(edt);
+
+	for (i = 0; i < num_filters; i++)
+		printf("%6u of %u frames  %s\n", num_passed[i], prov.count, filters[i]);
+
+	for (framenum = 0; framenum < prov.count; framenum++)
+		frame_data_destroy(&prov.frames[framenum]);
+	g_free(prov.frames);
+	epan_free(session);
+	field_cache_free(fc);
+	for (i = 0; i < num_filters; i++)
+		dfilter_free(dfs[i]);
+	g_free(dfs);
+	g_free(num_passed);
+	wtap_close(prov.wth);
+	epan_cleanup();
+	wtap_cleanup();
+
+	if (failed) {
+		printf("%d mismatches\n", failed);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
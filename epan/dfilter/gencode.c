@@ -40,6 +40,19 @@ dfw_append_const(dfwork_t *dfw, dfvm_insn_t *insn)
 	g_ptr_array_add(dfw->consts, insn);
 }
 
+/* Records the FIELD_ID of a field, and of all fields with the same name,
+ * in the hash of interesting fields. */
+static void
+dfw_add_interesting_fields(dfwork_t *dfw, header_field_info *hfinfo)
+{
+	while (hfinfo) {
+		g_hash_table_insert(dfw->interesting_fields,
+		    GINT_TO_POINTER(hfinfo->id),
+		    GUINT_TO_POINTER(TRUE));
+		hfinfo = hfinfo->same_name_next;
+	}
+}
+
 /* returns register number */
 static int
 dfw_append_read_tree(dfwork_t *dfw, header_field_info *hfinfo)
@@ -85,13 +98,7 @@ dfw_append_read_tree(dfwork_t *dfw, header_field_info *hfinfo)
 	dfw_append_insn(dfw, insn);
 
 	if (added_new_hfinfo) {
-		while (hfinfo) {
-			/* Record the FIELD_ID in hash of interesting fields. */
-			g_hash_table_insert(dfw->interesting_fields,
-			    GINT_TO_POINTER(hfinfo->id),
-			    GUINT_TO_POINTER(TRUE));
-			hfinfo = hfinfo->same_name_next;
-		}
+		dfw_add_interesting_fields(dfw, hfinfo);
 	}
 
 	return reg;
@@ -372,6 +379,693 @@ gen_relation_in(dfwork_t *dfw, stnode_t *st_arg1, stnode_t *st_arg2)
 	set_nodelist_free(nodelist_head);
 }
 
+/*
+ * Relations between a field, or a slice of one, and constants are done
+ * with a FIELD_*_TEST instruction when the field's values can be compared
+ * without going through the ftype functions.  The constants are folded
+ * into the instruction, and the tests of relations on the same field that
+ * are OR-ed together are merged, so that the field is only looked up once.
+ */
+
+/* Gets the FIELD_*_TEST instruction that compares values of a type,
+ * or a slice of them.  Returns FALSE if there's none. */
+static gboolean
+field_test_opcode(ftenum_t ftype, gboolean sliced, dfvm_opcode_t *p_op)
+{
+	if (sliced) {
+		switch (ftype) {
+			case FT_PROTOCOL:
+			case FT_BYTES:
+			case FT_UINT_BYTES:
+			case FT_AX25:
+			case FT_VINES:
+			case FT_ETHER:
+			case FT_OID:
+			case FT_REL_OID:
+			case FT_SYSTEM_ID:
+			case FT_FCWWN:
+				*p_op = FIELD_SLICE_TEST;
+				return TRUE;
+			default:
+				return FALSE;
+		}
+	}
+
+	if (IS_FT_UINT32(ftype) || ftype == FT_IPXNET) {
+		*p_op = FIELD_UINT_TEST;
+		return TRUE;
+	}
+	if (IS_FT_INT32(ftype)) {
+		*p_op = FIELD_SINT_TEST;
+		return TRUE;
+	}
+	if (ftype == FT_IPv4) {
+		*p_op = FIELD_IPV4_TEST;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/* Gets the comparison done by a relation; if the constant is on the left
+ * side, the comparison is mirrored so that the field is on the left. */
+static dfvm_opcode_t
+relation_opcode(test_op_t st_op, gboolean swapped)
+{
+	switch (st_op) {
+		case TEST_OP_EQ:
+			return ANY_EQ;
+		case TEST_OP_NE:
+			return ANY_NE;
+		case TEST_OP_GT:
+			return swapped ? ANY_LT : ANY_GT;
+		case TEST_OP_GE:
+			return swapped ? ANY_LE : ANY_GE;
+		case TEST_OP_LT:
+			return swapped ? ANY_GT : ANY_LT;
+		case TEST_OP_LE:
+			return swapped ? ANY_GE : ANY_LE;
+		case TEST_OP_BITWISE_AND:
+			return ANY_BITWISE_AND;
+		case TEST_OP_CONTAINS:
+			return ANY_CONTAINS;
+		case TEST_OP_MATCHES:
+			return ANY_MATCHES;
+		default:
+			g_assert_not_reached();
+			return RETURN;
+	}
+}
+
+static void
+field_tests_free(dfvm_opcode_t insn_op, GArray *tests)
+{
+	guint	i;
+
+	if (insn_op == FIELD_SLICE_TEST) {
+		for (i = 0; i < tests->len; i++) {
+			g_byte_array_free(g_array_index(tests,
+					dfvm_slice_test_t, i).bytes, TRUE);
+		}
+	}
+	g_array_free(tests, TRUE);
+}
+
+static void
+set_immediate(dfvm_opcode_t insn_op, fvalue_t *fv, dfvm_immediate_t *imm)
+{
+	switch (insn_op) {
+		case FIELD_UINT_TEST:
+			imm->uinteger = fvalue_get_uinteger(fv);
+			break;
+		case FIELD_SINT_TEST:
+			imm->sinteger = fvalue_get_sinteger(fv);
+			break;
+		case FIELD_IPV4_TEST:
+			imm->ipv4 = fv->value.ipv4;
+			break;
+		default:
+			g_assert_not_reached();
+			break;
+	}
+}
+
+/* Adds the test of a value against a constant, or against a range of
+ * constants if st_high isn't NULL.  Returns FALSE if the constant doesn't
+ * suit the instruction. */
+static gboolean
+add_field_test(GArray *tests, dfvm_opcode_t insn_op, dfvm_opcode_t op,
+		stnode_t *st_low, stnode_t *st_high, drange_node *rn)
+{
+	dfvm_field_test_t	test;
+	dfvm_slice_test_t	slice;
+	fvalue_t		*fv;
+	GByteArray		*bytes;
+	dfvm_opcode_t		const_op;
+
+	if (stnode_type_id(st_low) != STTYPE_FVALUE) {
+		return FALSE;
+	}
+	fv = (fvalue_t *)stnode_data(st_low);
+
+	if (insn_op == FIELD_SLICE_TEST) {
+		if ((op != ANY_EQ && op != ANY_NE) || st_high != NULL ||
+		    fvalue_type_ftenum(fv) != FT_BYTES) {
+			return FALSE;
+		}
+		bytes = (GByteArray *)fvalue_get(fv);
+		if (bytes->len != (guint)drange_node_get_length(rn)) {
+			return FALSE;
+		}
+		slice.op = op;
+		slice.offset = drange_node_get_start_offset(rn);
+		slice.bytes = g_byte_array_sized_new(bytes->len);
+		g_byte_array_append(slice.bytes, bytes->data, bytes->len);
+		g_array_append_val(tests, slice);
+		return TRUE;
+	}
+
+	if (!field_test_opcode(fvalue_type_ftenum(fv), FALSE, &const_op) ||
+	    const_op != insn_op) {
+		return FALSE;
+	}
+	test.op = op;
+	set_immediate(insn_op, fv, &test.value);
+	test.high = test.value;
+	if (st_high) {
+		if (stnode_type_id(st_high) != STTYPE_FVALUE) {
+			return FALSE;
+		}
+		fv = (fvalue_t *)stnode_data(st_high);
+		if (!field_test_opcode(fvalue_type_ftenum(fv), FALSE, &const_op) ||
+		    const_op != insn_op) {
+			return FALSE;
+		}
+		set_immediate(insn_op, fv, &test.high);
+	}
+	g_array_append_val(tests, test);
+	return TRUE;
+}
+
+/* If a relation can be done with a FIELD_*_TEST instruction, returns the
+ * instruction's tests, sets *p_op to the instruction and *p_hfinfo to the
+ * first field with the name of the field that is tested.  Otherwise
+ * returns NULL.  The syntax tree is left untouched. */
+static GArray *
+field_tests_new(stnode_t *st_node, dfvm_opcode_t *p_op,
+		header_field_info **p_hfinfo)
+{
+	test_op_t		st_op;
+	stnode_t		*st_arg1, *st_arg2, *entity, *constant;
+	header_field_info	*hfinfo, *hfinfo_same;
+	drange_t		*dr;
+	drange_node		*rn = NULL;
+	dfvm_opcode_t		insn_op, same_op;
+	gboolean		swapped = FALSE;
+	GSList			*nodelist;
+	GArray			*tests;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST) {
+		return NULL;
+	}
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_EQ:
+		case TEST_OP_NE:
+		case TEST_OP_GT:
+		case TEST_OP_GE:
+		case TEST_OP_LT:
+		case TEST_OP_LE:
+		case TEST_OP_BITWISE_AND:
+		case TEST_OP_IN:
+			break;
+		default:
+			return NULL;
+	}
+
+	entity = st_arg1;
+	constant = st_arg2;
+	if (st_op != TEST_OP_IN && stnode_type_id(st_arg1) == STTYPE_FVALUE) {
+		entity = st_arg2;
+		constant = st_arg1;
+		swapped = TRUE;
+	}
+
+	/* Only slices with a single start:length range are handled. */
+	if (stnode_type_id(entity) == STTYPE_RANGE) {
+		dr = sttype_range_drange(entity);
+		if (dr == NULL || g_slist_length(dr->range_list) != 1) {
+			return NULL;
+		}
+		rn = (drange_node *)dr->range_list->data;
+		if (drange_node_get_ending(rn) != DRANGE_NODE_END_T_LENGTH ||
+		    drange_node_get_length(rn) <= 0) {
+			return NULL;
+		}
+		entity = sttype_range_entity(entity);
+	}
+	if (stnode_type_id(entity) != STTYPE_FIELD) {
+		return NULL;
+	}
+
+	/* All the fields with that name must have values of the same kind. */
+	hfinfo = (header_field_info *)stnode_data(entity);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	if (!field_test_opcode(hfinfo->type, rn != NULL, &insn_op)) {
+		return NULL;
+	}
+	for (hfinfo_same = hfinfo->same_name_next; hfinfo_same;
+	    hfinfo_same = hfinfo_same->same_name_next) {
+		if (!field_test_opcode(hfinfo_same->type, rn != NULL, &same_op) ||
+		    same_op != insn_op) {
+			return NULL;
+		}
+	}
+
+	tests = g_array_new(FALSE, FALSE, insn_op == FIELD_SLICE_TEST ?
+			sizeof(dfvm_slice_test_t) : sizeof(dfvm_field_test_t));
+
+	if (st_op == TEST_OP_IN) {
+		for (nodelist = (GSList *)stnode_data(constant); nodelist;
+		    nodelist = g_slist_next(g_slist_next(nodelist))) {
+			stnode_t *low = (stnode_t *)nodelist->data;
+			stnode_t *high = (stnode_t *)nodelist->next->data;
+
+			if (!add_field_test(tests, insn_op,
+					high ? ANY_IN_RANGE : ANY_EQ,
+					low, high, rn)) {
+				field_tests_free(insn_op, tests);
+				return NULL;
+			}
+		}
+	}
+	else if (!add_field_test(tests, insn_op, relation_opcode(st_op, swapped),
+				constant, NULL, rn)) {
+		field_tests_free(insn_op, tests);
+		return NULL;
+	}
+
+	*p_op = insn_op;
+	*p_hfinfo = hfinfo;
+	return tests;
+}
+
+/* If a FIELD_UINT_TEST, FIELD_SINT_TEST or FIELD_IPV4_TEST instruction
+ * has many ANY_EQ tests, moves them to the end and puts their constants
+ * in a value set. */
+static void
+index_field_tests(dfvm_insn_t *insn)
+{
+	GArray			*tests = insn->arg2->value.tests;
+	GArray			*sorted;
+	dfvm_field_test_t	*test;
+	value_set_t		*set;
+	value_set_key_t		key;
+	guint8			buf[4];
+	guint			i, num_eq = 0;
+	dfvm_value_t		*val3, *val4;
+
+	if (insn->op == FIELD_SLICE_TEST) {
+		return;
+	}
+	for (i = 0; i < tests->len; i++) {
+		if (g_array_index(tests, dfvm_field_test_t, i).op == ANY_EQ) {
+			num_eq++;
+		}
+	}
+	if (num_eq < VALUE_SET_MIN_SIZE) {
+		return;
+	}
+
+	sorted = g_array_sized_new(FALSE, FALSE, sizeof(dfvm_field_test_t), tests->len);
+	for (i = 0; i < tests->len; i++) {
+		test = &g_array_index(tests, dfvm_field_test_t, i);
+		if (test->op != ANY_EQ) {
+			g_array_append_val(sorted, *test);
+		}
+	}
+	set = value_set_new();
+	for (i = 0; i < tests->len; i++) {
+		test = &g_array_index(tests, dfvm_field_test_t, i);
+		if (test->op == ANY_EQ) {
+			g_array_append_val(sorted, *test);
+			dfvm_immediate_key(insn->op, &test->value, buf, &key);
+			value_set_add(set, &key);
+		}
+	}
+	g_array_free(tests, TRUE);
+	insn->arg2->value.tests = sorted;
+
+	val3 = dfvm_value_new(VALUE_SET);
+	val3->value.set = set;
+	val4 = dfvm_value_new(INTEGER);
+	val4->value.numeric = sorted->len - num_eq;
+	insn->arg3 = val3;
+	insn->arg4 = val4;
+}
+
+static void
+dfw_append_field_test(dfwork_t *dfw, dfvm_opcode_t op,
+		header_field_info *hfinfo, GArray *tests)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val2;
+
+	insn = dfvm_insn_new(op);
+	val1 = dfvm_value_new(HFINFO);
+	val1->value.hfinfo = hfinfo;
+	val2 = dfvm_value_new(op == FIELD_SLICE_TEST ? SLICE_TESTS : FIELD_TESTS);
+	val2->value.tests = tests;
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	index_field_tests(insn);
+	dfw_append_insn(dfw, insn);
+
+	dfw_add_interesting_fields(dfw, hfinfo);
+}
+
+/* Generates a FIELD_*_TEST instruction for a relation, if it can be done
+ * with one. */
+static gboolean
+gen_field_test(dfwork_t *dfw, stnode_t *st_node)
+{
+	GArray			*tests;
+	dfvm_opcode_t		op;
+	header_field_info	*hfinfo;
+
+	tests = field_tests_new(st_node, &op, &hfinfo);
+	if (tests == NULL) {
+		return FALSE;
+	}
+	dfw_append_field_test(dfw, op, hfinfo, tests);
+	return TRUE;
+}
+
+/* Gets the kind of value set keys that the values of a field, and of all
+ * the fields with the same name, are turned into. */
+static value_set_kind_t
+field_set_kind(header_field_info *hfinfo)
+{
+	value_set_kind_t	kind = value_set_kind(hfinfo->type);
+	header_field_info	*hfinfo_same;
+
+	for (hfinfo_same = hfinfo->same_name_next; hfinfo_same;
+	    hfinfo_same = hfinfo_same->same_name_next) {
+		if (value_set_kind(hfinfo_same->type) != kind) {
+			return VALUE_SET_NONE;
+		}
+	}
+	return kind;
+}
+
+static void
+dfw_append_field_set(dfwork_t *dfw, dfvm_opcode_t op,
+		header_field_info *hfinfo, dfvm_value_t *val2, GPtrArray *fvalues)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *val3;
+
+	insn = dfvm_insn_new(op);
+	val1 = dfvm_value_new(HFINFO);
+	val1->value.hfinfo = hfinfo;
+	val3 = dfvm_value_new(FVALUES);
+	val3->value.fvalues = fvalues;
+	insn->arg1 = val1;
+	insn->arg2 = val2;
+	insn->arg3 = val3;
+	dfw_append_insn(dfw, insn);
+
+	dfw_add_interesting_fields(dfw, hfinfo);
+}
+
+/* Generates a FIELD_SET_TEST instruction for "field in {...}" if the set
+ * is large and only has constants that can be hashed. */
+static gboolean
+gen_field_set_test(dfwork_t *dfw, stnode_t *st_node)
+{
+	test_op_t		st_op;
+	stnode_t		*st_arg1, *st_arg2, *low;
+	header_field_info	*hfinfo;
+	value_set_kind_t	kind;
+	GSList			*nodelist;
+	GPtrArray		*fvalues;
+	value_set_t		*set;
+	value_set_key_t		key;
+	fvalue_t		*fv;
+	dfvm_value_t		*val2;
+	guint			count = 0;
+
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD) {
+		return FALSE;
+	}
+	hfinfo = (header_field_info *)stnode_data(st_arg1);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	kind = field_set_kind(hfinfo);
+	if (kind == VALUE_SET_NONE) {
+		return FALSE;
+	}
+
+	for (nodelist = (GSList *)stnode_data(st_arg2); nodelist;
+	    nodelist = g_slist_next(g_slist_next(nodelist))) {
+		low = (stnode_t *)nodelist->data;
+		if (nodelist->next->data != NULL ||
+		    stnode_type_id(low) != STTYPE_FVALUE ||
+		    value_set_kind(fvalue_type_ftenum((fvalue_t *)stnode_data(low))) != kind) {
+			return FALSE;
+		}
+		count++;
+	}
+	if (count < VALUE_SET_MIN_SIZE) {
+		return FALSE;
+	}
+
+	set = value_set_new();
+	fvalues = g_ptr_array_sized_new(count);
+	for (nodelist = (GSList *)stnode_data(st_arg2); nodelist;
+	    nodelist = g_slist_next(g_slist_next(nodelist))) {
+		fv = fvalue_dup((fvalue_t *)stnode_data((stnode_t *)nodelist->data));
+		value_set_key_from_fvalue(fv, &key);
+		value_set_add(set, &key);
+		g_ptr_array_add(fvalues, fv);
+	}
+
+	val2 = dfvm_value_new(VALUE_SET);
+	val2->value.set = set;
+	dfw_append_field_set(dfw, FIELD_SET_TEST, hfinfo, val2, fvalues);
+	return TRUE;
+}
+
+/* Generates a FIELD_CONTAINS_TEST instruction for "contains" relations
+ * between the same field and constants that are OR-ed together, if they
+ * are all "contains" relations on strings or bytes. */
+static gboolean
+gen_field_contains_test(dfwork_t *dfw, header_field_info *hfinfo,
+		stnode_t **relations, guint count)
+{
+	test_op_t		st_op;
+	stnode_t		*st_arg1, *st_arg2;
+	value_set_kind_t	kind;
+	GPtrArray		*fvalues;
+	pattern_set_t		*patterns;
+	value_set_key_t		key;
+	fvalue_t		*fv;
+	dfvm_value_t		*val2;
+	guint			i;
+
+	if (count < PATTERN_SET_MIN_SIZE) {
+		return FALSE;
+	}
+	kind = field_set_kind(hfinfo);
+	if (kind != VALUE_SET_STRING && kind != VALUE_SET_BYTES) {
+		return FALSE;
+	}
+	for (i = 0; i < count; i++) {
+		sttype_test_get(relations[i], &st_op, &st_arg1, &st_arg2);
+		fv = (fvalue_t *)stnode_data(st_arg2);
+		if (st_op != TEST_OP_CONTAINS ||
+		    value_set_kind(fvalue_type_ftenum(fv)) != kind) {
+			return FALSE;
+		}
+		/* An empty string is in no string, and empty bytes are in
+		 * all bytes; leave that to the ftype functions. */
+		value_set_key_from_fvalue(fv, &key);
+		if (key.len == 0) {
+			return FALSE;
+		}
+	}
+
+	patterns = pattern_set_new();
+	fvalues = g_ptr_array_sized_new(count);
+	for (i = 0; i < count; i++) {
+		sttype_test_get(relations[i], &st_op, &st_arg1, &st_arg2);
+		fv = fvalue_dup((fvalue_t *)stnode_data(st_arg2));
+		value_set_key_from_fvalue(fv, &key);
+		pattern_set_add(patterns, key.data, key.len);
+		g_ptr_array_add(fvalues, fv);
+	}
+	pattern_set_compile(patterns);
+
+	val2 = dfvm_value_new(PATTERN_SET);
+	val2->value.patterns = patterns;
+	dfw_append_field_set(dfw, FIELD_CONTAINS_TEST, hfinfo, val2, fvalues);
+	return TRUE;
+}
+
+/* If a relation compares a field with a constant, returns the first field
+ * with the name of that field. */
+static header_field_info *
+relation_field(stnode_t *st_node)
+{
+	test_op_t		st_op;
+	stnode_t		*st_arg1, *st_arg2;
+	header_field_info	*hfinfo;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST) {
+		return NULL;
+	}
+	sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+
+	switch (st_op) {
+		case TEST_OP_EQ:
+		case TEST_OP_NE:
+		case TEST_OP_GT:
+		case TEST_OP_GE:
+		case TEST_OP_LT:
+		case TEST_OP_LE:
+		case TEST_OP_BITWISE_AND:
+		case TEST_OP_CONTAINS:
+		case TEST_OP_MATCHES:
+			break;
+		default:
+			return NULL;
+	}
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD ||
+	    stnode_type_id(st_arg2) != STTYPE_FVALUE) {
+		return NULL;
+	}
+
+	hfinfo = (header_field_info *)stnode_data(st_arg1);
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	return hfinfo;
+}
+
+/* Generates the code for relations between the same field and constants
+ * that are OR-ed together, like gen_relation_in() does: the field is read
+ * and checked for once, and the first matching relation ends the "or". */
+static void
+gen_relations_or(dfwork_t *dfw, header_field_info *hfinfo,
+		stnode_t **relations, guint count, GSList **p_jumplist)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*val1, *jmp;
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	int		reg1, reg2;
+	guint		i;
+
+	reg1 = dfw_append_read_tree(dfw, hfinfo);
+
+	insn = dfvm_insn_new(IF_FALSE_GOTO);
+	jmp = dfvm_value_new(INSN_NUMBER);
+	insn->arg1 = jmp;
+	dfw_append_insn(dfw, insn);
+
+	for (i = 0; i < count; i++) {
+		sttype_test_get(relations[i], &st_op, &st_arg1, &st_arg2);
+		reg2 = dfw_append_put_fvalue(dfw, (fvalue_t *)stnode_steal_data(st_arg2));
+		gen_relation_regs(dfw, relation_opcode(st_op, FALSE), reg1, reg2);
+
+		if (i + 1 < count) {
+			insn = dfvm_insn_new(IF_TRUE_GOTO);
+			val1 = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = val1;
+			dfw_append_insn(dfw, insn);
+			*p_jumplist = g_slist_prepend(*p_jumplist, val1);
+		}
+	}
+
+	/* Jump here if the field is not present */
+	jmp->value.numeric = dfw->next_insn_id;
+}
+
+static void
+get_or_operands(stnode_t *st_node, GPtrArray *operands)
+{
+	test_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST) {
+		sttype_test_get(st_node, &st_op, &st_arg1, &st_arg2);
+		if (st_op == TEST_OP_OR) {
+			get_or_operands(st_arg1, operands);
+			get_or_operands(st_arg2, operands);
+			return;
+		}
+	}
+	g_ptr_array_add(operands, st_node);
+}
+
+/* Generate the code for a chain of "or"s.  Adjacent operands that test the
+ * same field are done together. */
+static void
+gen_or(dfwork_t *dfw, stnode_t *st_node)
+{
+	GPtrArray		*operands;
+	stnode_t		*operand;
+	GArray			*tests, *more_tests;
+	dfvm_opcode_t		op, more_op;
+	header_field_info	*hfinfo, *more_hfinfo;
+	dfvm_insn_t		*insn;
+	dfvm_value_t		*val1;
+	GSList			*jumplist = NULL;
+	guint			i, j;
+
+	operands = g_ptr_array_new();
+	get_or_operands(st_node, operands);
+
+	for (i = 0; i < operands->len; i = j) {
+		operand = (stnode_t *)g_ptr_array_index(operands, i);
+
+		if ((tests = field_tests_new(operand, &op, &hfinfo)) != NULL) {
+			for (j = i + 1; j < operands->len; j++) {
+				more_tests = field_tests_new((stnode_t *)g_ptr_array_index(operands, j),
+						&more_op, &more_hfinfo);
+				if (more_tests == NULL) {
+					break;
+				}
+				if (more_op != op || more_hfinfo != hfinfo) {
+					field_tests_free(more_op, more_tests);
+					break;
+				}
+				g_array_append_vals(tests, more_tests->data, more_tests->len);
+				g_array_free(more_tests, TRUE);
+			}
+			dfw_append_field_test(dfw, op, hfinfo, tests);
+		}
+		else if ((hfinfo = relation_field(operand)) != NULL) {
+			for (j = i + 1; j < operands->len; j++) {
+				if (relation_field((stnode_t *)g_ptr_array_index(operands, j)) != hfinfo) {
+					break;
+				}
+			}
+			if (j - i == 1) {
+				gencode(dfw, operand);
+			}
+			else if (!gen_field_contains_test(dfw, hfinfo,
+					(stnode_t **)&g_ptr_array_index(operands, i),
+					j - i)) {
+				gen_relations_or(dfw, hfinfo,
+						(stnode_t **)&g_ptr_array_index(operands, i),
+						j - i, &jumplist);
+			}
+		}
+		else {
+			gencode(dfw, operand);
+			j = i + 1;
+		}
+
+		/* Exit as soon as an operand is true */
+		if (j < operands->len) {
+			insn = dfvm_insn_new(IF_TRUE_GOTO);
+			val1 = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = val1;
+			dfw_append_insn(dfw, insn);
+			jumplist = g_slist_prepend(jumplist, val1);
+		}
+	}
+
+	g_slist_foreach(jumplist, fixup_jumps, dfw);
+	g_slist_free(jumplist);
+	g_ptr_array_free(operands, TRUE);
+}
+
 /* Parse an entity, returning the reg that it gets put into.
  * p_jmp will be set if it has to be set by the calling code; it should
  * be set to the place to jump to, to return to the calling code,
@@ -442,17 +1136,22 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			insn->arg1 = val1;
 			dfw_append_insn(dfw, insn);
 
-			/* Record the FIELD_ID in hash of interesting fields. */
-			while (hfinfo) {
-				g_hash_table_insert(dfw->interesting_fields,
-					GINT_TO_POINTER(hfinfo->id),
-					GUINT_TO_POINTER(TRUE));
-				hfinfo = hfinfo->same_name_next;
-			}
+			dfw_add_interesting_fields(dfw, hfinfo);
 
 			break;
 
 		case TEST_OP_NOT:
+			/* Fold "not not x" into "x". */
+			if (stnode_type_id(st_arg1) == STTYPE_TEST) {
+				test_op_t	inner_op;
+				stnode_t	*inner_arg1, *inner_arg2;
+
+				sttype_test_get(st_arg1, &inner_op, &inner_arg1, &inner_arg2);
+				if (inner_op == TEST_OP_NOT) {
+					gencode(dfw, inner_arg1);
+					break;
+				}
+			}
 			gencode(dfw, st_arg1);
 			insn = dfvm_insn_new(NOT);
 			dfw_append_insn(dfw, insn);
@@ -471,43 +1170,42 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_OR:
-			gencode(dfw, st_arg1);
-
-			insn = dfvm_insn_new(IF_TRUE_GOTO);
-			val1 = dfvm_value_new(INSN_NUMBER);
-			insn->arg1 = val1;
-			dfw_append_insn(dfw, insn);
-
-			gencode(dfw, st_arg2);
-			val1->value.numeric = dfw->next_insn_id;
+			gen_or(dfw, st_node);
 			break;
 
 		case TEST_OP_EQ:
-			gen_relation(dfw, ANY_EQ, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_EQ, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_NE:
-			gen_relation(dfw, ANY_NE, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_NE, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_GT:
-			gen_relation(dfw, ANY_GT, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_GT, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_GE:
-			gen_relation(dfw, ANY_GE, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_GE, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_LT:
-			gen_relation(dfw, ANY_LT, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_LT, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_LE:
-			gen_relation(dfw, ANY_LE, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_LE, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_BITWISE_AND:
-			gen_relation(dfw, ANY_BITWISE_AND, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node))
+				gen_relation(dfw, ANY_BITWISE_AND, st_arg1, st_arg2);
 			break;
 
 		case TEST_OP_CONTAINS:
@@ -519,7 +1217,9 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case TEST_OP_IN:
-			gen_relation_in(dfw, st_arg1, st_arg2);
+			if (!gen_field_test(dfw, st_node) &&
+			    !gen_field_set_test(dfw, st_node))
+				gen_relation_in(dfw, st_arg1, st_arg2);
 			break;
 	}
 }
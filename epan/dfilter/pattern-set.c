@@ -0,0 +1,169 @@
+/* pattern-set.c
+ * Searching for any of several byte strings at once, for the display
+ * filter "contains" operator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "pattern-set.h"
+
+/* Node 0 is the root; 0 is also used for "no node", as the root is
+ * nobody's child. */
+typedef struct {
+	guint32		first_child;
+	guint32		next_sibling;
+	guint32		fail;		/* longest proper suffix in the trie */
+	guint8		byte;		/* on the edge from the parent */
+	gboolean	output;		/* a pattern ends here, or at a suffix */
+} pattern_node_t;
+
+struct pattern_set {
+	GArray		*nodes;		/* pattern_node_t */
+	guint32		root_next[256];	/* the root's children, by byte */
+	gboolean	compiled;
+};
+
+#define NODE(ps, n)	(&g_array_index((ps)->nodes, pattern_node_t, (n)))
+
+pattern_set_t *
+pattern_set_new(void)
+{
+	pattern_set_t	*ps = g_new0(pattern_set_t, 1);
+	pattern_node_t	root;
+
+	memset(&root, 0, sizeof root);
+	ps->nodes = g_array_new(FALSE, FALSE, sizeof(pattern_node_t));
+	g_array_append_val(ps->nodes, root);
+	return ps;
+}
+
+void
+pattern_set_free(pattern_set_t *ps)
+{
+	if (!ps)
+		return;
+
+	g_array_free(ps->nodes, TRUE);
+	g_free(ps);
+}
+
+static guint32
+find_child(const pattern_set_t *ps, guint32 n, guint8 byte)
+{
+	guint32 child;
+
+	for (child = NODE(ps, n)->first_child; child;
+	    child = NODE(ps, child)->next_sibling) {
+		if (NODE(ps, child)->byte == byte)
+			return child;
+	}
+	return 0;
+}
+
+void
+pattern_set_add(pattern_set_t *ps, const guint8 *pattern, gsize len)
+{
+	pattern_node_t	node;
+	guint32		n = 0, child;
+	gsize		i;
+
+	g_assert(!ps->compiled && len > 0);
+
+	for (i = 0; i < len; i++) {
+		child = find_child(ps, n, pattern[i]);
+		if (!child) {
+			memset(&node, 0, sizeof node);
+			node.byte = pattern[i];
+			node.next_sibling = NODE(ps, n)->first_child;
+			child = ps->nodes->len;
+			g_array_append_val(ps->nodes, node);
+			NODE(ps, n)->first_child = child;
+		}
+		n = child;
+	}
+	NODE(ps, n)->output = TRUE;
+}
+
+void
+pattern_set_compile(pattern_set_t *ps)
+{
+	GQueue		queue = G_QUEUE_INIT;
+	guint32		n, child, f, next;
+
+	g_assert(!ps->compiled);
+
+	/* The root's children fail back to the root. */
+	for (child = NODE(ps, 0)->first_child; child;
+	    child = NODE(ps, child)->next_sibling) {
+		ps->root_next[NODE(ps, child)->byte] = child;
+		NODE(ps, child)->fail = 0;
+		g_queue_push_tail(&queue, GUINT_TO_POINTER(child));
+	}
+
+	/* The others, in breadth-first order, so that the links of the
+	 * shorter strings are known. */
+	while (!g_queue_is_empty(&queue)) {
+		n = GPOINTER_TO_UINT(g_queue_pop_head(&queue));
+		for (child = NODE(ps, n)->first_child; child;
+		    child = NODE(ps, child)->next_sibling) {
+			f = NODE(ps, n)->fail;
+			while (f && !find_child(ps, f, NODE(ps, child)->byte))
+				f = NODE(ps, f)->fail;
+			next = f ? find_child(ps, f, NODE(ps, child)->byte) :
+				ps->root_next[NODE(ps, child)->byte];
+			NODE(ps, child)->fail = next;
+			if (NODE(ps, next)->output)
+				NODE(ps, child)->output = TRUE;
+			g_queue_push_tail(&queue, GUINT_TO_POINTER(child));
+		}
+	}
+	ps->compiled = TRUE;
+}
+
+gboolean
+pattern_set_search(const pattern_set_t *ps, const guint8 *data, gsize len)
+{
+	guint32	n = 0, child;
+	gsize	i;
+
+	g_assert(ps->compiled);
+
+	for (i = 0; i < len; i++) {
+		for (;;) {
+			if (n == 0) {
+				n = ps->root_next[data[i]];
+				break;
+			}
+			child = find_child(ps, n, data[i]);
+			if (child) {
+				n = child;
+				break;
+			}
+			n = NODE(ps, n)->fail;
+		}
+		if (NODE(ps, n)->output)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
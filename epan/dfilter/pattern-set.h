@@ -0,0 +1,49 @@
+/* pattern-set.h
+ * Searching for any of several byte strings at once, for the display
+ * filter "contains" operator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef PATTERN_SET_H
+#define PATTERN_SET_H
+
+#include <glib.h>
+
+/*
+ * A pattern set is an Aho-Corasick automaton: a trie of the patterns in
+ * which each node also has a link to the node for the longest proper
+ * suffix of its string that is in the trie.  The text is searched for
+ * all the patterns in one pass, whatever their number.
+ */
+
+/* "field contains a || field contains b || ..." is done with a pattern
+ * set when there are at least this many patterns. */
+#define PATTERN_SET_MIN_SIZE	3
+
+typedef struct pattern_set pattern_set_t;
+
+pattern_set_t *
+pattern_set_new(void);
+
+void
+pattern_set_free(pattern_set_t *ps);
+
+/* Adds a pattern; it must not be empty.  Patterns can't be added after
+ * pattern_set_compile() has been called. */
+void
+pattern_set_add(pattern_set_t *ps, const guint8 *pattern, gsize len);
+
+/* Finishes the automaton. */
+void
+pattern_set_compile(pattern_set_t *ps);
+
+/* Returns TRUE if any of the patterns occurs in the data. */
+gboolean
+pattern_set_search(const pattern_set_t *ps, const guint8 *data, gsize len);
+
+#endif /* PATTERN_SET_H */
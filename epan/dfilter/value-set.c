@@ -0,0 +1,271 @@
+/* value-set.c
+ * Hashed sets of constants for the display filter "in" operator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "value-set.h"
+#include <ftypes/ftypes-int.h>
+
+/* Longest key that can have a prefix (an IPv6 address). */
+#define MAX_PREFIXED_KEY_LEN	16
+
+typedef struct {
+	guint		prefix;		/* of all the keys, or VALUE_SET_WHOLE */
+	GHashTable	*keys;		/* value_set_key_t */
+} value_set_level_t;
+
+struct value_set {
+	GArray	*levels;		/* value_set_level_t, longest prefix first */
+	guint	size;
+};
+
+value_set_kind_t
+value_set_kind(ftenum_t ftype)
+{
+	switch (ftype) {
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+		case FT_STRINGZPAD:
+		case FT_STRINGZTRUNC:
+			return VALUE_SET_STRING;
+
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_AX25:
+		case FT_VINES:
+		case FT_ETHER:
+		case FT_OID:
+		case FT_REL_OID:
+		case FT_SYSTEM_ID:
+		case FT_FCWWN:
+			return VALUE_SET_BYTES;
+
+		case FT_UINT40:
+		case FT_UINT48:
+		case FT_UINT56:
+		case FT_UINT64:
+		case FT_INT40:
+		case FT_INT48:
+		case FT_INT56:
+		case FT_INT64:
+		case FT_EUI64:
+			return VALUE_SET_INT64;
+
+		case FT_GUID:
+			return VALUE_SET_GUID;
+
+		case FT_IPv6:
+			return VALUE_SET_IPV6;
+
+		default:
+			return VALUE_SET_NONE;
+	}
+}
+
+void
+value_set_key_from_fvalue(const fvalue_t *fv, value_set_key_t *key)
+{
+	key->prefix = VALUE_SET_WHOLE;
+
+	switch (value_set_kind(fv->ftype->ftype)) {
+		case VALUE_SET_STRING:
+			key->data = (const guint8 *)fv->value.string;
+			key->len = strlen(fv->value.string);
+			break;
+
+		case VALUE_SET_BYTES:
+			key->data = fv->value.bytes->data;
+			key->len = fv->value.bytes->len;
+			break;
+
+		case VALUE_SET_INT64:
+			key->data = (const guint8 *)&fv->value.uinteger64;
+			key->len = sizeof fv->value.uinteger64;
+			break;
+
+		case VALUE_SET_GUID:
+			key->data = (const guint8 *)&fv->value.guid;
+			key->len = sizeof fv->value.guid;
+			break;
+
+		case VALUE_SET_IPV6:
+			key->data = fv->value.ipv6.addr.bytes;
+			key->len = sizeof fv->value.ipv6.addr.bytes;
+			if (fv->value.ipv6.prefix < 128)
+				key->prefix = fv->value.ipv6.prefix;
+			break;
+
+		default:
+			g_assert_not_reached();
+			break;
+	}
+}
+
+/* FNV-1a */
+static guint
+key_hash(gconstpointer data)
+{
+	const value_set_key_t	*key = (const value_set_key_t *)data;
+	guint32			h = 2166136261U;
+	gsize			i;
+
+	for (i = 0; i < key->len; i++) {
+		h ^= key->data[i];
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static gboolean
+key_equal(gconstpointer a, gconstpointer b)
+{
+	const value_set_key_t *key_a = (const value_set_key_t *)a;
+	const value_set_key_t *key_b = (const value_set_key_t *)b;
+
+	return key_a->len == key_b->len &&
+		memcmp(key_a->data, key_b->data, key_a->len) == 0;
+}
+
+/* Copies the first prefix bits of a key to buf and clears the rest. */
+static void
+mask_key(const value_set_key_t *key, guint prefix, guint8 *buf)
+{
+	gsize	full = prefix / 8;
+	guint	bits = prefix % 8;
+
+	memset(buf, 0, key->len);
+	memcpy(buf, key->data, MIN(full, key->len));
+	if (bits && full < key->len)
+		buf[full] = key->data[full] & (guint8)(0xff << (8 - bits));
+}
+
+value_set_t *
+value_set_new(void)
+{
+	value_set_t *vs = g_new0(value_set_t, 1);
+
+	vs->levels = g_array_new(FALSE, FALSE, sizeof(value_set_level_t));
+	return vs;
+}
+
+void
+value_set_free(value_set_t *vs)
+{
+	guint i;
+
+	if (!vs)
+		return;
+
+	for (i = 0; i < vs->levels->len; i++)
+		g_hash_table_destroy(g_array_index(vs->levels, value_set_level_t, i).keys);
+	g_array_free(vs->levels, TRUE);
+	g_free(vs);
+}
+
+static void
+stored_key_free(gpointer data)
+{
+	g_free(data);
+}
+
+static GHashTable *
+get_level(value_set_t *vs, guint prefix)
+{
+	value_set_level_t	level, *cur;
+	guint			i;
+
+	for (i = 0; i < vs->levels->len; i++) {
+		cur = &g_array_index(vs->levels, value_set_level_t, i);
+		if (cur->prefix == prefix)
+			return cur->keys;
+		if (cur->prefix < prefix)
+			break;
+	}
+
+	level.prefix = prefix;
+	level.keys = g_hash_table_new_full(key_hash, key_equal, stored_key_free, NULL);
+	g_array_insert_val(vs->levels, i, level);
+	return level.keys;
+}
+
+void
+value_set_add(value_set_t *vs, const value_set_key_t *key)
+{
+	value_set_key_t	*stored;
+	guint8		*data;
+	guint		prefix = key->prefix;
+
+	if (prefix != VALUE_SET_WHOLE &&
+	    (key->len > MAX_PREFIXED_KEY_LEN || prefix >= key->len * 8))
+		prefix = VALUE_SET_WHOLE;
+
+	/* The data is kept in the same block as the key. */
+	stored = (value_set_key_t *)g_malloc(sizeof(value_set_key_t) + key->len);
+	data = (guint8 *)(stored + 1);
+	if (prefix == VALUE_SET_WHOLE)
+		memcpy(data, key->data, key->len);
+	else
+		mask_key(key, prefix, data);
+	stored->data = data;
+	stored->len = key->len;
+	stored->prefix = prefix;
+
+	g_hash_table_add(get_level(vs, prefix), stored);
+	vs->size++;
+}
+
+guint
+value_set_size(const value_set_t *vs)
+{
+	return vs->size;
+}
+
+gboolean
+value_set_contains(const value_set_t *vs, const value_set_key_t *key)
+{
+	value_set_level_t	*level;
+	value_set_key_t		masked;
+	guint8			buf[MAX_PREFIXED_KEY_LEN];
+	guint			i;
+
+	for (i = 0; i < vs->levels->len; i++) {
+		level = &g_array_index(vs->levels, value_set_level_t, i);
+		if (level->prefix == VALUE_SET_WHOLE) {
+			if (g_hash_table_contains(level->keys, key))
+				return TRUE;
+			continue;
+		}
+		if (key->len > MAX_PREFIXED_KEY_LEN)
+			continue;
+		mask_key(key, level->prefix, buf);
+		masked.data = buf;
+		masked.len = key->len;
+		masked.prefix = level->prefix;
+		if (g_hash_table_contains(level->keys, &masked))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
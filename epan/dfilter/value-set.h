@@ -0,0 +1,83 @@
+/* value-set.h
+ * Hashed sets of constants for the display filter "in" operator
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef VALUE_SET_H
+#define VALUE_SET_H
+
+#include <glib.h>
+
+#include <epan/ftypes/ftypes.h>
+
+/*
+ * A value set holds the constants of a large "in" set as byte strings,
+ * so that whether a value is one of them is found with a hash lookup
+ * instead of a comparison with each of them.
+ *
+ * IPv4 and IPv6 constants can have a prefix, and then match any address
+ * that starts with the same bits.  They are kept in one hash table per
+ * prefix length, with the bits past the prefix cleared; a lookup is made
+ * in each table, longest prefix first, which is what a CIDR trie would
+ * do with one step per prefix length in use.
+ */
+
+/* Sets with fewer constants than this are faster to search one by one. */
+#define VALUE_SET_MIN_SIZE	8
+
+/* A key that is compared as a whole. */
+#define VALUE_SET_WHOLE		G_MAXUINT
+
+typedef struct {
+	const guint8	*data;
+	gsize		len;
+	guint		prefix;		/* bits compared, or VALUE_SET_WHOLE */
+} value_set_key_t;
+
+/* Kinds of values that keys can be made from; values of different kinds
+ * can't be in the same set. */
+typedef enum {
+	VALUE_SET_NONE,
+	VALUE_SET_STRING,
+	VALUE_SET_BYTES,
+	VALUE_SET_INT64,
+	VALUE_SET_GUID,
+	VALUE_SET_IPV6
+} value_set_kind_t;
+
+typedef struct value_set value_set_t;
+
+/* Returns the kind of keys made from values of a type, or VALUE_SET_NONE
+ * if two values of the type can be equal without having the same key. */
+value_set_kind_t
+value_set_kind(ftenum_t ftype);
+
+/* Makes the key of a value; the key points into the value. */
+void
+value_set_key_from_fvalue(const fvalue_t *fv, value_set_key_t *key);
+
+value_set_t *
+value_set_new(void);
+
+void
+value_set_free(value_set_t *vs);
+
+/* Adds a key; the data is copied. */
+void
+value_set_add(value_set_t *vs, const value_set_key_t *key);
+
+/* Returns the number of keys that were added. */
+guint
+value_set_size(const value_set_t *vs);
+
+/* Returns TRUE if the set has a key equal to a whole key, or has a
+ * prefixed key that matches its first bits. */
+gboolean
+value_set_contains(const value_set_t *vs, const value_set_key_t *key);
+
+#endif /* VALUE_SET_H */
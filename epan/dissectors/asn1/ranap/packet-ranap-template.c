@@ -462,6 +462,7 @@ proto_reg_handoff_ranap(void)
     rrc_t_to_srnc_handle = find_dissector_add_dependency("rrc.t_to_srnc_cont", proto_ranap);
     rrc_ho_to_utran_cmd = find_dissector_add_dependency("rrc.irat.ho_to_utran_cmd", proto_ranap);
     bssgp_handle = find_dissector("bssgp");
+    find_dissector_add_dependency("rtp", proto_ranap);
     initialized = TRUE;
 #include "packet-ranap-dis-tab.c"
   } else {
@@ -12899,6 +12899,9 @@ proto_reg_handoff_ansi_a(void)
         dtap_handle = create_dissector_handle(dissect_dtap, proto_a_dtap);
         sip_dtap_bsmap_handle = create_dissector_handle(dissect_sip_dtap_bsmap, proto_a_dtap);
 
+        find_dissector_add_dependency("rtp", proto_a_bsmap);
+        find_dissector_add_dependency("rtp", proto_a_dtap);
+
         dissector_add_uint("bsap.pdu_type",  BSSAP_PDU_TYPE_BSMAP, bsmap_handle);
         dissector_add_uint("bsap.pdu_type",  BSSAP_PDU_TYPE_DTAP, dtap_handle);
         dissector_add_string("media_type", "application/femtointerfacemsg", sip_dtap_bsmap_handle);
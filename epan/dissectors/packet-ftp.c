@@ -1661,6 +1661,8 @@ proto_reg_handoff_ftp(void)
     dissector_add_uint("acdr.tls_application", TLS_APP_FTP, ftp_handle);
 
     data_text_lines_handle = find_dissector_add_dependency("data-text-lines", proto_ftp_data);
+    /* FTP-DATA is reached through the conversations FTP sets up. */
+    find_dissector_add_dependency("ftp-data", proto_ftp);
 
 }
 
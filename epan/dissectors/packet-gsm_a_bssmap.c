@@ -8466,6 +8466,8 @@ proto_reg_handoff_gsm_a_bssmap(void)
     bssgp_handle      = find_dissector_add_dependency("bssgp", proto_a_bssmap);
     rrc_handle        = find_dissector_add_dependency("rrc", proto_a_bssmap);
     bicc_mst_handle   = find_dissector_add_dependency("bicc_mst", proto_a_bssmap);
+    find_dissector_add_dependency("rtp", proto_a_bssmap);
+    find_dissector_add_dependency("rtcp", proto_a_bssmap);
 }
 
 /*
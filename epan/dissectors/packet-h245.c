@@ -20795,7 +20795,9 @@ void proto_register_h245(void) {
 
 /*--- proto_reg_handoff_h245 ---------------------------------------*/
 void proto_reg_handoff_h245(void) {
-	rtcp_handle = find_dissector("rtcp");
+	rtcp_handle = find_dissector_add_dependency("rtcp", proto_h245);
+	find_dissector_add_dependency("rtp", proto_h245);
+	find_dissector_add_dependency("t38_udp", proto_h245);
 	data_handle = find_dissector("data");
 	h263_handle = find_dissector("h263data");
 	amr_handle = find_dissector("amr_if2_nb");
@@ -2930,6 +2930,8 @@ proto_register_ip(void)
   expert_module_t* expert_ip;
 
   proto_ip = proto_register_protocol("Internet Protocol Version 4", "IPv4", "ip");
+  /* Fragments must all be seen to be reassembled */
+  register_stateful_protocol(proto_ip);
   proto_register_field_array(proto_ip, hf, array_length(hf));
   proto_register_subtree_array(ett, array_length(ett));
   expert_ip = expert_register_protocol(proto_ip);
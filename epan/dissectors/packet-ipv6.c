@@ -3657,6 +3657,8 @@ proto_register_ipv6(void)
     expert_module_t* expert_ipv6_routing;
 
     proto_ipv6 = proto_register_protocol("Internet Protocol Version 6", "IPv6", "ipv6");
+    /* Fragments must all be seen to be reassembled */
+    register_stateful_protocol(proto_ipv6);
     proto_register_field_array(proto_ipv6, hf_ipv6, array_length(hf_ipv6));
     proto_register_subtree_array(ett_ipv6, array_length(ett_ipv6));
     expert_ipv6 = expert_register_protocol(proto_ipv6);
@@ -5288,6 +5288,8 @@ proto_reg_handoff_rsl(void)
     gsm_a_ccch_handle = find_dissector_add_dependency("gsm_a_ccch", proto_rsl);
     gsm_a_dtap_handle = find_dissector_add_dependency("gsm_a_dtap", proto_rsl);
     gsm_a_sacch_handle = find_dissector_add_dependency("gsm_a_sacch", proto_rsl);
+    find_dissector_add_dependency("rtp", proto_rsl);
+    find_dissector_add_dependency("rtcp", proto_rsl);
 }
 
 /*
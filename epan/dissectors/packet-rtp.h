@@ -189,7 +189,9 @@ struct _rtp_conversation_info
     wmem_array_t *rtp_sdp_setup_info_list;           /**> List with data from all SDP occurencies for this steram holding a call ID)*/
 };
 
-/* Add an RTP conversation with the given details */
+/* Add an RTP conversation with the given details.  Callers should register
+ * "rtp" as a dependency, with find_dissector_add_dependency(), so that they
+ * aren't pruned away when only RTP is needed. */
 WS_DLL_PUBLIC
 void rtp_add_address(packet_info *pinfo,
                      const port_type ptype,
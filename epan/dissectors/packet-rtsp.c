@@ -1636,6 +1636,7 @@ proto_reg_handoff_rtsp(void)
     rtp_rfc4571_handle = find_dissector_add_dependency("rtp.rfc4571", proto_rtsp);
     rtcp_handle = find_dissector_add_dependency("rtcp", proto_rtsp);
     rdt_handle = find_dissector_add_dependency("rdt", proto_rtsp);
+    find_dissector_add_dependency("sdp", proto_rtsp);
     media_type_dissector_table = find_dissector_table("media_type");
     voip_tap = find_tap_id("voip");
 
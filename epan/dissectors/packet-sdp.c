@@ -3409,6 +3409,10 @@ proto_reg_handoff_sdp(void)
     h265_handle   = find_dissector_add_dependency("h265", proto_sdp);
     mp4ves_config_handle = find_dissector_add_dependency("mp4ves_config", proto_sdp);
 
+    /* RTP and T.38 are reached through the conversations we set up. */
+    find_dissector_add_dependency("rtp", proto_sdp);
+    find_dissector_add_dependency("t38_udp", proto_sdp);
+
     proto_sprt    = dissector_handle_get_protocol_index(find_dissector("sprt"));
 
     dissector_add_string("media_type", "application/sdp", sdp_handle);
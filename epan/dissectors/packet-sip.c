@@ -7624,6 +7624,8 @@ proto_reg_handoff_sip(void)
 
     if (!sip_prefs_initialized) {
         sigcomp_handle = find_dissector_add_dependency("sigcomp", proto_sip);
+        /* SDP bodies are handed over through the "media_type" table */
+        find_dissector_add_dependency("sdp", proto_sip);
         sip_diag_handle = find_dissector("sip.diagnostic");
         sip_uri_userinfo_handle = find_dissector("sip.uri_userinfo");
         sip_via_branch_handle = find_dissector("sip.via_branch");
@@ -3177,6 +3177,10 @@ static gboolean tcp_desegment = TRUE;
  * subdissector (depends on "tcp_desegment"). */
 static gboolean tcp_reassemble_out_of_order = FALSE;
 
+/* Make reassembled PDUs out of the segments' data instead of copying it
+ * (depends on "tcp_desegment"). */
+static gboolean tcp_reassemble_composite = FALSE;
+
 /* Returns true iff any gap exists in the segments associated with msp up to the
  * given sequence number (it ignores any gaps after the sequence number). */
 static gboolean
@@ -7235,6 +7239,8 @@ tcp_init(void)
 {
     tcp_stream_count = 0;
 
+    reassembly_table_set_composite(&tcp_reassembly_table, tcp_reassemble_composite);
+
     /* MPTCP init */
     mptcp_stream_count = 0;
     mptcp_tokens = wmem_tree_new(wmem_file_scope());
@@ -8193,6 +8199,8 @@ proto_register_tcp(void)
 
     proto_tcp = proto_register_protocol("Transmission Control Protocol", "TCP", "tcp");
     tcp_handle = register_dissector("tcp", dissect_tcp, proto_tcp);
+    /* Reassembly and analysis need every segment, whatever is filtered on */
+    register_stateful_protocol(proto_tcp);
     proto_register_field_array(proto_tcp, hf, array_length(hf));
     proto_register_subtree_array(ett, array_length(ett));
     expert_tcp = expert_register_protocol(proto_tcp);
@@ -8254,6 +8262,13 @@ proto_register_tcp(void)
         "Whether out-of-order segments should be buffered and reordered before passing it to a subdissector. "
         "To use this option you must also enable \"Allow subdissector to reassemble TCP streams\".",
         &tcp_reassemble_out_of_order);
+    prefs_register_bool_preference(tcp_module, "reassemble_composite",
+        "Reassemble without copying segment data",
+        "Whether reassembled PDUs should be made of the data of their segments instead of a copy of it. "
+        "This saves memory and time with large PDUs, but dissectors that need their data in one piece "
+        "will still have it copied. "
+        "To use this option you must also enable \"Allow subdissector to reassemble TCP streams\".",
+        &tcp_reassemble_composite);
     prefs_register_bool_preference(tcp_module, "analyze_sequence_numbers",
         "Analyze TCP sequence numbers",
         "Make the TCP dissector analyze TCP sequence numbers to find and flag segment retransmissions, missing segments and RTT",
@@ -4475,6 +4475,8 @@ proto_register_tls(void)
     /* Register the protocol name and description */
     proto_tls = proto_register_protocol("Transport Layer Security",
                                         "TLS", "tls");
+    /* Records, handshakes and decryption state span segments */
+    register_stateful_protocol(proto_tls);
 
     ssl_associations = register_dissector_table("tls.port", "TLS Port", proto_tls, FT_UINT16, BASE_DEC);
     register_dissector_table_alias(ssl_associations, "ssl.port");
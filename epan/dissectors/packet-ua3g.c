@@ -4952,6 +4952,9 @@ proto_register_ua3g(void)
 
 void proto_reg_handoff_ua3g(void)
 {
+    find_dissector_add_dependency("rtp", proto_ua3g);
+    find_dissector_add_dependency("rtcp", proto_ua3g);
+
 #if 0 /* Future */
     dissector_handle_t handle_ua3g = find_dissector("ua3g");
 
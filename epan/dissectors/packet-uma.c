@@ -1740,6 +1740,7 @@ proto_reg_handoff_uma(void)
 {
 	dissector_add_for_decode_as_with_preference("udp.port", uma_udp_handle);
 	rtcp_handle = find_dissector_add_dependency("rtcp", proto_uma);
+	find_dissector_add_dependency("rtp", proto_uma);
 	llc_handle = find_dissector_add_dependency("llcgprs", proto_uma);
 	bssap_pdu_type_table = find_dissector_table("bssap.pdu_type");
 
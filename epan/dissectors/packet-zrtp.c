@@ -1131,6 +1131,8 @@ void
 proto_reg_handoff_zrtp(void)
 {
   dissector_add_for_decode_as_with_preference("udp.port", zrtp_handle);
+  find_dissector_add_dependency("rtp", proto_zrtp);
+  find_dissector_add_dependency("rtcp", proto_zrtp);
 }
 
 /*
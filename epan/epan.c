@@ -573,6 +573,34 @@ epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols)
 		proto_tree_set_fake_protocols(edt->tree, fake_protocols);
 }
 
+/*
+ * Whether a packet is being dissected.  The dissection state is
+ * process-wide, so dissecting in two threads at once would corrupt it;
+ * catch that rather than crash somewhere unrelated later on.
+ */
+static gint dissecting;
+
+static void
+dissection_enter(void)
+{
+	if (!g_atomic_int_compare_and_exchange(&dissecting, 0, 1))
+		g_error("Packets are being dissected in two threads at once; "
+		    "libwireshark can only dissect in one thread at a time");
+}
+
+static void
+dissection_leave(void)
+{
+	g_atomic_int_set(&dissecting, 0);
+}
+
+void
+epan_dissect_field_sink(epan_dissect_t *edt, const gboolean field_sink)
+{
+	if (edt && edt->tree)
+		proto_tree_set_field_sink(edt->tree, field_sink);
+}
+
 void
 epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
@@ -581,11 +609,13 @@ epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
+	dissection_enter();
 	wmem_enter_packet_scope();
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
+	dissection_leave();
 }
 
 void
@@ -593,6 +623,7 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
 	column_info *cinfo)
 {
+	dissection_enter();
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
@@ -600,6 +631,7 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
+	dissection_leave();
 }
 
 void
@@ -609,17 +641,20 @@ epan_dissect_file_run(epan_dissect_t *edt, wtap_rec *rec,
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
+	dissection_enter();
 	wmem_enter_packet_scope();
 	dissect_file(edt, rec, tvb, fd, cinfo);
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
+	dissection_leave();
 }
 
 void
 epan_dissect_file_run_with_taps(epan_dissect_t *edt, wtap_rec *rec,
 	tvbuff_t *tvb, frame_data *fd, column_info *cinfo)
 {
+	dissection_enter();
 	wmem_enter_packet_scope();
 	tap_queue_init(edt);
 	dissect_file(edt, rec, tvb, fd, cinfo);
@@ -627,6 +662,7 @@ epan_dissect_file_run_with_taps(epan_dissect_t *edt, wtap_rec *rec,
 
 	/* free all memory allocated */
 	wmem_leave_packet_scope();
+	dissection_leave();
 }
 
 void
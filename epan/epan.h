@@ -145,6 +145,15 @@ void epan_conversation_init(void);
  * packet trace file. The reasons epan_t exists is that some packets in
  * some protocols cannot be decoded without knowledge of previous packets.
  * This inter-packet "state" is stored in the epan_t.
+ *
+ * Most of that state is in fact kept in process-wide variables (the
+ * conversation and reassembly tables, the wmem file and packet scopes,
+ * the tap queue and the dissectors' own static variables), so only one
+ * epan_t can be dissecting at a time, and only in one thread at a time;
+ * epan_dissect_run() and its variants abort the program if they are
+ * called in one thread while a dissection is running in another.  To
+ * dissect in parallel, use separate processes, as TShark's --threads
+ * option does.
  */
 typedef struct epan_session epan_t;
 
@@ -199,6 +208,12 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fake_protocols(epan_dissect_t *edt, const gboolean fake_protocols);
 
+/** Use the (invisible) protocol tree only to collect the values of the
+ *  primed fields; see proto_tree_set_field_sink() */
+WS_DLL_PUBLIC
+void
+epan_dissect_field_sink(epan_dissect_t *edt, const gboolean field_sink);
+
 /** run a single packet dissection */
 WS_DLL_PUBLIC
 void
@@ -286,6 +286,57 @@ fvalue_init(fvalue_t *fv, ftenum_t ftype)
 	}
 }
 
+fvalue_t*
+fvalue_dup(const fvalue_t *fv_orig)
+{
+	fvalue_t		*fv;
+
+	switch (fv_orig->ftype->ftype) {
+		case FT_PROTOCOL:
+		case FT_PCRE:
+			return NULL;
+
+		default:
+			break;
+	}
+
+	fv = g_slice_new(fvalue_t);
+	*fv = *fv_orig;
+
+	switch (fv_orig->ftype->ftype) {
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+		case FT_STRINGZPAD:
+		case FT_STRINGZTRUNC:
+			fv->value.string = g_strdup(fv_orig->value.string);
+			break;
+
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_AX25:
+		case FT_VINES:
+		case FT_ETHER:
+		case FT_OID:
+		case FT_REL_OID:
+		case FT_SYSTEM_ID:
+		case FT_FCWWN:
+			if (fv_orig->value.bytes) {
+				fv->value.bytes = g_byte_array_sized_new(fv_orig->value.bytes->len);
+				g_byte_array_append(fv->value.bytes,
+						fv_orig->value.bytes->data,
+						fv_orig->value.bytes->len);
+			}
+			break;
+
+		default:
+			/* Everything else is stored in the fvalue_t itself. */
+			break;
+	}
+
+	return fv;
+}
+
 fvalue_t*
 fvalue_from_unparsed(ftenum_t ftype, const char *s, gboolean allow_partial_value, gchar **err_msg)
 {
@@ -257,6 +257,15 @@ fvalue_new(ftenum_t ftype);
 void
 fvalue_init(fvalue_t *fv, ftenum_t ftype);
 
+/* Makes a copy of a field value that shares no memory with the original,
+ * so that it can outlive the proto_tree it came from.
+ *
+ * Returns NULL if the value can't be copied, which is the case for
+ * protocol values (they refer to the packet's tvbuff) and regular
+ * expressions. */
+fvalue_t*
+fvalue_dup(const fvalue_t *fv_orig);
+
 WS_DLL_PUBLIC
 fvalue_t*
 fvalue_from_unparsed(ftenum_t ftype, const char *s, gboolean allow_partial_value, gchar **err_msg);
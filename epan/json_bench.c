@@ -0,0 +1,381 @@
+/* json_bench.c
+ * Times the JSON and Elasticsearch output of a protocol tree
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Usage: json_bench [iterations]
+ *
+ * Builds the protocol tree of an Ethernet/IPv4/TCP/HTTP packet once, then
+ * writes it the given number of times with write_ek_proto_tree() (as
+ * "tshark -T ek" does) and with write_json_proto_tree() (as "tshark -T
+ * json" does) to the null device, and prints the time and the number of
+ * bytes per packet.
+ *
+ * Then the strings of the packet are written as JSON strings, both with
+ * json_dumper and with the loop json_dumper used to have, which wrote
+ * each character with fputc(); the output of both is compared.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/print.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/privileges.h>
+#include <wsutil/ws_memmem.h>
+#include <wiretap/wtap.h>
+
+#define DEFAULT_ITERATIONS	100000
+
+#ifdef _WIN32
+#define NULL_DEVICE	"NUL"
+#else
+#define NULL_DEVICE	"/dev/null"
+#endif
+
+#define HTTP_REQUEST \
+	"GET /search?q=wireshark&lang=en HTTP/1.1\r\n" \
+	"Host: www.example.com\r\n" \
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:85.0) Gecko/20100101 Firefox/85.0\r\n" \
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n" \
+	"Referer: https://www.example.com/index.html\r\n" \
+	"\r\n"
+
+#define ETH_IP_TCP_LEN	54
+
+/* Ethernet, IPv4 and TCP headers of a segment from 10.1.2.3:51000 to
+ * 192.168.1.2:80; the request follows. */
+static const guint8 headers[ETH_IP_TCP_LEN] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x00, 0x1b,
+	0x21, 0x01, 0x02, 0x03, 0x08, 0x00, 0x45, 0x00,
+	0x01, 0x4b, 0x12, 0x34, 0x40, 0x00, 0x40, 0x06,
+	0x00, 0x00, 0x0a, 0x01, 0x02, 0x03, 0xc0, 0xa8,
+	0x01, 0x02, 0xc7, 0x38, 0x00, 0x50, 0x00, 0x00,
+	0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x50, 0x18,
+	0xfa, 0xf0, 0x00, 0x00, 0x00, 0x00
+};
+
+typedef struct {
+	const char	*name;
+	gboolean	subtree;	/* the following fields are in it */
+	gint		start;		/* -1 to look for text */
+	gint		length;		/* -1 to the end of the packet */
+	const char	*text;		/* in the request, with the length */
+} bench_field_t;
+
+/* The fields of the tree, in the order the dissectors would add them;
+ * the protocols are at the top, and their fields in their subtrees. */
+static const bench_field_t fields[] = {
+	{ "frame",			TRUE,	0,	-1,	NULL },
+	{ "eth",			TRUE,	0,	14,	NULL },
+	{ "eth.dst",			FALSE,	0,	6,	NULL },
+	{ "eth.src",			FALSE,	6,	6,	NULL },
+	{ "eth.type",			FALSE,	12,	2,	NULL },
+	{ "ip",				TRUE,	14,	20,	NULL },
+	{ "ip.version",			FALSE,	14,	1,	NULL },
+	{ "ip.len",			FALSE,	16,	2,	NULL },
+	{ "ip.id",			FALSE,	18,	2,	NULL },
+	{ "ip.ttl",			FALSE,	22,	1,	NULL },
+	{ "ip.proto",			FALSE,	23,	1,	NULL },
+	{ "ip.src",			FALSE,	26,	4,	NULL },
+	{ "ip.dst",			FALSE,	30,	4,	NULL },
+	{ "tcp",			TRUE,	34,	20,	NULL },
+	{ "tcp.srcport",		FALSE,	34,	2,	NULL },
+	{ "tcp.dstport",		FALSE,	36,	2,	NULL },
+	{ "tcp.seq",			FALSE,	38,	4,	NULL },
+	{ "tcp.ack",			FALSE,	42,	4,	NULL },
+	{ "tcp.window_size_value",	FALSE,	48,	2,	NULL },
+	{ "http",			TRUE,	ETH_IP_TCP_LEN,	-1,	NULL },
+	{ "http.request.method",	FALSE,	-1,	0,	"GET" },
+	{ "http.request.uri",		FALSE,	-1,	0,	"/search?q=wireshark&lang=en" },
+	{ "http.request.version",	FALSE,	-1,	0,	"HTTP/1.1" },
+	{ "http.host",			FALSE,	-1,	0,	"www.example.com" },
+	{ "http.user_agent",		FALSE,	-1,	0,	"Mozilla/5.0 (X11; Linux x86_64; rv:85.0) Gecko/20100101 Firefox/85.0" },
+	{ "http.accept",		FALSE,	-1,	0,	"text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8" },
+	{ "http.referer",		FALSE,	-1,	0,	"https://www.example.com/index.html" },
+};
+
+static gint ett_bench = -1;
+
+static void
+add_fields(proto_tree *tree, tvbuff_t *tvb, const guint8 *packet, gint packet_len)
+{
+	proto_tree	*subtree = tree;
+	proto_item	*item;
+	const guint8	*found;
+	gint		start, length;
+	guint		i;
+	int		hf_id;
+
+	for (i = 0; i < G_N_ELEMENTS(fields); i++) {
+		hf_id = proto_registrar_get_id_byname(fields[i].name);
+		if (hf_id == -1) {
+			fprintf(stderr, "json_bench: no field \"%s\"\n", fields[i].name);
+			continue;
+		}
+		start = fields[i].start;
+		length = fields[i].length;
+		if (fields[i].text) {
+			length = (gint)strlen(fields[i].text);
+			found = ws_memmem(packet, packet_len,
+					(const guint8 *)fields[i].text, length);
+			start = found ? (gint)(found - packet) : 0;
+		}
+		item = proto_tree_add_item(fields[i].subtree ? tree : subtree,
+				hf_id, tvb, start, length,
+				fields[i].text ? ENC_ASCII|ENC_NA : ENC_BIG_ENDIAN);
+		if (fields[i].subtree)
+			subtree = proto_item_add_subtree(item, ett_bench);
+	}
+}
+
+static void
+write_ek(FILE *fh, epan_dissect_t *edt, long iterations)
+{
+	long n;
+
+	for (n = 0; n < iterations; n++)
+		write_ek_proto_tree(NULL, FALSE, FALSE, NULL, PF_NONE, edt, NULL, fh);
+}
+
+static void
+write_json(FILE *fh, epan_dissect_t *edt, long iterations)
+{
+	json_dumper	dumper;
+	long		n;
+
+	dumper = write_json_preamble(fh);
+	for (n = 0; n < iterations; n++)
+		write_json_proto_tree(NULL, print_dissections_expanded, FALSE,
+				NULL, PF_NONE, edt, NULL,
+				proto_node_group_children_by_unique, &dumper);
+	write_json_finale(&dumper);
+}
+
+/* Prints the time taken to write a packet, and the size of the output;
+ * the latter can't be had from the null device. */
+static void
+time_tree(FILE *fh, const char *name, epan_dissect_t *edt, long iterations,
+		void (*write_func)(FILE *, epan_dissect_t *, long))
+{
+	FILE	*tmp;
+	long	size = 0;
+	gint64	start, elapsed;
+
+	tmp = tmpfile();
+	if (tmp) {
+		write_func(tmp, edt, 1);
+		size = ftell(tmp);
+		fclose(tmp);
+	}
+
+	start = g_get_monotonic_time();
+	write_func(fh, edt, iterations);
+	fflush(fh);
+	elapsed = g_get_monotonic_time() - start;
+
+	printf("%8.1f ns  %6ld bytes  %s\n",
+		(double)elapsed * 1000.0 / (double)iterations, size, name);
+}
+
+/* How json_dumper used to write a string, except for the conversion of
+ * dots, which isn't timed. */
+static void
+old_puts_string(FILE *fp, const char *str)
+{
+	static const char json_cntrl[0x20][6] = {
+		"u0000", "u0001", "u0002", "u0003", "u0004", "u0005", "u0006", "u0007", "b",     "t",     "n",     "u000b", "f",     "r",     "u000e", "u000f",
+		"u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
+	};
+
+	fputc('"', fp);
+	for (int i = 0; str[i]; i++) {
+		if ((guint)str[i] < 0x20) {
+			fputc('\\', fp);
+			fputs(json_cntrl[(guint)str[i]], fp);
+		} else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+			fputs("\\/", fp);
+		} else {
+			if (str[i] == '\\' || str[i] == '"')
+				fputc('\\', fp);
+			fputc(str[i], fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+/* Writes a JSON array of the strings, iterations times. */
+static void
+write_strings(FILE *fh, gboolean old, const char **strings, guint num_strings, long iterations)
+{
+	json_dumper	dumper;
+	long		n;
+	guint		i;
+
+	memset(&dumper, 0, sizeof dumper);
+	dumper.output_file = fh;
+
+	for (n = 0; n < iterations; n++) {
+		if (old) {
+			fputc('[', fh);
+			for (i = 0; i < num_strings; i++) {
+				if (i > 0)
+					fputc(',', fh);
+				old_puts_string(fh, strings[i]);
+			}
+			fputs("]\n", fh);
+		} else {
+			json_dumper_begin_array(&dumper);
+			for (i = 0; i < num_strings; i++)
+				json_dumper_value_string(&dumper, strings[i]);
+			json_dumper_end_array(&dumper);
+			json_dumper_finish(&dumper);
+		}
+	}
+}
+
+static gint64
+time_strings(FILE *fh, gboolean old, const char **strings, guint num_strings, long iterations)
+{
+	gint64	start = g_get_monotonic_time();
+
+	write_strings(fh, old, strings, num_strings, iterations);
+	fflush(fh);
+	return g_get_monotonic_time() - start;
+}
+
+static gboolean
+same_strings_output(const char **strings, guint num_strings)
+{
+	FILE		*fh[2];
+	char		buf[2][4096];
+	size_t		len[2];
+	gboolean	same = FALSE;
+	int		i;
+
+	for (i = 0; i < 2; i++) {
+		fh[i] = tmpfile();
+		if (!fh[i])
+			return FALSE;
+		write_strings(fh[i], i == 0, strings, num_strings, 1);
+		rewind(fh[i]);
+		len[i] = fread(buf[i], 1, sizeof buf[i], fh[i]);
+	}
+	same = len[0] == len[1] && memcmp(buf[0], buf[1], len[0]) == 0;
+	fclose(fh[0]);
+	fclose(fh[1]);
+	return same;
+}
+
+int
+main(int argc, char **argv)
+{
+	static gint	*ett[] = { &ett_bench };
+	char		*init_progfile_dir_error;
+	long		iterations = DEFAULT_ITERATIONS;
+	guint8		*packet;
+	gint		packet_len;
+	epan_dissect_t	*edt;
+	tvbuff_t	*tvb;
+	FILE		*fh;
+	const char	*strings[G_N_ELEMENTS(fields)];
+	guint		num_strings = 0;
+	gint64		elapsed, elapsed_old;
+	guint		i;
+
+	if (argc > 1) {
+		iterations = strtol(argv[1], NULL, 10);
+		if (iterations <= 0) {
+			fprintf(stderr, "Usage: json_bench [iterations]\n");
+			return 1;
+		}
+	}
+
+	init_process_policies();
+	init_progfile_dir_error = init_progfile_dir(argv[0]);
+	if (init_progfile_dir_error != NULL) {
+		fprintf(stderr, "json_bench: Can't get pathname of directory containing the json_bench program: %s.\n",
+			init_progfile_dir_error);
+		g_free(init_progfile_dir_error);
+	}
+
+	wtap_init(TRUE);
+	if (!epan_init(NULL, NULL, FALSE))
+		return 2;
+	proto_register_subtree_array(ett, G_N_ELEMENTS(ett));
+
+	fh = ws_fopen(NULL_DEVICE, "w");
+	if (!fh) {
+		fprintf(stderr, "json_bench: can't open %s\n", NULL_DEVICE);
+		return 2;
+	}
+
+	packet_len = ETH_IP_TCP_LEN + (gint)strlen(HTTP_REQUEST);
+	packet = (guint8 *)g_malloc(packet_len);
+	memcpy(packet, headers, ETH_IP_TCP_LEN);
+	memcpy(packet + ETH_IP_TCP_LEN, HTTP_REQUEST, packet_len - ETH_IP_TCP_LEN);
+
+	edt = epan_dissect_new(NULL, TRUE, TRUE);
+	tvb = tvb_new_real_data(packet, packet_len, packet_len);
+	add_fields(edt->tree, tvb, packet, packet_len);
+
+	printf("%ld iterations\n\n", iterations);
+
+	time_tree(fh, "-T ek", edt, iterations, write_ek);
+	time_tree(fh, "-T json", edt, iterations, write_json);
+	printf("\n");
+
+	for (i = 0; i < G_N_ELEMENTS(fields); i++) {
+		if (fields[i].text)
+			strings[num_strings++] = fields[i].text;
+	}
+	strings[num_strings++] = HTTP_REQUEST;
+
+	elapsed_old = time_strings(fh, TRUE, strings, num_strings, iterations);
+	elapsed = time_strings(fh, FALSE, strings, num_strings, iterations);
+	printf("%8.1f ns  fputc() per character\n",
+		(double)elapsed_old * 1000.0 / (double)iterations);
+	printf("%8.1f ns  json_dumper (%.1fx)  %s\n",
+		(double)elapsed * 1000.0 / (double)iterations,
+		elapsed ? (double)elapsed_old / (double)elapsed : 0.0,
+		same_strings_output(strings, num_strings) ? "same output" : "OUTPUT DIFFERS");
+
+	fclose(fh);
+	epan_dissect_free(edt);
+	tvb_free(tvb);
+	g_free(packet);
+	epan_cleanup();
+	wtap_cleanup();
+	return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
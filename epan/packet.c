@@ -116,6 +116,13 @@ struct depend_dissector_list {
 /* Maps char *dissector_name to depend_dissector_list_t */
 static GHashTable *depend_dissector_lists = NULL;
 
+/*
+ * Protocols that have to be dissected even if pruning would skip them,
+ * as they keep state that other protocols rely on.
+ * List of GINT_TO_POINTER(proto_id).
+ */
+static GSList *stateful_protocols = NULL;
+
 /* Allow protocols to register a "cleanup" routine to be
  * run after the initial sequential run through the packets.
  * Note that the file can still be open after this; this is not
@@ -257,6 +264,8 @@ packet_cleanup(void)
 	g_hash_table_destroy(dissector_table_aliases);
 	g_hash_table_destroy(registered_dissectors);
 	g_hash_table_destroy(depend_dissector_lists);
+	g_slist_free(stateful_protocols);
+	stateful_protocols = NULL;
 	g_hash_table_destroy(heur_dissector_lists);
 	g_hash_table_destroy(heuristic_short_names);
 	g_slist_foreach(shutdown_routines, &call_routine, NULL);
@@ -762,9 +771,10 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 	guint        saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	if (handle->protocol != NULL &&
-	    !proto_is_protocol_enabled(handle->protocol)) {
+	    (!proto_is_protocol_enabled(handle->protocol) ||
+	     proto_is_protocol_pruned(handle->protocol))) {
 		/*
-		 * The protocol isn't enabled.
+		 * The protocol isn't enabled, or nothing needs it.
 		 */
 		return 0;
 	}
@@ -2800,7 +2810,8 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
 
 		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE)||
+			 proto_is_protocol_pruned(hdtbl_entry->protocol))) {
 			/*
 			 * No - don't try this dissector.
 			 */
@@ -3301,7 +3312,9 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	saved_layers_len = wmem_list_count(pinfo->layers);
 
 	if (!heur_dtbl_entry->enabled ||
-		(heur_dtbl_entry->protocol != NULL && !proto_is_protocol_enabled(heur_dtbl_entry->protocol))) {
+		(heur_dtbl_entry->protocol != NULL &&
+		 (!proto_is_protocol_enabled(heur_dtbl_entry->protocol) ||
+		  proto_is_protocol_pruned(heur_dtbl_entry->protocol)))) {
 		DISSECTOR_ASSERT(data_handle->protocol != NULL);
 		call_dissector_work(data_handle, tvb, pinfo, tree, TRUE, NULL);
 		return;
@@ -3391,6 +3404,169 @@ depend_dissector_list_t find_depend_dissector_list(const char* name)
 	return (depend_dissector_list_t)g_hash_table_lookup(depend_dissector_lists, name);
 }
 
+void register_stateful_protocol(const int proto_id)
+{
+	stateful_protocols = g_slist_prepend(stateful_protocols, GINT_TO_POINTER(proto_id));
+}
+
+/*
+ * Return the id of the protocol that determines whether the given
+ * protocol is dissected, i.e. the parent for a "helper" protocol.
+ */
+static int
+prune_resolve_proto_id(int proto_id)
+{
+	protocol_t *protocol;
+
+	if (proto_id == -1)
+		return -1;
+
+	protocol = find_protocol_by_id(proto_id);
+	if (protocol == NULL)
+		return -1;
+	if (proto_is_pino(protocol))
+		return proto_get_parent_proto_id(protocol);
+
+	return proto_id;
+}
+
+static void
+prune_add_needed(GHashTable *needed, GQueue *todo, int proto_id)
+{
+	proto_id = prune_resolve_proto_id(proto_id);
+	if (proto_id == -1)
+		return;
+
+	if (!g_hash_table_contains(needed, GINT_TO_POINTER(proto_id))) {
+		g_hash_table_add(needed, GINT_TO_POINTER(proto_id));
+		g_queue_push_tail(todo, GINT_TO_POINTER(proto_id));
+	}
+}
+
+/*
+ * Add the reverse edges of a dependency list to a table mapping
+ * dependent protocol ids to a list of their parent protocol ids.
+ */
+static void
+prune_add_parents(gpointer key, gpointer value, gpointer user_data)
+{
+	const char              *parent_name = (const char *)key;
+	depend_dissector_list_t  sub_dissectors = (depend_dissector_list_t)value;
+	GHashTable              *parents = (GHashTable *)user_data;
+	GSList                  *entry;
+	GSList                  *parent_list;
+	int                      parent_id, dependent_id;
+
+	parent_id = prune_resolve_proto_id(proto_get_id_by_short_name(parent_name));
+	if (parent_id == -1)
+		return;
+
+	for (entry = sub_dissectors->dissectors; entry; entry = g_slist_next(entry)) {
+		dependent_id = prune_resolve_proto_id(proto_get_id_by_short_name((const char *)entry->data));
+		if (dependent_id == -1 || dependent_id == parent_id)
+			continue;
+
+		parent_list = (GSList *)g_hash_table_lookup(parents, GINT_TO_POINTER(dependent_id));
+		g_hash_table_insert(parents, GINT_TO_POINTER(dependent_id),
+				    g_slist_prepend(parent_list, GINT_TO_POINTER(parent_id)));
+	}
+}
+
+static void
+prune_free_parents(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	g_slist_free((GSList *)value);
+}
+
+gboolean
+prune_protocols(GArray *hfids)
+{
+	GHashTable *needed;
+	GHashTable *parents;
+	GQueue     *todo;
+	GSList     *entry;
+	guint       i, j;
+	int         hfid, proto_id;
+	void       *cookie;
+	gboolean    pruned = FALSE;
+
+	proto_unprune_all();
+
+	if (hfids == NULL)
+		return FALSE;
+
+	needed = g_hash_table_new(g_direct_hash, g_direct_equal);
+	todo = g_queue_new();
+
+	for (i = 0; i < hfids->len; i++) {
+		hfid = g_array_index(hfids, int, i);
+		proto_id = proto_registrar_is_protocol(hfid) ? hfid : proto_registrar_get_parent(hfid);
+		if (proto_id == -1 || g_str_has_prefix(proto_get_protocol_filter_name(proto_id), "_ws.")) {
+			/*
+			 * Pseudo-protocols such as expert info or columns
+			 * get their items from every protocol; we can't
+			 * prune anything.
+			 */
+			goto done;
+		}
+		prune_add_needed(needed, todo, proto_id);
+	}
+
+	/*
+	 * Postdissectors look at fields from other protocols; keep the
+	 * protocols those come from.
+	 */
+	for (i = 0; postdissectors != NULL && i < postdissectors->len; i++) {
+		GArray *wanted_hfids = POSTDISSECTORS(i).wanted_hfids;
+
+		for (j = 0; wanted_hfids != NULL && j < wanted_hfids->len; j++) {
+			hfid = g_array_index(wanted_hfids, int, j);
+			prune_add_needed(needed, todo,
+			    proto_registrar_is_protocol(hfid) ? hfid : proto_registrar_get_parent(hfid));
+		}
+	}
+
+	for (entry = stateful_protocols; entry; entry = g_slist_next(entry))
+		prune_add_needed(needed, todo, GPOINTER_TO_INT(entry->data));
+
+	/*
+	 * Everything that can lead to a needed protocol, through a
+	 * dissector table, a heuristic list or a registered dependency,
+	 * is needed as well.
+	 */
+	parents = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_hash_table_foreach(depend_dissector_lists, prune_add_parents, parents);
+
+	while (!g_queue_is_empty(todo)) {
+		proto_id = GPOINTER_TO_INT(g_queue_pop_head(todo));
+		entry = (GSList *)g_hash_table_lookup(parents, GINT_TO_POINTER(proto_id));
+		for (; entry; entry = g_slist_next(entry))
+			prune_add_needed(needed, todo, GPOINTER_TO_INT(entry->data));
+	}
+
+	g_hash_table_foreach(parents, prune_free_parents, NULL);
+	g_hash_table_destroy(parents);
+
+	for (proto_id = proto_get_first_protocol(&cookie); proto_id != -1;
+	     proto_id = proto_get_next_protocol(&cookie)) {
+		if (g_hash_table_contains(needed, GINT_TO_POINTER(proto_id)))
+			continue;
+		if (proto_is_pino(find_protocol_by_id(proto_id)) ||
+		    !proto_can_toggle_protocol(proto_id) ||
+		    g_str_has_prefix(proto_get_protocol_filter_name(proto_id), "_ws."))
+			continue;
+
+		proto_set_pruned(proto_id, TRUE);
+		pruned = TRUE;
+	}
+
+done:
+	g_queue_free(todo);
+	g_hash_table_destroy(needed);
+
+	return pruned;
+}
+
 /*
  * Dumps the "layer type"/"decode as" associations to stdout, similar
  * to the proto_registrar_dump_*() routines.
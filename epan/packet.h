@@ -648,6 +648,34 @@ WS_DLL_PUBLIC gboolean deregister_depend_dissector(const char* parent, const cha
  */
 WS_DLL_PUBLIC depend_dissector_list_t find_depend_dissector_list(const char* name);
 
+/** Register a protocol that has to be dissected even when pruning would
+ * skip it, because it keeps state that other protocols rely on and
+ * that isn't reflected in the protocol dependencies.
+ *
+ *   @param proto_id Protocol id
+ */
+WS_DLL_PUBLIC void register_stateful_protocol(const int proto_id);
+
+/** Restrict dissection to the protocols needed to produce a set of fields.
+ * The protocols the fields belong to, the protocols that can lead to
+ * them according to the protocol dependencies (see register_depend_dissector),
+ * the protocols of fields wanted by postdissectors and the protocols
+ * registered with register_stateful_protocol() keep being dissected; all
+ * others are treated as disabled until the next call.
+ *
+ * Dependencies that are not registered, e.g. a dissector calling a
+ * handle found with find_dissector() rather than with
+ * find_dissector_add_dependency(), or setting up a conversation for
+ * another protocol without registering that protocol as a dependency,
+ * are not known, so this is only safe to use when the caller can
+ * accept that.
+ *
+ *   @param hfids GArray of the hfids of the fields and protocols that
+ *   are used, or NULL to stop pruning
+ *   @return TRUE if any protocol was pruned
+ */
+WS_DLL_PUBLIC gboolean prune_protocols(GArray *hfids);
+
 
 /* Do all one-time initialization. */
 extern void dissect_init(void);
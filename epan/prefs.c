@@ -3380,6 +3380,18 @@ prefs_register_modules(void)
                                    "The maximum depth of the dissection tree (Increase with caution)",
                                    10,
                                    &prefs.gui_max_tree_depth);
+    prefs_register_uint_preference(gui_module, "field_cache_size",
+                                   "Display filter field cache size (MB)",
+                                   "The amount of memory used to remember the values of the fields display filters "
+                                   "refer to, so that changing the display filter doesn't require dissecting every "
+                                   "packet again (0 disables the cache)",
+                                   10,
+                                   &prefs.gui_field_cache_size);
+    prefs_register_bool_preference(gui_module, "write_capture_index",
+                                   "Write an index of opened capture files",
+                                   "Write a \"<file>.gzidx\" index of the places a gzip-compressed capture file can be read from, "
+                                   "so that it needn't be decompressed from the start again when it's reopened",
+                                   &prefs.gui_write_capture_index);
 
 
     /* User Interface : Layout */
@@ -4199,6 +4211,8 @@ pre_init_prefs(void)
     prefs.gui_max_export_objects     = 1000;
     prefs.gui_max_tree_items = 1 * 1000 * 1000;
     prefs.gui_max_tree_depth = 5 * 100;
+    prefs.gui_field_cache_size = 0;
+    prefs.gui_write_capture_index = FALSE;
     prefs.gui_decimal_places1 = DEF_GUI_DECIMAL_PLACES1;
     prefs.gui_decimal_places2 = DEF_GUI_DECIMAL_PLACES2;
     prefs.gui_decimal_places3 = DEF_GUI_DECIMAL_PLACES3;
@@ -178,6 +178,8 @@ typedef struct _e_prefs {
   guint        gui_max_export_objects;
   guint        gui_max_tree_items;
   guint        gui_max_tree_depth;
+  guint        gui_field_cache_size;
+  gboolean     gui_write_capture_index;
   layout_type_e gui_layout_type;
   layout_pane_content_e gui_layout_content_1;
   layout_pane_content_e gui_layout_content_2;
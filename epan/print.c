@@ -28,7 +28,9 @@
 #include <epan/print.h>
 #include <epan/charsets.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/arrow_writer.h>
 #include <wsutil/filesystem.h>
+#include <wsutil/strtoi.h>
 #include <version_info.h>
 #include <wsutil/utf8_entities.h>
 #include <ftypes/ftypes-int.h>
@@ -75,14 +77,32 @@ struct _output_fields {
     gboolean      print_header;
     gchar         separator;
     gchar         occurrence;
+    guint         occurrence_num;   /* with occurrence 'n' */
     gchar         aggregator;
     GPtrArray    *fields;
     GHashTable   *field_indicies;
     GPtrArray   **field_values;
+    guint        *occurrence_counts; /* of the current packet */
     gchar         quote;
     gboolean      includes_col_fields;
+    arrow_writer *arrow;            /* -T arrow */
+    arrow_column_type *arrow_types;
+    field_info  **arrow_values;     /* of the current packet */
+    const gchar **arrow_col_values; /* of the current packet */
+    header_field_info **sink_hfinfos; /* of the fields, if the values are
+                                         read from a field sink; NULL
+                                         for columns */
+    GArray       *sink_values;      /* sink_value_t, of the current packet */
+    GHashTable   *sink_positions;   /* node -> its position in the sink,
+                                       counting from 1 */
 };
 
+/* A node from a field sink, and the index of its field. */
+typedef struct {
+    proto_node *node;
+    guint       indx;
+} sink_value_t;
+
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
 static void proto_tree_print_node(proto_node *node, gpointer data);
 static void proto_tree_write_node_pdml(proto_node *node, gpointer data);
@@ -762,6 +782,10 @@ write_json_proto_tree(output_fields_t* fields,
 
     json_dumper_end_object(dumper);
     json_dumper_end_object(dumper);
+
+    /* The array goes on, but the packet should be out (and write errors
+     * seen) before the next one is dissected. */
+    json_dumper_flush(dumper);
 }
 
 /**
@@ -2095,6 +2119,17 @@ void output_fields_free(output_fields_t* fields)
         if (NULL != fields->field_values) {
             g_free(fields->field_values);
         }
+        g_free(fields->occurrence_counts);
+
+        arrow_writer_free(fields->arrow);
+        g_free(fields->arrow_types);
+        g_free(fields->arrow_values);
+        g_free(fields->arrow_col_values);
+        g_free(fields->sink_hfinfos);
+        if (NULL != fields->sink_values) {
+            g_array_free(fields->sink_values, TRUE);
+            g_hash_table_destroy(fields->sink_positions);
+        }
 
         for (i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
@@ -2216,10 +2251,17 @@ gboolean output_fields_set_option(output_fields_t *info, gchar *option)
         case 'f':
         case 'l':
         case 'a':
+            if (option_value[1] != '\0')
+                return FALSE;
             info->occurrence = *option_value;
             break;
         default:
-            return FALSE;
+            /* The number of the occurrence, starting at 1 */
+            if (!ws_strtou32(option_value, NULL, &info->occurrence_num) ||
+                info->occurrence_num == 0)
+                return FALSE;
+            info->occurrence = 'n';
+            break;
         }
         return TRUE;
     }
@@ -2280,7 +2322,7 @@ void output_fields_list_options(FILE *fh)
     fputs("bom=y|n    Prepend output with the UTF-8 BOM (def: N: no)\n", fh);
     fputs("header=y|n    Print field abbreviations as first line of output (def: N: no)\n", fh);
     fputs("separator=/t|/s|<character>   Set the separator to use;\n     \"/t\" = tab, \"/s\" = space (def: /t: tab)\n", fh);
-    fputs("occurrence=f|l|a  Select the occurrence of a field to use;\n     \"f\" = first, \"l\" = last, \"a\" = all (def: a: all)\n", fh);
+    fputs("occurrence=f|l|a|<number>  Select the occurrence of a field to use;\n     \"f\" = first, \"l\" = last, \"a\" = all, <number> = that one,\n     counting from 1 (def: a: all)\n", fh);
     fputs("aggregator=,|/s|<character>   Set the aggregator to use;\n     \",\" = comma, \"/s\" = space (def: ,: comma)\n", fh);
     fputs("quote=d|s|n   Print either d: double-quotes, s: single quotes or \n     n: no quotes around field values (def: n: none)\n", fh);
 }
@@ -2291,6 +2333,76 @@ gboolean output_fields_has_cols(output_fields_t* fields)
     return fields->includes_col_fields;
 }
 
+void output_fields_get_hfids(output_fields_t* fields, GArray *hfids)
+{
+    gsize i;
+    header_field_info *hfinfo;
+
+    g_assert(fields);
+    g_assert(hfids);
+
+    if (fields->fields == NULL)
+        return;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+
+        /* Columns aren't fields; see output_fields_has_cols() */
+        for (hfinfo = proto_registrar_get_byname(field); hfinfo; hfinfo = hfinfo->same_name_next)
+            g_array_append_val(hfids, hfinfo->id);
+    }
+}
+
+gboolean output_fields_use_field_sink(output_fields_t* fields)
+{
+    gsize i;
+    header_field_info *hfinfo;
+
+    g_assert(fields);
+
+    if (fields->fields == NULL)
+        return FALSE;
+
+    if (fields->sink_hfinfos != NULL)
+        return TRUE;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+
+        /* The value of a protocol, or of a text item, is the text of
+         * its item, which an invisible tree doesn't have. */
+        for (hfinfo = proto_registrar_get_byname(field); hfinfo; hfinfo = hfinfo->same_name_next) {
+            if (hfinfo->type == FT_PROTOCOL || hfinfo->id == hf_text_only)
+                return FALSE;
+        }
+    }
+
+    fields->sink_hfinfos = g_new0(header_field_info *, fields->fields->len);
+    for (i = 0; i < fields->fields->len; i++) {
+        gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+
+        /* Columns aren't fields, and are left NULL */
+        fields->sink_hfinfos[i] = proto_registrar_get_byname(field);
+    }
+    fields->sink_values = g_array_new(FALSE, FALSE, sizeof(sink_value_t));
+    fields->sink_positions = g_hash_table_new(g_direct_hash, g_direct_equal);
+    return TRUE;
+}
+
+void output_fields_prime_edt(output_fields_t* fields, epan_dissect_t *edt)
+{
+    gsize i;
+    header_field_info *hfinfo;
+
+    g_assert(fields);
+    g_assert(fields->sink_hfinfos);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        for (hfinfo = fields->sink_hfinfos[i]; hfinfo; hfinfo = hfinfo->same_name_next)
+            epan_dissect_prime_with_hfid(edt, hfinfo->id);
+    }
+}
+
 void write_fields_preamble(output_fields_t* fields, FILE *fh)
 {
     gsize i;
@@ -2363,6 +2475,13 @@ static void format_field_values(output_fields_t* fields, gpointer field_index, g
             g_ptr_array_set_size(fv_p, 0);
         }
         break;
+    case 'n':
+        /* print the value of only the occurrence with that number */
+        if (++fields->occurrence_counts[indx] != fields->occurrence_num) {
+            g_free(value);
+            return;
+        }
+        break;
     case 'a':
         /* print the value of all accurrences of the field */
         if (g_ptr_array_len(fv_p) != 0) {
@@ -2408,6 +2527,125 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     }
 }
 
+static guint sink_node_depth(proto_node *node)
+{
+    guint depth = 0;
+
+    for (; node->parent != NULL; node = node->parent)
+        depth++;
+    return depth;
+}
+
+/*
+ * Compares the places of two nodes in the protocol tree: a node comes
+ * after its ancestors, and after the subtrees of the children of its
+ * parent that were added before it.
+ */
+static gint compare_sink_values(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    GHashTable *positions = (GHashTable *)user_data;
+    proto_node *node_a = ((const sink_value_t *)a)->node;
+    proto_node *node_b = ((const sink_value_t *)b)->node;
+    guint       depth_a = sink_node_depth(node_a);
+    guint       depth_b = sink_node_depth(node_b);
+
+    if (node_a == node_b)
+        return 0;
+    for (; depth_a > depth_b; depth_a--) {
+        node_a = node_a->parent;
+        if (node_a == node_b)
+            return 1;
+    }
+    for (; depth_b > depth_a; depth_b--) {
+        node_b = node_b->parent;
+        if (node_b == node_a)
+            return -1;
+    }
+    while (node_a->parent != node_b->parent) {
+        node_a = node_a->parent;
+        node_b = node_b->parent;
+    }
+    return GPOINTER_TO_UINT(g_hash_table_lookup(positions, node_a)) <
+           GPOINTER_TO_UINT(g_hash_table_lookup(positions, node_b)) ? -1 : 1;
+}
+
+/*
+ * Get the nodes of the fields from the field sink, in the order in which
+ * they are in the protocol tree.  Every node of the sink is a child of
+ * the root, in the order in which it was added, and records its parent,
+ * so a dissector that adds to an earlier subtree later doesn't change
+ * the order.  Items that were faked have no node, so the children of one
+ * are taken to be children of its parent.
+ */
+static void get_field_sink_nodes(output_fields_t *fields, epan_dissect_t *edt)
+{
+    proto_node  *node;
+    field_info  *fi;
+    gpointer     field_index;
+    guint        position = 0;
+    sink_value_t value;
+
+    g_array_set_size(fields->sink_values, 0);
+    g_hash_table_remove_all(fields->sink_positions);
+
+    for (node = edt->tree->first_child; node != NULL; node = node->next) {
+        fi = PNODE_FINFO(node);
+
+        /* dissection with an invisible proto tree? */
+        g_assert(fi);
+
+        g_hash_table_insert(fields->sink_positions, node, GUINT_TO_POINTER(++position));
+        field_index = g_hash_table_lookup(fields->field_indicies, fi->hfinfo->abbrev);
+        if (NULL != field_index) {
+            value.node = node;
+            value.indx = GPOINTER_TO_UINT(field_index) - 1;
+            g_array_append_val(fields->sink_values, value);
+        }
+    }
+
+    if (fields->sink_values->len > 1)
+        g_array_sort_with_data(fields->sink_values, compare_sink_values,
+                               fields->sink_positions);
+}
+
+static void get_field_sink_values(output_fields_t *fields, epan_dissect_t *edt)
+{
+    guint         i;
+    sink_value_t *value;
+
+    get_field_sink_nodes(fields, edt);
+    for (i = 0; i < fields->sink_values->len; i++) {
+        value = &g_array_index(fields->sink_values, sink_value_t, i);
+        format_field_values(fields, GUINT_TO_POINTER(value->indx + 1),
+                            get_node_field_value(PNODE_FINFO(value->node), edt) /* g_ alloc'd string */
+            );
+    }
+}
+
+static void prepare_field_indicies(output_fields_t *fields)
+{
+    gsize i;
+
+    if (NULL == fields->field_indicies) {
+        /* Prepare a lookup table from string abbreviation for field to its index. */
+        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+
+        i = 0;
+        while (i < fields->fields->len) {
+            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+            /* Store field indicies +1 so that zero is not a valid value,
+             * and can be distinguished from NULL as a pointer.
+             */
+            ++i;
+            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
+        }
+        fields->occurrence_counts = g_new0(guint, fields->fields->len);
+    } else {
+        /* A new packet */
+        memset(fields->occurrence_counts, 0, fields->fields->len * sizeof(guint));
+    }
+}
+
 static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
 {
     gsize     i;
@@ -2430,20 +2668,7 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     data.fields = fields;
     data.edt = edt;
 
-    if (NULL == fields->field_indicies) {
-        /* Prepare a lookup table from string abbreviation for field to its index. */
-        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
-
-        i = 0;
-        while (i < fields->fields->len) {
-            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
-            /* Store field indicies +1 so that zero is not a valid value,
-             * and can be distinguished from NULL as a pointer.
-             */
-            ++i;
-            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
-        }
-    }
+    prepare_field_indicies(fields);
 
     /* Array buffer to store values for this packet              */
     /*  Allocate an array for the 'GPtrarray *' the first time   */
@@ -2454,8 +2679,11 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     if (NULL == fields->field_values)
         fields->field_values = g_new0(GPtrArray*, fields->fields->len);  /* free'd in output_fields_free() */
 
-    proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
-                                &data);
+    if (fields->sink_hfinfos != NULL)
+        get_field_sink_values(fields, edt);
+    else
+        proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
+                                    &data);
 
     /* Add columns to fields */
     if (fields->includes_col_fields) {
@@ -2596,6 +2824,264 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+/*
+ * -T arrow: the fields as typed columns of an Arrow IPC stream.  A column
+ * has only one value per packet, the first occurrence of the field (the
+ * last one with -E occurrence=l, or the one with that number with -E
+ * occurrence=<number>).  A field given more than once has the same value
+ * in each of its columns.
+ */
+
+static arrow_column_type arrow_column_type_for_ftype(ftenum_t type)
+{
+    switch (type) {
+    case FT_BOOLEAN:
+        return ARROW_COLUMN_BOOL;
+    case FT_CHAR:
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_FRAMENUM:
+    case FT_IPv4:
+        return ARROW_COLUMN_UINT32;
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        return ARROW_COLUMN_UINT64;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return ARROW_COLUMN_INT32;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return ARROW_COLUMN_INT64;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return ARROW_COLUMN_DOUBLE;
+    case FT_ABSOLUTE_TIME:
+        return ARROW_COLUMN_TIMESTAMP;
+    case FT_RELATIVE_TIME:
+        return ARROW_COLUMN_DURATION;
+    case FT_BYTES:
+    case FT_UINT_BYTES:
+        return ARROW_COLUMN_BINARY;
+    default:
+        /* As it would be printed with -T fields. */
+        return ARROW_COLUMN_STRING;
+    }
+}
+
+/* Fields that share a name but not a column type are strings. */
+static arrow_column_type arrow_column_type_for_field(const gchar *field)
+{
+    header_field_info *hfinfo;
+    arrow_column_type  type;
+
+    if (!strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)))
+        return ARROW_COLUMN_STRING;
+
+    hfinfo = proto_registrar_get_byname(field);
+    if (!hfinfo)
+        return ARROW_COLUMN_STRING;
+    type = arrow_column_type_for_ftype(hfinfo->type);
+    for (hfinfo = hfinfo->same_name_next; hfinfo; hfinfo = hfinfo->same_name_next) {
+        if (arrow_column_type_for_ftype(hfinfo->type) != type)
+            return ARROW_COLUMN_STRING;
+    }
+    return type;
+}
+
+void write_arrow_preamble(output_fields_t* fields, FILE *fh)
+{
+    gsize i;
+
+    g_assert(fields);
+    g_assert(fh);
+    g_assert(fields->fields);
+
+    fields->arrow = arrow_writer_new(fh, 0);
+    fields->arrow_types = g_new(arrow_column_type, fields->fields->len);
+    fields->arrow_values = g_new0(field_info *, fields->fields->len);
+    fields->arrow_col_values = g_new0(const gchar *, fields->fields->len);
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+
+        fields->arrow_types[i] = arrow_column_type_for_field(field);
+        arrow_writer_add_column(fields->arrow, field, fields->arrow_types[i]);
+    }
+}
+
+/* Whether this occurrence of the field with that index is the one to write. */
+static gboolean arrow_use_occurrence(output_fields_t *fields, guint indx)
+{
+    guint count = ++fields->occurrence_counts[indx];
+
+    switch (fields->occurrence) {
+    case 'l':
+        return TRUE;
+    case 'n':
+        return count == fields->occurrence_num;
+    default:
+        return count == 1;
+    }
+}
+
+static void proto_tree_get_node_arrow_values(proto_node *node, gpointer data)
+{
+    output_fields_t *fields = (output_fields_t *)data;
+    field_info      *fi = PNODE_FINFO(node);
+    gpointer         field_index;
+    guint            indx;
+
+    /* dissection with an invisible proto tree? */
+    g_assert(fi);
+
+    field_index = g_hash_table_lookup(fields->field_indicies, fi->hfinfo->abbrev);
+    if (NULL != field_index) {
+        indx = GPOINTER_TO_UINT(field_index) - 1;
+        if (arrow_use_occurrence(fields, indx))
+            fields->arrow_values[indx] = fi;
+    }
+
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_arrow_values,
+                                    fields);
+    }
+}
+
+static void get_field_sink_arrow_values(output_fields_t *fields, epan_dissect_t *edt)
+{
+    guint         i;
+    sink_value_t *value;
+
+    get_field_sink_nodes(fields, edt);
+    for (i = 0; i < fields->sink_values->len; i++) {
+        value = &g_array_index(fields->sink_values, sink_value_t, i);
+        if (arrow_use_occurrence(fields, value->indx))
+            fields->arrow_values[value->indx] = PNODE_FINFO(value->node);
+    }
+}
+
+static void write_arrow_value(output_fields_t *fields, guint indx, field_info *fi, epan_dissect_t *edt)
+{
+    arrow_writer *writer = fields->arrow;
+    const nstime_t *ts;
+    const guint8 *bytes;
+    gchar *str;
+
+    switch (fields->arrow_types[indx]) {
+    case ARROW_COLUMN_BOOL:
+    case ARROW_COLUMN_UINT64:
+        arrow_writer_append_uint(writer, indx, fvalue_get_uinteger64(&fi->value));
+        break;
+    case ARROW_COLUMN_UINT32:
+        if (fi->hfinfo->type == FT_IPv4) {
+            /* As a number, 10.0.0.1 being 0x0a000001 */
+            arrow_writer_append_uint(writer, indx, g_ntohl(fvalue_get_uinteger(&fi->value)));
+        } else {
+            arrow_writer_append_uint(writer, indx, fvalue_get_uinteger(&fi->value));
+        }
+        break;
+    case ARROW_COLUMN_INT32:
+        arrow_writer_append_int(writer, indx, fvalue_get_sinteger(&fi->value));
+        break;
+    case ARROW_COLUMN_INT64:
+        arrow_writer_append_int(writer, indx, fvalue_get_sinteger64(&fi->value));
+        break;
+    case ARROW_COLUMN_DOUBLE:
+        arrow_writer_append_double(writer, indx, fvalue_get_floating(&fi->value));
+        break;
+    case ARROW_COLUMN_TIMESTAMP:
+    case ARROW_COLUMN_DURATION:
+        ts = (const nstime_t *)fvalue_get(&fi->value);
+        arrow_writer_append_int(writer, indx, (gint64)ts->secs * 1000000000 + ts->nsecs);
+        break;
+    case ARROW_COLUMN_BINARY:
+        /* an empty byte array may have no data, but it's still a value */
+        bytes = (const guint8 *)fvalue_get(&fi->value);
+        arrow_writer_append_bytes(writer, indx, bytes, bytes ? fvalue_length(&fi->value) : 0);
+        break;
+    case ARROW_COLUMN_STRING:
+    default:
+        str = get_node_field_value(fi, edt);
+        arrow_writer_append_string(writer, indx, str);
+        g_free(str);
+        break;
+    }
+}
+
+void write_arrow_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo)
+{
+    gsize     i;
+    guint     indx;
+    gint      col;
+    gchar    *col_name;
+    gpointer  field_index;
+
+    g_assert(fields);
+    g_assert(fields->arrow);
+    g_assert(edt);
+
+    prepare_field_indicies(fields);
+
+    if (fields->sink_hfinfos != NULL)
+        get_field_sink_arrow_values(fields, edt);
+    else
+        proto_tree_children_foreach(edt->tree, proto_tree_get_node_arrow_values,
+                                    fields);
+
+    /* Several columns can have the same title */
+    if (fields->includes_col_fields) {
+        for (col = 0; col < cinfo->num_cols; col++) {
+            if (!get_column_visible(col))
+                continue;
+            col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
+            field_index = g_hash_table_lookup(fields->field_indicies, col_name);
+            g_free(col_name);
+
+            if (NULL != field_index) {
+                indx = GPOINTER_TO_UINT(field_index) - 1;
+                if (arrow_use_occurrence(fields, indx))
+                    fields->arrow_col_values[indx] = cinfo->columns[col].col_data;
+            }
+        }
+    }
+
+    /*
+     * The values are found at the index of the last column of a field
+     * given more than once, and written to each of its columns.
+     */
+    for (i = 0; i < fields->fields->len; i++) {
+        field_index = g_hash_table_lookup(fields->field_indicies,
+                                          g_ptr_array_index(fields->fields, i));
+        indx = GPOINTER_TO_UINT(field_index) - 1;
+        if (fields->arrow_values[indx] != NULL)
+            write_arrow_value(fields, (guint)i, fields->arrow_values[indx], edt);
+        else if (fields->arrow_col_values[indx] != NULL)
+            arrow_writer_append_string(fields->arrow, (guint)i, fields->arrow_col_values[indx]);
+    }
+    memset(fields->arrow_values, 0, fields->fields->len * sizeof(field_info *));
+    memset(fields->arrow_col_values, 0, fields->fields->len * sizeof(const gchar *));
+
+    arrow_writer_end_row(fields->arrow);
+}
+
+void write_arrow_finale(output_fields_t* fields)
+{
+    g_assert(fields);
+
+    if (fields->arrow) {
+        arrow_writer_finish(fields->arrow);
+        arrow_writer_free(fields->arrow);
+        fields->arrow = NULL;
+    }
+}
+
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -2727,12 +3213,21 @@ output_fields_t* output_fields_new(void)
     fields->print_header        = FALSE;
     fields->separator           = '\t';
     fields->occurrence          = 'a';
+    fields->occurrence_num      = 0;
     fields->aggregator          = ',';
     fields->fields              = NULL; /*Do lazy initialisation */
     fields->field_indicies      = NULL;
     fields->field_values        = NULL;
+    fields->occurrence_counts   = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->arrow               = NULL;
+    fields->arrow_types         = NULL;
+    fields->arrow_values        = NULL;
+    fields->arrow_col_values    = NULL;
+    fields->sink_hfinfos        = NULL;
+    fields->sink_values         = NULL;
+    fields->sink_positions      = NULL;
     return fields;
 }
 
@@ -70,6 +70,17 @@ WS_DLL_PUBLIC gsize output_fields_num_fields(output_fields_t* info);
 WS_DLL_PUBLIC gboolean output_fields_set_option(output_fields_t* info, gchar* option);
 WS_DLL_PUBLIC void output_fields_list_options(FILE *fh);
 WS_DLL_PUBLIC gboolean output_fields_has_cols(output_fields_t* info);
+WS_DLL_PUBLIC void output_fields_get_hfids(output_fields_t* info, GArray *hfids);
+
+/*
+ * Get the values of the fields from a field sink (see
+ * epan_dissect_field_sink()) rather than from the protocol tree.  Returns
+ * FALSE if that can't be done because some field needs the tree.  If it
+ * returns TRUE, the epan_dissect_t must be primed with
+ * output_fields_prime_edt() before each dissection.
+ */
+WS_DLL_PUBLIC gboolean output_fields_use_field_sink(output_fields_t* info);
+WS_DLL_PUBLIC void output_fields_prime_edt(output_fields_t* info, epan_dissect_t *edt);
 
 /*
  * Higher-level packet-printing code.
@@ -125,6 +136,10 @@ WS_DLL_PUBLIC void write_fields_preamble(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
 WS_DLL_PUBLIC void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+WS_DLL_PUBLIC void write_arrow_preamble(output_fields_t* fields, FILE *fh);
+WS_DLL_PUBLIC void write_arrow_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo);
+WS_DLL_PUBLIC void write_arrow_finale(output_fields_t* fields);
+
 WS_DLL_PUBLIC gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 extern void print_cache_field_handles(void);
@@ -350,6 +350,7 @@ struct _protocol {
 	gboolean    is_enabled;         /* TRUE if protocol is enabled */
 	gboolean    enabled_by_default; /* TRUE if protocol is enabled by default */
 	gboolean    can_toggle;         /* TRUE if is_enabled can be changed */
+	gboolean    is_pruned;          /* TRUE if nothing needs this protocol dissected */
 	int         parent_proto_id;    /* Used to identify "pino"s (Protocol In Name Only).
                                        For dissectors that need a protocol name so they
                                        can be added to a dissector table, but use the
@@ -774,6 +775,10 @@ proto_tree_reset(proto_tree *tree)
 	/* Reset track of the number of children */
 	tree_data->count = 0;
 
+	/* The filter results were for the previous dissection */
+	g_free(tree_data->dfilter_results);
+	tree_data->dfilter_results = NULL;
+
 	PROTO_NODE_INIT(tree);
 }
 
@@ -795,6 +800,8 @@ proto_tree_free(proto_tree *tree)
 		g_hash_table_destroy(tree_data->interesting_hfids);
 	}
 
+	g_free(tree_data->dfilter_results);
+
 	g_slice_free(tree_data_t, tree_data);
 
 	g_slice_free(proto_tree, tree);
@@ -820,6 +827,12 @@ proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols)
 	PTREE_DATA(tree)->fake_protocols = fake_protocols;
 }
 
+void
+proto_tree_set_field_sink(proto_tree *tree, gboolean field_sink)
+{
+	PTREE_DATA(tree)->field_sink = field_sink;
+}
+
 /* Assume dissector set only its protocol fields.
    This function is called by dissectors and allows the speeding up of filtering
    in wireshark; if this function returns FALSE it is safe to reset tree to NULL
@@ -5827,6 +5840,47 @@ proto_tree_set_eui64_tvb(field_info *fi, tvbuff_t *tvb, gint start, const guint
 	}
 }
 
+/*
+ * Add a field_info struct to a field sink.  Only the primed fields and the
+ * items the dissectors add directly to the root get this far in an
+ * invisible tree, and the primed fields are read from the interesting_hfids
+ * arrays, so every node goes on the list of children of the root, where it
+ * is freed with the tree, rather than on that of its parent.  The parent is
+ * still recorded, for proto_item_get_parent() and for limiting the depth.
+ */
+static proto_item *
+proto_tree_add_node_to_sink(proto_tree *tree, field_info *fi)
+{
+	proto_node *pnode, *root;
+	guint depth = 1;
+
+	for (root = tree; root->parent != NULL; root = root->parent) {
+		depth++;
+		if (G_UNLIKELY(depth > prefs.gui_max_tree_depth)) {
+			THROW_MESSAGE(DissectorError, wmem_strdup_printf(wmem_packet_scope(),
+					     "Maximum tree depth %d exceeded for \"%s\" - \"%s\" (%s:%u) (Maximum depth can be increased in advanced preferences)",
+					     prefs.gui_max_tree_depth,
+					     fi->hfinfo->name, fi->hfinfo->abbrev, G_STRFUNC, __LINE__));
+		}
+	}
+
+	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_INIT(pnode);
+	pnode->parent = tree;
+	PNODE_FINFO(pnode) = fi;
+	pnode->tree_data = PTREE_DATA(tree);
+
+	if (root->last_child != NULL)
+		root->last_child->next = pnode;
+	else
+		root->first_child = pnode;
+	root->last_child = pnode;
+
+	tree_data_add_maybe_interesting_field(pnode->tree_data, fi);
+
+	return (proto_item *)pnode;
+}
+
 /* Add a field_info struct to the proto_tree, encapsulating it in a proto_node */
 static proto_item *
 proto_tree_add_node(proto_tree *tree, field_info *fi)
@@ -5835,6 +5889,9 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 	field_info *tfi;
 	guint depth = 1;
 
+	if (PTREE_DATA(tree)->field_sink && !PTREE_DATA(tree)->visible)
+		return proto_tree_add_node_to_sink(tree, fi);
+
 	/*
 	 * Restrict our depth. proto_tree_traverse_pre_order and
 	 * proto_tree_traverse_post_order (and possibly others) are recursive
@@ -7114,9 +7171,13 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Make sure that we fake protocols (if possible) */
 	pnode->tree_data->fake_protocols = TRUE;
 
+	pnode->tree_data->field_sink = FALSE;
+
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
+	pnode->tree_data->dfilter_results = NULL;
+
 	return (proto_tree *)pnode;
 }
 
@@ -7364,6 +7425,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->is_enabled = TRUE; /* protocol is enabled by default */
 	protocol->enabled_by_default = TRUE; /* see previous comment */
 	protocol->can_toggle = TRUE;
+	protocol->is_pruned = FALSE;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
 
@@ -7422,6 +7484,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 	protocol->is_enabled = TRUE;
 	protocol->enabled_by_default = TRUE;
 	protocol->can_toggle = TRUE;
+	protocol->is_pruned = FALSE;
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
@@ -7768,6 +7831,12 @@ proto_is_pino(const protocol_t *protocol)
 	return (protocol->parent_proto_id != -1);
 }
 
+int
+proto_get_parent_proto_id(const protocol_t *protocol)
+{
+	return protocol->parent_proto_id;
+}
+
 gboolean
 proto_is_protocol_enabled(const protocol_t *protocol)
 {
@@ -7781,6 +7850,18 @@ proto_is_protocol_enabled(const protocol_t *protocol)
 	return protocol->is_enabled;
 }
 
+gboolean
+proto_is_protocol_pruned(const protocol_t *protocol)
+{
+	if (protocol == NULL)
+		return FALSE;
+
+	if (proto_is_pino(protocol))
+		return proto_is_protocol_pruned(find_protocol_by_id(protocol->parent_proto_id));
+
+	return protocol->is_pruned;
+}
+
 gboolean
 proto_is_protocol_enabled_by_default(const protocol_t *protocol)
 {
@@ -7844,6 +7925,26 @@ proto_reenable_all(void)
 	}
 }
 
+void
+proto_set_pruned(const int proto_id, const gboolean pruned)
+{
+	protocol_t *protocol;
+
+	protocol = find_protocol_by_id(proto_id);
+	DISSECTOR_ASSERT(protocol->can_toggle);
+	DISSECTOR_ASSERT(proto_is_pino(protocol) == FALSE);
+	protocol->is_pruned = pruned;
+}
+
+void
+proto_unprune_all(void)
+{
+	GList *list_item;
+
+	for (list_item = protocols; list_item; list_item = g_list_next(list_item))
+		((protocol_t *)list_item->data)->is_pruned = FALSE;
+}
+
 void
 proto_set_cant_toggle(const int proto_id)
 {
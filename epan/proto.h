@@ -851,8 +851,15 @@ typedef struct {
     GHashTable          *interesting_hfids;
     gboolean             visible;
     gboolean             fake_protocols;
+    gboolean             field_sink;      /* only collecting the primed
+                                             fields; see
+                                             proto_tree_set_field_sink() */
     guint                count;
     struct _packet_info *pinfo;
+    gpointer             dfilter_results; /* results of the display filters
+                                             applied to the tree; owned by
+                                             the dfilter code, g_free()d
+                                             when the tree is reset */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1170,6 +1177,15 @@ proto_tree_set_visible(proto_tree *tree, gboolean visible);
 extern void
 proto_tree_set_fake_protocols(proto_tree *tree, gboolean fake_protocols);
 
+/** Use an invisible tree only to collect the values of the "interesting"
+ (primed) fields, which are then read with proto_get_finfo_ptr_array().
+ The items for those fields are all added to the root of the tree, so
+ that no hierarchy is kept and the tree can't be walked for anything else.
+ @param tree the tree to be set
+ @param field_sink TRUE to use the tree as a field sink */
+extern void
+proto_tree_set_field_sink(proto_tree *tree, gboolean field_sink);
+
 /** Mark a field/protocol ID as "interesting".
  @param tree the tree to be set (currently ignored)
  @param hfid the interesting field id
@@ -2603,6 +2619,10 @@ WS_DLL_PUBLIC gboolean proto_is_protocol_enabled_by_default(const protocol_t *pr
  @return TRUE if helper, FALSE if not */
 WS_DLL_PUBLIC gboolean proto_is_pino(const protocol_t *protocol);
 
+/** Get the protocol a protocol in name only belongs to.
+ @return the parent protocol id for a helper, -1 if not a helper */
+WS_DLL_PUBLIC int proto_get_parent_proto_id(const protocol_t *protocol);
+
 /** Get a protocol's filter name by its item number.
  @param proto_id protocol id (0-indexed)
  @return its filter name. */
@@ -2663,6 +2683,23 @@ WS_DLL_PUBLIC void proto_set_decoding(const int proto_id, const gboolean enabled
 /** Re-enable all protocols that are not marked as disabled by default. */
 WS_DLL_PUBLIC void proto_reenable_all(void);
 
+/** Is this protocol pruned, i.e. skipped while dissecting even though
+ it is enabled? See prune_protocols().
+ @param protocol the protocol
+ @return TRUE if pruned, FALSE if not */
+WS_DLL_PUBLIC gboolean proto_is_protocol_pruned(const protocol_t *protocol);
+
+/** Prune / unprune protocol of the given item number. A pruned protocol
+ is skipped while dissecting like a disabled one, but its enabled state
+ (and so what is saved as the disabled protocols) is not changed; see
+ prune_protocols().
+ @param proto_id protocol id (0-indexed)
+ @param pruned prune / unprune the protocol */
+WS_DLL_PUBLIC void proto_set_pruned(const int proto_id, const gboolean pruned);
+
+/** Unprune all protocols. */
+WS_DLL_PUBLIC void proto_unprune_all(void);
+
 /** Disable disabling/enabling of protocol of the given item number.
  @param proto_id protocol id (0-indexed) */
 WS_DLL_PUBLIC void proto_set_cant_toggle(const int proto_id);
@@ -532,6 +532,12 @@ reassembly_table_destroy(reassembly_table *table)
 	}
 }
 
+void
+reassembly_table_set_composite(reassembly_table *table, gboolean composite)
+{
+	table->composite_data = composite;
+}
+
 /*
  * Look up an fd_head in the fragment table, optionally returning the key
  * for it.
@@ -989,8 +995,51 @@ MERGE_FRAG(fragment_head *fd_head, fragment_item *fd)
  * with the new fragment. FD_TOOLONGFRAGMENT and FD_MULTIPLETAILS flags
  * are lowered when a new extension process is started.
  */
+/*
+ * Returns TRUE if the fragments of a reassembly that has all of them fit
+ * together with neither gaps nor overlaps, so that the reassembled data
+ * can be made of their data as it is.
+ */
 static gboolean
-fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
+fragments_are_contiguous(const fragment_head *fd_head)
+{
+	const fragment_item *fd_i;
+	guint32 dfpos = 0;
+
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (!fd_i->len || fd_i->offset >= fd_head->datalen)
+			continue;
+		if (fd_i->offset != dfpos || !fd_i->tvb_data ||
+		    fd_i->offset + fd_i->len < fd_i->offset)
+			return FALSE;
+		dfpos = MIN(fd_i->offset + fd_i->len, fd_head->datalen);
+	}
+
+	return dfpos != 0 && dfpos == fd_head->datalen;
+}
+
+/*
+ * Appends the first len bytes of the data of a fragment to the composite
+ * tvbuff that is the reassembled data, which then owns it; the fragment
+ * keeps pointing to the data until the caller is done with it, but it's
+ * marked as a subset so that it isn't freed.
+ */
+static void
+fragment_add_to_composite(tvbuff_t *composite, fragment_item *fd, const guint32 len)
+{
+	tvbuff_t *member = fd->tvb_data;
+
+	if (!(fd->flags & FD_SUBSET_TVB))
+		tvb_composite_own(composite, fd->tvb_data);
+	if (len < tvb_captured_length(member))
+		member = tvb_new_subset_length_caplen(member, 0, len, len);
+	tvb_composite_append(composite, member);
+	fd->flags |= FD_SUBSET_TVB;
+}
+
+static gboolean
+fragment_add_work(const reassembly_table *table, fragment_head *fd_head,
+		 tvbuff_t *tvb, const int offset,
 		 const packet_info *pinfo, const guint32 frag_offset,
 		 const guint32 frag_data_len, const gboolean more_frags)
 {
@@ -998,7 +1047,8 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	fragment_item *fd_i;
 	guint32 max, dfpos, fraglen, overlap;
 	tvbuff_t *old_tvb_data;
-	guint8 *data;
+	tvbuff_t *composite = NULL;
+	guint8 *data = NULL;
 
 	/* create new fd describing this fragment */
 	fd = g_slice_new(fragment_item);
@@ -1190,9 +1240,19 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	 */
 	/* store old data just in case */
 	old_tvb_data=fd_head->tvb_data;
-	data = (guint8 *) g_malloc(fd_head->datalen);
-	fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
-	tvb_set_free_cb(fd_head->tvb_data, g_free);
+	if (table->composite_data && fragments_are_contiguous(fd_head)) {
+		/* Fragments made of the old data, if any, are subsets of it,
+		 * so it's kept as long as the new data. */
+		composite = tvb_new_composite();
+		if (old_tvb_data) {
+			tvb_composite_own(composite, old_tvb_data);
+			old_tvb_data = NULL;
+		}
+	} else {
+		data = (guint8 *) g_malloc(fd_head->datalen);
+		fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
+		tvb_set_free_cb(fd_head->tvb_data, g_free);
+	}
 
 	/* add all data fragments */
 	for (dfpos=0,fd_i=fd_head;fd_i;fd_i=fd_i->next) {
@@ -1300,9 +1360,14 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 				 * out rather than mixed with the new ones?
 				 */
 				if (fd_i->offset + fraglen > dfpos) {
-					memcpy(data+dfpos,
-						tvb_get_ptr(fd_i->tvb_data, overlap, fraglen-overlap),
-						fraglen-overlap);
+					if (composite) {
+						/* No overlaps, see above */
+						fragment_add_to_composite(composite, fd_i, fraglen);
+					} else {
+						memcpy(data+dfpos,
+							tvb_get_ptr(fd_i->tvb_data, overlap, fraglen-overlap),
+							fraglen-overlap);
+					}
 					dfpos = fd_i->offset + fraglen;
 				}
 			}
@@ -1316,6 +1381,10 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 		}
 	}
 
+	if (composite) {
+		tvb_composite_finalize(composite);
+		fd_head->tvb_data = composite;
+	}
 	if (old_tvb_data)
 		tvb_add_to_chain(tvb, old_tvb_data);
 	/* mark this packet as defragmented.
@@ -1508,7 +1577,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		insert_fd_head(table, fd_head, pinfo, id, data);
 	}
 
-	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
+	if (fragment_add_work(table, fd_head, tvb, offset, pinfo, frag_offset,
 		frag_data_len, more_frags)) {
 		/*
 		 * Reassembly is complete.
@@ -1592,7 +1661,7 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		return NULL;
 	}
 
-	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
+	if (fragment_add_work(table, fd_head, tvb, offset, pinfo, frag_offset,
 		frag_data_len, more_frags)) {
 		/*
 		 * Reassembly is complete.
@@ -1621,13 +1690,15 @@ fragment_add_check(reassembly_table *table, tvbuff_t *tvb, const int offset,
 }
 
 static void
-fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
+fragment_defragment_and_free (const reassembly_table *table, fragment_head *fd_head,
+			      const packet_info *pinfo)
 {
 	fragment_item *fd_i = NULL;
 	fragment_item *last_fd = NULL;
 	guint32  dfpos = 0, size = 0;
 	tvbuff_t *old_tvb_data = NULL;
-	guint8 *data;
+	tvbuff_t *composite = NULL;
+	guint8 *data = NULL;
 
 	for(fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
 		if(!last_fd || last_fd->offset!=fd_i->offset){
@@ -1638,9 +1709,17 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 
 	/* store old data in case the fd_i->data pointers refer to it */
 	old_tvb_data=fd_head->tvb_data;
-	data = (guint8 *) g_malloc(size);
-	fd_head->tvb_data = tvb_new_real_data(data, size, size);
-	tvb_set_free_cb(fd_head->tvb_data, g_free);
+	if (table->composite_data && size) {
+		composite = tvb_new_composite();
+		if (old_tvb_data) {
+			tvb_composite_own(composite, old_tvb_data);
+			old_tvb_data = NULL;
+		}
+	} else {
+		data = (guint8 *) g_malloc(size);
+		fd_head->tvb_data = tvb_new_real_data(data, size, size);
+		tvb_set_free_cb(fd_head->tvb_data, g_free);
+	}
 	fd_head->len = size;		/* record size for caller	*/
 
 	/* add all data fragments */
@@ -1649,7 +1728,10 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 		if (fd_i->len) {
 			if(!last_fd || last_fd->offset != fd_i->offset) {
 				/* First fragment or in-sequence fragment */
-				memcpy(data+dfpos, tvb_get_ptr(fd_i->tvb_data, 0, fd_i->len), fd_i->len);
+				if (composite)
+					fragment_add_to_composite(composite, fd_i, fd_i->len);
+				else
+					memcpy(data+dfpos, tvb_get_ptr(fd_i->tvb_data, 0, fd_i->len), fd_i->len);
 				dfpos += fd_i->len;
 			} else {
 				/* duplicate/retransmission/overlap */
@@ -1673,6 +1755,10 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 			tvb_free(fd_i->tvb_data);
 		fd_i->tvb_data=NULL;
 	}
+	if (composite) {
+		tvb_composite_finalize(composite);
+		fd_head->tvb_data = composite;
+	}
 	if (old_tvb_data)
 		tvb_free(old_tvb_data);
 
@@ -1697,7 +1783,8 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
  * The bsn for the first block is 0.
  */
 static gboolean
-fragment_add_seq_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
+fragment_add_seq_work(const reassembly_table *table, fragment_head *fd_head,
+		 tvbuff_t *tvb, const int offset,
 		 const packet_info *pinfo, const guint32 frag_number,
 		 const guint32 frag_data_len, const gboolean more_frags)
 {
@@ -1927,7 +2014,7 @@ fragment_add_seq_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	/* we have received an entire packet, defragment it and
 	 * free all fragments
 	 */
-	fragment_defragment_and_free(fd_head, pinfo);
+	fragment_defragment_and_free(table, fd_head, pinfo);
 
 	return TRUE;
 }
@@ -2025,7 +2112,7 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 		}
 	}
 
-	if (fragment_add_seq_work(fd_head, tvb, offset, pinfo,
+	if (fragment_add_seq_work(table, fd_head, tvb, offset, pinfo,
 				  frag_number, frag_data_len, more_frags)) {
 		/*
 		 * Reassembly is complete.
@@ -2539,7 +2626,7 @@ fragment_end_seq_next(reassembly_table *table, const packet_info *pinfo,
 		fd_head->datalen = fd_head->offset;
 		fd_head->flags |= FD_DATALEN_SET;
 
-		fragment_defragment_and_free (fd_head, pinfo);
+		fragment_defragment_and_free (table, fd_head, pinfo);
 
 		/*
 		 * Remove this from the table of in-progress reassemblies,
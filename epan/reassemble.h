@@ -130,6 +130,7 @@ typedef struct {
 	fragment_temporary_key temporary_key_func;
 	fragment_persistent_key persistent_key_func;
 	GDestroyNotify free_temporary_key_func;		/* temporary key destruction function */
+	gboolean composite_data;			/* see reassembly_table_set_composite() */
 } reassembly_table;
 
 /*
@@ -175,6 +176,18 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/*
+ * By default the data of a reassembled packet is copied into one buffer.
+ * With composite data, it's instead a composite tvbuff made of the data
+ * kept for each fragment, and one buffer is only made if a dissector asks
+ * for a pointer to bytes from more than one fragment.  This saves the copy,
+ * and memory, for large packets that are mostly handed on or searched.
+ *
+ * Fragments that overlap, or that don't all have data, are still copied.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_composite(reassembly_table *table, gboolean composite);
+
 /*
  * This function adds a new fragment to the reassembly table
  * If this is the first fragment seen for this datagram, a new entry
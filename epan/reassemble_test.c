@@ -3262,6 +3262,111 @@ test_fragment_add_check_duplicate_conflict(void)
     print_fragment_table();
 #endif
 }
+/**********************************************************************************
+ *
+ * composite data
+ *
+ *********************************************************************************/
+
+/* The tests above, with the reassembled data made of the fragments' data
+ * instead of a copy of it. */
+static void
+test_simple_fragment_add_seq_composite(void)
+{
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+    test_simple_fragment_add_seq();
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
+static void
+test_fragment_add_seq_partial_reassembly_composite(void)
+{
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+    test_fragment_add_seq_partial_reassembly();
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
+static void
+test_simple_fragment_add_composite(void)
+{
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+    test_simple_fragment_add();
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
+static void
+test_fragment_add_partial_reassembly_composite(void)
+{
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+    test_fragment_add_partial_reassembly();
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
+/* Reads composite reassembled data across the boundaries of fragments,
+ * including a last fragment that goes past the end of the datagram.
+ */
+/*   visit  id  frame  frag_off  len  more  tvb_offset
+       0    12     1        0    50   T      10
+       0    12     2       50    60   T      5
+       0    12     3      110    40   T      100
+       (total length set to 140)
+*/
+static void
+test_fragment_add_composite_boundaries(void)
+{
+    fragment_head *fd_head;
+    guint8 buf[140];
+
+    printf("Starting test test_fragment_add_composite_boundaries\n");
+
+    reassembly_table_set_composite(&test_reassembly_table, TRUE);
+
+    pinfo.num = 1;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 10, &pinfo, 12, NULL,
+                         0, 50, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    pinfo.num = 2;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 5, &pinfo, 12, NULL,
+                         50, 60, TRUE);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    fragment_set_tot_len(&test_reassembly_table, &pinfo, 12, NULL, 140);
+
+    pinfo.num = 3;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 100, &pinfo, 12, NULL,
+                         110, 40, TRUE);
+    ASSERT_NE_POINTER(NULL,fd_head);
+
+    ASSERT_EQ(140,fd_head->datalen);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_TOOLONGFRAGMENT,fd_head->flags);
+    ASSERT_EQ(140,tvb_captured_length(fd_head->tvb_data));
+    ASSERT_EQ(140,tvb_reported_length(fd_head->tvb_data));
+    ASSERT_EQ_POINTER(NULL,fd_head->next->tvb_data);
+    ASSERT_EQ_POINTER(NULL,fd_head->next->next->tvb_data);
+    ASSERT_EQ_POINTER(NULL,fd_head->next->next->next->tvb_data);
+    ASSERT_EQ(FD_TOOLONGFRAGMENT,fd_head->next->next->next->flags);
+
+    /* copies across the boundaries */
+    tvb_memcpy(fd_head->tvb_data, buf, 40, 80);
+    ASSERT(!memcmp(buf,data+50,10));
+    ASSERT(!memcmp(buf+10,data+5,60));
+    ASSERT(!memcmp(buf+70,data+100,10));
+    tvb_memcpy(fd_head->tvb_data, buf, 0, 140);
+    ASSERT(!memcmp(buf,data+10,50));
+    ASSERT(!memcmp(buf+50,data+5,60));
+    ASSERT(!memcmp(buf+110,data+100,30));
+
+    /* pointers within a fragment, then across them */
+    ASSERT(!tvb_memeql(fd_head->tvb_data,60,data+15,50));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,45,buf+45,10));
+    ASSERT(!tvb_memeql(fd_head->tvb_data,0,buf,140));
+    ASSERT_EQ(0x10,tvb_get_guint8(fd_head->tvb_data,6));
+    ASSERT_EQ(0x3f4064,tvb_get_ntoh24(fd_head->tvb_data,108));
+
+    reassembly_table_set_composite(&test_reassembly_table, FALSE);
+}
+
 /**********************************************************************************
  *
  * main
@@ -3310,6 +3415,11 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_check_duplicate_last,
 #endif
         test_fragment_add_check_duplicate_conflict,
+        test_simple_fragment_add_seq_composite,
+        test_fragment_add_seq_partial_reassembly_composite,
+        test_simple_fragment_add_composite,
+        test_fragment_add_partial_reassembly_composite,
+        test_fragment_add_composite_boundaries,
     };
 
     /* a tvbuff for testing with */
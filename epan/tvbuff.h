@@ -203,6 +203,11 @@ extern void tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member);
 /** Create an empty composite tvbuff. */
 WS_DLL_PUBLIC tvbuff_t *tvb_new_composite(void);
 
+/** Have a composite tvbuff free a chain of tvbuffs along with itself,
+ * instead of being attached to the chain of its first member. Must be
+ * called before the first member is added. */
+extern void tvb_composite_own(tvbuff_t *tvb, tvbuff_t *chain);
+
 /** Mark a composite tvbuff as initialized. No further appends or prepends
  * occur, data access can finally happen after this finalization. */
 WS_DLL_PUBLIC void tvb_composite_finalize(tvbuff_t *tvb);
@@ -24,6 +24,14 @@ typedef struct {
 	guint		*start_offsets;
 	guint		*end_offsets;
 
+	/* The members, in the same order as the offsets, so that the
+	 * one with an offset can be found with a binary search. */
+	tvbuff_t	**members;
+	guint		num_members;
+
+	/* Chains freed along with the composite; see tvb_composite_own(). */
+	GSList		*owned;
+
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -42,7 +50,10 @@ composite_free(tvbuff_t *tvb)
 
 	g_free(composite->start_offsets);
 	g_free(composite->end_offsets);
+	g_free(composite->members);
 	g_free((gpointer)tvb->real_data);
+
+	g_slist_free_full(composite->owned, (GDestroyNotify)tvb_free_chain);
 }
 
 static guint
@@ -51,37 +62,46 @@ composite_offset(const tvbuff_t *tvb _U_, const guint counter)
 	return counter;
 }
 
+/* Returns the index of the member that has the byte at abs_offset, or
+ * num_members if abs_offset is at or past the end. */
+static guint
+composite_find_member(const tvb_comp_t *composite, guint abs_offset)
+{
+	guint low = 0, high = composite->num_members, mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		if (abs_offset <= composite->end_offsets[mid])
+			high = mid;
+		else
+			low = mid + 1;
+	}
+	return low;
+}
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return "";
 	}
 
+	member_tvb = composite->members[i];
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
@@ -108,63 +128,54 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
+	guint	    i;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	composite = &composite_tvb->composite;
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
 	member_offset = abs_offset - composite->start_offsets[i];
 
-	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
+	if (tvb_bytes_exist(composite->members[i], member_offset, abs_length)) {
 		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
+		return tvb_memcpy(composite->members[i], target, member_offset, abs_length);
 	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
+
+	/* The requested data is non-contiguous inside
+	 * the member tvb. We have to memcpy() the part that's in the member tvb,
+	 * then go on through the following member tvb's, copying their portions
+	 * until we have copied all data.
+	 */
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb = composite->members[i];
 		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
 
 		/* composite_memcpy() can't handle a member_length of zero. */
 		DISSECTOR_ASSERT(member_length > 0);
 
+		if (member_length > abs_length)
+			member_length = abs_length;
 		tvb_memcpy(member_tvb, target, member_offset, member_length);
-		abs_offset	+= member_length;
+		target		+= member_length;
 		abs_length	-= member_length;
-
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
-
-		return target;
+		member_offset	 = 0;
+		i++;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return _target;
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -201,6 +212,9 @@ tvb_new_composite(void)
 	composite->tvbs		 = NULL;
 	composite->start_offsets = NULL;
 	composite->end_offsets	 = NULL;
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
+	composite->owned	 = NULL;
 
 	return tvb;
 }
@@ -222,8 +236,9 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	composite       = &composite_tvb->composite;
 	composite->tvbs = g_slist_append(composite->tvbs, member);
 
-	/* Attach the composite TVB to the first TVB only. */
-	if (!composite->tvbs->next) {
+	/* Attach the composite TVB to the first TVB only, unless it
+	 * owns the chains of its members. */
+	if (!composite->tvbs->next && !composite->owned) {
 		tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
 	}
 }
@@ -245,12 +260,35 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	composite       = &composite_tvb->composite;
 	composite->tvbs = g_slist_prepend(composite->tvbs, member);
 
-	/* Attach the composite TVB to the first TVB only. */
-	if (!composite->tvbs->next) {
+	/* Attach the composite TVB to the first TVB only, unless it
+	 * owns the chains of its members. */
+	if (!composite->tvbs->next && !composite->owned) {
 		tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb);
 	}
 }
 
+/*
+ * Makes the composite TVB the owner of a chain of TVBs, which is freed
+ * along with it.  This is for members whose chain is not freed with
+ * a frame, such as the data of the fragments of a reassembly; the
+ * composite TVB is then not attached to the chain of its first member, so
+ * this must be called before any member is added.
+ */
+void
+tvb_composite_own(tvbuff_t *tvb, tvbuff_t *chain)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite;
+
+	DISSECTOR_ASSERT(tvb && !tvb->initialized);
+	DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops);
+	DISSECTOR_ASSERT(chain);
+
+	composite        = &composite_tvb->composite;
+	DISSECTOR_ASSERT(!composite->tvbs || composite->owned);
+	composite->owned = g_slist_prepend(composite->owned, chain);
+}
+
 void
 tvb_composite_finalize(tvbuff_t *tvb)
 {
@@ -278,6 +316,8 @@ tvb_composite_finalize(tvbuff_t *tvb)
 
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
+	composite->members = g_new(tvbuff_t *, num_members);
+	composite->num_members = num_members;
 
 	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
 		DISSECTOR_ASSERT((guint) i < num_members);
@@ -287,6 +327,7 @@ tvb_composite_finalize(tvbuff_t *tvb)
 		tvb->reported_length += member_tvb->reported_length;
 		tvb->contained_length += member_tvb->contained_length;
 		composite->end_offsets[i] = tvb->length - 1;
+		composite->members[i] = member_tvb;
 		i++;
 	}
 
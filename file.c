@@ -21,6 +21,7 @@
 #include <wsutil/file_util.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/json_dumper.h>
+#include <wsutil/ws_memmem.h>
 #include <version_info.h>
 
 #include <wiretap/merge.h>
@@ -127,6 +128,22 @@ static void ref_time_packets(capture_file *cf);
  */
 static guint32 max_records = G_MAXUINT32;
 
+/*
+ * Fields whose values we cache from the start, if the field cache is
+ * enabled, as display filters often refer to them.  Other fields are
+ * cached once a display filter refers to them.
+ */
+static const char *const field_cache_default_fields[] = {
+  "frame.time",
+  "eth.addr",
+  "ip.addr",
+  "ipv6.addr",
+  "tcp.port",
+  "tcp.stream",
+  "udp.port",
+  "udp.stream",
+};
+
 void
 cf_set_max_records(guint max_records_arg)
 {
@@ -261,7 +278,11 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
 {
   wtap  *wth;
   gchar *err_info;
+  guint  i;
 
+  /* Keep the places a gzipped file can be read from, if we've been
+     asked to. */
+  wtap_set_write_gzip_index(prefs.gui_write_capture_index && !is_tempfile);
   wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
   if (wth == NULL)
     goto fail;
@@ -323,6 +344,13 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
    */
   cf->epan = ws_epan_new(cf);
 
+  /* Remember field values for refiltering, if we've been asked to. */
+  if (prefs.gui_field_cache_size > 0) {
+    cf->field_cache = field_cache_new((gsize)prefs.gui_field_cache_size * 1024 * 1024);
+    for (i = 0; i < G_N_ELEMENTS(field_cache_default_fields); i++)
+      field_cache_add_field(cf->field_cache, field_cache_default_fields[i]);
+  }
+
   packet_list_queue_draw();
   cf_callback_invoke(cf_cb_file_opened, cf);
 
@@ -406,6 +434,8 @@ cf_close(capture_file *cf)
 
   dfilter_free(cf->rfcode);
   cf->rfcode = NULL;
+  field_cache_free(cf->field_cache);
+  cf->field_cache = NULL;
   if (cf->provider.frames != NULL) {
     free_frame_data_sequence(cf->provider.frames);
     cf->provider.frames = NULL;
@@ -534,6 +564,9 @@ cf_read(capture_file *cf, gboolean reloading)
   compiled = dfilter_compile(cf->dfilter, &dfcode, NULL);
   g_assert(!cf->dfilter || (compiled && dfcode));
 
+  if (cf->field_cache != NULL && dfcode != NULL)
+    field_cache_note_filter(cf->field_cache, dfcode);
+
   /* Get the union of the flags for all tap listeners. */
   tap_flags = union_of_tap_listener_flags();
 
@@ -548,11 +581,14 @@ cf_read(capture_file *cf, gboolean reloading)
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're caching field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_cache != NULL);
 
   reset_tap_listeners();
 
@@ -808,11 +844,14 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're caching field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_cache != NULL);
 
   *err = 0;
 
@@ -952,11 +991,14 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're caching field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_cache != NULL);
 
   if (cf->provider.wth == NULL) {
     cf_close(cf);
@@ -1180,6 +1222,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
     wtap_rec *rec, Buffer *buf, gboolean add_to_packet_list)
 {
+  gboolean first_pass = !fdata->visited;
+
   frame_data_set_before_dissect(fdata, &cf->elapsed_time,
                                 &cf->provider.ref, cf->provider.prev_dis);
   cf->provider.prev_cap = fdata;
@@ -1197,17 +1241,27 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   }
 #endif
 
-  if (!fdata->visited) {
+  if (first_pass) {
     /* This is the first pass, so prime the epan_dissect_t with the
        hfids postdissectors want on the first pass. */
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
   }
 
+  if (cf->field_cache != NULL && edt->tree != NULL)
+    field_cache_prime_proto_tree(cf->field_cache, edt->tree);
+
   /* Dissect the frame. */
   epan_dissect_run_with_taps(edt, cf->cd_t, rec,
                              frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
                              fdata, cinfo);
 
+  /* On the first pass, fields that refer to later frames, such as
+     dns.response_in, aren't there yet, so only record the values a
+     frame has once every frame has been seen. */
+  if (cf->field_cache != NULL && !first_pass)
+    field_cache_record(cf->field_cache, fdata->num, edt->tree,
+                       edt->pi.dependent_frames);
+
   /* If we don't have a display filter, set "passed_dfilter" to 1. */
   if (dfcode != NULL) {
     fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
@@ -1246,6 +1300,49 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   epan_dissect_reset(edt);
 }
 
+/*
+ * Apply the display filter to a frame using the values in the field
+ * cache rather than dissecting the frame, and account for the result
+ * as add_packet_to_packet_list() does.
+ * Returns FALSE if the frame has to be dissected.
+ */
+static gboolean
+filter_packet_from_field_cache(frame_data *fdata, capture_file *cf,
+    dfilter_t *dfcode)
+{
+  gboolean passed = TRUE;
+  GSList  *dependent_frames = NULL;
+
+  if (dfcode != NULL &&
+      !field_cache_apply_dfilter(cf->field_cache, dfcode, fdata->num,
+                                 &passed, &dependent_frames))
+    return FALSE;
+
+  frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                &cf->provider.ref, cf->provider.prev_dis);
+  cf->provider.prev_cap = fdata;
+
+  fdata->passed_dfilter = passed ? 1 : 0;
+  if (fdata->passed_dfilter)
+    g_slist_foreach(dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+
+  if (fdata->passed_dfilter || fdata->ref_time)
+  {
+    cf->displayed_count++;
+    frame_data_set_after_dissect(fdata, &cf->cum_bytes);
+    cf->provider.prev_dis = fdata;
+
+    /* If we haven't yet seen the first frame, this is it. */
+    if (cf->first_displayed == 0)
+      cf->first_displayed = fdata->num;
+
+    /* This is the last frame we've seen so far. */
+    cf->last_displayed = fdata->num;
+  }
+
+  return TRUE;
+}
+
 /*
  * Read in a new record.
  * Returns TRUE if the packet was added to the packet (record) list,
@@ -1531,6 +1628,10 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
     }
   }
 
+  /* Start caching the fields this filter refers to, if we aren't yet. */
+  if (cf->field_cache != NULL && dfcode != NULL)
+    field_cache_note_filter(cf->field_cache, dfcode);
+
   /* We have a valid filter.  Replace the current filter. */
   g_free(cf->dfilter);
   cf->dfilter = dftext;
@@ -1658,6 +1759,8 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
+  gboolean    use_field_cache;
+  field_cache_stats_t field_cache_stats;
 
   /* Rescan in progress, clear pending actions. */
   cf->redissection_queued = RESCAN_NONE;
@@ -1691,12 +1794,25 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
    *    one of the tap listeners requires a protocol tree;
    *
    *    we're redissecting and a postdissector wants field
-   *    values or protocols on the first pass.
+   *    values or protocols on the first pass;
+   *
+   *    we're caching field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
      (tap_flags & TL_REQUIRES_PROTO_TREE) ||
-     (redissect && postdissectors_want_hfids()));
+     (redissect && postdissectors_want_hfids()) ||
+     cf->field_cache != NULL);
+
+  /*
+   * If we aren't redissecting, and no tap listener needs to see the
+   * frames, we can try to filter the frames using the cached field
+   * values rather than dissecting them again.
+   */
+  use_field_cache = (cf->field_cache != NULL && !redissect &&
+                     !tap_listeners_require_dissection());
+  if (use_field_cache)
+    field_cache_get_stats(cf->field_cache, &field_cache_stats);
 
   reset_tap_listeners();
   /* Which frame, if any, is the currently selected frame?
@@ -1743,6 +1859,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      * packet list store. */
     packet_list_clear();
     add_to_packet_list = TRUE;
+
+    /* The cached field values might be different now. */
+    if (cf->field_cache != NULL)
+      field_cache_clear(cf->field_cache);
   }
 
   /* We don't yet know which will be the first and last frames displayed. */
@@ -1870,9 +1990,6 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata, &rec, &buf))
-      break; /* error reading the frame */
-
     /* If the previous frame is displayed, and we haven't yet seen the
        selected frame, remember that frame - it's the closest one we've
        yet seen before the selected frame. */
@@ -1881,9 +1998,15 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &rec, &buf,
-                                    add_to_packet_list);
+    if (!use_field_cache ||
+        !filter_packet_from_field_cache(fdata, cf, dfcode)) {
+      if (!cf_read_record(cf, fdata, &rec, &buf))
+        break; /* error reading the frame */
+
+      add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                                      cinfo, &rec, &buf,
+                                      add_to_packet_list);
+    }
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1909,6 +2032,22 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
 
+  if (use_field_cache && dfcode != NULL) {
+    guint64 hits = field_cache_stats.hits;
+    guint64 misses = field_cache_stats.misses;
+
+    field_cache_get_stats(cf->field_cache, &field_cache_stats);
+    hits = field_cache_stats.hits - hits;
+    misses = field_cache_stats.misses - misses;
+    g_debug("Field cache: %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT
+            " frames filtered without dissection (%.1f%%), %u fields, %"
+            G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " bytes used",
+            hits, hits + misses,
+            hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0,
+            field_cache_stats.num_fields,
+            field_cache_stats.size, field_cache_stats.budget);
+  }
+
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
 
@@ -3370,6 +3509,7 @@ match_narrow(capture_file *cf, frame_data *fdata,
   guint32       i;
   guint8        c_char;
   size_t        c_match    = 0;
+  const guint8 *found;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -3380,11 +3520,22 @@ match_narrow(capture_file *cf, frame_data *fdata,
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(buf);
+  if (!cf->case_type) {
+    /* No folding to do, so the text can be looked for as it is. */
+    if (textlen == 0)
+      return result;
+    found = ws_memmem(pd, buf_len, ascii_text, textlen);
+    if (found != NULL) {
+      result = MR_MATCHED;
+      /* Save the position of the last character for highlighting the field. */
+      cf->search_pos = (guint32)(found - pd + textlen - 1);
+      cf->search_len = (guint32)textlen;
+    }
+    return result;
+  }
   i = 0;
   while (i < buf_len) {
-    c_char = pd[i];
-    if (cf->case_type)
-      c_char = g_ascii_toupper(c_char);
+    c_char = g_ascii_toupper(pd[i]);
     if (c_char == ascii_text[c_match]) {
       c_match += 1;
       if (c_match == textlen) {
@@ -3465,8 +3616,7 @@ match_binary(capture_file *cf, frame_data *fdata,
   match_result  result;
   guint32       buf_len;
   guint8       *pd;
-  guint32       i;
-  size_t        c_match     = 0;
+  const guint8 *found;
 
   /* Load the frame's data. */
   if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -3477,24 +3627,14 @@ match_binary(capture_file *cf, frame_data *fdata,
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
   pd = ws_buffer_start_ptr(buf);
-  i = 0;
-  while (i < buf_len) {
-    if (pd[i] == binary_data[c_match]) {
-      c_match += 1;
-      if (c_match == datalen) {
-        result = MR_MATCHED;
-        cf->search_pos = i; /* Save the position of the last character
-                               for highlighting the field. */
-        cf->search_len = (guint32)datalen;
-        break;
-      }
-    }
-    else {
-      g_assert(i>=c_match);
-      i -= (guint32)c_match;
-      c_match = 0;
-    }
-    i += 1;
+  if (datalen == 0)
+    return result;
+  found = ws_memmem(pd, buf_len, binary_data, datalen);
+  if (found != NULL) {
+    result = MR_MATCHED;
+    /* Save the position of the last character for highlighting the field. */
+    cf->search_pos = (guint32)(found - pd + datalen - 1);
+    cf->search_len = (guint32)datalen;
   }
   return result;
 }
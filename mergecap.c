@@ -50,6 +50,8 @@
 
 #include "ui/failure_message.h"
 
+#define LONGOPT_READ_AHEAD LONGOPT_BASE_APPLICATION+1
+
 /*
  * Show the usage
  */
@@ -68,8 +70,12 @@ print_usage(FILE *output)
   fprintf(output, "                    an empty \"-F\" option will list the file types.\n");
   fprintf(output, "  -I <IDB merge mode> set the merge mode for Interface Description Blocks; default is 'all'.\n");
   fprintf(output, "                    an empty \"-I\" option will list the merge modes.\n");
+  fprintf(output, "  -m <max files>    have at most <max files> input files open at once;\n");
+  fprintf(output, "                    more are merged in groups through temporary files.\n");
   fprintf(output, "\n");
   fprintf(output, "Miscellaneous:\n");
+  fprintf(output, "  --read-ahead <MB> read up to <MB> megabytes ahead of each input file\n");
+  fprintf(output, "                    in a separate thread; default is 0, off.\n");
   fprintf(output, "  -h                display this help and exit.\n");
   fprintf(output, "  -v                verbose output.\n");
   fprintf(output, "  -V                print version information and exit.\n");
@@ -231,6 +237,7 @@ main(int argc, char *argv[])
   static const struct option long_options[] = {
       {"help", no_argument, NULL, 'h'},
       {"version", no_argument, NULL, 'V'},
+      {"read-ahead", required_argument, NULL, LONGOPT_READ_AHEAD},
       {0, 0, 0, 0 }
   };
   gboolean            do_append          = FALSE;
@@ -279,7 +286,7 @@ main(int argc, char *argv[])
   wtap_init(TRUE);
 
   /* Process the options first */
-  while ((opt = getopt_long(argc, argv, "aF:hI:s:vVw:", long_options, NULL)) != -1) {
+  while ((opt = getopt_long(argc, argv, "aF:hI:m:s:vVw:", long_options, NULL)) != -1) {
 
     switch (opt) {
     case 'a':
@@ -314,6 +321,14 @@ main(int argc, char *argv[])
       }
       break;
 
+    case 'm':
+      merge_set_max_open_files(get_nonzero_guint32(optarg, "maximum number of open files"));
+      break;
+
+    case LONGOPT_READ_AHEAD:
+      wtap_set_read_ahead(get_guint32(optarg, "read-ahead size"));
+      break;
+
     case 's':
       snaplen = get_nonzero_guint32(optarg, "snapshot length");
       break;
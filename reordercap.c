@@ -32,6 +32,7 @@
 #include <cli_main.h>
 #include <version_info.h>
 #include <wiretap/wtap_opttypes.h>
+#include <wiretap/merge.h>
 
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
@@ -39,12 +40,16 @@
 
 #include <wsutil/report_message.h>
 
+#include "ui/clopts_common.h"
 #include "ui/failure_message.h"
 
 #define INVALID_OPTION 1
 #define OPEN_ERROR 2
 #define OUTPUT_FILE_ERROR 1
 
+/* With -m, the most runs that are open at once when they're merged */
+#define MAX_OPEN_RUNS 64
+
 /* Show command-line usage */
 static void
 print_usage(FILE *output)
@@ -54,6 +59,11 @@ print_usage(FILE *output)
     fprintf(output, "\n");
     fprintf(output, "Options:\n");
     fprintf(output, "  -n        don't write to output file if the input file is ordered.\n");
+    fprintf(output, "  -w <secs> reorder as the input is read, holding back only the frames\n");
+    fprintf(output, "            within <secs> seconds of the latest frame read so far.\n");
+    fprintf(output, "  -c <n>    reorder as the input is read, holding back at most <n> frames.\n");
+    fprintf(output, "  -m <n>    sort in runs of at most <n> frames that are written to\n");
+    fprintf(output, "            temporary files and then merged, to bound the memory used.\n");
     fprintf(output, "  -h        display this help and exit.\n");
     fprintf(output, "  -v        print version information and exit.\n");
 }
@@ -81,6 +91,22 @@ typedef struct FrameRecord_t {
 /**************************************************/
 
 
+/* Write a record to outfile */
+static void
+record_write(wtap_dumper *pdh, wtap_rec *rec, Buffer *buf, guint num,
+             int file_type_subtype, const char *infile,
+             const char *outfile)
+{
+    int    err;
+    gchar  *err_info;
+
+    if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(buf), &err, &err_info)) {
+        cfile_write_failure_message("reordercap", infile, outfile, err,
+                                    err_info, num, file_type_subtype);
+        exit(1);
+    }
+}
+
 static void
 frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
             wtap_rec *rec, Buffer *buf, const char *infile,
@@ -111,12 +137,8 @@ frame_write(FrameRecord_t *frame, wtap *wth, wtap_dumper *pdh,
     rec->ts = frame->frame_time;
 
     /* Dump frame to outfile */
-    if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(buf), &err, &err_info)) {
-        cfile_write_failure_message("reordercap", infile, outfile, err,
-                                    err_info, frame->num,
-                                    wtap_file_type_subtype(wth));
-        exit(1);
-    }
+    record_write(pdh, rec, buf, frame->num, wtap_file_type_subtype(wth),
+                 infile, outfile);
 }
 
 /* Comparing timestamps between 2 frames.
@@ -136,6 +158,562 @@ frames_compare(gconstpointer a, gconstpointer b)
     return nstime_cmp(time1, time2);
 }
 
+/*
+ * With -w, -c and -m, frames are not re-read from the input file, but
+ * held in memory, with a copy of the record and its data.
+ */
+typedef struct HeldFrame_t {
+    wtap_rec     rec;
+    Buffer       buf;
+    guint        num;
+
+    nstime_t     frame_time;
+} HeldFrame_t;
+
+/* With -m, a sorted run of frames written to a temporary file */
+typedef struct SortRun_t {
+    char        *filename;
+    wtap        *wth;
+    wtap_rec     rec;
+    Buffer       buf;
+    guint        index;
+    guint        num;           /* frames read from the run */
+
+    nstime_t     frame_time;    /* of the frame in rec */
+} SortRun_t;
+
+static guint32
+record_data_len(const wtap_rec *rec)
+{
+    switch (rec->rec_type) {
+        case REC_TYPE_PACKET:
+            return rec->rec_header.packet_header.caplen;
+        case REC_TYPE_FT_SPECIFIC_EVENT:
+        case REC_TYPE_FT_SPECIFIC_REPORT:
+            return rec->rec_header.ft_specific_header.record_len;
+        case REC_TYPE_SYSCALL:
+            return rec->rec_header.syscall_header.event_filelen;
+        case REC_TYPE_SYSTEMD_JOURNAL:
+            return rec->rec_header.systemd_journal_header.record_len;
+        default:
+            return 0;
+    }
+}
+
+static HeldFrame_t *
+held_frame_new(const wtap_rec *rec, Buffer *buf, guint num)
+{
+    HeldFrame_t *frame = g_new(HeldFrame_t, 1);
+    guint32     len = record_data_len(rec);
+    guint       i;
+
+    frame->rec = *rec;
+    frame->rec.opt_comment = g_strdup(rec->opt_comment);
+    if (rec->packet_verdict != NULL) {
+        frame->rec.packet_verdict =
+            g_ptr_array_new_full(rec->packet_verdict->len,
+                                 (GDestroyNotify) g_bytes_unref);
+        for (i = 0; i < rec->packet_verdict->len; i++) {
+            g_ptr_array_add(frame->rec.packet_verdict,
+                            g_bytes_ref((GBytes *)g_ptr_array_index(rec->packet_verdict, i)));
+        }
+    }
+    /* The options buffer is only used while reading a record */
+    ws_buffer_init(&frame->rec.options_buf, 0);
+
+    ws_buffer_init(&frame->buf, len);
+    ws_buffer_append(&frame->buf, ws_buffer_start_ptr(buf), len);
+    frame->num = num;
+    if (rec->presence_flags & WTAP_HAS_TS) {
+        frame->frame_time = rec->ts;
+    } else {
+        nstime_set_unset(&frame->frame_time);
+    }
+    return frame;
+}
+
+static void
+held_frame_free(HeldFrame_t *frame)
+{
+    wtap_rec_cleanup(&frame->rec);
+    ws_buffer_free(&frame->buf);
+    g_free(frame);
+}
+
+/* Frames with the same timestamp stay in the order in which they were read */
+static int
+held_frames_compare(gconstpointer a, gconstpointer b)
+{
+    const HeldFrame_t *frame1 = (const HeldFrame_t *) a;
+    const HeldFrame_t *frame2 = (const HeldFrame_t *) b;
+    int cmp;
+
+    cmp = nstime_cmp(&frame1->frame_time, &frame2->frame_time);
+    if (cmp != 0)
+        return cmp;
+    return frame1->num < frame2->num ? -1 : frame1->num > frame2->num;
+}
+
+static int
+held_frames_sort_compare(gconstpointer a, gconstpointer b)
+{
+    return held_frames_compare(*(const HeldFrame_t *const *) a,
+                               *(const HeldFrame_t *const *) b);
+}
+
+/* Runs hold frames that were read one after the other, so ties go to
+   the earlier run */
+static int
+sort_runs_compare(gconstpointer a, gconstpointer b)
+{
+    const SortRun_t *run1 = (const SortRun_t *) a;
+    const SortRun_t *run2 = (const SortRun_t *) b;
+    int cmp;
+
+    cmp = nstime_cmp(&run1->frame_time, &run2->frame_time);
+    if (cmp != 0)
+        return cmp;
+    return run1->index < run2->index ? -1 : run1->index > run2->index;
+}
+
+/* Binary min-heap kept in a GPtrArray */
+static void
+heap_push(GPtrArray *heap, gpointer item, GCompareFunc compare)
+{
+    guint i, parent;
+
+    g_ptr_array_add(heap, item);
+    for (i = heap->len - 1; i > 0; i = parent) {
+        parent = (i - 1) / 2;
+        if (compare(heap->pdata[parent], item) <= 0)
+            break;
+        heap->pdata[i] = heap->pdata[parent];
+    }
+    heap->pdata[i] = item;
+}
+
+static gpointer
+heap_pop(GPtrArray *heap, GCompareFunc compare)
+{
+    gpointer top = heap->pdata[0];
+    gpointer last = g_ptr_array_remove_index(heap, heap->len - 1);
+    guint i = 0, child;
+
+    if (heap->len == 0)
+        return top;
+
+    for (;;) {
+        child = 2 * i + 1;
+        if (child >= heap->len)
+            break;
+        if (child + 1 < heap->len &&
+            compare(heap->pdata[child + 1], heap->pdata[child]) < 0)
+            child++;
+        if (compare(last, heap->pdata[child]) <= 0)
+            break;
+        heap->pdata[i] = heap->pdata[child];
+        i = child;
+    }
+    heap->pdata[i] = last;
+    return top;
+}
+
+/* Is the oldest frame held back outside the reorder window? */
+static gboolean
+reorder_window_full(GPtrArray *heap, const nstime_t *newest_time,
+                    const nstime_t *window, guint window_count)
+{
+    const HeldFrame_t *oldest;
+    nstime_t delta;
+
+    if (heap->len == 0)
+        return FALSE;
+    if (window_count != 0 && heap->len > window_count)
+        return TRUE;
+    if (window == NULL)
+        return FALSE;
+
+    oldest = (const HeldFrame_t *)heap->pdata[0];
+    if (nstime_is_unset(&oldest->frame_time)) {
+        /* Nothing read later can go before it */
+        return TRUE;
+    }
+    nstime_delta(&delta, newest_time, &oldest->frame_time);
+    return nstime_cmp(&delta, window) > 0;
+}
+
+/*
+ * Reorder as the input is read (-w and -c): frames are held back in a
+ * heap until they are outside the reorder window, and then written in
+ * order, so that the input is read and the output written sequentially.
+ * A frame that arrives after a later one has already been written can't
+ * be put in order; it's written as soon as possible, and counted.
+ */
+static void
+reorder_window(wtap *wth, wtap_dumper *pdh, const nstime_t *window,
+               guint window_count, const char *infile, const char *outfile)
+{
+    GPtrArray *heap = g_ptr_array_new();
+    HeldFrame_t *frame;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    guint num = 0;
+    guint wrong_order_count = 0;
+    guint late_count = 0;
+    nstime_t prev_time, newest_time, written_time;
+    gboolean written = FALSE;
+
+    nstime_set_unset(&newest_time);
+    nstime_set_unset(&written_time);
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    for (;;) {
+        gboolean more = wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset);
+
+        if (more) {
+            frame = held_frame_new(&rec, &buf, ++num);
+
+            if (num > 1 && nstime_cmp(&frame->frame_time, &prev_time) < 0) {
+                wrong_order_count++;
+            }
+            prev_time = frame->frame_time;
+            if (nstime_cmp(&frame->frame_time, &newest_time) > 0) {
+                newest_time = frame->frame_time;
+            }
+
+            heap_push(heap, frame, held_frames_compare);
+        }
+
+        while (heap->len > 0 &&
+               (!more || reorder_window_full(heap, &newest_time, window,
+                                             window_count))) {
+            frame = (HeldFrame_t *)heap_pop(heap, held_frames_compare);
+            if (written && nstime_cmp(&frame->frame_time, &written_time) < 0) {
+                late_count++;
+            } else {
+                written_time = frame->frame_time;
+            }
+            written = TRUE;
+            record_write(pdh, &frame->rec, &frame->buf, frame->num,
+                         wtap_file_type_subtype(wth), infile, outfile);
+            held_frame_free(frame);
+        }
+
+        if (!more)
+            break;
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    g_ptr_array_free(heap, TRUE);
+    if (err != 0) {
+      /* Print a message noting that the read failed somewhere along the line. */
+      cfile_read_failure_message("reordercap", infile, err, err_info);
+    }
+
+    printf("%u frames, %u out of order\n", num, wrong_order_count);
+    if (late_count > 0) {
+        printf("%u frames were out of order by more than the reorder window, and are still out of order\n",
+               late_count);
+    }
+}
+
+static void
+sort_runs_remove(GPtrArray *runs)
+{
+    guint i;
+
+    for (i = 0; i < runs->len; i++) {
+        SortRun_t *run = (SortRun_t *)runs->pdata[i];
+
+        if (run->wth != NULL) {
+            wtap_close(run->wth);
+            wtap_rec_cleanup(&run->rec);
+            ws_buffer_free(&run->buf);
+        }
+        if (run->filename != NULL) {
+            ws_unlink(run->filename);
+            g_free(run->filename);
+        }
+        g_free(run);
+    }
+    g_ptr_array_set_size(runs, 0);
+}
+
+/* Sort the frames held and write them to a new run, emptying frames */
+static void
+sort_run_write(GPtrArray *frames, GPtrArray *runs, int file_type_subtype,
+               const wtap_dump_params *params, const char *infile)
+{
+    SortRun_t *run = g_new0(SortRun_t, 1);
+    wtap_dumper *run_pdh;
+    int err;
+    gchar *err_info;
+    guint i;
+
+    run->index = runs->len;
+    g_ptr_array_add(runs, run);
+
+    g_ptr_array_sort(frames, held_frames_sort_compare);
+
+    run_pdh = wtap_dump_open_tempfile(&run->filename, "reordercap_",
+                                      file_type_subtype, WTAP_UNCOMPRESSED,
+                                      params, &err, &err_info);
+    if (run_pdh == NULL) {
+        cfile_dump_open_failure_message("reordercap", "temporary file", err,
+                                        err_info, file_type_subtype);
+        sort_runs_remove(runs);
+        exit(1);
+    }
+    for (i = 0; i < frames->len; i++) {
+        HeldFrame_t *frame = (HeldFrame_t *)frames->pdata[i];
+
+        if (!wtap_dump(run_pdh, &frame->rec, ws_buffer_start_ptr(&frame->buf),
+                       &err, &err_info)) {
+            cfile_write_failure_message("reordercap", infile, run->filename,
+                                        err, err_info, frame->num,
+                                        file_type_subtype);
+            wtap_dump_close(run_pdh, &err, &err_info);
+            sort_runs_remove(runs);
+            exit(1);
+        }
+        held_frame_free(frame);
+    }
+    g_ptr_array_set_size(frames, 0);
+
+    if (!wtap_dump_close(run_pdh, &err, &err_info)) {
+        cfile_close_failure_message(run->filename, err, err_info);
+        sort_runs_remove(runs);
+        exit(1);
+    }
+}
+
+/* Read the next frame of a run; FALSE at the end of it */
+static gboolean
+sort_run_read(SortRun_t *run, GPtrArray *runs)
+{
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+
+    if (!wtap_read(run->wth, &run->rec, &run->buf, &err, &err_info,
+                   &data_offset)) {
+        if (err != 0) {
+            cfile_read_failure_message("reordercap", run->filename, err,
+                                       err_info);
+            sort_runs_remove(runs);
+            exit(1);
+        }
+        return FALSE;
+    }
+    run->num++;
+    if (run->rec.presence_flags & WTAP_HAS_TS) {
+        run->frame_time = run->rec.ts;
+    } else {
+        nstime_set_unset(&run->frame_time);
+    }
+    return TRUE;
+}
+
+/*
+ * If there are more runs than can be open at once, merge them to one
+ * run, MAX_OPEN_RUNS at a time, in as many passes as that takes.
+ *
+ * The merge takes records with the same time stamp from the last file
+ * first, so the runs are handed to it last first, to keep those records
+ * in the order in which they were read.
+ */
+static void
+sort_runs_merge(GPtrArray *runs, const char *infile)
+{
+    const char **filenames;
+    SortRun_t *run;
+    gchar *merged = NULL;
+    merge_result status;
+    int err = 0;
+    gchar *err_info = NULL;
+    guint err_fileno = 0;
+    guint32 err_framenum = 0;
+    guint i;
+
+    if (runs->len <= MAX_OPEN_RUNS)
+        return;
+
+    filenames = g_new(const char *, runs->len);
+    for (i = 0; i < runs->len; i++) {
+        run = (SortRun_t *)runs->pdata[runs->len - 1 - i];
+        filenames[i] = run->filename;
+    }
+    merge_set_max_open_files(MAX_OPEN_RUNS);
+    status = merge_files_to_tempfile(&merged, "reordercap_",
+                                     WTAP_FILE_TYPE_SUBTYPE_PCAPNG,
+                                     filenames, runs->len, FALSE,
+                                     IDB_MERGE_MODE_ALL_SAME, 0,
+                                     "reordercap", NULL, &err, &err_info,
+                                     &err_fileno, &err_framenum);
+
+    switch (status) {
+        case MERGE_OK:
+            break;
+
+        case MERGE_ERR_CANT_OPEN_INFILE:
+            cfile_open_failure_message("reordercap", filenames[err_fileno],
+                                       err, err_info);
+            break;
+
+        case MERGE_ERR_CANT_OPEN_OUTFILE:
+            cfile_dump_open_failure_message("reordercap", "temporary file",
+                                            err, err_info,
+                                            WTAP_FILE_TYPE_SUBTYPE_PCAPNG);
+            break;
+
+        case MERGE_ERR_CANT_READ_INFILE:
+            cfile_read_failure_message("reordercap", filenames[err_fileno],
+                                       err, err_info);
+            break;
+
+        case MERGE_ERR_CANT_WRITE_OUTFILE:
+            cfile_write_failure_message("reordercap", infile, merged, err,
+                                        err_info, err_framenum,
+                                        WTAP_FILE_TYPE_SUBTYPE_PCAPNG);
+            break;
+
+        case MERGE_ERR_CANT_CLOSE_OUTFILE:
+            cfile_close_failure_message(merged, err, err_info);
+            break;
+
+        default:
+            cmdarg_err("Merging the sorted runs failed (error %d).", status);
+            break;
+    }
+    g_free(filenames);
+
+    sort_runs_remove(runs);
+    if (status != MERGE_OK) {
+        if (merged != NULL) {
+            ws_unlink(merged);
+            g_free(merged);
+        }
+        exit(1);
+    }
+
+    run = g_new0(SortRun_t, 1);
+    run->filename = merged;
+    g_ptr_array_add(runs, run);
+}
+
+/*
+ * Sort with bounded memory (-m): the input is read in runs of at most
+ * max_frames frames, each of which is sorted and written to a temporary
+ * file, and the runs are then merged into the output.  If the whole input
+ * fits in one run, it's written directly.
+ */
+static void
+reorder_external(wtap *wth, wtap_dumper *pdh, const wtap_dump_params *params,
+                 guint max_frames, gboolean write_output_regardless,
+                 const char *infile, const char *outfile)
+{
+    GPtrArray *frames = g_ptr_array_new();
+    GPtrArray *runs = g_ptr_array_new();
+    GPtrArray *heap;
+    HeldFrame_t *frame;
+    SortRun_t *run;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    guint num = 0;
+    guint wrong_order_count = 0;
+    nstime_t prev_time;
+    guint i;
+
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        frame = held_frame_new(&rec, &buf, ++num);
+        if (num > 1 && nstime_cmp(&frame->frame_time, &prev_time) < 0) {
+            wrong_order_count++;
+        }
+        prev_time = frame->frame_time;
+
+        g_ptr_array_add(frames, frame);
+        if (frames->len >= max_frames) {
+            sort_run_write(frames, runs, wtap_file_type_subtype(wth), params,
+                           infile);
+        }
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    if (err != 0) {
+      /* Print a message noting that the read failed somewhere along the line. */
+      cfile_read_failure_message("reordercap", infile, err, err_info);
+    }
+
+    printf("%u frames, %u out of order\n", num, wrong_order_count);
+
+    if (!write_output_regardless && (wrong_order_count == 0)) {
+        printf("Not writing output file because input file is already in order.\n");
+    } else if (runs->len == 0) {
+        g_ptr_array_sort(frames, held_frames_sort_compare);
+        for (i = 0; i < frames->len; i++) {
+            frame = (HeldFrame_t *)frames->pdata[i];
+            record_write(pdh, &frame->rec, &frame->buf, frame->num,
+                         wtap_file_type_subtype(wth), infile, outfile);
+        }
+    } else {
+        if (frames->len > 0) {
+            sort_run_write(frames, runs, wtap_file_type_subtype(wth), params,
+                           infile);
+        }
+        sort_runs_merge(runs, infile);
+
+        heap = g_ptr_array_sized_new(runs->len);
+        for (i = 0; i < runs->len; i++) {
+            run = (SortRun_t *)runs->pdata[i];
+            run->wth = wtap_open_offline(run->filename, WTAP_TYPE_AUTO, &err,
+                                         &err_info, FALSE);
+            if (run->wth == NULL) {
+                cfile_open_failure_message("reordercap", run->filename, err,
+                                           err_info);
+                sort_runs_remove(runs);
+                exit(1);
+            }
+            wtap_rec_init(&run->rec);
+            ws_buffer_init(&run->buf, 1514);
+            if (sort_run_read(run, runs)) {
+                heap_push(heap, run, sort_runs_compare);
+            }
+        }
+
+        while (heap->len > 0) {
+            run = (SortRun_t *)heap_pop(heap, sort_runs_compare);
+            if (!wtap_dump(pdh, &run->rec, ws_buffer_start_ptr(&run->buf),
+                           &err, &err_info)) {
+                cfile_write_failure_message("reordercap", run->filename,
+                                            outfile, err, err_info, run->num,
+                                            wtap_file_type_subtype(wth));
+                sort_runs_remove(runs);
+                exit(1);
+            }
+            if (sort_run_read(run, runs)) {
+                heap_push(heap, run, sort_runs_compare);
+            }
+        }
+        g_ptr_array_free(heap, TRUE);
+    }
+
+    for (i = 0; i < frames->len; i++) {
+        held_frame_free((HeldFrame_t *)frames->pdata[i]);
+    }
+    g_ptr_array_free(frames, TRUE);
+    sort_runs_remove(runs);
+    g_ptr_array_free(runs, TRUE);
+}
+
 /*
  * General errors and warnings are reported with an console message
  * in reordercap.
@@ -176,6 +754,10 @@ main(int argc, char *argv[])
     gboolean write_output_regardless = TRUE;
     guint i;
     wtap_dump_params params;
+    nstime_t window;
+    gboolean use_window = FALSE;
+    guint window_count = 0;
+    guint max_frames = 0;
     int                          ret = EXIT_SUCCESS;
 
     GPtrArray *frames;
@@ -219,11 +801,26 @@ main(int argc, char *argv[])
     wtap_init(TRUE);
 
     /* Process the options first */
-    while ((opt = getopt_long(argc, argv, "hnv", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:hm:nvw:", long_options, NULL)) != -1) {
         switch (opt) {
+            case 'c':
+                window_count = get_nonzero_guint32(optarg, "reorder window frame count");
+                break;
+            case 'm':
+                max_frames = get_nonzero_guint32(optarg, "maximum frames in memory");
+                break;
             case 'n':
                 write_output_regardless = FALSE;
                 break;
+            case 'w':
+            {
+                double secs = get_positive_double(optarg, "reorder window");
+
+                window.secs = (time_t)secs;
+                window.nsecs = (int)((secs - (double)window.secs) * 1000000000.0);
+                use_window = TRUE;
+                break;
+            }
             case 'h':
                 show_help_header("Reorder timestamps of input file frames into output file.");
                 print_usage(stdout);
@@ -238,6 +835,19 @@ main(int argc, char *argv[])
         }
     }
 
+    if (use_window || window_count != 0) {
+        if (max_frames != 0) {
+            cmdarg_err("-m can't be used with -w or -c.");
+            ret = INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (!write_output_regardless) {
+            cmdarg_err("-n can't be used with -w or -c, as the output is written while the input is read.");
+            ret = INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+
     /* Remaining args are file names */
     file_count = argc - optind;
     if (file_count == 2) {
@@ -271,17 +881,34 @@ main(int argc, char *argv[])
       pdh = wtap_dump_open(outfile, wtap_file_type_subtype(wth),
                            WTAP_UNCOMPRESSED, &params, &err, &err_info);
     }
-    g_free(params.idb_inf);
-    params.idb_inf = NULL;
 
     if (pdh == NULL) {
         cfile_dump_open_failure_message("reordercap", outfile, err, err_info,
                                         wtap_file_type_subtype(wth));
+        g_free(params.idb_inf);
         wtap_dump_params_cleanup(&params);
         ret = OUTPUT_FILE_ERROR;
         goto clean_exit;
     }
 
+    if (use_window || window_count != 0) {
+        g_free(params.idb_inf);
+        params.idb_inf = NULL;
+        reorder_window(wth, pdh, use_window ? &window : NULL, window_count,
+                       infile, outfile);
+        goto close_outfile;
+    }
+    if (max_frames != 0) {
+        /* The temporary files get the same IDBs as outfile */
+        reorder_external(wth, pdh, &params, max_frames,
+                         write_output_regardless, infile, outfile);
+        g_free(params.idb_inf);
+        params.idb_inf = NULL;
+        goto close_outfile;
+    }
+    g_free(params.idb_inf);
+    params.idb_inf = NULL;
+
     /* Allocate the array of frame pointers. */
     frames = g_ptr_array_new();
 
@@ -343,6 +970,7 @@ main(int argc, char *argv[])
     /* Free the whole array */
     g_ptr_array_free(frames, TRUE);
 
+close_outfile:
     /* Close outfile */
     if (!wtap_dump_close(pdh, &err, &err_info)) {
         cfile_close_failure_message(outfile, err, err_info);
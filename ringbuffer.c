@@ -53,6 +53,7 @@
 
 #include "ringbuffer.h"
 #include <wsutil/file_util.h>
+#include <wiretap/wtap.h>
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
@@ -65,6 +66,26 @@ typedef struct _rb_file {
 
 #define MAX_FILENAME_QUEUE  100
 
+/*
+ * Finished files are compressed by a pool of at most this many threads,
+ * rather than by a thread of their own each, so that frequent file
+ * switches don't leave the capture competing with a pile of compressors.
+ */
+#define COMPRESS_MAX_THREADS  4
+
+/*
+ * If this many files are already waiting to be compressed, the pool isn't
+ * keeping up; further files are left uncompressed, rather than letting
+ * the backlog, and the disk space it holds, grow without limit.
+ */
+#define COMPRESS_MAX_QUEUED   32
+
+/* A file waiting to be compressed */
+typedef struct _compress_job {
+  gchar        *name;
+  gint64        queued;              /**< g_get_monotonic_time() when it was queued */
+} compress_job;
+
 /** Ringbuffer data structure */
 typedef struct _ringbuf_data {
   rb_file      *files;
@@ -81,8 +102,12 @@ typedef struct _ringbuf_data {
   FILE         *name_h;              /**< write names of completed files to this handle */
   gchar        *compress_type;       /**< compress type */
 
-  GMutex        mutex;               /**< mutex for oldnames */
+  GMutex        mutex;               /**< mutex for oldnames and the compression counts */
   gchar        *oldnames[MAX_FILENAME_QUEUE];       /**< filename list of pending to be deleted */
+
+  GThreadPool  *compress_pool;       /**< threads compressing finished files */
+  guint         compress_queued;     /**< files waiting for or being compressed */
+  ringbuf_compress_stats compress_stats;
 } ringbuf_data;
 
 static ringbuf_data rb_data;
@@ -124,36 +149,28 @@ static void CleanupOldCap(gchar* name)
 }
 
 /*
- * compress capture file
+ * compress capture file with gzip; returns TRUE if it succeeds
  */
-static int ringbuf_exec_compress(gchar* name)
+static gboolean ringbuf_compress_gzip(int fd, gchar *name)
 {
   guint8  *buffer = NULL;
   gchar* outgz = NULL;
-  int  fd = -1;
   ssize_t nread;
   gboolean delete_org_file = TRUE;
   gzFile fi = NULL;
 
-  fd = ws_open(name, O_RDONLY | O_BINARY, 0000);
-  if (fd < 0) {
-    return -1;
-  }
-
   outgz = g_strdup_printf("%s.gz", name);
   fi = gzopen(outgz, "wb");
   g_free(outgz);
   if (fi == NULL) {
-    ws_close(fd);
-    return -1;
+    return FALSE;
   }
 
 #define FS_READ_SIZE 65536
   buffer = (guint8*)g_malloc(FS_READ_SIZE);
   if (buffer == NULL) {
-    ws_close(fd);
     gzclose(fi);
-    return -1;
+    return FALSE;
   }
 
   while ((nread = ws_read(fd, buffer, FS_READ_SIZE)) > 0) {
@@ -168,36 +185,127 @@ static int ringbuf_exec_compress(gchar* name)
     /* mark compression as failed */
     delete_org_file = FALSE;
   }
-  ws_close(fd);
   gzclose(fi);
   g_free(buffer);
+  return delete_org_file;
+}
+
+/*
+ * compress capture file with one of the other types of compression
+ * wiretap can write; returns TRUE if it succeeds
+ */
+static gboolean ringbuf_compress_wtap(int fd, gchar *name)
+{
+  wtap_compression_type type;
+  gchar *outname;
+  int outfd;
+  int err;
+
+  type = wtap_name_to_compression_type(rb_data.compress_type);
+  if (type == WTAP_UNCOMPRESSED || type == WTAP_UNKNOWN_COMPRESSION)
+    return FALSE;
+
+  outname = g_strdup_printf("%s.%s", name, wtap_compression_type_extension(type));
+  outfd = ws_open(outname, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,
+                  rb_data.group_read_access ? 0640 : 0600);
+  if (outfd < 0) {
+    g_free(outname);
+    return FALSE;
+  }
+  if (!wtap_compress_fd(fd, outfd, type, &err)) {
+    /* don't leave a partly-written file behind */
+    ws_unlink(outname);
+    g_free(outname);
+    return FALSE;
+  }
+  g_free(outname);
+  return TRUE;
+}
+
+/*
+ * compress capture file; returns TRUE if it succeeds
+ */
+static gboolean ringbuf_exec_compress(gchar* name)
+{
+  int  fd = -1;
+  gboolean delete_org_file;
+
+  fd = ws_open(name, O_RDONLY | O_BINARY, 0000);
+  if (fd < 0) {
+    return FALSE;
+  }
+
+  if (strcmp(rb_data.compress_type, "gzip") == 0)
+    delete_org_file = ringbuf_compress_gzip(fd, name);
+  else
+    delete_org_file = ringbuf_compress_wtap(fd, name);
+  ws_close(fd);
 
   /* delete the original file only if compression succeeds */
   if (delete_org_file) {
     ws_unlink(name);
     CleanupOldCap(name);
   }
-  g_free(name);
-  return 0;
+  return delete_org_file;
 }
 
 /*
- * thread to compress capture file
+ * compress a queued capture file, in one of the pool's threads
  */
-static void* exec_compress_thread(void* arg)
+static void exec_compress_job(gpointer data, gpointer user_data _U_)
 {
-  ringbuf_exec_compress((gchar*)arg);
-  return NULL;
+  compress_job *job = (compress_job *)data;
+  gboolean ok;
+  gint64 lag;
+
+  ok = ringbuf_exec_compress(job->name);
+  lag = g_get_monotonic_time() - job->queued;
+
+  g_mutex_lock(&rb_data.mutex);
+  rb_data.compress_queued--;
+  if (ok)
+    rb_data.compress_stats.compressed++;
+  else
+    rb_data.compress_stats.failed++;
+  if (lag > rb_data.compress_stats.max_lag)
+    rb_data.compress_stats.max_lag = lag;
+  g_mutex_unlock(&rb_data.mutex);
+
+  g_free(job->name);
+  g_free(job);
 }
 
 /*
- * start a thread to compress capture file
+ * queue a capture file to be compressed
  */
-static int ringbuf_start_compress_file(rb_file* rfile)
+static void ringbuf_start_compress_file(rb_file* rfile)
 {
-  gchar* name = g_strdup(rfile->name);
-  g_thread_new("exec_compress", &exec_compress_thread, name);
-  return 0;
+  compress_job *job;
+
+  g_mutex_lock(&rb_data.mutex);
+  if (rb_data.compress_queued >= COMPRESS_MAX_QUEUED) {
+    rb_data.compress_stats.skipped++;
+    g_mutex_unlock(&rb_data.mutex);
+    return;
+  }
+  rb_data.compress_queued++;
+  if (rb_data.compress_queued > rb_data.compress_stats.max_queued)
+    rb_data.compress_stats.max_queued = rb_data.compress_queued;
+  g_mutex_unlock(&rb_data.mutex);
+
+  if (rb_data.compress_pool == NULL) {
+    /* leave at least half the processors to the capture */
+    guint threads = MAX(g_get_num_processors() / 2, 1);
+
+    rb_data.compress_pool = g_thread_pool_new(exec_compress_job, NULL,
+                                              MIN(threads, COMPRESS_MAX_THREADS),
+                                              FALSE, NULL);
+  }
+
+  job = g_new(compress_job, 1);
+  job->name = g_strdup(rfile->name);
+  job->queued = g_get_monotonic_time();
+  g_thread_pool_push(rb_data.compress_pool, job, NULL);
 }
 
 /*
@@ -215,7 +323,7 @@ static int ringbuf_open_file(rb_file *rfile, int *err)
       /* remove old file (if any, so ignore error) */
       ws_unlink(rfile->name);
     }
-    else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "gzip") == 0) {
+    else if (rb_data.compress_type != NULL && strcmp(rb_data.compress_type, "none") != 0) {
       ringbuf_start_compress_file(rfile);
     }
     g_free(rfile->name);
@@ -273,6 +381,9 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
   rb_data.name_h = NULL;
   rb_data.compress_type = compress_type;
   g_mutex_init(&rb_data.mutex);
+  rb_data.compress_pool = NULL;
+  rb_data.compress_queued = 0;
+  memset(&rb_data.compress_stats, 0, sizeof rb_data.compress_stats);
 
   /* just to be sure ... */
   if (num_files <= RINGBUFFER_MAX_NUM_FILES) {
@@ -508,13 +619,30 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 }
 
 /*
- * Frees all memory allocated by the ringbuffer
+ * Gets the counts of the compression of finished files.
+ */
+void
+ringbuf_get_compress_stats(ringbuf_compress_stats *stats)
+{
+  g_mutex_lock(&rb_data.mutex);
+  *stats = rb_data.compress_stats;
+  g_mutex_unlock(&rb_data.mutex);
+}
+
+/*
+ * Frees all memory allocated by the ringbuffer, after waiting for any
+ * files still being compressed
  */
 void
 ringbuf_free(void)
 {
   unsigned int i;
 
+  if (rb_data.compress_pool != NULL) {
+    g_thread_pool_free(rb_data.compress_pool, FALSE, TRUE);
+    rb_data.compress_pool = NULL;
+  }
+
   if (rb_data.files != NULL) {
     for (i=0; i < rb_data.num_files; i++) {
       if (rb_data.files[i].name != NULL) {
@@ -23,6 +23,16 @@
 /* Maximum number for FAT filesystems */
 #define RINGBUFFER_WARN_NUM_FILES 65535
 
+/* Counts of the compression of finished files */
+typedef struct _ringbuf_compress_stats {
+  guint   compressed;   /**< files compressed */
+  guint   failed;       /**< files that couldn't be compressed */
+  guint   skipped;      /**< files left uncompressed because too many were waiting */
+  guint   max_queued;   /**< most files waiting for or being compressed at once */
+  gint64  max_lag;      /**< longest time, in microseconds, from a file being
+                             finished to its being compressed */
+} ringbuf_compress_stats;
+
 int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_access, gchar* compress_type);
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
@@ -33,6 +43,7 @@ gboolean ringbuf_libpcap_dump_close(gchar **save_file, int *err);
 void ringbuf_free(void);
 void ringbuf_error_cleanup(void);
 gboolean ringbuf_set_print_name(gchar *name, int *err);
+void ringbuf_get_compress_stats(ringbuf_compress_stats *stats);
 
 #endif /* ringbuffer.h */
 
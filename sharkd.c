@@ -399,6 +399,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
   wtap  *wth;
   gchar *err_info;
 
+  wtap_set_write_gzip_index(prefs.gui_write_capture_index && !is_tempfile);
   wth = wtap_open_offline(fname, type, err, &err_info, TRUE);
   if (wth == NULL)
     goto fail;
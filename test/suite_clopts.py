@@ -44,6 +44,17 @@ class case_dumpcap_options(subprocesstest.SubprocessTestCase):
             process = self.runProcess((cmd_dumpcap, '-' + char_arg), env=base_env)
             self.assertIn(process.returncode, valid_returns)
 
+    def test_dumpcap_fanout_invalid(self, cmd_dumpcap, base_env):
+        '''Invalid --fanout socket counts and options used with it'''
+        if sys.platform != 'linux':
+            self.skipTest('--fanout is only available on Linux.')
+        for args in (('--fanout', '0'), ('--fanout', 'x'), ('--fanout', '257')):
+            self.assertRun((cmd_dumpcap,) + args, env=base_env,
+                           expected_return=self.exit_command_line)
+        self.assertRun((cmd_dumpcap, '--fanout', '4', '-P', '-w', self.filename_from_id(testout_pcap)),
+                       env=base_env, expected_return=self.exit_command_line)
+        self.assertTrue(self.grepOutput("can't be used with -P"))
+
 
 @fixtures.mark_usefixtures('base_env')
 @fixtures.uses_fixtures
@@ -156,3 +156,19 @@ class case_integer(unittest.TestCase):
     def test_bool_ne_2(self, checkDFilterCount):
         dfilter = "ip.flags.df != 0"
         checkDFilterCount(dfilter, 0)
+
+    def test_or_1(self, checkDFilterCount):
+        dfilter = "ip.version == 6 || ip.version == 4"
+        checkDFilterCount(dfilter, 1)
+
+    def test_or_2(self, checkDFilterCount):
+        dfilter = "ip.version > 5 || ip.version < 3"
+        checkDFilterCount(dfilter, 0)
+
+    def test_lhs_constant_1(self, checkDFilterCount):
+        dfilter = "4 == ip.version"
+        checkDFilterCount(dfilter, 1)
+
+    def test_lhs_constant_2(self, checkDFilterCount):
+        dfilter = "3 < ip.version"
+        checkDFilterCount(dfilter, 1)
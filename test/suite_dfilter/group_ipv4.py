@@ -134,3 +134,15 @@ class case_ipv4(unittest.TestCase):
     def test_count_2(self, checkDFilterCount):
          dfilter = "count(ip.addr) == 2"
          checkDFilterCount(dfilter, 2)
+
+    def test_or_1(self, checkDFilterCount):
+        dfilter = "ip.src == 255.255.255.255 || ip.src == 172.25.100.14"
+        checkDFilterCount(dfilter, 1)
+
+    def test_or_2(self, checkDFilterCount):
+        dfilter = "ip.src == 10.0.0.0/8 || ip.src == 172.25.0.0/16"
+        checkDFilterCount(dfilter, 1)
+
+    def test_lhs_constant_1(self, checkDFilterCount):
+        dfilter = "198.95.230.10 < ip.dst"
+        checkDFilterCount(dfilter, 1)
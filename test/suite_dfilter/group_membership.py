@@ -58,3 +58,31 @@ class case_membership(unittest.TestCase):
         dfilter = 'frame.number in {1 "foo"}'
         error = '"foo" cannot be converted to Unsigned integer, 4 bytes.'
         checkDFilterFail(dfilter, error)
+
+    def test_membership_12_large_set(self, checkDFilterCount):
+        dfilter = 'tcp.port in {1 2 3 4 5 6 7 8 80}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_13_large_set_no_match(self, checkDFilterCount):
+        dfilter = 'tcp.port in {1 2 3 4 5 6 7 8 9}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_14_large_set_range(self, checkDFilterCount):
+        dfilter = 'tcp.port in {1 2 3 4 5 6 7 8 3000..3300}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_15_large_ip_set_netmask(self, checkDFilterCount):
+        dfilter = 'ip.addr in {1.1.1.1 2.2.2.2 3.3.3.3 4.4.4.4 5.5.5.5 6.6.6.6 7.7.7.7 10.0.0.0/8}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_16_large_ip_set_no_match(self, checkDFilterCount):
+        dfilter = 'ip.addr in {1.1.1.1 2.2.2.2 3.3.3.3 4.4.4.4 5.5.5.5 6.6.6.6 7.7.7.7 11.0.0.0/8}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_membership_17_large_string_set(self, checkDFilterCount):
+        dfilter = 'http.request.method in {"A" "B" "C" "D" "E" "F" "G" "HEAD"}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_membership_18_large_string_set_no_match(self, checkDFilterCount):
+        dfilter = 'http.request.method in {"A" "B" "C" "D" "E" "F" "G" "HEA"}'
+        checkDFilterCount(dfilter, 0)
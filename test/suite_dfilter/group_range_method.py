@@ -34,3 +34,19 @@ class case_range(unittest.TestCase):
     def test_slice_2_neg(self, checkDFilterCount):
         dfilter = "ipx.src.node[3:2] == cc:dd"
         checkDFilterCount(dfilter, 0)
+
+    def test_slice_2_neg_offset(self, checkDFilterCount):
+        dfilter = "ipx.src.node[-3:2] == a3:e3"
+        checkDFilterCount(dfilter, 1)
+
+    def test_slice_out_of_bounds_eq(self, checkDFilterCount):
+        dfilter = "ipx.src.node[5:2] == 00:00"
+        checkDFilterCount(dfilter, 0)
+
+    def test_slice_out_of_bounds_ne(self, checkDFilterCount):
+        dfilter = "ipx.src.node[5:2] != 00:00"
+        checkDFilterCount(dfilter, 1)
+
+    def test_slice_or(self, checkDFilterCount):
+        dfilter = "ipx.src.node[1] == bb || ipx.src.node[3:2] == a3:e3"
+        checkDFilterCount(dfilter, 1)
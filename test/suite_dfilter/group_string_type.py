@@ -140,6 +140,19 @@ class case_string(unittest.TestCase):
         dfilter = 'http.user_agent contains "UPDATE"'
         checkDFilterCount(dfilter, 0)
 
+    def test_contains_any_1(self, checkDFilterCount):
+        dfilter = 'http.request.method contains "X" || http.request.method contains "Y" || http.request.method contains "AD"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_2(self, checkDFilterCount):
+        dfilter = 'http.request.method contains "X" || http.request.method contains "Y" || http.request.method contains "DA"'
+        checkDFilterCount(dfilter, 0)
+
+    def test_contains_any_3(self, checkDFilterCount):
+        # Overlapping patterns, where the first one fails halfway.
+        dfilter = 'http.request.method contains "HEX" || http.request.method contains "EAX" || http.request.method contains "EAD"'
+        checkDFilterCount(dfilter, 1)
+
     def test_contains_upper_0(self, checkDFilterCount):
         dfilter = 'upper(http.user_agent) contains "UPDATE"'
         checkDFilterCount(dfilter, 1)
@@ -464,3 +464,91 @@ class case_communityid(subprocesstest.SubprocessTestCase):
              ))
 
         self.assertBaseline(dirs, proc.stdout_str, 'communityid-filtered.txt')
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_tshark_threads(subprocesstest.SubprocessTestCase):
+    def check_same_output(self, cmd_tshark, capture_file, pcap_file, args):
+        '''Checks that --threads doesn't change the output.'''
+        single_proc = self.assertRun([cmd_tshark, '-r', capture_file(pcap_file)] + args)
+        for threads in ('2', '5'):
+            threads_proc = self.assertRun([cmd_tshark, '-r', capture_file(pcap_file),
+                                           '--threads', threads] + args)
+            self.assertNotEqual(single_proc.stdout_str, '')
+            self.assertEqual(single_proc.stdout_str, threads_proc.stdout_str)
+
+    def test_tshark_threads_summary(self, cmd_tshark, capture_file):
+        '''Packet summary lines in frame order.'''
+        self.check_same_output(cmd_tshark, capture_file, 'dns+icmp.pcapng.gz', [])
+
+    def test_tshark_threads_details(self, cmd_tshark, capture_file):
+        '''Packet details and bytes.'''
+        self.check_same_output(cmd_tshark, capture_file, 'dhcp.pcap', ['-V', '-x'])
+
+    def test_tshark_threads_tcp_reassembly(self, cmd_tshark, capture_file):
+        '''HTTP over out of order TCP segments.'''
+        self.check_same_output(cmd_tshark, capture_file, 'http-ooo.pcap',
+            ['-Tfields', '-eframe.number', '-eframe.time_relative', '-ehttp.request.uri',
+             '-ehttp.response.code'])
+
+    def test_tshark_threads_filter(self, cmd_tshark, capture_file):
+        '''A display filter, with DNS responses matched to their requests.'''
+        self.check_same_output(cmd_tshark, capture_file, 'dns+icmp.pcapng.gz',
+            ['-Ydns', '-Tfields', '-eframe.number', '-edns.qry.name', '-edns.response_to'])
+
+    def test_tshark_threads_count(self, cmd_tshark, capture_file):
+        '''-c counts every packet read, whichever worker dissects it.'''
+        self.check_same_output(cmd_tshark, capture_file, 'dns+icmp.pcapng.gz',
+            ['-c', '3', '-Tfields', '-eframe.number', '-eip.src'])
+
+    def test_tshark_threads_two_pass(self, cmd_tshark, capture_file):
+        '''--threads can't be used with -2.'''
+        self.assertRun((cmd_tshark, '-r', capture_file('dhcp.pcap'), '--threads', '2', '-2'),
+            expected_return=self.exit_command_line)
+
+    def test_tshark_threads_statistics(self, cmd_tshark, capture_file):
+        '''--threads can't be used with statistics.'''
+        self.assertRun((cmd_tshark, '-r', capture_file('dhcp.pcap'), '--threads', '2',
+            '-q', '-z', 'io,phs'),
+            expected_return=self.exit_command_line)
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_prune_protocols(subprocesstest.SubprocessTestCase):
+    def check_same_output(self, cmd_tshark, capture_file, pcap_file, args):
+        '''Checks that --prune-protocols doesn't change the output.'''
+        full_proc = self.assertRun([cmd_tshark, '-r', capture_file(pcap_file)] + args)
+        pruned_proc = self.assertRun([cmd_tshark, '-r', capture_file(pcap_file),
+                                      '--prune-protocols'] + args)
+        self.assertNotEqual(full_proc.stdout_str, '')
+        self.assertEqual(full_proc.stdout_str, pruned_proc.stdout_str)
+
+    def test_prune_protocols_tls_reassembly(self, cmd_tshark, capture_file):
+        '''TCP and TLS handshake reassembly with pruned protocols.'''
+        self.check_same_output(cmd_tshark, capture_file, 'tls-fragmented-handshakes.pcap.gz',
+            ['-Ytls.handshake.extension.data', '-Tfields', '-etls.handshake.extension.data'])
+
+    def test_prune_protocols_tls_reassembly_2(self, cmd_tshark, capture_file):
+        '''TCP and TLS handshake reassembly with pruned protocols (second pass).'''
+        self.check_same_output(cmd_tshark, capture_file, 'tls-fragmented-handshakes.pcap.gz',
+            ['-2', '-Ytls.handshake.extension.data', '-Tfields', '-etls.handshake.extension.data'])
+
+    def test_prune_protocols_http_out_of_order(self, cmd_tshark, capture_file):
+        '''HTTP over out of order TCP segments with pruned protocols.'''
+        self.check_same_output(cmd_tshark, capture_file, 'http-ooo.pcap',
+            ['-Yhttp', '-Tfields', '-eframe.number', '-ehttp.request.uri', '-ehttp.response.code'])
+
+    def test_prune_protocols_lower_layer_fields(self, cmd_tshark, capture_file):
+        '''Filtering on TCP with the protocols above it pruned.'''
+        self.check_same_output(cmd_tshark, capture_file, 'http-ooo.pcap',
+            ['-Ytcp.len > 0', '-Tfields', '-eframe.number', '-etcp.stream', '-etcp.seq'])
+
+    def test_prune_protocols_sip_rtp(self, cmd_tshark, capture_file):
+        '''RTP set up by SIP and SDP with pruned protocols.'''
+        self.check_same_output(cmd_tshark, capture_file, 'sip-rtp.pcap',
+            ['-Yrtp', '-Tfields', '-eframe.number', '-ertp.seq', '-ertp.setup-method'])
+
+    def test_prune_protocols_udp(self, cmd_tshark, capture_file):
+        '''DHCP fields with pruned protocols.'''
+        self.check_same_output(cmd_tshark, capture_file, 'dhcp.pcap',
+            ['-Tfields', '-eip.src', '-edhcp.option.type'])
@@ -8,8 +8,11 @@
 #
 '''File I/O tests'''
 
+import gzip
 import io
 import os.path
+import random
+import struct
 import subprocesstest
 import sys
 import unittest
@@ -17,6 +20,7 @@ import fixtures
 
 testout_pcap = 'testout.pcap'
 baseline_file = 'io-rawshark-dhcp-pcap.txt'
+read_ahead_pcap = 'read-ahead.pcap'
 
 
 @fixtures.fixture(scope='session')
@@ -84,3 +88,383 @@ class case_rawshark_io(subprocesstest.SubprocessTestCase):
         rawshark_cmd = '{0} | "{1}" -r - -n -dencap:1 -R "udp.port==68"'.format(raw_dhcp_cmd, cmd_rawshark)
         rawshark_proc = self.assertRun(rawshark_cmd, shell=True)
         self.assertTrue(self.diffOutput(rawshark_proc.stdout_str, io_baseline_str, 'rawshark', baseline_file))
+
+
+def make_read_ahead_capture(self, compress):
+    # Random payloads don't compress, so the file is a few times the size
+    # of the read-ahead buffers (1 MB) whether it's gzipped or not.
+    rng = random.Random(13)
+    filename = self.filename_from_id(read_ahead_pcap + ('.gz' if compress else ''))
+    opener = gzip.open if compress else open
+    with opener(filename, 'wb') as pcap_fd:
+        pcap_fd.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+        for num in range(4000):
+            length = rng.randint(60, 1514)
+            pcap_fd.write(struct.pack('<IIII', 1600000000 + num, num, length, length))
+            pcap_fd.write(rng.getrandbits(8 * length).to_bytes(length, 'little'))
+    return filename
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_read_ahead(subprocesstest.SubprocessTestCase):
+    fields = ('-Tfields', '-eframe.number', '-eframe.time_epoch', '-eframe.len', '-eeth.src', '-eeth.dst')
+
+    def check_tshark(self, cmd_tshark, capture, *args):
+        baseline = self.assertRun((cmd_tshark, '-r', capture) + args + self.fields)
+        self.assertEqual(baseline.stdout_str.count('\n'), 4000)
+        for depth in ('1', '3'):
+            read_ahead = self.assertRun((cmd_tshark, '--read-ahead', depth, '-r', capture) + args + self.fields)
+            self.assertEqual(read_ahead.stdout_str, baseline.stdout_str)
+
+    def test_read_ahead_tshark_gzip(self, cmd_tshark):
+        '''Read a gzipped file ahead with TShark'''
+        self.check_tshark(cmd_tshark, make_read_ahead_capture(self, True))
+
+    def test_read_ahead_tshark_uncompressed(self, cmd_tshark):
+        '''Read an uncompressed file ahead with TShark'''
+        self.check_tshark(cmd_tshark, make_read_ahead_capture(self, False))
+
+    def test_read_ahead_tshark_two_pass(self, cmd_tshark):
+        '''Read a gzipped file ahead, then at random, with TShark'''
+        self.check_tshark(cmd_tshark, make_read_ahead_capture(self, True), '-2', '-Y', 'frame.len > 100')
+
+    def test_read_ahead_tshark_stdin(self, cmd_tshark):
+        '''Pipes aren't read ahead'''
+        capture = make_read_ahead_capture(self, True)
+        baseline = self.assertRun((cmd_tshark, '-r', capture) + self.fields)
+        read_ahead = self.assertRun('"{0}" --read-ahead 1 -r - {1} < "{2}"'.format(
+            cmd_tshark, ' '.join(self.fields), capture), shell=True)
+        self.assertEqual(read_ahead.stdout_str, baseline.stdout_str)
+
+    def test_read_ahead_editcap(self, cmd_editcap):
+        '''Read a gzipped file ahead with Editcap'''
+        capture = make_read_ahead_capture(self, True)
+        baseline_file = self.filename_from_id('baseline.pcap')
+        read_ahead_file = self.filename_from_id(testout_pcap)
+        self.assertRun((cmd_editcap, '-F', 'pcap', capture, baseline_file))
+        self.assertRun((cmd_editcap, '--read-ahead', '1', '-F', 'pcap', capture, read_ahead_file))
+        with open(baseline_file, 'rb') as baseline_fd, open(read_ahead_file, 'rb') as read_ahead_fd:
+            self.assertEqual(read_ahead_fd.read(), baseline_fd.read())
+
+    def test_read_ahead_mergecap(self, cmd_mergecap):
+        '''Read gzipped files ahead with Mergecap'''
+        capture = make_read_ahead_capture(self, True)
+        uncompressed = make_read_ahead_capture(self, False)
+        baseline_file = self.filename_from_id('baseline.pcap')
+        read_ahead_file = self.filename_from_id(testout_pcap)
+        self.assertRun((cmd_mergecap, '-F', 'pcap', '-w', baseline_file, capture, uncompressed))
+        self.assertRun((cmd_mergecap, '--read-ahead', '1', '-F', 'pcap', '-w', read_ahead_file, capture, uncompressed))
+        with open(baseline_file, 'rb') as baseline_fd, open(read_ahead_file, 'rb') as read_ahead_fd:
+            self.assertEqual(read_ahead_fd.read(), baseline_fd.read())
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_compress(subprocesstest.SubprocessTestCase):
+    fields = ('-Tfields', '-eframe.number', '-eframe.time_epoch', '-eframe.len', '-eeth.src', '-eeth.dst')
+    magic = {
+        'gzip': b'\x1f\x8b',
+        'zstd': b'\x28\xb5\x2f\xfd',
+        'lz4': b'\x04\x22\x4d\x18',
+    }
+    extension = {
+        'gzip': '.gz',
+        'zstd': '.zst',
+        'lz4': '.lz4',
+    }
+
+    def compression_types(self, cmd_editcap):
+        # An empty --compress lists the types this build can write.
+        list_proc = self.runProcess((cmd_editcap, '--compress'))
+        types = [line.strip() for line in list_proc.stdout_str.splitlines() if line.startswith('    ')]
+        self.assertIn('none', types)
+        return [t for t in types if t != 'none']
+
+    def check_compressed(self, cmd_editcap, cmd_tshark, capture, compressed, compression):
+        with open(compressed, 'rb') as compressed_fd:
+            self.assertEqual(compressed_fd.read(len(self.magic[compression])), self.magic[compression])
+        # Reading the file back gives the packets that were written...
+        baseline_file = self.filename_from_id('baseline.pcap')
+        round_trip_file = self.filename_from_id(testout_pcap)
+        self.assertRun((cmd_editcap, '-F', 'pcap', capture, baseline_file))
+        self.assertRun((cmd_editcap, '-F', 'pcap', compressed, round_trip_file))
+        with open(baseline_file, 'rb') as baseline_fd, open(round_trip_file, 'rb') as round_trip_fd:
+            self.assertEqual(round_trip_fd.read(), baseline_fd.read())
+        # ...in order, and at random.
+        for args in ((), ('-2', '-Y', 'frame.len > 100')):
+            baseline = self.assertRun((cmd_tshark, '-r', capture) + args + self.fields)
+            read_back = self.assertRun((cmd_tshark, '-r', compressed) + args + self.fields)
+            self.assertEqual(read_back.stdout_str, baseline.stdout_str)
+
+    def test_compress_editcap(self, cmd_editcap, cmd_tshark):
+        '''Write compressed files with Editcap and read them back'''
+        types = self.compression_types(cmd_editcap)
+        if not types:
+            self.skipTest('Requires a build that can write compressed files.')
+        capture = make_read_ahead_capture(self, False)
+        for compression in types:
+            compressed = self.filename_from_id('compressed.pcap' + self.extension[compression])
+            self.assertRun((cmd_editcap, '-F', 'pcap', '--compress', compression, capture, compressed))
+            self.check_compressed(cmd_editcap, cmd_tshark, capture, compressed, compression)
+
+    def test_compress_tshark(self, cmd_editcap, cmd_tshark):
+        '''Write compressed files with TShark and read them back'''
+        types = self.compression_types(cmd_editcap)
+        if not types:
+            self.skipTest('Requires a build that can write compressed files.')
+        capture = make_read_ahead_capture(self, False)
+        for compression in types:
+            compressed = self.filename_from_id('compressed.pcap' + self.extension[compression])
+            self.assertRun((cmd_tshark, '-r', capture, '-F', 'pcap', '--compress', compression, '-w', compressed))
+            self.check_compressed(cmd_editcap, cmd_tshark, capture, compressed, compression)
+
+    def test_compress_invalid(self, cmd_editcap, cmd_tshark):
+        '''Unknown types of compression are rejected'''
+        capture = make_read_ahead_capture(self, False)
+        compressed = self.filename_from_id('compressed.pcap')
+        editcap_proc = self.runProcess((cmd_editcap, '--compress', 'bogus', capture, compressed))
+        self.assertNotEqual(editcap_proc.returncode, 0)
+        self.assertIn('isn\'t a valid type of compression', editcap_proc.stderr_str)
+        tshark_proc = self.runProcess((cmd_tshark, '-r', capture, '--compress', 'bogus', '-w', compressed))
+        self.assertNotEqual(tshark_proc.returncode, 0)
+        # Compression needs a file to compress.
+        tshark_proc = self.runProcess((cmd_tshark, '-r', capture, '--compress', 'gzip'))
+        self.assertNotEqual(tshark_proc.returncode, 0)
+
+
+def make_gzip_index_capture(self, seed=17):
+    # Text-like payloads, which deflate does compress, in two gzip
+    # members, so that the index has points of every kind.
+    rng = random.Random(seed)
+    words = [b'alpha', b'bravo', b'charlie', b'delta', b'echo', b'foxtrot', b'golf', b'hotel']
+    pcap = io.BytesIO()
+    pcap.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+    for num in range(12000):
+        payload = b' '.join(rng.choice(words) for _ in range(rng.randint(10, 250)))[:1514]
+        pcap.write(struct.pack('<IIII', 1600000000 + num, num, len(payload), len(payload)))
+        pcap.write(payload)
+    data = pcap.getvalue()
+    filename = self.filename_from_id('gzip-index.pcap.gz')
+    with open(filename, 'wb') as pcap_fd:
+        pcap_fd.write(gzip.compress(data[:len(data) // 3]))
+        pcap_fd.write(gzip.compress(data[len(data) // 3:]))
+    return filename
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_gzip_index(subprocesstest.SubprocessTestCase):
+    fields = ('-Tfields', '-eframe.number', '-eframe.time_epoch', '-eframe.len', '-edata.len')
+    magic = b'\x89WSGZI\r\n'
+
+    def read_index(self, capture):
+        with open(capture + '.gzidx', 'rb') as index_fd:
+            return index_fd.read()
+
+    def test_gzip_index_write(self, cmd_tshark):
+        '''Write a gzip index once a file has been read to the end'''
+        capture = make_gzip_index_capture(self)
+        baseline = self.assertRun((cmd_tshark, '-r', capture) + self.fields)
+        self.assertFalse(os.path.exists(capture + '.gzidx'))
+        indexing = self.assertRun((cmd_tshark, '--write-gzip-index', '-r', capture) + self.fields)
+        self.assertEqual(indexing.stdout_str, baseline.stdout_str)
+        index = self.read_index(capture)
+        self.assertEqual(index[:len(self.magic)], self.magic)
+        # Several points, with their windows.
+        self.assertGreater(len(index), 80 + 4 * 36)
+
+    def test_gzip_index_not_written(self, cmd_tshark):
+        '''No index is written unless asked for, or for a file that isn't read to the end'''
+        capture = make_gzip_index_capture(self)
+        self.assertRun((cmd_tshark, '--inflate-threads', '4', '-r', capture) + self.fields)
+        self.assertFalse(os.path.exists(capture + '.gzidx'))
+        self.assertRun((cmd_tshark, '--write-gzip-index', '-c', '10', '-r', capture) + self.fields)
+        self.assertFalse(os.path.exists(capture + '.gzidx'))
+
+    def test_gzip_index_reuse(self, cmd_tshark):
+        '''Read a file with an index, in order, in parallel and at random'''
+        capture = make_gzip_index_capture(self)
+        self.assertRun((cmd_tshark, '--write-gzip-index', '-r', capture) + self.fields)
+        index = self.read_index(capture)
+        for args in ((), ('-2', '-Y', 'frame.len > 1000')):
+            baseline = self.assertRun((cmd_tshark, '-r', capture) + args + self.fields)
+            for threads in ('0', '1', '4'):
+                with_index = self.assertRun((cmd_tshark, '--inflate-threads', threads,
+                    '--write-gzip-index', '-r', capture) + args + self.fields)
+                self.assertEqual(with_index.stdout_str, baseline.stdout_str)
+        # An up-to-date index is left alone.
+        self.assertEqual(self.read_index(capture), index)
+
+    def test_gzip_index_stale(self, cmd_tshark):
+        '''An index for what's no longer the same file is ignored, and replaced'''
+        capture = make_gzip_index_capture(self)
+        self.assertRun((cmd_tshark, '--write-gzip-index', '-r', capture) + self.fields)
+        old_index = self.read_index(capture)
+        make_gzip_index_capture(self, seed=18)
+        baseline = self.assertRun((cmd_tshark, '-r', capture) + self.fields)
+        stale = self.assertRun((cmd_tshark, '--inflate-threads', '4', '-r', capture) + self.fields)
+        self.assertEqual(stale.stdout_str, baseline.stdout_str)
+        self.assertRun((cmd_tshark, '--write-gzip-index', '-r', capture) + self.fields)
+        self.assertNotEqual(self.read_index(capture), old_index)
+
+    def test_parallel_inflate_output(self, cmd_tshark):
+        '''Inflating in parallel writes the same file as inflating serially'''
+        capture = make_gzip_index_capture(self)
+        self.assertRun((cmd_tshark, '--write-gzip-index', '-r', capture) + self.fields)
+        serial_file = self.filename_from_id('serial.pcap')
+        parallel_file = self.filename_from_id(testout_pcap)
+        self.assertRun((cmd_tshark, '-r', capture, '-F', 'pcap', '-w', serial_file))
+        self.assertRun((cmd_tshark, '--inflate-threads', '4', '-r', capture, '-F', 'pcap', '-w', parallel_file))
+        with open(serial_file, 'rb') as serial_fd, open(parallel_file, 'rb') as parallel_fd:
+            self.assertEqual(parallel_fd.read(), serial_fd.read())
+
+
+def write_pcap(filename, packets):
+    # packets is a list of (time in microseconds, payload).
+    with open(filename, 'wb') as pcap_fd:
+        pcap_fd.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+        for usecs, payload in packets:
+            pcap_fd.write(struct.pack('<IIII', usecs // 1000000, usecs % 1000000, len(payload), len(payload)))
+            pcap_fd.write(payload)
+
+
+def read_pcap(filename):
+    packets = []
+    with open(filename, 'rb') as pcap_fd:
+        pcap_fd.read(24)
+        while True:
+            header = pcap_fd.read(16)
+            if not header:
+                break
+            secs, usecs, caplen, _ = struct.unpack('<IIII', header)
+            packets.append((secs * 1000000 + usecs, pcap_fd.read(caplen)))
+    return packets
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_editcap_dedup(subprocesstest.SubprocessTestCase):
+    def check_dedup(self, cmd_editcap, args, packets, kept):
+        '''Remove duplicates from packets, given as (seconds, payload), and check which are kept'''
+        in_file = self.filename_from_id('dedup-in.pcap')
+        out_file = self.filename_from_id(testout_pcap)
+        packets = [(int(round(secs * 1000000)), payload.encode()) for secs, payload in packets]
+        write_pcap(in_file, packets)
+        self.assertRun((cmd_editcap, '-F', 'pcap') + args + (in_file, out_file))
+        self.assertEqual(read_pcap(out_file), [packets[i] for i in kept])
+
+    def test_dedup_window(self, cmd_editcap):
+        '''Remove duplicates among the last packets with -d and -D'''
+        packets = [(n, payload) for n, payload in enumerate(
+            ('alpha', 'bravo', 'alpha', 'charlie', 'alpha', 'delta', 'echo', 'foxtrot', 'golf', 'alpha'))]
+        # -d compares each packet with the 4 before it.
+        self.check_dedup(cmd_editcap, ('-d',), packets, (0, 1, 3, 5, 6, 7, 8, 9))
+        self.check_dedup(cmd_editcap, ('-D', '2'), packets, (0, 1, 2, 3, 4, 5, 6, 7, 8, 9))
+        self.check_dedup(cmd_editcap, ('-D', '3'), packets, (0, 1, 3, 5, 6, 7, 8, 9))
+        self.check_dedup(cmd_editcap, ('-D', '10'), packets, (0, 1, 3, 5, 6, 7, 8))
+        self.check_dedup(cmd_editcap, ('-D', '0'), packets, range(10))
+
+    def test_dedup_time_window(self, cmd_editcap):
+        '''Remove duplicates that are close in time with -w'''
+        packets = [(1.0, 'alpha'), (1.2, 'alpha'), (2.0, 'alpha'), (2.1, 'bravo'), (2.4, 'alpha'), (2.5, 'bravo')]
+        self.check_dedup(cmd_editcap, ('-w', '0.5'), packets, (0, 2, 3))
+        self.check_dedup(cmd_editcap, ('-w', '0.1'), packets, (0, 1, 2, 3, 4, 5))
+
+    def test_dedup_time_window_out_of_order(self, cmd_editcap):
+        '''Remove duplicates with -w from packets that aren't in time order'''
+        # A packet is a duplicate of an earlier one that's within the
+        # window before it, even if packets with the same data that came
+        # in between are later than it, or long before it.
+        packets = [(1.0, 'alpha'), (5.0, 'alpha'), (1.3, 'alpha'), (10.0, 'bravo'), (20.0, 'charlie'),
+                   (10.5, 'bravo'), (0.5, 'alpha'), (5.4, 'alpha')]
+        self.check_dedup(cmd_editcap, ('-w', '0.5'), packets, (0, 1, 3, 4, 6))
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_reordercap(subprocesstest.SubprocessTestCase):
+    def make_packets(self, count=1000, late_by=3):
+        # Each packet is up to late_by seconds late, and every tenth one
+        # has the same time stamp as the one before it.
+        rng = random.Random(5)
+        packets = []
+        for num in range(count):
+            usecs = (1600000000 + num + rng.randint(0, late_by)) * 1000000
+            if num % 10 == 9:
+                usecs = packets[-1][0]
+            packets.append((usecs, 'packet {}'.format(num).encode()))
+        in_file = self.filename_from_id('reorder-in.pcap')
+        write_pcap(in_file, packets)
+        # Packets with the same time stamp stay in the order they were read in.
+        return in_file, sorted(packets, key=lambda packet: packet[0])
+
+    def check_reorder(self, cmd_reordercap, args, in_file, expected):
+        out_file = self.filename_from_id(testout_pcap)
+        self.assertRun((cmd_reordercap,) + args + (in_file, out_file))
+        self.assertEqual(read_pcap(out_file), expected)
+
+    def test_reorder(self, cmd_reordercap):
+        '''Sort a file, re-reading its packets at random'''
+        in_file, expected = self.make_packets()
+        self.check_reorder(cmd_reordercap, (), in_file, expected)
+
+    def test_reorder_window(self, cmd_reordercap):
+        '''Sort a file as it's read, with a window that holds every late packet'''
+        in_file, expected = self.make_packets()
+        self.check_reorder(cmd_reordercap, ('-w', '4'), in_file, expected)
+        self.check_reorder(cmd_reordercap, ('-c', '10'), in_file, expected)
+        self.check_reorder(cmd_reordercap, ('-w', '4', '-c', '10'), in_file, expected)
+
+    def test_reorder_window_too_small(self, cmd_reordercap):
+        '''Packets later than the window are written as soon as they can be, and counted'''
+        in_file, expected = self.make_packets()
+        out_file = self.filename_from_id(testout_pcap)
+        reorder_proc = self.assertRun((cmd_reordercap, '-w', '1', in_file, out_file))
+        self.assertIn('are still out of order', reorder_proc.stdout_str)
+        self.assertCountEqual(read_pcap(out_file), expected)
+        self.assertNotEqual(read_pcap(out_file), expected)
+
+    def test_reorder_external(self, cmd_reordercap):
+        '''Sort a file in runs, including more runs than are merged at once'''
+        in_file, expected = self.make_packets()
+        # One run, 20 runs, and 334 runs, which are merged in passes.
+        for max_frames in ('1000', '50', '3'):
+            self.check_reorder(cmd_reordercap, ('-m', max_frames), in_file, expected)
+
+
+@fixtures.mark_usefixtures('test_env')
+@fixtures.uses_fixtures
+class case_capinfos_threads(subprocesstest.SubprocessTestCase):
+    captures = ('dhcp.pcap', 'dhcp.pcapng', 'dhcp-nanosecond.pcapng', 'dns+icmp.pcapng.gz',
+                'many_interfaces.pcapng.1', 'many_interfaces.pcapng.2', 'many_interfaces.pcapng.3',
+                'sip.pcapng', 'tls12-dsb.pcapng', 'http.pcap')
+
+    def check_threads(self, cmd_capinfos, args, files):
+        serial = self.runProcess((cmd_capinfos,) + args + files)
+        for threads in ('2', '4', '16'):
+            parallel = self.runProcess((cmd_capinfos, '--threads', threads) + args + files)
+            self.assertEqual(parallel.returncode, serial.returncode)
+            self.assertEqual(parallel.stdout_str, serial.stdout_str)
+            self.assertEqual(parallel.stderr_str, serial.stderr_str)
+        return serial
+
+    def test_capinfos_threads(self, cmd_capinfos, capture_file):
+        '''Scanning files in parallel prints what a serial scan does'''
+        files = tuple(capture_file(name) for name in self.captures)
+        serial = self.check_threads(cmd_capinfos, (), files)
+        self.assertEqual(serial.returncode, 0)
+        self.check_threads(cmd_capinfos, ('-T', '-H'), files)
+
+    def test_capinfos_threads_errors(self, cmd_capinfos, capture_file):
+        '''Errors are reported in command-line order, and a cut-short file is noticed'''
+        truncated = make_read_ahead_capture(self, False)
+        with open(truncated, 'r+b') as pcap_fd:
+            pcap_fd.truncate(os.path.getsize(truncated) - 100)
+        files = tuple(capture_file(name) for name in self.captures[:4]) + \
+            (truncated, self.filename_from_id('missing.pcap')) + \
+            tuple(capture_file(name) for name in self.captures[4:])
+        serial = self.check_threads(cmd_capinfos, (), files)
+        self.assertNotEqual(serial.returncode, 0)
+        self.assertIn('cut short in the middle of a packet', serial.stderr_str)
+        self.check_threads(cmd_capinfos, ('-C',), files)
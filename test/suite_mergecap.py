@@ -9,6 +9,7 @@
 '''Mergecap tests'''
 
 import re
+import struct
 import subprocesstest
 import fixtures
 
@@ -69,6 +70,40 @@ def check_mergecap(self, mergecap_proc, file_type, encapsulation, tot_packets, g
     self.assertTrue(re.search(midb_pat, capinfos_testout) is not None,
         'Failed to merge {} IDB packets'.format(idb_packets))
 
+def pcapng_block(block_type, body):
+    body += b'\0' * (-len(body) % 4)
+    length = 12 + len(body)
+    return struct.pack('<II', block_type, length) + body + struct.pack('<I', length)
+
+def write_no_ts_pcapng(filename, file_num):
+    '''Writes a pcapng file with two packets without time stamps (in simple
+    packet blocks) followed by three with time stamps 1, 2 and 3.'''
+    with open(filename, 'wb') as pcapng_fd:
+        pcapng_fd.write(pcapng_block(0x0a0d0d0a, struct.pack('<IHHq', 0x1a2b3c4d, 1, 0, -1)))
+        pcapng_fd.write(pcapng_block(1, struct.pack('<HHI', 1, 0, 65535)))
+        for packet_num in range(2):
+            data = 'notime-{}-{}'.format(file_num, packet_num).encode().ljust(60, b'\0')
+            pcapng_fd.write(pcapng_block(3, struct.pack('<I', len(data)) + data))
+        for secs in range(1, 4):
+            data = 'time-{}-{}'.format(file_num, secs).encode().ljust(60, b'\0')
+            ts = secs * 1000000
+            pcapng_fd.write(pcapng_block(6, struct.pack('<IIIII', 0, ts >> 32, ts & 0xffffffff,
+                len(data), len(data)) + data))
+
+def read_pcapng_packets(filename):
+    '''Returns the data of the enhanced packet blocks of a pcapng file.'''
+    packets = []
+    with open(filename, 'rb') as pcapng_fd:
+        contents = pcapng_fd.read()
+    offset = 0
+    while offset < len(contents):
+        block_type, length = struct.unpack_from('<II', contents, offset)
+        if block_type == 6:
+            caplen = struct.unpack_from('<I', contents, offset + 20)[0]
+            packets.append(contents[offset + 28:offset + 28 + caplen].rstrip(b'\0').decode())
+        offset += length
+    return packets
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -232,6 +267,53 @@ class case_mergecap_pcapng(subprocesstest.SubprocessTestCase):
         ))
         check_mergecap(self, mergecap_proc, 'pcapng', 'Per packet', 88, 33, 62)
 
+    def test_mergecap_3_pcapng_batched_pcapng(self, cmd_mergecap, capture_file):
+        '''Merge multiple pcapng files with many interfaces to pcapng, two at a time'''
+        testout_file = self.filename_from_id(testout_pcapng)
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-v',
+            '-m', '2',
+            '-w', testout_file,
+            capture_file('many_interfaces.pcapng.1'),
+            capture_file('many_interfaces.pcapng.2'),
+            capture_file('many_interfaces.pcapng.3'),
+        ))
+        check_mergecap(self, mergecap_proc, 'pcapng', 'Per packet', 88, 11, 86)
+
+    def test_mergecap_3_pcapng_none_batched_pcapng(self, cmd_mergecap, capture_file):
+        '''Merge multiple pcapng files with many interfaces to pcapng, two at a time, "none" merge mode'''
+        testout_file = self.filename_from_id(testout_pcapng)
+        mergecap_proc = self.assertRun((cmd_mergecap,
+            '-v',
+            '-m', '2',
+            '-I', 'none',
+            '-w', testout_file,
+            capture_file('many_interfaces.pcapng.1'),
+            capture_file('many_interfaces.pcapng.2'),
+            capture_file('many_interfaces.pcapng.3'),
+        ))
+        check_mergecap(self, mergecap_proc, 'pcapng', 'Per packet', 88, 33, 62)
+
+    def test_mergecap_no_ts_batched_pcapng(self, cmd_mergecap):
+        '''Merge files with packets without time stamps, two at a time'''
+        in_files = []
+        for file_num in range(3):
+            in_file = self.filename_from_id('in{}.pcapng'.format(file_num))
+            write_no_ts_pcapng(in_file, file_num)
+            in_files.append(in_file)
+        testout_file = self.filename_from_id(testout_pcapng)
+        self.assertRun([cmd_mergecap, '-w', testout_file] + in_files)
+        batched_file = self.filename_from_id('batched.pcapng')
+        self.assertRun([cmd_mergecap, '-m', '2', '-w', batched_file] + in_files)
+        packets = read_pcapng_packets(testout_file)
+        # packets without time stamps first, then the last file first at
+        # each time stamp
+        self.assertEqual(packets[:6], ['notime-0-0', 'notime-0-1', 'notime-1-0',
+            'notime-1-1', 'notime-2-0', 'notime-2-1'])
+        self.assertEqual(packets[6:9], ['time-2-1', 'time-1-1', 'time-0-1'])
+        self.assertEqual(len(packets), 15)
+        self.assertEqual(read_pcapng_packets(batched_file), packets)
+
     def test_mergecap_3_pcapng_all_pcapng(self, cmd_mergecap, capture_file):
         '''Merge multiple pcapng files to pcapng in "none" mode, then merge that to "all" mode.'''
         # build a pcapng of all the interfaces repeated by using mode 'none'
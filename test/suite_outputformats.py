@@ -93,3 +93,123 @@ class case_outputformats(subprocesstest.SubprocessTestCase):
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True)
+
+    def test_outputformat_arrow(self, cmd_tshark, capture_file):
+        '''Checks that -Tarrow writes the -e fields as an Arrow IPC stream.'''
+        arrow_file = self.filename_from_id('dhcp.arrows')
+        self.assertRun('"{}" -r "{}" -T arrow -e frame.number -e ip.src -e _ws.col.Protocol > "{}"'.format(
+            cmd_tshark, capture_file('dhcp.pcap'), arrow_file), shell=True)
+        with open(arrow_file, 'rb') as f:
+            data = f.read()
+        # A continuation marker before the schema, and the end of stream marker.
+        self.assertEqual(data[:4], b'\xff\xff\xff\xff')
+        self.assertEqual(data[-8:], b'\xff\xff\xff\xff\x00\x00\x00\x00')
+        try:
+            import pyarrow.ipc
+        except ImportError:
+            return
+        table = pyarrow.ipc.open_stream(arrow_file).read_all()
+        self.assertEqual(table.column('frame.number').to_pylist(), [1, 2, 3, 4])
+        self.assertEqual(table.column('ip.src').to_pylist(), [0, 0xc0a80001, 0, 0xc0a80001])
+        self.assertEqual(table.column('_ws.col.Protocol').to_pylist(), ['DHCP'] * 4)
+
+    def test_outputformat_arrow_occurrence(self, cmd_tshark, capture_file):
+        '''Checks -Tarrow with -E occurrence and fields given more than once.'''
+        try:
+            import pyarrow.ipc
+        except ImportError:
+            self.skipTest('Requires pyarrow.')
+        fields = '-e dhcp.option.type -e frame.number -e dhcp.option.type -e _ws.col.Protocol -e _ws.col.Protocol'
+        # Two columns with the same title
+        columns = '-o \'gui.column.format:"Protocol","%p","Protocol","%p"\''
+        for occurrence, option_types, protocols in (
+                ('f', [53, 53, 53, 53], ['DHCP'] * 4),
+                ('l', [0, 0, 0, 0], ['DHCP'] * 4),
+                ('2', [61, 1, 61, 58], ['DHCP'] * 4),
+                ('6', [None, 54, 0, 1], [None] * 4)):
+            arrow_file = self.filename_from_id('dhcp-{}.arrows'.format(occurrence))
+            self.assertRun('"{}" -r "{}" -T arrow -E occurrence={} {} {} > "{}"'.format(
+                cmd_tshark, capture_file('dhcp.pcap'), occurrence, columns, fields, arrow_file),
+                shell=True)
+            table = pyarrow.ipc.open_stream(arrow_file).read_all()
+            self.assertEqual(table.column_names, [
+                'dhcp.option.type', 'frame.number', 'dhcp.option.type',
+                '_ws.col.Protocol', '_ws.col.Protocol'])
+            self.assertEqual(table.column(0).to_pylist(), option_types)
+            self.assertEqual(table.column(1).to_pylist(), [1, 2, 3, 4])
+            self.assertEqual(table.column(2).to_pylist(), option_types)
+            self.assertEqual(table.column(3).to_pylist(), protocols)
+            self.assertEqual(table.column(4).to_pylist(), protocols)
+
+    def test_outputformat_fields_numbered_occurrence(self, cmd_tshark, capture_file):
+        '''Checks that -Tfields -Eoccurrence=<number> gets that occurrence.'''
+        tshark_proc = self.assertRun([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+            '-T', 'fields', '-E', 'occurrence=6', '-e', 'frame.number', '-e', 'dhcp.option.type'])
+        self.assertEqual(tshark_proc.stdout_str.splitlines(), [
+            '1\t', '2\t54', '3\t0', '4\t1',
+        ])
+        self.assertRun([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+            '-T', 'fields', '-E', 'occurrence=0', '-e', 'frame.number'],
+            expected_return=1)
+
+    def test_outputformat_field_sink_same_as_tree(self, cmd_tshark, capture_file, base_env):
+        '''Checks that the field sink gets the values the protocol tree has, in the same order.'''
+        # Fields found more than once in a packet, and names shared by several fields.
+        fields = ['-e', 'frame.number', '-e', 'ip.proto', '-e', 'udp.port', '-e', 'tcp.port',
+                  '-e', 'dhcp.option.type', '-e', 'dhcp.option.value.uint', '-e', 'dhcp.option.end',
+                  '-e', 'dns.qry.class', '-e', 'dns.resp.class', '-e', 'dns.flags.authenticated',
+                  '-e', 'dns.rr.udp_payload_size']
+        tree_env = dict(base_env)
+        tree_env['WIRESHARK_NO_FIELD_SINK'] = '1'
+        for pcap_file in ('dhcp.pcap', 'dns+icmp.pcapng.gz', 'http.pcap'):
+            for occurrence in ('a', 'f', 'l', '2'):
+                args = [cmd_tshark, '-r', capture_file(pcap_file), '-T', 'fields',
+                        '-E', 'occurrence=' + occurrence] + fields
+                sink_proc = self.assertRun(args)
+                tree_proc = self.assertRun(args, env=tree_env)
+                self.assertEqual(sink_proc.stdout_str, tree_proc.stdout_str)
+
+                arrow_files = []
+                for env in (base_env, tree_env):
+                    arrow_files.append(self.filename_from_id('{}-{}-{}.arrows'.format(
+                        pcap_file, occurrence, len(arrow_files))))
+                    self.assertRun('"{}" -r "{}" -T arrow -E occurrence={} {} > "{}"'.format(
+                        cmd_tshark, capture_file(pcap_file), occurrence, ' '.join(fields),
+                        arrow_files[-1]), shell=True, env=env)
+                with open(arrow_files[0], 'rb') as sink_file, open(arrow_files[1], 'rb') as tree_file:
+                    self.assertEqual(sink_file.read(), tree_file.read())
+
+    def test_outputformat_arrow_last_occurrence(self, cmd_tshark, capture_file, base_env):
+        '''Checks that -Tarrow -Eoccurrence=l gets the last occurrence in the packet.'''
+        try:
+            import pyarrow.ipc
+        except ImportError:
+            self.skipTest('Requires pyarrow.')
+        tree_env = dict(base_env)
+        tree_env['WIRESHARK_NO_FIELD_SINK'] = '1'
+        for env in (base_env, tree_env):
+            for occurrence, ports in (('f', [68, 67, 68, 67]), ('l', [67, 68, 67, 68])):
+                arrow_file = self.filename_from_id('dhcp-ports-{}.arrows'.format(occurrence))
+                # The source port, then the destination port
+                self.assertRun('"{}" -r "{}" -T arrow -E occurrence={} -e udp.port > "{}"'.format(
+                    cmd_tshark, capture_file('dhcp.pcap'), occurrence, arrow_file),
+                    shell=True, env=env)
+                table = pyarrow.ipc.open_stream(arrow_file).read_all()
+                self.assertEqual(table.column('udp.port').to_pylist(), ports)
+
+    def test_outputformat_fields_text(self, cmd_tshark, capture_file):
+        '''Checks that -e text gets the labels of text items.'''
+        tshark_proc = self.assertRun([cmd_tshark, '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-Y', 'dns', '-T', 'fields', '-e', 'text'])
+        self.assertIn('Queries', tshark_proc.stdout_str)
+
+    def test_outputformat_fields_all_occurrences(self, cmd_tshark, capture_file):
+        '''Checks that -Tfields gets every occurrence of a field, in order.'''
+        tshark_proc = self.assertRun([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+            '-T', 'fields', '-e', 'frame.number', '-e', 'dhcp.option.type'])
+        self.assertEqual(tshark_proc.stdout_str.splitlines(), [
+            '1\t53,61,50,55,0',
+            '2\t53,1,58,59,51,54,0',
+            '3\t53,61,50,54,55,0',
+            '4\t53,58,59,51,54,1,0',
+        ])
@@ -19,14 +19,36 @@ import fixtures
 
 @fixtures.uses_fixtures
 class case_unittests(subprocesstest.SubprocessTestCase):
+    def test_unit_buffer_test(self, program, base_env):
+        '''buffer_test'''
+        self.assertRun(program('buffer_test'), env=base_env)
+
+    def test_unit_dump_test(self, program, base_env):
+        '''dump_test'''
+        self.assertRun(program('dump_test'), env=base_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         self.assertRun(program('exntest'), env=base_env)
 
+    def test_unit_field_cache_test(self, program, capture_file, base_env):
+        '''field_cache_test'''
+        self.assertRun((program('field_cache_test'),
+            capture_file('dns+icmp.pcapng.gz')
+        ), env=base_env)
+
+    def test_unit_memmem_test(self, program, base_env):
+        '''memmem_test'''
+        self.assertRun(program('memmem_test'), env=base_env)
+
     def test_unit_oids_test(self, program, base_env):
         '''oids_test'''
         self.assertRun(program('oids_test'), env=base_env)
 
+    def test_unit_read_test(self, program, base_env):
+        '''read_test'''
+        self.assertRun(program('read_test'), env=base_env)
+
     def test_unit_reassemble_test(self, program, base_env):
         '''reassemble_test'''
         self.assertRun(program('reassemble_test'), env=base_env)
@@ -26,10 +26,16 @@
 
 #ifdef _WIN32
 # include <winsock2.h>
+# include <io.h>     /* for _setmode */
+# include <fcntl.h>  /* for O_BINARY */
 #endif
 
 #ifndef _WIN32
 #include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #ifndef HAVE_GETOPT_LONG
@@ -94,6 +100,9 @@
 #include <epan/ex-opt.h>
 #include <epan/exported_pdu.h>
 #include <epan/secrets.h>
+#include <epan/etypes.h>
+#include <wsutil/pint.h>
+#include <wsutil/tempfile.h>
 
 #include "capture_opts.h"
 
@@ -138,6 +147,12 @@
 #define LONGOPT_COLOR                   LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_NO_DUPLICATE_KEYS       LONGOPT_BASE_APPLICATION+3
 #define LONGOPT_ELASTIC_MAPPING_FILTER  LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_THREADS                 LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_PRUNE_PROTOCOLS         LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_READ_AHEAD              LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_INFLATE_THREADS         LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_WRITE_GZIP_INDEX        LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_COMPRESS                LONGOPT_BASE_APPLICATION+10
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -156,6 +171,17 @@ static gboolean perform_two_pass_analysis;
 static guint32 epan_auto_reset_count = 0;
 static gboolean epan_auto_reset = FALSE;
 
+/*
+ * --threads: the number of worker processes the packets are dissected
+ * in, and, in a worker, which one it is and the pipe it sends its
+ * output to the parent on.
+ */
+static guint shard_count = 1;
+#ifndef _WIN32
+static guint shard_index = 0;
+static int shard_pipe = -1;
+#endif
+
 /*
  * The way the packet decode is to be written.
  */
@@ -166,7 +192,8 @@ typedef enum {
   WRITE_FIELDS,   /* User defined list of fields */
   WRITE_JSON,     /* JSON */
   WRITE_JSON_RAW, /* JSON only raw hex */
-  WRITE_EK        /* JSON bulk insert to Elasticsearch */
+  WRITE_EK,       /* JSON bulk insert to Elasticsearch */
+  WRITE_ARROW     /* User defined list of fields, as an Arrow IPC stream */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -181,11 +208,14 @@ static gboolean quiet = FALSE;
 static gboolean really_quiet = FALSE;
 static gchar* delimiter_char = " ";
 static gboolean dissect_color = FALSE;
+static gboolean prune_unused_protocols = FALSE;
+static gboolean use_field_sink = FALSE;
 
 static print_format_e print_format = PR_FMT_TEXT;
 static print_stream_t *print_stream = NULL;
 
 static char *output_file_name;
+static wtap_compression_type out_compression_type = WTAP_UNCOMPRESSED;
 
 static output_fields_t* output_fields  = NULL;
 static gchar **protocolfilter = NULL;
@@ -253,6 +283,12 @@ static process_file_status_t process_cap_file(capture_file *, char *, int, gbool
 static gboolean process_packet_single_pass(capture_file *cf,
     epan_dissect_t *edt, gint64 offset, wtap_rec *rec, Buffer *buf,
     guint tap_flags);
+#ifndef _WIN32
+static guint shard_of_record(const wtap_rec *rec, const guint8 *pd);
+static void skip_packet_single_pass(capture_file *cf, gint64 offset,
+    wtap_rec *rec);
+static void shard_send_output(guint32 framenum);
+#endif
 static void show_print_file_io_error(int err);
 static gboolean write_preamble(capture_file *cf);
 static gboolean print_packet(capture_file *cf, epan_dissect_t *edt);
@@ -307,6 +343,18 @@ list_capture_types(void) {
   g_free(captypes);
 }
 
+static void
+list_compression_types(void) {
+  GSList *names, *name;
+
+  fprintf(stderr, "tshark: The available types of compression for the \"--compress\" flag are:\n");
+  fprintf(stderr, "    none\n");
+  names = wtap_get_all_compression_type_names_list();
+  for (name = names; name != NULL; name = g_slist_next(name))
+    fprintf(stderr, "    %s\n", (const char *)name->data);
+  g_slist_free(names);
+}
+
 static void
 list_read_capture_types(void) {
   int                 i;
@@ -388,6 +436,12 @@ print_usage(FILE *output)
   fprintf(output, "Input file:\n");
   fprintf(output, "  -r <infile>, --read-file <infile>\n");
   fprintf(output, "                           set the filename to read from (or '-' for stdin)\n");
+  fprintf(output, "  --read-ahead <MB>        read up to <MB> megabytes ahead of the input file\n");
+  fprintf(output, "                           in a separate thread (def: 0, off)\n");
+  fprintf(output, "  --inflate-threads <n>    decompress a gzipped input file that has a\n");
+  fprintf(output, "                           \"<infile>.gzidx\" index in <n> threads (def: 0, off)\n");
+  fprintf(output, "  --write-gzip-index       write a \"<infile>.gzidx\" index of a gzipped input\n");
+  fprintf(output, "                           file once it's been read\n");
 
   fprintf(output, "\n");
   fprintf(output, "Processing:\n");
@@ -414,6 +468,10 @@ print_usage(FILE *output)
   fprintf(output, "                           enable dissection of heuristic protocol\n");
   fprintf(output, "  --disable-heuristic <short_name>\n");
   fprintf(output, "                           disable dissection of heuristic protocol\n");
+  fprintf(output, "  --threads <n>            dissect the packets of a capture file in <n> worker\n");
+  fprintf(output, "                           processes, split by IP address pair\n");
+  fprintf(output, "  --prune-protocols        only dissect the protocols needed for the filters\n");
+  fprintf(output, "                           and the -e fields when -Tfields is selected\n");
 
   /*fprintf(output, "\n");*/
   fprintf(output, "Output:\n");
@@ -421,6 +479,9 @@ print_usage(FILE *output)
   fprintf(output, "                           (or '-' for stdout)\n");
   fprintf(output, "  --capture-comment <comment>\n");
   fprintf(output, "                           set the capture file comment, if supported\n");
+  fprintf(output, "  --compress <type>        compress the file written when reading a capture file\n");
+  fprintf(output, "                           with gzip, zstd or lz4; an empty \"--compress\"\n");
+  fprintf(output, "                           option will list the types\n");
   fprintf(output, "  -C <config profile>      start with specified configuration profile\n");
   fprintf(output, "  -F <output file type>    set the output file type, default is pcapng\n");
   fprintf(output, "                           an empty \"-F\" option will list the file types\n");
@@ -430,7 +491,7 @@ print_usage(FILE *output)
   fprintf(output, "  -P, --print              print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|arrow|?\n");
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
@@ -444,7 +505,8 @@ print_usage(FILE *output)
   fprintf(output, "     bom=y|n               print a UTF-8 BOM\n");
   fprintf(output, "     header=y|n            switch headers on and off\n");
   fprintf(output, "     separator=/t|/s|<char> select tab, space, printable character as separator\n");
-  fprintf(output, "     occurrence=f|l|a      print first, last or all occurrences of each field\n");
+  fprintf(output, "     occurrence=f|l|a|<n>  print first, last, all or the n-th occurrence of\n");
+  fprintf(output, "                           each field\n");
   fprintf(output, "     aggregator=,|/s|<char> select comma, space, printable character as\n");
   fprintf(output, "                           aggregator\n");
   fprintf(output, "     quote=d|s|n           select double, single, no quotes for values\n");
@@ -694,6 +756,120 @@ must_do_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
       tap_listeners_require_dissection() || dissect_color;
 }
 
+/*
+ * Stop dissecting protocols that nothing we output depends on.
+ *
+ * That's only possible if we know which fields we use: the read and
+ * display filters and, if we're printing, the -e fields.  Columns,
+ * packet details, hex dumps, coloring and taps can depend on any
+ * protocol.
+ */
+static gboolean
+prune_protocols_for_output(dfilter_t *rfcode, dfilter_t *dfcode)
+{
+  GArray   *hfids;
+  gboolean  pruned;
+
+  if (print_packet_info &&
+      ((output_action != WRITE_FIELDS && output_action != WRITE_ARROW) ||
+       print_summary || print_hex ||
+       output_fields_has_cols(output_fields)))
+    return FALSE;
+
+  if (tap_listeners_require_dissection() || dissect_color)
+    return FALSE;
+
+  hfids = g_array_new(FALSE, FALSE, sizeof(int));
+  if (rfcode)
+    dfilter_get_interesting_fields(rfcode, hfids);
+  if (dfcode)
+    dfilter_get_interesting_fields(dfcode, hfids);
+  if (print_packet_info)
+    output_fields_get_hfids(output_fields, hfids);
+
+  pruned = prune_protocols(hfids);
+  g_array_free(hfids, TRUE);
+
+  return pruned;
+}
+
+/*
+ * Can the -e fields be collected by a field sink, without building the
+ * protocol tree?
+ *
+ * Only if the fields are all we print from the dissection, no tap
+ * needs the tree (it might walk it, and the sink doesn't keep the
+ * hierarchy), and no field needs the text of its item.
+ *
+ * WIRESHARK_NO_FIELD_SINK turns the sink off, so that the values it
+ * collects can be compared with those from the tree.
+ */
+static gboolean
+fields_from_field_sink(void)
+{
+  if (getenv("WIRESHARK_NO_FIELD_SINK") != NULL)
+    return FALSE;
+
+  if (!print_packet_info ||
+      (output_action != WRITE_FIELDS && output_action != WRITE_ARROW) ||
+      print_summary)
+    return FALSE;
+
+  if (union_of_tap_listener_flags() & TL_REQUIRES_PROTO_TREE)
+    return FALSE;
+
+  return output_fields_use_field_sink(output_fields);
+}
+
+/*
+ * Check whether we can do what we've been asked to do with --threads.
+ * Each worker prints the packets it dissects and the output is put back
+ * in frame order, so that only works for output that's written packet
+ * by packet, and every worker has to be able to open the capture file
+ * itself.
+ */
+static gboolean
+check_threads_options(const char *cf_name)
+{
+#ifdef _WIN32
+  (void)cf_name;
+  cmdarg_err("--threads isn't supported on Windows.");
+  return FALSE;
+#else
+  ws_statb64 statb;
+
+  if (cf_name == NULL) {
+    cmdarg_err("--threads can only be used when reading a capture file.");
+    return FALSE;
+  }
+  if (strcmp(cf_name, "-") == 0 ||
+      (ws_stat64(cf_name, &statb) == 0 && !S_ISREG(statb.st_mode))) {
+    cmdarg_err("--threads can't be used when reading from a pipe.");
+    return FALSE;
+  }
+  if (perform_two_pass_analysis) {
+    cmdarg_err("--threads can't be used with -2.");
+    return FALSE;
+  }
+  if (output_file_name != NULL) {
+    cmdarg_err("--threads can't be used with -w.");
+    return FALSE;
+  }
+  switch (output_action) {
+
+  case WRITE_TEXT:
+  case WRITE_XML:
+  case WRITE_FIELDS:
+    break;
+
+  default:
+    cmdarg_err("--threads can only be used with -T text, tabs, ps, pdml, psml or fields.");
+    return FALSE;
+  }
+  return TRUE;
+#endif
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -709,6 +885,12 @@ main(int argc, char *argv[])
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
     {"elastic-mapping-filter", required_argument, NULL, LONGOPT_ELASTIC_MAPPING_FILTER},
+    {"threads", required_argument, NULL, LONGOPT_THREADS},
+    {"prune-protocols", no_argument, NULL, LONGOPT_PRUNE_PROTOCOLS},
+    {"read-ahead", required_argument, NULL, LONGOPT_READ_AHEAD},
+    {"inflate-threads", required_argument, NULL, LONGOPT_INFLATE_THREADS},
+    {"write-gzip-index", no_argument, NULL, LONGOPT_WRITE_GZIP_INDEX},
+    {"compress", required_argument, NULL, LONGOPT_COMPRESS},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
@@ -1351,11 +1533,17 @@ main(int argc, char *argv[])
         output_action = WRITE_JSON_RAW;
         print_details = TRUE;   /* Need details */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "arrow") == 0) {
+        output_action = WRITE_ARROW;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
       }
       else {
         cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", optarg);                   /* x */
         cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                         "\t          specified by the -E option.\n"
+                        "\t\"arrow\"   The values of fields specified with the -e option, as typed\n"
+                        "\t          columns of an Apache Arrow IPC stream.\n"
                         "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                         "\t          details of a decoded packet. This information is equivalent to\n"
                         "\t          the packet details printed with the -V flag.\n"
@@ -1480,12 +1668,39 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_PRUNE_PROTOCOLS:
+      prune_unused_protocols = TRUE;
+      break;
+    case LONGOPT_READ_AHEAD:
+      wtap_set_read_ahead(get_guint32(optarg, "read-ahead size"));
+      break;
+    case LONGOPT_INFLATE_THREADS:
+      wtap_set_inflate_threads(get_guint32(optarg, "number of inflate threads"));
+      break;
+    case LONGOPT_WRITE_GZIP_INDEX:
+      wtap_set_write_gzip_index(TRUE);
+      break;
+    case LONGOPT_COMPRESS:
+      out_compression_type = wtap_name_to_compression_type(optarg);
+      if (out_compression_type == WTAP_UNKNOWN_COMPRESSION) {
+        cmdarg_err("\"%s\" isn't a valid type of compression", optarg);
+        list_compression_types();
+        exit_status = INVALID_OPTION;
+        goto clean_exit;
+      }
+      break;
+    case LONGOPT_THREADS:
+      shard_count = get_positive_int(optarg, "number of threads");
+      break;
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
       case 'F':
         list_capture_types();
         break;
+      case LONGOPT_COMPRESS:
+        list_compression_types();
+        break;
       default:
         print_usage(stderr);
       }
@@ -1515,14 +1730,15 @@ main(int argc, char *argv[])
   }
 
   /* If we specified output fields, but not the output field type... */
-  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+  if ((WRITE_FIELDS != output_action && WRITE_ARROW != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
+            "but \"-Tarrow, -Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
         goto clean_exit;
-  } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                    "specified with \"-e\".");
+  } else if ((WRITE_FIELDS == output_action || WRITE_ARROW == output_action) && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                    "specified with \"-e\".",
+                    WRITE_ARROW == output_action ? "arrow" : "fields");
 
         exit_status = INVALID_OPTION;
         goto clean_exit;
@@ -1641,6 +1857,11 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+  if (shard_count > 1 && !check_threads_options(cf_name)) {
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+
 #ifdef HAVE_LIBPCAP
   if (caps_queries) {
     /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -1817,6 +2038,26 @@ main(int argc, char *argv[])
   }
 #endif
 
+  if (out_compression_type != WTAP_UNCOMPRESSED) {
+    /* Only files written by TShark itself, not by dumpcap, are compressed. */
+    if (!cf_name) {
+      cmdarg_err("Compression was requested, but a capture file isn't being read.");
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+    }
+    if (!output_file_name) {
+      cmdarg_err("Compression was requested, but the packets aren't being saved to a file.");
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+    }
+    if (!wtap_dump_can_compress(out_file_type)) {
+      cmdarg_err("%s files can't be written compressed.",
+                 wtap_file_type_subtype_string(out_file_type));
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+    }
+  }
+
   err_msg = ws_init_sockets();
   if (err_msg != NULL)
   {
@@ -2057,11 +2298,27 @@ main(int argc, char *argv[])
        filter. */
     start_requested_stats();
 
+    /* The workers' tap results would have to be merged, which taps
+       have no way to do. */
+    if (shard_count > 1 && tap_listeners_require_dissection()) {
+      cmdarg_err("--threads can't be used with statistics, -U or --export-objects.");
+      epan_cleanup();
+      extcap_cleanup();
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+    }
+
     /* Do we need to do dissection of packets?  That depends on, among
        other things, what taps are listening, so determine that after
        starting the statistics taps. */
     do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
 
+    if (do_dissection && prune_unused_protocols &&
+        !prune_protocols_for_output(rfcode, dfcode) && !really_quiet)
+      cmdarg_err("Not pruning any protocols; the output depends on more than the filters and fields.");
+
+    use_field_sink = do_dissection && fields_from_field_sink();
+
     /* Process the packets in the file */
     tshark_debug("tshark: invoking process_cap_file() to process the packets");
     TRY {
@@ -2243,6 +2500,12 @@ main(int argc, char *argv[])
        starting the statistics taps. */
     do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
 
+    if (do_dissection && prune_unused_protocols &&
+        !prune_protocols_for_output(rfcode, dfcode) && !really_quiet)
+      cmdarg_err("Not pruning any protocols; the output depends on more than the filters and fields.");
+
+    use_field_sink = do_dissection && fields_from_field_sink();
+
     /*
      * XXX - this returns FALSE if an error occurred, but it also
      * returns FALSE if the capture stops because a time limit
@@ -2765,8 +3028,12 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
     /* The protocol tree will be "visible", i.e., printed, only if we're
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
-       ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+       ("packet_details" is true), and we're not just collecting the
+       -e fields in a field sink. */
+    edt = epan_dissect_new(cf->epan, create_proto_tree,
+                           print_packet_info && print_details && !use_field_sink);
+    if (use_field_sink)
+      epan_dissect_field_sink(edt, TRUE);
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
@@ -2884,13 +3151,21 @@ capture_input_drops(capture_session *cap_session _U_, guint32 dropped, const cha
  * do the required cleanup.
  */
 static void
-capture_input_closed(capture_session *cap_session _U_, gchar *msg)
+capture_input_closed(capture_session *cap_session, gchar *msg)
 {
   if (msg != NULL)
     fprintf(stderr, "tshark: %s\n", msg);
 
   report_counts();
 
+  /* dumpcap only queues packets, and reports how many it had queued at
+     most, when capturing from more than one interface. */
+  if (cap_session->queue_max_packets != 0 && !really_quiet) {
+    fprintf(stderr, "Packet queue high-water mark: %" G_GINT64_MODIFIER "u packet%s, %" G_GINT64_MODIFIER "u bytes\n",
+            cap_session->queue_max_packets, plurality(cap_session->queue_max_packets, "", "s"),
+            cap_session->queue_max_bytes);
+  }
+
 #ifdef USE_BROKEN_G_MAIN_LOOP
   /*g_main_loop_quit(loop);*/
   g_main_loop_quit(loop);
@@ -3190,6 +3465,9 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    if (use_field_sink)
+      output_fields_prime_edt(output_fields, edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3329,8 +3607,12 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     /* The protocol tree will be "visible", i.e., printed, only if we're
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
-       ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+       ("packet_details" is true), and we're not just collecting the
+       -e fields in a field sink. */
+    edt = epan_dissect_new(cf->epan, create_proto_tree,
+                           print_packet_info && print_details && !use_field_sink);
+    if (use_field_sink)
+      epan_dissect_field_sink(edt, TRUE);
   }
 
   /*
@@ -3436,8 +3718,12 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     /* The protocol tree will be "visible", i.e., printed, only if we're
        printing packet details, which is true if we're printing stuff
        ("print_packet_info" is true) and we're in verbose mode
-       ("packet_details" is true). */
-    edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+       ("packet_details" is true), and we're not just collecting the
+       -e fields in a field sink. */
+    edt = epan_dissect_new(cf->epan, create_proto_tree,
+                           print_packet_info && print_details && !use_field_sink);
+    if (use_field_sink)
+      epan_dissect_field_sink(edt, TRUE);
   }
 
   /*
@@ -3468,6 +3754,13 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
     reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
 
+#ifndef _WIN32
+    if (shard_count > 1 &&
+        shard_of_record(&rec, ws_buffer_start_ptr(&buf)) != shard_index) {
+      /* Another --threads worker dissects this packet. */
+      skip_packet_single_pass(cf, data_offset, &rec);
+    } else
+#endif
     if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
       /* Either there's no read filtering or this packet passed the
          filter, so, if we're writing to a capture file, write
@@ -3483,6 +3776,10 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         }
       }
     }
+#ifndef _WIN32
+    if (shard_count > 1)
+      shard_send_output(framenum);
+#endif
     /* Stop reading if we have the maximum number of packets;
      * When the -c option has not been used, max_packet_count
      * starts at 0, which practically means, never stop reading.
@@ -3509,6 +3806,567 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
   return status;
 }
 
+#ifndef _WIN32
+/*
+ * --threads runs the dissection in worker processes rather than
+ * threads; the dissectors keep their state between packets in
+ * process-wide variables, so separate processes are the only way to
+ * give each worker a dissection state of its own.
+ *
+ * Every worker reads the whole file, so that frame numbers, time
+ * references and -c work as they do without --threads, but only
+ * dissects the packets of its own share of the IP address pairs.
+ * It sends the output for each packet it dissects to the parent,
+ * which writes the output of all the workers in frame order.
+ */
+
+/* Send a progress record at least this often, in frames. */
+#define SHARD_PROGRESS_INTERVAL 4096
+
+/* Stop reading from a worker with this much output queued. */
+#define SHARD_QUEUE_LIMIT       (16*1024*1024)
+
+/* The pipe buffer size to ask for, where that can be set. */
+#define SHARD_PIPE_SIZE         (1024*1024)
+
+/*
+ * What a worker sends on its pipe: the output for a frame, with a
+ * framenum of the frame and a len of the length of the output
+ * following it, or, at the end, a framenum of 0 followed by a
+ * shard_trailer_t and the error information string.  Output with a
+ * len of 0 tells the parent how far the worker has got.
+ */
+typedef struct {
+  guint32 framenum;
+  guint32 len;
+} shard_record_t;
+
+typedef struct {
+  gint32  status;       /* pass_status_t of the worker's pass */
+  gint32  err;
+  guint32 err_framenum;
+  guint32 count;        /* number of records read */
+} shard_trailer_t;
+
+typedef struct {
+  int         fd;
+  pid_t       pid;
+  GByteArray *in;       /* what's been read from the worker */
+  guint       in_pos;   /* where the next record starts in it */
+  guint32     done;     /* all the frames up to here have been handled */
+  gboolean    eof;
+  gboolean    finished; /* the trailer has been received */
+  shard_trailer_t trailer;
+  gchar      *err_info;
+} shard_worker_t;
+
+/*
+ * Pick the worker that dissects a packet.  Packets are shared out by
+ * their IP address pair, in either direction, so that both directions
+ * of a connection, IP fragments, and the data connections an FTP or
+ * SIP session between two hosts sets up are all dissected by the same
+ * worker.  Everything that isn't IP over Ethernet, Linux cooked
+ * capture or raw IP goes to the first worker.
+ */
+static guint
+shard_of_record(const wtap_rec *rec, const guint8 *pd)
+{
+  guint32        caplen;
+  guint          offset;
+  guint16        ethertype;
+  const guint8  *lo, *hi, *tmp;
+  size_t         addr_len, i;
+  guint32        hash;
+
+  if (rec->rec_type != REC_TYPE_PACKET)
+    return 0;
+  caplen = rec->rec_header.packet_header.caplen;
+
+  switch (rec->rec_header.packet_header.pkt_encap) {
+
+  case WTAP_ENCAP_ETHERNET:
+    if (caplen < 14)
+      return 0;
+    ethertype = pntoh16(pd + 12);
+    offset = 14;
+    while ((ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_IEEE_802_1AD ||
+            ethertype == ETHERTYPE_QINQ_OLD) && caplen >= offset + 4) {
+      ethertype = pntoh16(pd + offset + 2);
+      offset += 4;
+    }
+    break;
+
+  case WTAP_ENCAP_SLL:
+    if (caplen < 16)
+      return 0;
+    ethertype = pntoh16(pd + 14);
+    offset = 16;
+    break;
+
+  case WTAP_ENCAP_RAW_IP:
+  case WTAP_ENCAP_RAW_IP4:
+  case WTAP_ENCAP_RAW_IP6:
+    if (caplen < 1)
+      return 0;
+    ethertype = (pd[0] >> 4) == 6 ? ETHERTYPE_IPv6 : ETHERTYPE_IP;
+    offset = 0;
+    break;
+
+  default:
+    return 0;
+  }
+
+  switch (ethertype) {
+
+  case ETHERTYPE_IP:
+    if (caplen < offset + 20 || (pd[offset] >> 4) != 4)
+      return 0;
+    lo = pd + offset + 12;
+    hi = pd + offset + 16;
+    addr_len = 4;
+    break;
+
+  case ETHERTYPE_IPv6:
+    if (caplen < offset + 40 || (pd[offset] >> 4) != 6)
+      return 0;
+    lo = pd + offset + 8;
+    hi = pd + offset + 24;
+    addr_len = 16;
+    break;
+
+  default:
+    return 0;
+  }
+
+  if (memcmp(lo, hi, addr_len) > 0) {
+    tmp = lo;
+    lo = hi;
+    hi = tmp;
+  }
+  /* FNV-1a over the lower address and then the higher one. */
+  hash = 2166136261U;
+  for (i = 0; i < addr_len; i++)
+    hash = (hash ^ lo[i]) * 16777619U;
+  for (i = 0; i < addr_len; i++)
+    hash = (hash ^ hi[i]) * 16777619U;
+  return hash % shard_count;
+}
+
+static void
+shard_write(const void *data, size_t len)
+{
+  const guint8 *p = (const guint8 *)data;
+  ssize_t       written;
+
+  while (len != 0) {
+    written = ws_write(shard_pipe, p, len);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      /* The parent has gone away; there's nobody left to report to. */
+      _exit(2);
+    }
+    p += written;
+    len -= written;
+  }
+}
+
+/*
+ * Send what's been printed for a frame to the parent, and start again
+ * with an empty standard output for the next frame.
+ */
+static void
+shard_send_output(guint32 framenum)
+{
+  ws_statb64     statb;
+  shard_record_t hdr;
+  guint8         chunk[65536];
+  off_t          pos;
+  ssize_t        nread;
+
+  fflush(stdout);
+  if (ws_fstat64(1, &statb) != 0) {
+    show_print_file_io_error(errno);
+    _exit(2);
+  }
+  if (statb.st_size == 0 && framenum % SHARD_PROGRESS_INTERVAL != 0)
+    return;
+  if (statb.st_size > G_MAXUINT32) {
+    cmdarg_err("The output for frame %u is too large for --threads.", framenum);
+    _exit(2);
+  }
+
+  hdr.framenum = framenum;
+  hdr.len = (guint32)statb.st_size;
+  shard_write(&hdr, sizeof hdr);
+  for (pos = 0; pos < statb.st_size; pos += nread) {
+    nread = pread(1, chunk, MIN(sizeof chunk, (size_t)(statb.st_size - pos)), pos);
+    if (nread <= 0) {
+      if (nread < 0 && errno == EINTR) {
+        nread = 0;
+        continue;
+      }
+      show_print_file_io_error(nread < 0 ? errno : EIO);
+      _exit(2);
+    }
+    shard_write(chunk, nread);
+  }
+
+  rewind(stdout);
+  if (ftruncate(1, 0) != 0) {
+    show_print_file_io_error(errno);
+    _exit(2);
+  }
+}
+
+/*
+ * Account for a packet that another worker dissects, so that frame
+ * numbers, the time reference, and relative and delta times stay the
+ * same as if this worker had dissected every packet.
+ */
+static void
+skip_packet_single_pass(capture_file *cf, gint64 offset, wtap_rec *rec)
+{
+  frame_data fdata;
+
+  cf->count++;
+  frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+  frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+                                &cf->provider.ref, cf->provider.prev_dis);
+  if (cf->provider.ref == &fdata) {
+    ref_frame = fdata;
+    cf->provider.ref = &ref_frame;
+  }
+
+  /* With a display filter we can't tell whether the packet would have
+     been displayed, so it's counted as not displayed. */
+  if (cf->dfcode == NULL) {
+    frame_data_set_after_dissect(&fdata, &cum_bytes);
+    prev_dis_frame = fdata;
+    cf->provider.prev_dis = &prev_dis_frame;
+  }
+
+  prev_cap_frame = fdata;
+  cf->provider.prev_cap = &prev_cap_frame;
+}
+
+/*
+ * The body of a worker process; it doesn't return.
+ */
+static void
+shard_worker(capture_file *cf, guint worker_index, int pipe_fd,
+             int max_packet_count, gint64 max_byte_count)
+{
+  int              tmp_fd;
+  char            *tmp_name;
+  GError          *gerr = NULL;
+  int              err = 0;
+  gchar           *err_info = NULL;
+  guint32          err_framenum = 0;
+  pass_status_t    status;
+  shard_record_t   hdr;
+  shard_trailer_t  trailer;
+  size_t           err_info_len;
+
+  shard_index = worker_index;
+  shard_pipe = pipe_fd;
+
+  /* Every worker reads the whole file; only one of them writes its
+     gzip index. */
+  if (worker_index != 0)
+    wtap_set_write_gzip_index(FALSE);
+
+  /* Print into a temporary file, which shard_send_output() empties
+     after every frame. */
+  tmp_fd = create_tempfile(&tmp_name, "tshark_threads_", NULL, &gerr);
+  if (tmp_fd == -1) {
+    cmdarg_err("Couldn't create a temporary file for --threads: %s",
+               gerr->message);
+    _exit(2);
+  }
+  ws_unlink(tmp_name);
+  g_free(tmp_name);
+  if (dup2(tmp_fd, 1) == -1) {
+    cmdarg_err("Couldn't redirect the standard output for --threads: %s",
+               g_strerror(errno));
+    _exit(2);
+  }
+  ws_close(tmp_fd);
+  rewind(stdout);
+
+  /* The parent closed its handle for the file before forking, as the
+     workers would otherwise share its file offset; open our own. */
+  cf->provider.wth = wtap_open_offline(cf->filename, cf->open_type, &err,
+                                       &err_info, FALSE);
+  if (cf->provider.wth != NULL) {
+    wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
+    wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+    wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+    status = process_cap_file_single_pass(cf, NULL, max_packet_count,
+                                          max_byte_count, &err, &err_info,
+                                          &err_framenum);
+  } else {
+    status = PASS_READ_ERROR;
+  }
+
+  err_info_len = err_info != NULL ? strlen(err_info) : 0;
+  hdr.framenum = 0;
+  hdr.len = (guint32)(sizeof trailer + err_info_len);
+  trailer.status = status;
+  trailer.err = err;
+  trailer.err_framenum = err_framenum;
+  trailer.count = cf->count;
+  shard_write(&hdr, sizeof hdr);
+  shard_write(&trailer, sizeof trailer);
+  if (err_info_len != 0)
+    shard_write(err_info, err_info_len);
+  _exit(0);
+}
+
+/*
+ * Handle the records at the front of what's been read from a worker
+ * until there's output for a frame at the front, or nothing complete.
+ * Returns TRUE, with the header of the output in *hdr, if there's
+ * output at the front.
+ */
+static gboolean
+shard_next_output(shard_worker_t *worker, shard_record_t *hdr_out)
+{
+  shard_record_t hdr;
+  guint          avail;
+
+  for (;;) {
+    avail = worker->in->len - worker->in_pos;
+    if (avail < sizeof hdr)
+      return FALSE;
+    memcpy(&hdr, worker->in->data + worker->in_pos, sizeof hdr);
+    if (avail - sizeof hdr < hdr.len)
+      return FALSE;
+    if (hdr.framenum != 0 && hdr.len != 0) {
+      *hdr_out = hdr;
+      return TRUE;
+    }
+
+    if (hdr.framenum == 0) {
+      if (hdr.len >= sizeof worker->trailer) {
+        memcpy(&worker->trailer, worker->in->data + worker->in_pos + sizeof hdr,
+               sizeof worker->trailer);
+        if (hdr.len > sizeof worker->trailer)
+          worker->err_info = g_strndup((const gchar *)worker->in->data + worker->in_pos + sizeof hdr + sizeof worker->trailer,
+                                       hdr.len - sizeof worker->trailer);
+        worker->finished = TRUE;
+      }
+    } else {
+      worker->done = hdr.framenum;
+    }
+    worker->in_pos += (guint)sizeof hdr + hdr.len;
+  }
+}
+
+/*
+ * Write out, in frame order, all the output we've got from the workers
+ * that no worker can still have earlier output for.
+ */
+static void
+shard_write_ready_output(shard_worker_t *workers)
+{
+  shard_record_t hdr, first = { 0, 0 };
+  guint          i, first_i;
+  gboolean       have_first;
+
+  for (;;) {
+    have_first = FALSE;
+    first_i = 0;
+    for (i = 0; i < shard_count; i++) {
+      if (shard_next_output(&workers[i], &hdr) &&
+          (!have_first || hdr.framenum < first.framenum)) {
+        first = hdr;
+        first_i = i;
+        have_first = TRUE;
+      }
+    }
+    if (!have_first)
+      return;
+
+    /* A worker with nothing queued may still have output for an
+       earlier frame, unless it's finished or got past this one. */
+    for (i = 0; i < shard_count; i++) {
+      if (i != first_i && !shard_next_output(&workers[i], &hdr) &&
+          !workers[i].finished && !workers[i].eof &&
+          workers[i].done < first.framenum)
+        return;
+    }
+
+    fwrite(workers[first_i].in->data + workers[first_i].in_pos + sizeof first,
+           1, first.len, stdout);
+    if (line_buffered)
+      fflush(stdout);
+    if (ferror(stdout)) {
+      show_print_file_io_error(errno);
+      exit(2);
+    }
+    workers[first_i].done = first.framenum;
+    workers[first_i].in_pos += (guint)sizeof first + first.len;
+    if (workers[first_i].in_pos > workers[first_i].in->len / 2) {
+      g_byte_array_remove_range(workers[first_i].in, 0, workers[first_i].in_pos);
+      workers[first_i].in_pos = 0;
+    }
+  }
+}
+
+static pass_status_t
+process_cap_file_sharded(capture_file *cf, int max_packet_count,
+                         gint64 max_byte_count, int *err, gchar **err_info,
+                         volatile guint32 *err_framenum)
+{
+  shard_worker_t *workers;
+  shard_record_t  hdr;
+  struct pollfd  *pfds;
+  guint          *pfd_worker;
+  guint           i, j, npfds;
+  int             fds[2];
+  int             wstatus;
+  guint           old_len;
+  ssize_t         nread;
+  pass_status_t   status;
+
+  workers = g_new0(shard_worker_t, shard_count);
+  pfds = g_new(struct pollfd, shard_count);
+  pfd_worker = g_new(guint, shard_count);
+
+  /* Don't have the workers inherit unwritten output, or a handle for
+     the file that shares its offset with ours. */
+  fflush(stdout);
+  fflush(stderr);
+  wtap_close(cf->provider.wth);
+  cf->provider.wth = NULL;
+
+  *err = 0;
+  *err_info = NULL;
+  for (i = 0; i < shard_count; i++) {
+    workers[i].fd = -1;
+    workers[i].pid = -1;
+    workers[i].in = g_byte_array_new();
+    if (pipe(fds) == -1) {
+      *err = WTAP_ERR_INTERNAL;
+      *err_info = g_strdup_printf("couldn't create a pipe for a --threads worker: %s",
+                                  g_strerror(errno));
+      break;
+    }
+#ifdef F_SETPIPE_SZ
+    fcntl(fds[1], F_SETPIPE_SZ, SHARD_PIPE_SIZE);
+#endif
+    workers[i].pid = fork();
+    if (workers[i].pid == 0) {
+      for (j = 0; j < i; j++)
+        ws_close(workers[j].fd);
+      ws_close(fds[0]);
+      shard_worker(cf, i, fds[1], max_packet_count, max_byte_count);
+    }
+    ws_close(fds[1]);
+    workers[i].fd = fds[0];
+    if (workers[i].pid == -1) {
+      *err = WTAP_ERR_INTERNAL;
+      *err_info = g_strdup_printf("couldn't start a --threads worker: %s",
+                                  g_strerror(errno));
+      break;
+    }
+  }
+  if (*err != 0) {
+    /* Stop the workers we did start; their output is of no use. */
+    for (j = 0; j < shard_count; j++) {
+      if (workers[j].pid > 0)
+        kill(workers[j].pid, SIGTERM);
+    }
+  }
+
+  for (;;) {
+    npfds = 0;
+    for (i = 0; i < shard_count; i++) {
+      if (workers[i].fd == -1 || workers[i].eof)
+        continue;
+      /* Leave a worker that's got far ahead of the others blocked on its
+         pipe, rather than queueing up all of its output. */
+      if (workers[i].in->len - workers[i].in_pos >= SHARD_QUEUE_LIMIT &&
+          shard_next_output(&workers[i], &hdr))
+        continue;
+      pfds[npfds].fd = workers[i].fd;
+      pfds[npfds].events = POLLIN;
+      pfd_worker[npfds] = i;
+      npfds++;
+    }
+    if (npfds == 0)
+      break;
+
+    if (poll(pfds, npfds, -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      if (*err == 0) {
+        *err = WTAP_ERR_INTERNAL;
+        *err_info = g_strdup_printf("couldn't wait for the --threads workers: %s",
+                                    g_strerror(errno));
+      }
+      break;
+    }
+    for (j = 0; j < npfds; j++) {
+      if (pfds[j].revents == 0)
+        continue;
+      i = pfd_worker[j];
+      old_len = workers[i].in->len;
+      g_byte_array_set_size(workers[i].in, old_len + 65536);
+      nread = ws_read(workers[i].fd, workers[i].in->data + old_len, 65536);
+      g_byte_array_set_size(workers[i].in, old_len + (nread > 0 ? (guint)nread : 0));
+      if (nread == 0 || (nread < 0 && errno != EINTR))
+        workers[i].eof = TRUE;
+    }
+    shard_write_ready_output(workers);
+  }
+  shard_write_ready_output(workers);
+
+  for (i = 0; i < shard_count; i++) {
+    if (workers[i].fd != -1)
+      ws_close(workers[i].fd);
+    if (workers[i].pid <= 0)
+      continue;
+    while (waitpid(workers[i].pid, &wstatus, 0) == -1 && errno == EINTR)
+      ;
+    if (*err == 0 && !workers[i].finished) {
+      *err = WTAP_ERR_INTERNAL;
+      if (WIFSIGNALED(wstatus))
+        *err_info = g_strdup_printf("--threads worker %u was killed by signal %d",
+                                    i, WTERMSIG(wstatus));
+      else
+        *err_info = g_strdup_printf("--threads worker %u exited with status %d",
+                                    i, WEXITSTATUS(wstatus));
+    }
+  }
+
+  /* Every worker read the whole file, so they all got the same read
+     error, if any; report the first worker's. */
+  status = PASS_SUCCEEDED;
+  if (*err == 0) {
+    status = (pass_status_t)workers[0].trailer.status;
+    *err = workers[0].trailer.err;
+    *err_info = workers[0].err_info;
+    workers[0].err_info = NULL;
+    *err_framenum = workers[0].trailer.err_framenum;
+    cf->count = workers[0].trailer.count;
+  }
+  if (*err != 0 && status == PASS_SUCCEEDED)
+    status = PASS_READ_ERROR;
+
+  for (i = 0; i < shard_count; i++) {
+    g_byte_array_free(workers[i].in, TRUE);
+    g_free(workers[i].err_info);
+  }
+  g_free(pfd_worker);
+  g_free(pfds);
+  g_free(workers);
+
+  return status;
+}
+#endif /* _WIN32 */
+
 static process_file_status_t
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count)
@@ -3538,10 +4396,10 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     tshark_debug("tshark: writing format type %d, to %s", out_file_type, save_file);
     if (strcmp(save_file, "-") == 0) {
       /* Write to the standard output. */
-      pdh = wtap_dump_open_stdout(out_file_type, WTAP_UNCOMPRESSED, &params,
+      pdh = wtap_dump_open_stdout(out_file_type, out_compression_type, &params,
                                   &err, &err_info);
     } else {
-      pdh = wtap_dump_open(save_file, out_file_type, WTAP_UNCOMPRESSED, &params,
+      pdh = wtap_dump_open(save_file, out_file_type, out_compression_type, &params,
                            &err, &err_info);
     }
 
@@ -3624,6 +4482,14 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
     tshark_debug("tshark: perform one pass analysis, do_dissection=%s", do_dissection ? "TRUE" : "FALSE");
 
     first_pass_status = PASS_SUCCEEDED; /* There is no first pass */
+#ifndef _WIN32
+    if (shard_count > 1)
+      second_pass_status = process_cap_file_sharded(cf, max_packet_count,
+                                                    max_byte_count,
+                                                    &err, &err_info,
+                                                    &err_framenum);
+    else
+#endif
     second_pass_status = process_cap_file_single_pass(cf, pdh,
                                                       max_packet_count,
                                                       max_byte_count,
@@ -3747,7 +4613,9 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
   }
 
 out:
-  wtap_close(cf->provider.wth);
+  /* With --threads, the workers had the file open, not us. */
+  if (cf->provider.wth != NULL)
+    wtap_close(cf->provider.wth);
   cf->provider.wth = NULL;
 
   wtap_dump_params_cleanup(&params);
@@ -3790,6 +4658,9 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
 
     col_custom_prime_edt(edt, &cf->cinfo);
 
+    if (use_field_sink)
+      output_fields_prime_edt(output_fields, edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3879,6 +4750,15 @@ write_preamble(capture_file *cf)
     write_fields_preamble(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_ARROW:
+#ifdef _WIN32
+    /* The stream is binary. */
+    if (_setmode(1, O_BINARY) == -1)
+      return FALSE;
+#endif
+    write_arrow_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     jdumper = write_json_preamble(stdout);
@@ -4232,6 +5112,10 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
     }
     break;
 
+  case WRITE_ARROW:
+    write_arrow_proto_tree(output_fields, edt, &cf->cinfo);
+    return !ferror(stdout);
+
   case WRITE_JSON:
     if (print_summary)
       g_assert_not_reached();
@@ -4295,6 +5179,10 @@ write_finale(void)
     write_fields_finale(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_ARROW:
+    write_arrow_finale(output_fields);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     write_json_finale(&jdumper);
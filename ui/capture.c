@@ -704,6 +704,10 @@ capture_input_closed(capture_session *cap_session, gchar *msg)
     int  err;
 
     g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_MESSAGE, "Capture stopped.");
+    if (cap_session->queue_max_packets != 0)
+        g_log(LOG_DOMAIN_CAPTURE, G_LOG_LEVEL_MESSAGE,
+              "Packet queue high-water mark: %" G_GINT64_MODIFIER "u packets, %" G_GINT64_MODIFIER "u bytes.",
+              cap_session->queue_max_packets, cap_session->queue_max_bytes);
     g_assert(cap_session->state == CAPTURE_PREPARING || cap_session->state == CAPTURE_RUNNING);
 
     if (msg != NULL)
@@ -610,7 +610,7 @@ int CaptureFileDialog::selectedFileType() {
 }
 
 wtap_compression_type CaptureFileDialog::compressionType() {
-    return compress_.isChecked() ? WTAP_GZIP_COMPRESSED : WTAP_UNCOMPRESSED;
+    return (wtap_compression_type) compress_.currentData().toInt();
 }
 
 void CaptureFileDialog::addDisplayFilterEdit() {
@@ -645,17 +645,24 @@ void CaptureFileDialog::addFormatTypeSelector(QVBoxLayout &v_box) {
     v_box.addWidget(&format_type_, 0, Qt::AlignTop);
 }
 
-void CaptureFileDialog::addGzipControls(QVBoxLayout &v_box) {
-    compress_.setText(tr("Compress with g&zip"));
-    if (cap_file_->compression_type == WTAP_GZIP_COMPRESSED &&
-        wtap_dump_can_compress(default_ft_)) {
-        compress_.setChecked(true);
-    } else {
-        compress_.setChecked(false);
+void CaptureFileDialog::addCompressionControls(QVBoxLayout &v_box) {
+    compress_.addItem(tr("Don't compress"), WTAP_UNCOMPRESSED);
+    GSList *compression_type_names = wtap_get_all_compression_type_names_list();
+    for (GSList *compression_type_name = compression_type_names;
+        compression_type_name != NULL;
+        compression_type_name = g_slist_next(compression_type_name)) {
+        const char *name = (const char *)compression_type_name->data;
+        compress_.addItem(tr("Compress with %1").arg(name), wtap_name_to_compression_type(name));
     }
-    v_box.addWidget(&compress_, 0, Qt::AlignTop);
-    connect(&compress_, &QCheckBox::stateChanged, this, &CaptureFileDialog::fixFilenameExtension);
+    g_slist_free(compression_type_names);
 
+    int index = 0;
+    if (wtap_dump_can_compress(default_ft_)) {
+        index = compress_.findData(cap_file_->compression_type);
+    }
+    compress_.setCurrentIndex(index < 0 ? 0 : index);
+    v_box.addWidget(&compress_, 0, Qt::AlignTop);
+    connect(&compress_, SIGNAL(currentIndexChanged(int)), this, SLOT(fixFilenameExtension()));
 }
 
 void CaptureFileDialog::addRangeControls(QVBoxLayout &v_box, packet_range_t *range, QString selRange) {
@@ -717,7 +724,7 @@ check_savability_t CaptureFileDialog::saveAs(QString &file_name, bool must_suppo
     setAcceptMode(QFileDialog::AcceptSave);
     setLabelText(FileType, tr("Save as:"));
 
-    addGzipControls(left_v_box_);
+    addCompressionControls(left_v_box_);
     addHelpButton(HELP_SAVE_DIALOG);
 
     // Grow the dialog to account for the extra widgets.
@@ -745,7 +752,7 @@ check_savability_t CaptureFileDialog::exportSelectedPackets(QString &file_name,
     setLabelText(FileType, tr("Export as:"));
 
     addRangeControls(left_v_box_, range, selRange);
-    addGzipControls(right_v_box_);
+    addCompressionControls(right_v_box_);
     button_box = addHelpButton(HELP_EXPORT_FILE_DIALOG);
 
     if (button_box) {
@@ -103,7 +103,7 @@ private:
     QHash<QString, int> type_hash_;
     QHash<QString, QStringList> type_suffixes_;
 
-    void addGzipControls(QVBoxLayout &v_box);
+    void addCompressionControls(QVBoxLayout &v_box);
     void addRangeControls(QVBoxLayout &v_box, packet_range_t *range, QString selRange = QString());
     QDialogButtonBox *addHelpButton(topic_action_e help_topic);
 
@@ -111,7 +111,7 @@ private:
 
     int default_ft_;
 
-    QCheckBox compress_;
+    QComboBox compress_;
 
     PacketRangeGroupBox packet_range_group_box_;
     QPushButton *save_bt_;
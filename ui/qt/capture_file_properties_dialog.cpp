@@ -523,6 +523,40 @@ QString CaptureFilePropertiesDialog::summaryToHtml()
 
     out << table_end;
 
+    // Display filter field cache
+    if (summary.field_cache_known) {
+        const field_cache_stats_t *fcs = &summary.field_cache;
+        guint64 lookups = fcs->hits + fcs->misses;
+
+        out << section_tmpl_.arg(tr("Display Filter Field Cache"));
+        out << table_begin;
+
+        out << table_row_begin
+            << table_vheader_tmpl.arg(tr("Fields"))
+            << table_data_tmpl.arg(fcs->num_fields)
+            << table_row_end;
+
+        out << table_row_begin
+            << table_vheader_tmpl.arg(tr("Memory"))
+            << table_data_tmpl.arg(tr("%1 of %2")
+                                   .arg(file_size_to_qstring(fcs->size))
+                                   .arg(file_size_to_qstring(fcs->budget)))
+            << table_row_end;
+
+        QString hits_str = n_a;
+        if (lookups > 0) {
+            hits_str = QString("%1 of %2 (%3%)").arg(fcs->hits).arg(lookups).arg(QString::number(
+                /* MSVC cannot convert from unsigned __int64 to float, so first convert to signed __int64 */
+                (100.0 * (gint64)fcs->hits) / (gint64)lookups, 'f', 1));
+        }
+        out << table_row_begin
+            << table_vheader_tmpl.arg(tr("Frames filtered from the cache"))
+            << table_data_tmpl.arg(hits_str)
+            << table_row_end;
+
+        out << table_end;
+    }
+
     return summary_str;
 }
 
@@ -165,6 +165,10 @@ summary_fill_in(capture_file *cf, summary_tally *st)
   st->drops_known = cf->drops_known;
   st->drops = cf->drops;
   st->dfilter = cf->dfilter;
+  st->field_cache_known = cf->field_cache != NULL;
+  if (st->field_cache_known) {
+    field_cache_get_stats(cf->field_cache, &st->field_cache);
+  }
 
   st->ifaces  = g_array_new(FALSE, FALSE, sizeof(iface_summary_info));
   idb_info = wtap_file_get_idb_info(cf->provider.wth);
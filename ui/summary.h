@@ -11,6 +11,8 @@
 #ifndef __SUMMARY_H__
 #define __SUMMARY_H__
 
+#include <epan/dfilter/field-cache.h>
+
 #ifdef HAVE_LIBPCAP
 #include "ui/capture.h"
 #endif
@@ -65,6 +67,8 @@ typedef struct _summary_tally {
   gboolean              drops_known;        /**< TRUE if number of packet drops is known */
   guint64               drops;              /**< number of packet drops */
   const char           *dfilter;            /**< display filter */
+  gboolean              field_cache_known;  /**< TRUE if the display filter field cache is in use */
+  field_cache_stats_t   field_cache;        /**< display filter field cache statistics */
   gboolean              is_tempfile;
   /* capture related, use summary_fill_in_capture() to get values */
   GArray               *ifaces;
@@ -0,0 +1,265 @@
+/* dump_test.c
+ * Checks that what's written to a dump file, through the buffer that
+ * collects small writes, is what the file format says it should be
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <wsutil/file_util.h>
+
+#include <wiretap/wtap.h>
+
+#define SNAPLEN		262144
+
+/*
+ * Records smaller than the buffer, ones that fill it exactly once their
+ * header is in it, and ones bigger than it, in an order that leaves it
+ * partly full at every kind of record.
+ */
+static const guint record_lens[] = {
+	1, 60, 1514, 65536 - 16, 65536 - 16 - 24, 14, 65536, 70000, 3,
+	200000, 9000, 131072 - 16, 0, 64, 65535, 42,
+};
+
+static void
+append_guint32(GByteArray *bytes, guint32 val)
+{
+	g_byte_array_append(bytes, (const guint8 *)&val, sizeof val);
+}
+
+static void
+append_guint16(GByteArray *bytes, guint16 val)
+{
+	g_byte_array_append(bytes, (const guint8 *)&val, sizeof val);
+}
+
+/* The file libpcap.c writes, built independently of it. */
+static void
+append_pcap_header(GByteArray *bytes)
+{
+	append_guint32(bytes, 0xa1b2c3d4);
+	append_guint16(bytes, 2);
+	append_guint16(bytes, 4);
+	append_guint32(bytes, 0);
+	append_guint32(bytes, 0);
+	append_guint32(bytes, SNAPLEN);
+	append_guint32(bytes, 1);	/* LINKTYPE_ETHERNET */
+}
+
+static void
+append_pcap_record(GByteArray *bytes, guint num, const guint8 *data, guint len)
+{
+	append_guint32(bytes, 1600000000 + num);
+	append_guint32(bytes, num);
+	append_guint32(bytes, len);
+	append_guint32(bytes, len);
+	g_byte_array_append(bytes, data, len);
+}
+
+/* Reads what's in the file so far, decompressing it. */
+static GByteArray *
+read_file(const char *filename, wtap_compression_type compression_type,
+		guint max_len)
+{
+	GByteArray	*bytes = g_byte_array_new();
+	gchar		*contents;
+	gsize		len;
+
+	switch (compression_type) {
+
+	case WTAP_UNCOMPRESSED:
+		g_assert_true(g_file_get_contents(filename, &contents, &len, NULL));
+		g_byte_array_append(bytes, (const guint8 *)contents, (guint)len);
+		g_free(contents);
+		break;
+
+#ifdef HAVE_ZLIB
+	case WTAP_GZIP_COMPRESSED:
+	{
+		gzFile	gz;
+		int	nread;
+
+		/* One more than expected, to catch anything extra. */
+		g_byte_array_set_size(bytes, max_len + 1);
+		gz = gzopen(filename, "rb");
+		g_assert_nonnull(gz);
+		len = 0;
+		while (len < max_len + 1 &&
+		    (nread = gzread(gz, bytes->data + len, (unsigned)(max_len + 1 - len))) > 0)
+			len += nread;
+		gzclose(gz);
+		g_byte_array_set_size(bytes, (guint)len);
+		break;
+	}
+#endif
+
+	default:
+		g_assert_not_reached();
+	}
+	return bytes;
+}
+
+static void
+check_file(const char *filename, wtap_compression_type compression_type,
+		const GByteArray *expected)
+{
+	GByteArray	*bytes;
+	guint		i;
+
+	bytes = read_file(filename, compression_type, expected->len);
+	if (bytes->len != expected->len) {
+		g_test_message("%s: %u bytes, expected %u", filename,
+				bytes->len, expected->len);
+	}
+	g_assert_cmpuint(bytes->len, ==, expected->len);
+	for (i = 0; i < bytes->len; i++) {
+		if (bytes->data[i] != expected->data[i]) {
+			g_test_message("%s: byte %u differs", filename, i);
+			break;
+		}
+	}
+	g_assert_cmpuint(i, ==, bytes->len);
+	g_byte_array_free(bytes, TRUE);
+}
+
+/*
+ * Writes the records to a file, flushing it after every flush_every
+ * records if that's not 0 and checking that everything written so far
+ * is in the file, then closes it and checks all of it.
+ */
+static void
+check_dump(wtap_compression_type compression_type, guint flush_every)
+{
+	gchar		*filename;
+	int		fd;
+	wtap_dump_params params;
+	wtap_dumper	*pdh;
+	wtap_rec	rec;
+	GByteArray	*expected;
+	guint8		*data;
+	guint		i, j;
+	int		err;
+	gchar		*err_info;
+
+	fd = g_file_open_tmp("dump_test_XXXXXX.pcap", &filename, NULL);
+	g_assert_true(fd != -1);
+	ws_close(fd);
+
+	wtap_dump_params_init(&params, NULL);
+	params.encap = WTAP_ENCAP_ETHERNET;
+	params.snaplen = SNAPLEN;
+	params.tsprec = WTAP_TSPREC_USEC;
+	pdh = wtap_dump_open(filename, WTAP_FILE_TYPE_SUBTYPE_PCAP,
+			compression_type, &params, &err, &err_info);
+	g_assert_nonnull(pdh);
+
+	expected = g_byte_array_new();
+	append_pcap_header(expected);
+
+	data = (guint8 *)g_malloc(SNAPLEN);
+	wtap_rec_init(&rec);
+	for (i = 0; i < G_N_ELEMENTS(record_lens); i++) {
+		for (j = 0; j < record_lens[i]; j++)
+			data[j] = (guint8)(i * 31 + j);
+
+		rec.rec_type = REC_TYPE_PACKET;
+		rec.presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
+		rec.ts.secs = 1600000000 + i;
+		rec.ts.nsecs = i * 1000;
+		rec.rec_header.packet_header.caplen = record_lens[i];
+		rec.rec_header.packet_header.len = record_lens[i];
+		rec.rec_header.packet_header.pkt_encap = WTAP_ENCAP_ETHERNET;
+		rec.rec_header.packet_header.pseudo_header.eth.fcs_len = -1;
+		g_assert_true(wtap_dump(pdh, &rec, data, &err, &err_info));
+		append_pcap_record(expected, i, data, record_lens[i]);
+
+		if (flush_every != 0 && (i + 1) % flush_every == 0) {
+			g_assert_true(wtap_dump_flush(pdh, &err));
+			check_file(filename, compression_type, expected);
+		}
+	}
+	wtap_rec_cleanup(&rec);
+	g_free(data);
+
+	g_assert_true(wtap_dump_close(pdh, &err, &err_info));
+	check_file(filename, compression_type, expected);
+
+	g_byte_array_free(expected, TRUE);
+	ws_unlink(filename);
+	g_free(filename);
+}
+
+static void
+dump_test_uncompressed(void)
+{
+	check_dump(WTAP_UNCOMPRESSED, 0);
+}
+
+static void
+dump_test_uncompressed_flush(void)
+{
+	check_dump(WTAP_UNCOMPRESSED, 1);
+	check_dump(WTAP_UNCOMPRESSED, 3);
+}
+
+#ifdef HAVE_ZLIB
+static void
+dump_test_gzip(void)
+{
+	check_dump(WTAP_GZIP_COMPRESSED, 0);
+}
+
+static void
+dump_test_gzip_flush(void)
+{
+	check_dump(WTAP_GZIP_COMPRESSED, 1);
+	check_dump(WTAP_GZIP_COMPRESSED, 3);
+}
+#endif
+
+int
+main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+	wtap_init(FALSE);
+
+	g_test_add_func("/wtap_dump/uncompressed",		dump_test_uncompressed);
+	g_test_add_func("/wtap_dump/uncompressed_flush",	dump_test_uncompressed_flush);
+#ifdef HAVE_ZLIB
+	g_test_add_func("/wtap_dump/gzip",			dump_test_gzip);
+	g_test_add_func("/wtap_dump/gzip_flush",		dump_test_gzip_flush);
+#endif
+
+	ret = g_test_run();
+	wtap_cleanup();
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
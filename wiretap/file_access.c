@@ -891,11 +891,28 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 	 */
 	wth->next_interface_data = 0;
 
-	if (wth->random_fh) {
+	/*
+	 * Keep fast seek points for random access, and, for a file that
+	 * might be gzipped, to be able to read them from or write them to
+	 * its gzip index.
+	 */
+	if (wth->random_fh || (!ispipe && file_gzip_index_wanted(filename))) {
 		wth->fast_seek = g_ptr_array_new();
 
 		file_set_random_access(wth->fh, FALSE, wth->fast_seek);
-		file_set_random_access(wth->random_fh, TRUE, wth->fast_seek);
+		if (wth->random_fh)
+			file_set_random_access(wth->random_fh, TRUE, wth->fast_seek);
+		if (!ispipe && !file_read_gzip_index(wth->fh, filename) &&
+		    !wth->random_fh && !file_gzip_index_to_write()) {
+			/*
+			 * The index couldn't be used after all, and no
+			 * index will be written; don't collect points
+			 * that nothing would use.
+			 */
+			file_set_random_access(wth->fh, FALSE, NULL);
+			g_ptr_array_free(wth->fast_seek, TRUE);
+			wth->fast_seek = NULL;
+		}
 	}
 
 	/* 'type' is 1 greater than the array index */
@@ -2241,7 +2258,7 @@ wtap_dump_can_open(int file_type_subtype)
 	return TRUE;
 }
 
-#ifdef HAVE_ZLIB
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
 gboolean
 wtap_dump_can_compress(int file_type_subtype)
 {
@@ -2289,7 +2306,8 @@ wtap_dump_supports_comment_types(int file_type_subtype, guint32 comment_types)
 	return FALSE;
 }
 
-static gboolean wtap_dump_open_check(int file_type_subtype, int encap, gboolean compressed, int *err);
+static gboolean wtap_dump_open_check(int file_type_subtype, int encap,
+				     wtap_compression_type compression_type, int *err);
 static wtap_dumper* wtap_dump_alloc_wdh(int file_type_subtype, int encap, int snaplen,
 					wtap_compression_type compression_type,
 					int *err);
@@ -2299,6 +2317,7 @@ static gboolean wtap_dump_open_finish(wtap_dumper *wdh, int file_type_subtype,
 static WFILE_T wtap_dump_file_open(wtap_dumper *wdh, const char *filename);
 static WFILE_T wtap_dump_file_fdopen(wtap_dumper *wdh, int fd);
 static int wtap_dump_file_close(wtap_dumper *wdh);
+static gboolean wtap_dump_file_write_buf(wtap_dumper *wdh, int *err);
 
 static wtap_dumper *
 wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_type,
@@ -2312,9 +2331,9 @@ wtap_dump_init_dumper(int file_type_subtype, wtap_compression_type compression_t
 	/* Check whether we can open a capture file with that file type
 	   and that encapsulation, and, if the compression type isn't
 	   "uncompressed", whether we can write a *compressed* file
-	   of that file type. */
+	   of that file type with that compression. */
 	if (!wtap_dump_open_check(file_type_subtype, params->encap,
-	    (compression_type != WTAP_UNCOMPRESSED), err))
+	    compression_type, err))
 		return NULL;
 
 	/* Allocate a data structure for the output stream. */
@@ -2597,7 +2616,8 @@ wtap_dump_open_stdout(int file_type_subtype, wtap_compression_type compression_t
 }
 
 static gboolean
-wtap_dump_open_check(int file_type_subtype, int encap, gboolean compressed, int *err)
+wtap_dump_open_check(int file_type_subtype, int encap,
+    wtap_compression_type compression_type, int *err)
 {
 	if (!wtap_dump_can_open(file_type_subtype)) {
 		/* Invalid type, or type we don't know how to write. */
@@ -2620,8 +2640,11 @@ wtap_dump_open_check(int file_type_subtype, int encap, gboolean compressed, int
 	if (*err != 0)
 		return FALSE;
 
-	/* if compression is wanted, do we support this for this file_type_subtype? */
-	if(compressed && !wtap_dump_can_compress(file_type_subtype)) {
+	/* if compression is wanted, do we support it, and do we support
+	   it for this file_type_subtype? */
+	if (compression_type != WTAP_UNCOMPRESSED &&
+	    (wtap_compression_type_description(compression_type) == NULL ||
+	     !wtap_dump_can_compress(file_type_subtype))) {
 		*err = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
 		return FALSE;
 	}
@@ -2721,6 +2744,8 @@ wtap_dump(wtap_dumper *wdh, const wtap_rec *rec,
 gboolean
 wtap_dump_flush(wtap_dumper *wdh, int *err)
 {
+	if (!wtap_dump_file_write_buf(wdh, err))
+		return FALSE;
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
 		if (gzwfile_flush((GZWFILE_T)wdh->fh) == -1) {
@@ -2728,6 +2753,15 @@ wtap_dump_flush(wtap_dumper *wdh, int *err)
 			return FALSE;
 		}
 	} else
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED ||
+	    wdh->compression_type == WTAP_LZ4_COMPRESSED) {
+		if (framewfile_flush((FRAMEWFILE_T)wdh->fh) == -1) {
+			*err = framewfile_geterr((FRAMEWFILE_T)wdh->fh);
+			return FALSE;
+		}
+	} else
 #endif
 	{
 		if (fflush((FILE *)wdh->fh) == EOF) {
@@ -2831,46 +2865,46 @@ gboolean wtap_dump_get_needs_reload(wtap_dumper *wdh) {
 }
 
 /* internally open a file for writing (compressed or not) */
-#ifdef HAVE_ZLIB
 static WFILE_T
 wtap_dump_file_open(wtap_dumper *wdh, const char *filename)
 {
-	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+	switch (wdh->compression_type) {
+#ifdef HAVE_ZLIB
+	case WTAP_GZIP_COMPRESSED:
 		return gzwfile_open(filename);
-	} else {
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+	case WTAP_ZSTD_COMPRESSED:
+	case WTAP_LZ4_COMPRESSED:
+		return framewfile_open(filename, wdh->compression_type);
+#endif
+	default:
 		return ws_fopen(filename, "wb");
 	}
 }
-#else
-static WFILE_T
-wtap_dump_file_open(wtap_dumper *wdh _U_, const char *filename)
-{
-	return ws_fopen(filename, "wb");
-}
-#endif
 
 /* internally open a file for writing (compressed or not) */
-#ifdef HAVE_ZLIB
 static WFILE_T
 wtap_dump_file_fdopen(wtap_dumper *wdh, int fd)
 {
-	if (wdh->compression_type == WTAP_GZIP_COMPRESSED) {
+	switch (wdh->compression_type) {
+#ifdef HAVE_ZLIB
+	case WTAP_GZIP_COMPRESSED:
 		return gzwfile_fdopen(fd);
-	} else {
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+	case WTAP_ZSTD_COMPRESSED:
+	case WTAP_LZ4_COMPRESSED:
+		return framewfile_fdopen(fd, wdh->compression_type);
+#endif
+	default:
 		return ws_fdopen(fd, "wb");
 	}
 }
-#else
-static WFILE_T
-wtap_dump_file_fdopen(wtap_dumper *wdh _U_, int fd)
-{
-	return ws_fdopen(fd, "wb");
-}
-#endif
 
-/* internally writing raw bytes (compressed or not) */
-gboolean
-wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
+/* internally writing raw bytes (compressed or not), bypassing the buffer */
+static gboolean
+wtap_dump_file_write_raw(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
 {
 	size_t nwritten;
 
@@ -2885,6 +2919,19 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 			return FALSE;
 		}
 	} else
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED ||
+	    wdh->compression_type == WTAP_LZ4_COMPRESSED) {
+		nwritten = framewfile_write((FRAMEWFILE_T)wdh->fh, buf, (unsigned int) bufsize);
+		/*
+		 * framewfile_write() returns 0 on error.
+		 */
+		if (nwritten == 0) {
+			*err = framewfile_geterr((FRAMEWFILE_T)wdh->fh);
+			return FALSE;
+		}
+	} else
 #endif
 	{
 		errno = WTAP_ERR_CANT_WRITE;
@@ -2904,28 +2951,88 @@ wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err
 	return TRUE;
 }
 
+/* write out whatever is in the buffer */
+static gboolean
+wtap_dump_file_write_buf(wtap_dumper *wdh, int *err)
+{
+	size_t len = wdh->write_buf_len;
+
+	if (len == 0)
+		return TRUE;
+	wdh->write_buf_len = 0;
+	return wtap_dump_file_write_raw(wdh, wdh->write_buf, len, err);
+}
+
+/* internally writing raw bytes (compressed or not) */
+gboolean
+wtap_dump_file_write(wtap_dumper *wdh, const void *buf, size_t bufsize, int *err)
+{
+	if (wdh->write_buf == NULL)
+		wdh->write_buf = (guint8 *)g_malloc(WTAP_DUMP_WRITE_BUF_SIZE);
+
+	if (bufsize <= WTAP_DUMP_WRITE_BUF_SIZE - wdh->write_buf_len) {
+		memcpy(wdh->write_buf + wdh->write_buf_len, buf, bufsize);
+		wdh->write_buf_len += bufsize;
+		return TRUE;
+	}
+
+	/*
+	 * It doesn't fit; write out what we have, and then either
+	 * start a new buffer with this or, if it's at least as big
+	 * as the buffer, write it out directly.
+	 */
+	if (!wtap_dump_file_write_buf(wdh, err))
+		return FALSE;
+	if (bufsize >= WTAP_DUMP_WRITE_BUF_SIZE)
+		return wtap_dump_file_write_raw(wdh, buf, bufsize, err);
+	memcpy(wdh->write_buf, buf, bufsize);
+	wdh->write_buf_len = bufsize;
+	return TRUE;
+}
+
 /* internally close a file for writing (compressed or not) */
 static int
 wtap_dump_file_close(wtap_dumper *wdh)
 {
+	gboolean flushed;
+	int err = 0;
+	int ret;
+
+	flushed = wtap_dump_file_write_buf(wdh, &err);
+	g_free(wdh->write_buf);
+	wdh->write_buf = NULL;
+
 #ifdef HAVE_ZLIB
 	if (wdh->compression_type == WTAP_GZIP_COMPRESSED)
-		return gzwfile_close((GZWFILE_T)wdh->fh);
+		ret = gzwfile_close((GZWFILE_T)wdh->fh);
 	else
 #endif
-		return fclose((FILE *)wdh->fh);
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+	if (wdh->compression_type == WTAP_ZSTD_COMPRESSED ||
+	    wdh->compression_type == WTAP_LZ4_COMPRESSED)
+		ret = framewfile_close((FRAMEWFILE_T)wdh->fh);
+	else
+#endif
+		ret = fclose((FILE *)wdh->fh);
+
+	if (!flushed) {
+		/* Report the error from writing out the buffer. */
+		errno = err;
+		return EOF;
+	}
+	return ret;
 }
 
 gint64
 wtap_dump_file_seek(wtap_dumper *wdh, gint64 offset, int whence, int *err)
 {
-#ifdef HAVE_ZLIB
 	if (wdh->compression_type != WTAP_UNCOMPRESSED) {
 		*err = WTAP_ERR_CANT_SEEK_COMPRESSED;
 		return -1;
 	} else
-#endif
 	{
+		if (!wtap_dump_file_write_buf(wdh, err))
+			return -1;
 		if (-1 == ws_fseek64((FILE *)wdh->fh, offset, whence)) {
 			*err = errno;
 			return -1;
@@ -2940,19 +3047,18 @@ gint64
 wtap_dump_file_tell(wtap_dumper *wdh, int *err)
 {
 	gint64 rval;
-#ifdef HAVE_ZLIB
 	if (wdh->compression_type != WTAP_UNCOMPRESSED) {
 		*err = WTAP_ERR_CANT_SEEK_COMPRESSED;
 		return -1;
 	} else
-#endif
 	{
 		if (-1 == (rval = ws_ftell64((FILE *)wdh->fh))) {
 			*err = errno;
 			return -1;
 		} else
 		{
-			return rval;
+			/* What's still in our buffer comes after that. */
+			return rval + (gint64)wdh->write_buf_len;
 		}
 	}
 }
@@ -22,11 +22,23 @@
 #include "file_wrappers.h"
 #include <wsutil/file_util.h>
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif /* HAVE_MMAP */
+
 #ifdef HAVE_ZLIB
 #define ZLIB_CONST
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+#include <lz4frame.h>
+#endif /* HAVE_LZ4FRAME_H */
+
 /*
  * See RFC 1952:
  *
@@ -34,6 +46,18 @@
  *
  * for a description of the gzip file format.
  *
+ * See
+ *
+ *      https://github.com/facebook/zstd/blob/dev/doc/zstd_compression_format.md
+ *      https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+ *
+ * for the zstd format, and the seek table that makes a file of
+ * independently compressed zstd frames seekable, and
+ *
+ *      https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md
+ *
+ * for the lz4 frame format.
+ *
  * Some other compressed file formats we might want to support:
  *
  *      XZ format: https://tukaani.org/xz/
@@ -50,20 +74,24 @@ static struct compression_type {
     wtap_compression_type  type;
     const char            *extension;
     const char            *description;
+    const char            *name;
 } compression_types[] = {
 #ifdef HAVE_ZLIB
-    { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed" },
+    { WTAP_GZIP_COMPRESSED, "gz", "gzip compressed", "gzip" },
 #endif
-    { WTAP_UNCOMPRESSED, NULL, NULL }
+#ifdef HAVE_ZSTD
+    { WTAP_ZSTD_COMPRESSED, "zst", "zstd compressed", "zstd" },
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    { WTAP_LZ4_COMPRESSED, "lz4", "lz4 compressed", "lz4" },
+#endif
+    { WTAP_UNCOMPRESSED, NULL, NULL, NULL }
 };
 
 wtap_compression_type
 wtap_get_compression_type(wtap *wth)
 {
-	gboolean is_compressed;
-
-	is_compressed = file_iscompressed((wth->fh == NULL) ? wth->random_fh : wth->fh);
-	return is_compressed ? WTAP_GZIP_COMPRESSED : WTAP_UNCOMPRESSED;
+	return file_get_compression_type((wth->fh == NULL) ? wth->random_fh : wth->fh);
 }
 
 const char *
@@ -88,6 +116,33 @@ wtap_compression_type_extension(wtap_compression_type compression_type)
 	return NULL;
 }
 
+wtap_compression_type
+wtap_name_to_compression_type(const char *name)
+{
+	if (strcmp(name, "none") == 0)
+		return WTAP_UNCOMPRESSED;
+	for (struct compression_type *p = compression_types;
+	    p->type != WTAP_UNCOMPRESSED; p++) {
+		if (strcmp(p->name, name) == 0)
+			return p->type;
+	}
+	return WTAP_UNKNOWN_COMPRESSION;
+}
+
+GSList *
+wtap_get_all_compression_type_names_list(void)
+{
+	GSList *names;
+
+	names = NULL;	/* empty list, to start with */
+
+	for (struct compression_type *p = compression_types;
+	    p->type != WTAP_UNCOMPRESSED; p++)
+		names = g_slist_append(names, (gpointer)p->name);
+
+	return names;
+}
+
 GSList *
 wtap_get_all_compression_type_extensions_list(void)
 {
@@ -111,10 +166,42 @@ typedef enum {
     UNCOMPRESSED,  /* uncompressed - copy input directly */
 #ifdef HAVE_ZLIB
     ZLIB,          /* decompress a zlib stream */
-    GZIP_AFTER_HEADER
+    GZIP_AFTER_HEADER,
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD,          /* decompress zstd frames */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4,           /* decompress lz4 frames */
 #endif
 } compression_t;
 
+/*
+ * Read-ahead: a thread reads from the file descriptor into a ring of
+ * chunks while the data that's already been read is being processed,
+ * and buf_read() takes the data from the ring.
+ */
+#define READ_AHEAD_CHUNK (1024 * 1024)
+
+/* Number of chunks for files opened from now on; 0 if none. */
+static guint read_ahead_chunks;
+
+struct read_ahead {
+    GThread *thread;
+    GMutex mutex;
+    GCond cond;                 /* full changed, or stop or done set */
+    int fd;
+    guint count;                /* number of chunks */
+    guint8 *data;               /* count chunks of READ_AHEAD_CHUNK bytes */
+    guint *len;                 /* number of bytes read into each chunk */
+    guint head;                 /* next chunk to take data from */
+    guint full;                 /* number of chunks read into, from head on */
+    guint offset;               /* offset of the next byte in the head chunk */
+    gboolean stop;              /* TRUE if the thread is to stop */
+    gboolean done;              /* TRUE if the thread stopped at the end or an error */
+    int err;                    /* errno, if it stopped at an error */
+};
+
 struct wtap_reader_buf {
     guint8 *buf;  /* buffer */
     guint8 *next; /* next byte to deliver from buffer */
@@ -135,6 +222,7 @@ struct wtap_reader {
     gint64 raw;                 /* where the raw data started, for seeking */
     compression_t compression;  /* type of compression, if any */
     gboolean is_compressed;     /* FALSE if completely uncompressed, TRUE otherwise */
+    wtap_compression_type compression_type; /* the compression we've seen */
 
     /* seek request */
     gint64 skip;                /* amount to skip (already rewound if backwards) */
@@ -149,9 +237,34 @@ struct wtap_reader {
     z_stream strm;              /* stream structure in-place (not a pointer) */
     gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
 #endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zstd;         /* zstd decompression stream, once needed */
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    LZ4F_decompressionContext_t lz4; /* lz4 decompression context, once needed */
+#endif
+    gboolean in_frame;          /* TRUE if we're part way through a zstd or lz4 frame */
     /* fast seeking */
     GPtrArray *fast_seek;
     void *fast_seek_cur;
+
+#ifdef HAVE_MMAP
+    /* memory-mapped uncompressed file */
+    guint8 *map;                /* the mapping, or NULL */
+    gsize map_len;              /* length of the mapping */
+    gint64 map_size;            /* how much of it we read from; 0 if none */
+    guint8 *out_buf;            /* our output buffer, while out is in the mapping */
+#endif
+
+    /* read-ahead */
+    guint read_ahead;           /* number of chunks to read ahead; 0 if none */
+    struct read_ahead *ra;      /* the read-ahead thread, if it's running */
+
+    /* gzip index and parallel inflate */
+    gchar *index_path;          /* capture file whose index we looked for, or NULL */
+    gint64 index_out_size;      /* uncompressed size, if we have its index; 0 otherwise */
+    guint inflate_threads;      /* number of threads to inflate with; 0 if none */
+    struct parallel_inflate *pi; /* the inflating threads, if they're running */
 };
 
 /* Current read offset within a buffer. */
@@ -190,6 +303,151 @@ buf_reset(struct wtap_reader_buf *buf)
     buf->avail = 0;
 }
 
+static gpointer
+read_ahead_thread(gpointer data)
+{
+    struct read_ahead *ra = (struct read_ahead *)data;
+    guint idx;
+    ssize_t ret;
+
+    g_mutex_lock(&ra->mutex);
+    for (;;) {
+        while (!ra->stop && ra->full == ra->count)
+            g_cond_wait(&ra->cond, &ra->mutex);
+        if (ra->stop)
+            break;
+
+        /* The chunk after the full ones is ours until we fill it. */
+        idx = (ra->head + ra->full) % ra->count;
+        g_mutex_unlock(&ra->mutex);
+        ret = ws_read(ra->fd, ra->data + (gsize)idx * READ_AHEAD_CHUNK,
+                      READ_AHEAD_CHUNK);
+        g_mutex_lock(&ra->mutex);
+
+        if (ret <= 0) {
+            ra->err = ret < 0 ? errno : 0;
+            ra->done = TRUE;
+            g_cond_signal(&ra->cond);
+            break;
+        }
+        ra->len[idx] = (guint)ret;
+        ra->full++;
+        g_cond_signal(&ra->cond);
+    }
+    g_mutex_unlock(&ra->mutex);
+    return NULL;
+}
+
+static void
+read_ahead_start(FILE_T state)
+{
+    struct read_ahead *ra;
+
+    ra = g_new0(struct read_ahead, 1);
+    ra->data = (guint8 *)g_try_malloc((gsize)state->read_ahead * READ_AHEAD_CHUNK);
+    if (ra->data == NULL) {
+        /* just read without it */
+        g_free(ra);
+        state->read_ahead = 0;
+        return;
+    }
+    ra->len = g_new0(guint, state->read_ahead);
+    ra->count = state->read_ahead;
+    ra->fd = state->fd;
+    g_mutex_init(&ra->mutex);
+    g_cond_init(&ra->cond);
+    ra->thread = g_thread_new("read-ahead", read_ahead_thread, ra);
+    state->ra = ra;
+}
+
+/*
+ * Stop the read-ahead thread, if it's running, and seek the file descriptor
+ * back to the data we haven't taken yet, so that it can be used directly.
+ */
+static int
+read_ahead_stop(FILE_T state)
+{
+    struct read_ahead *ra = state->ra;
+    gboolean unread;
+
+    if (ra == NULL)
+        return 0;
+
+    g_mutex_lock(&ra->mutex);
+    ra->stop = TRUE;
+    g_cond_signal(&ra->cond);
+    g_mutex_unlock(&ra->mutex);
+    g_thread_join(ra->thread);
+
+    unread = ra->full != 0;
+    g_cond_clear(&ra->cond);
+    g_mutex_clear(&ra->mutex);
+    g_free(ra->len);
+    g_free(ra->data);
+    g_free(ra);
+    state->ra = NULL;
+
+    if (unread && state->fd != -1 &&
+        ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1)
+        return -1;
+    return 0;
+}
+
+/* Like ws_read(), but from the read-ahead ring, starting the thread if
+   necessary. */
+static ssize_t
+read_ahead_read(FILE_T state, guint8 *buf, guint count)
+{
+    struct read_ahead *ra;
+    guint n;
+    int err;
+
+    if (state->ra == NULL) {
+        read_ahead_start(state);
+        if (state->ra == NULL)
+            return ws_read(state->fd, buf, count);
+    }
+    ra = state->ra;
+
+    g_mutex_lock(&ra->mutex);
+    while (ra->full == 0 && !ra->done)
+        g_cond_wait(&ra->cond, &ra->mutex);
+    if (ra->full == 0) {
+        /*
+         * The thread stopped at the end of the file or at an error.
+         * A later read starts it again, in case the file has grown.
+         */
+        err = ra->err;
+        g_mutex_unlock(&ra->mutex);
+        read_ahead_stop(state);
+        if (err != 0) {
+            errno = err;
+            return -1;
+        }
+        return 0;
+    }
+
+    n = ra->len[ra->head] - ra->offset;
+    if (n > count)
+        n = count;
+    memcpy(buf, ra->data + (gsize)ra->head * READ_AHEAD_CHUNK + ra->offset, n);
+    ra->offset += n;
+    if (ra->offset == ra->len[ra->head]) {
+        ra->head = (ra->head + 1) % ra->count;
+        ra->offset = 0;
+        ra->full--;
+        g_cond_signal(&ra->cond);
+    }
+    g_mutex_unlock(&ra->mutex);
+    return n;
+}
+
+void
+wtap_set_read_ahead(guint mbytes)
+{
+    read_ahead_chunks = mbytes;
+}
+
 static int
 buf_read(FILE_T state, struct wtap_reader_buf *buf)
 {
@@ -215,7 +473,10 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
         to_read = space_left;
     }
 
-    ret = ws_read(state->fd, read_ptr, to_read);
+    if (state->read_ahead != 0)
+        ret = read_ahead_read(state, read_ptr, to_read);
+    else
+        ret = ws_read(state->fd, read_ptr, to_read);
     if (ret < 0) {
         state->err = errno;
         state->err_info = NULL;
@@ -240,6 +501,26 @@ fill_in_buffer(FILE_T state)
     return 0;
 }
 
+#if defined(HAVE_ZLIB) || defined(HAVE_ZSTD)
+/* Read len bytes at offset in the file, or fail. */
+static gboolean
+read_at(int fd, gint64 offset, guint8 *buf, guint len)
+{
+    ssize_t ret;
+
+    if (ws_lseek64(fd, offset, SEEK_SET) == -1)
+        return FALSE;
+    while (len != 0) {
+        ret = ws_read(fd, buf, len);
+        if (ret <= 0)
+            return FALSE;
+        buf += ret;
+        len -= (guint)ret;
+    }
+    return TRUE;
+}
+#endif
+
 #define ZLIB_WINSIZE 32768
 
 struct fast_seek_point {
@@ -247,18 +528,26 @@ struct fast_seek_point {
     gint64 in;          /* offset in input file of first full byte */
 
     compression_t compression;
-    union {
-        struct {
+};
+
+/*
+ * A point within a deflate stream also has what inflate() needs to carry
+ * on from there, so it's much bigger than the others, which are at the
+ * start of uncompressed data, a gzip member, or a zstd or lz4 frame;
+ * there's one of those for every frame in a zstd seek table, and the
+ * frames can be as small as a megabyte or so.
+ */
+struct zlib_fast_seek_point {
+    struct fast_seek_point point;
+
 #ifdef HAVE_INFLATEPRIME
-            int bits;   /* number of bits (1-7) from byte at in - 1, or 0 */
+    int bits;   /* number of bits (1-7) from byte at in - 1, or 0 */
 #endif
-            unsigned char window[ZLIB_WINSIZE]; /* preceding 32K of uncompressed data */
+    unsigned char window[ZLIB_WINSIZE]; /* preceding 32K of uncompressed data */
 
-            /* be gentle with Z_STREAM_END, 8 bytes more... Another solution would be to comment checks out */
-            guint32 adler;
-            guint32 total_out;
-        } zlib;
-    } data;
+    /* be gentle with Z_STREAM_END, 8 bytes more... Another solution would be to comment checks out */
+    guint32 adler;
+    guint32 total_out;
 };
 
 struct zlib_cur_seek_point {
@@ -313,6 +602,27 @@ fast_seek_header(FILE_T file, gint64 in_pos, gint64 out_pos,
     }
 }
 
+/* Is this point at the start of a zstd or lz4 frame?  Seeking to one of
+   those costs no more than decompressing what's after it. */
+static gboolean
+fast_seek_at_frame(
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+    struct fast_seek_point *point)
+#else
+    struct fast_seek_point *point _U_)
+#endif
+{
+#ifdef HAVE_ZSTD
+    if (point->compression == ZSTD)
+        return TRUE;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (point->compression == LZ4)
+        return TRUE;
+#endif
+    return FALSE;
+}
+
 static void
 fast_seek_reset(
 #ifdef HAVE_ZLIB
@@ -475,20 +785,20 @@ zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gin
      *      It's not big deal, cause first-read don't usually invoke seeking
      */
     if (item->out + SPAN < out_pos) {
-        struct fast_seek_point *val = g_new(struct fast_seek_point,1);
-        val->in = in_pos;
-        val->out = out_pos;
-        val->compression = ZLIB;
+        struct zlib_fast_seek_point *val = g_new(struct zlib_fast_seek_point,1);
+        val->point.in = in_pos;
+        val->point.out = out_pos;
+        val->point.compression = ZLIB;
 #ifdef HAVE_INFLATEPRIME
-        val->data.zlib.bits = bits;
+        val->bits = bits;
 #endif
         if (point->pos != 0) {
             unsigned int left = ZLIB_WINSIZE - point->pos;
 
-            memcpy(val->data.zlib.window, point->window + point->pos, left);
-            memcpy(val->data.zlib.window + left, point->window, point->pos);
+            memcpy(val->window, point->window + point->pos, left);
+            memcpy(val->window + left, point->window, point->pos);
         } else
-            memcpy(val->data.zlib.window, point->window, ZLIB_WINSIZE);
+            memcpy(val->window, point->window, ZLIB_WINSIZE);
 
         /*
          * XXX - strm.adler is a uLong in at least some versions
@@ -503,8 +813,8 @@ zlib_fast_seek_add(FILE_T file, struct zlib_cur_seek_point *point, int bits, gin
          *
          * The same applies to strm.total_out.
          */
-        val->data.zlib.adler = (guint32) file->strm.adler;
-        val->data.zlib.total_out = (guint32) file->strm.total_out;
+        val->adler = (guint32) file->strm.adler;
+        val->total_out = (guint32) file->strm.total_out;
         g_ptr_array_add(file->fast_seek, val);
     }
 }
@@ -642,6 +952,265 @@ DIAG_ON(cast-qual)
 }
 #endif
 
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+/* Make sure there are at least n bytes in the input buffer, unless the
+   file is shorter than that.  Returns -1 on a read error, 0 otherwise. */
+static int
+fill_in_buffer_min(FILE_T state, guint n)
+{
+    while (state->in.avail < n && !state->eof) {
+        /* move what we have to the start of the buffer, so that it's
+           not discarded if the buffer's full */
+        if (state->in.next != state->in.buf) {
+            memmove(state->in.buf, state->in.next, state->in.avail);
+            state->in.next = state->in.buf;
+        }
+        if (fill_in_buffer(state) == -1)
+            return -1;
+    }
+    return 0;
+}
+#endif /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+
+#ifdef HAVE_ZSTD
+#define ZSTD_SKIPPABLE_MAGIC            0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC             0x8F92EAB1
+#define ZSTD_SEEK_TABLE_FOOTER_SIZE     9
+#define ZSTD_SEEK_TABLE_MAX_FRAMES      0x8000000U
+
+/*
+ * A file in the zstd seekable format is a series of independently
+ * compressed frames followed by a seek table, in a skippable frame, giving
+ * the compressed and decompressed size of each of them.  If the file has
+ * one, add a fast seek point for the start of every frame, so that a
+ * random access can go straight to the frame it's in even on the first
+ * pass through the file.  Otherwise, or if the table is inconsistent with
+ * the file, the points are added as we come to the frames.
+ */
+static void
+zstd_read_seek_table(FILE_T state)
+{
+    ws_statb64 st;
+    guint8 footer[ZSTD_SEEK_TABLE_FOOTER_SIZE];
+    guint8 *table = NULL, *entry;
+    guint32 frames, i;
+    guint entry_size;
+    gint64 table_size, table_start, in, out;
+
+    if (ws_fstat64(state->fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_size - state->start < 8 + ZSTD_SEEK_TABLE_FOOTER_SIZE)
+        return;
+
+    /* we're about to move the file descriptor */
+    if (read_ahead_stop(state) == -1) {
+        state->err = errno;
+        state->err_info = NULL;
+        return;
+    }
+
+    if (!read_at(state->fd, st.st_size - ZSTD_SEEK_TABLE_FOOTER_SIZE, footer,
+                 ZSTD_SEEK_TABLE_FOOTER_SIZE) ||
+        pletoh32(footer + 5) != ZSTD_SEEKABLE_MAGIC ||
+        (footer[4] & 0x7c) != 0)        /* reserved bits */
+        goto done;
+    frames = pletoh32(footer);
+    entry_size = (footer[4] & 0x80) ? 12 : 8;   /* with checksums, or not */
+    table_size = (gint64)frames * entry_size;
+    table_start = st.st_size - ZSTD_SEEK_TABLE_FOOTER_SIZE - table_size - 8;
+    if (frames == 0 || frames > ZSTD_SEEK_TABLE_MAX_FRAMES ||
+        table_start < state->start)
+        goto done;
+
+    table = (guint8 *)g_try_malloc((gsize)table_size + 8);
+    if (table == NULL ||
+        !read_at(state->fd, table_start, table, (guint)table_size + 8) ||
+        pletoh32(table) != ZSTD_SKIPPABLE_MAGIC ||
+        pletoh32(table + 4) != table_size + ZSTD_SEEK_TABLE_FOOTER_SIZE)
+        goto done;
+
+    /* the frames must be everything before the table */
+    in = state->start;
+    for (i = 0, entry = table + 8; i < frames; i++, entry += entry_size)
+        in += pletoh32(entry);
+    if (in != table_start)
+        goto done;
+
+    in = state->start;
+    out = 0;
+    for (i = 0, entry = table + 8; i < frames; i++, entry += entry_size) {
+        fast_seek_header(state, in, out, ZSTD);
+        in += pletoh32(entry);
+        out += pletoh32(entry + 4);
+    }
+
+done:
+    g_free(table);
+    /* go back to where we were reading */
+    if (ws_lseek64(state->fd, state->raw_pos, SEEK_SET) == -1) {
+        state->err = errno;
+        state->err_info = NULL;
+    }
+}
+
+/* Start decompressing a zstd frame. */
+static int
+zstd_reset(FILE_T state)
+{
+    size_t ret;
+
+    if (state->zstd == NULL) {
+        state->zstd = ZSTD_createDStream();
+        if (state->zstd == NULL) {
+            state->err = ENOMEM;
+            state->err_info = NULL;
+            return -1;
+        }
+    }
+    ret = ZSTD_initDStream(state->zstd);
+    if (ZSTD_isError(ret)) {
+        state->err = WTAP_ERR_INTERNAL;
+        state->err_info = ZSTD_getErrorName(ret);
+        return -1;
+    }
+    state->compression = ZSTD;
+    state->is_compressed = TRUE;
+    state->compression_type = WTAP_ZSTD_COMPRESSED;
+    state->in_frame = FALSE;
+    return 0;
+}
+
+static void
+zstd_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    ZSTD_outBuffer output;
+    ZSTD_inBuffer input;
+    size_t ret;
+
+    output.dst = buf;
+    output.size = count;
+    output.pos = 0;
+
+    /*
+     * Fill the output buffer, up to the end of the input or an error.
+     * The decompressor is called first even if there's no input, as it
+     * may have output left over from the last call.
+     */
+    for (;;) {
+        input.src = state->in.next;
+        input.size = state->in.avail;
+        input.pos = 0;
+        ret = ZSTD_decompressStream(state->zstd, &output, &input);
+        state->in.next += input.pos;
+        state->in.avail -= (guint)input.pos;
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = ZSTD_getErrorName(ret);
+            break;
+        }
+        if (ret == 0) {
+            /* end of a frame; the next one can be decompressed on its own */
+            state->in_frame = FALSE;
+            if (state->fast_seek)
+                fast_seek_header(state, state->raw_pos - state->in.avail,
+                                 state->pos + output.pos, ZSTD);
+        } else if (input.pos != 0)
+            state->in_frame = TRUE;
+
+        if (output.pos == output.size)
+            break;
+        if (state->in.avail == 0) {
+            if (fill_in_buffer(state) == -1)
+                break;
+            if (state->in.avail == 0) {
+                /* EOF; that's an error if it's in the middle of a frame */
+                if (state->in_frame) {
+                    state->err = WTAP_ERR_SHORT_READ;
+                    state->err_info = NULL;
+                }
+                break;
+            }
+        }
+    }
+
+    state->out.next = buf;
+    state->out.avail = (guint)output.pos;
+}
+#endif /* HAVE_ZSTD */
+
+#ifdef HAVE_LZ4FRAME_H
+/* Start decompressing an lz4 frame. */
+static int
+lz4_reset(FILE_T state)
+{
+    LZ4F_errorCode_t ret;
+
+    /* a new context, rather than one that may be part way through a frame */
+    if (state->lz4 != NULL) {
+        LZ4F_freeDecompressionContext(state->lz4);
+        state->lz4 = NULL;
+    }
+    ret = LZ4F_createDecompressionContext(&state->lz4, LZ4F_VERSION);
+    if (LZ4F_isError(ret)) {
+        state->lz4 = NULL;
+        state->err = ENOMEM;
+        state->err_info = NULL;
+        return -1;
+    }
+    state->compression = LZ4;
+    state->is_compressed = TRUE;
+    state->compression_type = WTAP_LZ4_COMPRESSED;
+    state->in_frame = FALSE;
+    return 0;
+}
+
+static void
+lz4_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+    size_t have = 0, dst_size, src_size;
+    size_t ret;
+
+    /* as zstd_read() */
+    for (;;) {
+        dst_size = count - have;
+        src_size = state->in.avail;
+        ret = LZ4F_decompress(state->lz4, buf + have, &dst_size,
+                              state->in.next, &src_size, NULL);
+        state->in.next += src_size;
+        state->in.avail -= (guint)src_size;
+        have += dst_size;
+        if (LZ4F_isError(ret)) {
+            state->err = WTAP_ERR_DECOMPRESS;
+            state->err_info = LZ4F_getErrorName(ret);
+            break;
+        }
+        if (ret == 0) {
+            state->in_frame = FALSE;
+            if (state->fast_seek)
+                fast_seek_header(state, state->raw_pos - state->in.avail,
+                                 state->pos + have, LZ4);
+        } else if (src_size != 0)
+            state->in_frame = TRUE;
+
+        if (have == count)
+            break;
+        if (state->in.avail == 0) {
+            if (fill_in_buffer(state) == -1)
+                break;
+            if (state->in.avail == 0) {
+                if (state->in_frame) {
+                    state->err = WTAP_ERR_SHORT_READ;
+                    state->err_info = NULL;
+                }
+                break;
+            }
+        }
+    }
+
+    state->out.next = buf;
+    state->out.avail = (guint)have;
+}
+#endif /* HAVE_LZ4FRAME_H */
+
 static int
 gz_head(FILE_T state)
 {
@@ -767,6 +1336,7 @@ gz_head(FILE_T state)
                 state->strm.adler = crc32(0L, Z_NULL, 0);
                 state->compression = ZLIB;
                 state->is_compressed = TRUE;
+                state->compression_type = WTAP_GZIP_COMPRESSED;
 #ifdef Z_BLOCK
                 if (state->fast_seek) {
                     struct zlib_cur_seek_point *cur = g_new(struct zlib_cur_seek_point,1);
@@ -804,6 +1374,52 @@ gz_head(FILE_T state)
             state->in.next--;
         }
     }
+
+    /* look for the magic numbers of a zstd frame, 0xFD2FB528, and an
+       lz4 frame, 0x184D2204, both little-endian */
+    if (state->in.next[0] == 0x28 || state->in.next[0] == 0x04) {
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+        gint64 in_pos;
+
+        if (fill_in_buffer_min(state, 4) == -1)
+            return -1;
+        in_pos = state->raw_pos - state->in.avail;
+#endif
+        if (state->in.avail >= 4 &&
+            memcmp(state->in.next, "\x28\xb5\x2f\xfd", 4) == 0) {
+#ifdef HAVE_ZSTD
+            if (zstd_reset(state) == -1)
+                return -1;
+            if (state->fast_seek) {
+                /* the seek table is for the whole file */
+                if (state->fast_seek->len == 0 && in_pos == state->start)
+                    zstd_read_seek_table(state);
+                fast_seek_header(state, in_pos, state->pos, ZSTD);
+            }
+            return 0;
+#else
+            state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
+            state->err_info = "reading zstd-compressed files isn't supported";
+            return -1;
+#endif
+        }
+
+        if (state->in.avail >= 4 &&
+            memcmp(state->in.next, "\x04\x22\x4d\x18", 4) == 0) {
+#ifdef HAVE_LZ4FRAME_H
+            if (lz4_reset(state) == -1)
+                return -1;
+            if (state->fast_seek)
+                fast_seek_header(state, in_pos, state->pos, LZ4);
+            return 0;
+#else
+            state->err = WTAP_ERR_DECOMPRESSION_NOT_SUPPORTED;
+            state->err_info = "reading lz4-compressed files isn't supported";
+            return -1;
+#endif
+        }
+    }
+
 #ifdef HAVE_LIBXZ
     /* { 0xFD, '7', 'z', 'X', 'Z', 0x00 } */
     /* FD 37 7A 58 5A 00 */
@@ -831,31 +1447,631 @@ gz_head(FILE_T state)
     return 0;
 }
 
-static int /* gz_make */
-fill_out_buffer(FILE_T state)
+#ifdef HAVE_MMAP
+/*
+ * Most of an uncompressed file is read straight from a memory mapping of
+ * it: the output buffer is pointed at a window of the mapping, so that
+ * the code that reads from the output buffer works unchanged, and
+ * file_read_ptr() can hand out pointers into the mapping rather than
+ * copying the data.  The window is bounded, as the buffer's counts are
+ * unsigned ints.
+ *
+ * Past the end of the mapping, e.g. in a file that's still being
+ * written, we read from the file descriptor as usual.
+ */
+#define MAP_WINDOW (1U << 30)
+
+/* Map a regular file that's not compressed; failing that, we just read it. */
+static void
+map_file(FILE_T state)
 {
-    if (state->compression == UNKNOWN) {           /* look for gzip header */
-        if (gz_head(state) == -1)
-            return -1;
-        if (state->out.avail != 0)                /* got some data from gz_head() */
-            return 0;
-    }
-    if (state->compression == UNCOMPRESSED) {           /* straight copy */
-        if (buf_read(state, &state->out) < 0)
-            return -1;
-    }
-#ifdef HAVE_ZLIB
-    else if (state->compression == ZLIB) {      /* decompress */
-        zlib_read(state, state->out.buf, state->size << 1);
+    ws_statb64 st;
+    void *map;
+    const guint8 *data;
+    gsize left;
+
+    if (ws_fstat64(state->fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_size <= state->start || (guint64)st.st_size > G_MAXSIZE)
+        return;
+
+    /*
+     * Private, so that anything that modifies the data in place, such
+     * as editcap -E, gets a copy of the page rather than changing the
+     * file.
+     */
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+               state->fd, 0);
+    if (map == MAP_FAILED)
+        return;
+    state->map = (guint8 *)map;
+    state->map_len = (gsize)st.st_size;
+
+    data = state->map + state->start;
+    left = state->map_len - state->start;
+    if ((left >= 2 && data[0] == 31 && data[1] == 139) ||
+        (left >= 4 && (memcmp(data, "\x28\xb5\x2f\xfd", 4) == 0 ||
+                       memcmp(data, "\x04\x22\x4d\x18", 4) == 0))) {
+        /* gzip, zstd or lz4 compressed; leave it to gz_head() */
+        munmap(map, state->map_len);
+        state->map = NULL;
+        state->map_len = 0;
+        return;
     }
-#endif
-    return 0;
+
+    state->map += state->start;
+    state->map_size = st.st_size - state->start;
+    state->compression = UNCOMPRESSED;
+    state->raw = 0;
 }
 
-static int
-gz_skip(FILE_T state, gint64 len)
+/* Point the output buffer at the mapping, from the current position. */
+static void
+map_out_buffer(FILE_T state)
 {
-    guint n;
+    gint64 left = state->map_size - state->pos;
+
+    if (state->out_buf == NULL)
+        state->out_buf = state->out.buf;
+    state->out.buf = state->map + state->pos;
+    state->out.next = state->out.buf;
+    state->out.avail = left > MAP_WINDOW ? MAP_WINDOW : (guint)left;
+    /* nothing has been read ahead; see file_tell_raw() */
+    state->raw_pos = state->start + state->pos;
+    state->eof = FALSE;
+}
+
+/* Go back to reading from the file descriptor, at the current position. */
+static int
+map_leave(FILE_T state)
+{
+    if (state->out_buf != NULL) {
+        state->out.buf = state->out_buf;
+        state->out_buf = NULL;
+    }
+    buf_reset(&state->out);
+    if (read_ahead_stop(state) == -1 ||
+        ws_lseek64(state->fd, state->start + state->pos, SEEK_SET) == -1) {
+        state->err = errno;
+        state->err_info = NULL;
+        return -1;
+    }
+    state->raw_pos = state->start + state->pos;
+    return 0;
+}
+#endif /* HAVE_MMAP */
+
+/* Number of threads to inflate gzip files opened from now on with; 0 if none. */
+static guint inflate_thread_count;
+
+/* TRUE if we're to write gzip indexes. */
+static gboolean write_gzip_index;
+
+/* What's appended to a capture file's name to get its gzip index's. */
+#define GZIP_INDEX_SUFFIX       ".gzidx"
+
+#ifdef HAVE_ZLIB
+/*
+ * Parallel inflate.  Once we have the fast seek points for the whole of a
+ * gzip file, from its index, the stretches of it between them can be
+ * inflated independently of each other, as each point has the dictionary
+ * that inflate() needs to start there.  Threads inflate the stretches
+ * after the current position, a few ahead of the reader, into buffers of
+ * their own, and the reader points the output buffer at them in turn.
+ * The CRCs of the stretches are combined to check the gzip trailers.
+ */
+#define INFLATE_MAX_SEGMENT     (64 * 1024 * 1024)
+#define INFLATE_AHEAD           2       /* segments per thread */
+
+struct inflate_segment {
+    struct fast_seek_point *start; /* point it starts at */
+    gint64 in_end;              /* end of the compressed data it needs */
+    guint len;                  /* length of its uncompressed data */
+    gboolean member_end;        /* TRUE if it ends at the end of a gzip member */
+
+    /* set by the thread that inflates it */
+    guint8 *data;               /* the uncompressed data */
+    guint have;                 /* how much of it there is */
+    guint first_len;            /* how much of it is in the member it starts in */
+    guint32 first_crc;          /* CRC of that part */
+    gboolean first_end;         /* TRUE if that member ends in it */
+    guint32 trailer_crc;        /* CRC in that member's trailer, if so */
+    guint32 last_crc;           /* CRC of the part after the last member start in it */
+    gboolean mismatch;          /* TRUE if it isn't what the index says */
+    int err;                    /* error code */
+    const char *err_info;       /* additional error information string */
+    gboolean done;              /* TRUE once it's been inflated */
+};
+
+struct parallel_inflate {
+    GThread **threads;
+    guint nthreads;
+    GMutex mutex;
+    GCond cond;                 /* a segment was inflated or taken, or stop set */
+    GMutex io_mutex;            /* held while reading from fd */
+    int fd;
+    gboolean dont_check_crc;    /* TRUE if we aren't supposed to check the CRC */
+    struct inflate_segment *segs;
+    guint nsegs;
+    guint next_start;           /* next segment for a thread to inflate */
+    guint next_take;            /* next segment for the reader */
+    guint ahead;                /* most segments to have ready for the reader */
+    gboolean stop;              /* TRUE if the threads are to stop */
+
+    /* used only by the reader */
+    struct inflate_segment *cur; /* segment the output buffer is in, or NULL */
+    guint skip;                 /* bytes of the first segment before where we started */
+    guint32 check;              /* CRC of the current gzip member so far */
+    guint8 *out_buf;            /* our output buffer, while out is in a segment */
+};
+
+static gint64 fast_seek_to(FILE_T file, struct fast_seek_point *here, gint64 offset, int *err);
+static int gz_skip(FILE_T state, gint64 len);
+static void parallel_inflate_stop(FILE_T state);
+
+/* Skip the gzip header at the start of the input, if it's all there. */
+static gboolean
+skip_gzip_header(z_stream *strm)
+{
+    const guint8 *p = strm->next_in;
+    guint left = strm->avail_in;
+    guint8 flags;
+    guint n;
+
+    if (left < 10 || p[0] != 31 || p[1] != 139 || p[2] != 8)
+        return FALSE;
+    flags = p[3];
+    if (flags & 0xe0)           /* reserved flag bits */
+        return FALSE;
+    p += 10;
+    left -= 10;
+
+    if (flags & 4) {            /* extra field */
+        if (left < 2)
+            return FALSE;
+        n = 2 + (p[0] | ((guint)p[1] << 8));
+        if (left < n)
+            return FALSE;
+        p += n;
+        left -= n;
+    }
+    for (n = 8; n <= 16; n <<= 1) {
+        if (flags & n) {        /* file name, then comment */
+            while (left != 0 && *p != 0) {
+                p++;
+                left--;
+            }
+            if (left == 0)
+                return FALSE;
+            p++;
+            left--;
+        }
+    }
+    if (flags & 2) {            /* header crc */
+        if (left < 2)
+            return FALSE;
+        p += 2;
+        left -= 2;
+    }
+
+    strm->next_in = p;
+    strm->avail_in = left;
+    return TRUE;
+}
+
+static void
+inflate_segment(struct parallel_inflate *pi, struct inflate_segment *seg)
+{
+    struct fast_seek_point *start = seg->start;
+    gint64 in_start = start->in;
+    guint32 total_out = 0;
+    guint8 *in, *piece;
+    guint in_len, piece_len;
+    guint32 piece_crc;
+    z_stream strm;
+    int ret, err;
+    gboolean ok;
+
+#ifdef HAVE_INFLATEPRIME
+    if (start->compression == ZLIB &&
+        ((struct zlib_fast_seek_point *)start)->bits)
+        in_start--;
+#endif
+    in_len = (guint)(seg->in_end - in_start);
+
+    /* one byte more than it should need, to see the end of a member */
+    seg->data = (guint8 *)g_try_malloc((gsize)seg->len + 1);
+    in = (guint8 *)g_try_malloc(in_len);
+    if (seg->data == NULL || in == NULL) {
+        g_free(in);
+        seg->err = ENOMEM;
+        return;
+    }
+
+    g_mutex_lock(&pi->io_mutex);
+    errno = 0;
+    ok = read_at(pi->fd, in_start, in, in_len);
+    err = errno;
+    g_mutex_unlock(&pi->io_mutex);
+    if (!ok) {
+        g_free(in);
+        seg->err = err != 0 ? err : WTAP_ERR_SHORT_READ;
+        return;
+    }
+
+    memset(&strm, 0, sizeof strm);
+    if (inflateInit2(&strm, -15) != Z_OK) {     /* raw inflate */
+        g_free(in);
+        seg->err = ENOMEM;
+        return;
+    }
+    strm.next_in = in;
+    strm.avail_in = in_len;
+    if (start->compression == ZLIB) {
+        struct zlib_fast_seek_point *point = (struct zlib_fast_seek_point *)start;
+
+#ifdef HAVE_INFLATEPRIME
+        if (point->bits) {
+            (void)inflatePrime(&strm, point->bits, in[0] >> (8 - point->bits));
+            strm.next_in++;
+            strm.avail_in--;
+        }
+#endif
+        (void)inflateSetDictionary(&strm, point->window, ZLIB_WINSIZE);
+        total_out = point->total_out;
+    }
+    strm.next_out = seg->data;
+    strm.avail_out = seg->len + (seg->member_end ? 1 : 0);
+
+    /*
+     * A stretch usually ends in the member it starts in, but not if there
+     * are members too small to have points of their own, such as empty
+     * ones; the CRCs of any members that start and end in it are checked
+     * here.
+     */
+    piece = seg->data;
+    for (;;) {
+        do {
+            ret = inflate(&strm, Z_NO_FLUSH);
+        } while (ret == Z_OK && strm.avail_out != 0 && strm.avail_in != 0);
+        if (ret != Z_STREAM_END)
+            break;
+
+        piece_len = (guint)(strm.next_out - piece);
+        piece_crc = (guint32)crc32(0L, piece, piece_len);
+        if (strm.avail_in < 8) {
+            seg->mismatch = TRUE;
+            break;
+        }
+        if (!seg->first_end) {
+            seg->first_end = TRUE;
+            seg->first_len = piece_len;
+            seg->first_crc = piece_crc;
+            seg->trailer_crc = pletoh32(strm.next_in);
+            total_out += piece_len;
+        } else {
+            if (piece_crc != pletoh32(strm.next_in) && !pi->dont_check_crc) {
+                seg->err = WTAP_ERR_DECOMPRESS;
+                seg->err_info = "bad CRC";
+                break;
+            }
+            total_out = piece_len;
+        }
+        if (pletoh32(strm.next_in + 4) != total_out) {
+            seg->err = WTAP_ERR_DECOMPRESS;
+            seg->err_info = "length field wrong";
+            break;
+        }
+        strm.next_in += 8;
+        strm.avail_in -= 8;
+        piece = strm.next_out;
+        if (piece == seg->data + seg->len)
+            break;
+
+        /* on to the next member */
+        if (!skip_gzip_header(&strm)) {
+            seg->mismatch = TRUE;
+            break;
+        }
+        inflateReset(&strm);
+    }
+    seg->have = (guint)(strm.next_out - seg->data);
+    if (!seg->first_end) {
+        seg->first_len = seg->have;
+        seg->first_crc = (guint32)crc32(0L, seg->data, seg->have);
+    } else
+        seg->last_crc = (guint32)crc32(0L, piece, (guint)(strm.next_out - piece));
+
+    if (seg->err != 0 || seg->mismatch) {
+        ;
+    } else if (ret == Z_NEED_DICT) {
+        seg->err = WTAP_ERR_DECOMPRESS;
+        seg->err_info = "preset dictionary needed";
+    } else if (ret == Z_MEM_ERROR) {
+        seg->err = ENOMEM;
+    } else if (ret == Z_DATA_ERROR || ret == Z_STREAM_ERROR) {
+        seg->err = WTAP_ERR_DECOMPRESS;
+        seg->err_info = strm.msg;
+    } else if (seg->have != seg->len || (ret == Z_STREAM_END) != seg->member_end) {
+        seg->mismatch = TRUE;
+    }
+    inflateEnd(&strm);
+    g_free(in);
+}
+
+static gpointer
+inflate_thread(gpointer data)
+{
+    struct parallel_inflate *pi = (struct parallel_inflate *)data;
+    struct inflate_segment *seg;
+
+    g_mutex_lock(&pi->mutex);
+    for (;;) {
+        while (!pi->stop && pi->next_start < pi->nsegs &&
+               pi->next_start >= pi->next_take + pi->ahead)
+            g_cond_wait(&pi->cond, &pi->mutex);
+        if (pi->stop || pi->next_start == pi->nsegs)
+            break;
+
+        seg = &pi->segs[pi->next_start++];
+        g_mutex_unlock(&pi->mutex);
+        inflate_segment(pi, seg);
+        g_mutex_lock(&pi->mutex);
+
+        seg->done = TRUE;
+        g_cond_broadcast(&pi->cond);
+    }
+    g_mutex_unlock(&pi->mutex);
+    return NULL;
+}
+
+/*
+ * Start inflating from the fast seek point at or before the current
+ * position, if the points from there on can be used for it.
+ */
+static gboolean
+parallel_inflate_start(FILE_T state)
+{
+    struct parallel_inflate *pi;
+    struct inflate_segment *seg;
+    struct fast_seek_point *point, *next;
+    ws_statb64 st;
+    gint64 out_end;
+    guint first, i;
+
+    if (ws_fstat64(state->fd, &st) == -1)
+        return FALSE;
+
+    for (first = state->fast_seek->len; first != 0; first--) {
+        point = (struct fast_seek_point *)state->fast_seek->pdata[first - 1];
+        if (point->out <= state->pos)
+            break;
+    }
+    if (first == 0)
+        return FALSE;
+    first--;
+
+    pi = g_new0(struct parallel_inflate, 1);
+    pi->nsegs = state->fast_seek->len - first;
+    pi->segs = g_new0(struct inflate_segment, pi->nsegs);
+    for (i = 0; i < pi->nsegs; i++) {
+        seg = &pi->segs[i];
+        point = (struct fast_seek_point *)state->fast_seek->pdata[first + i];
+        next = i + 1 < pi->nsegs ?
+            (struct fast_seek_point *)state->fast_seek->pdata[first + i + 1] : NULL;
+
+        /* uncompressed data, say, is left to the usual code */
+        if (point->compression != ZLIB && point->compression != GZIP_AFTER_HEADER) {
+            g_free(pi->segs);
+            g_free(pi);
+            return FALSE;
+        }
+        out_end = next != NULL ? next->out : state->index_out_size;
+        seg->in_end = next != NULL ? next->in : st.st_size;
+        if (out_end < point->out || out_end - point->out > INFLATE_MAX_SEGMENT ||
+            seg->in_end <= point->in || seg->in_end - point->in > INFLATE_MAX_SEGMENT) {
+            g_free(pi->segs);
+            g_free(pi);
+            return FALSE;
+        }
+        seg->start = point;
+        seg->len = (guint)(out_end - point->out);
+        seg->member_end = next == NULL || next->compression == GZIP_AFTER_HEADER;
+    }
+
+    point = pi->segs[0].start;
+    pi->skip = (guint)(state->pos - point->out);
+    if (point->compression == ZLIB)
+        pi->check = ((struct zlib_fast_seek_point *)point)->adler;
+    pi->out_buf = state->out.buf;
+
+    /* the threads read the file from now on */
+    read_ahead_stop(state);
+    buf_reset(&state->in);
+
+    pi->fd = state->fd;
+    pi->dont_check_crc = state->dont_check_crc;
+    pi->nthreads = state->inflate_threads;
+    pi->ahead = pi->nthreads * INFLATE_AHEAD;
+    g_mutex_init(&pi->mutex);
+    g_cond_init(&pi->cond);
+    g_mutex_init(&pi->io_mutex);
+    pi->threads = g_new(GThread *, pi->nthreads);
+    for (i = 0; i < pi->nthreads; i++)
+        pi->threads[i] = g_thread_new("inflate", inflate_thread, pi);
+    state->pi = pi;
+    return TRUE;
+}
+
+/* Point the output buffer at the next segment. */
+static int
+parallel_inflate_fill(FILE_T state)
+{
+    struct parallel_inflate *pi = state->pi;
+    struct inflate_segment *seg;
+    int err;
+
+    if (pi->cur != NULL) {
+        state->out.buf = pi->out_buf;
+        buf_reset(&state->out);
+        g_free(pi->cur->data);
+        pi->cur->data = NULL;
+        pi->cur = NULL;
+    }
+    if (pi->next_take == pi->nsegs) {
+        state->eof = TRUE;
+        return 0;
+    }
+
+    g_mutex_lock(&pi->mutex);
+    seg = &pi->segs[pi->next_take];
+    while (!seg->done)
+        g_cond_wait(&pi->cond, &pi->mutex);
+    pi->next_take++;
+    g_cond_broadcast(&pi->cond);
+    g_mutex_unlock(&pi->mutex);
+
+    if (seg->mismatch) {
+        /*
+         * The index must be wrong; carry on without the threads from
+         * where we are, and don't try them again.
+         */
+        parallel_inflate_stop(state);
+        state->inflate_threads = 0;
+        if (fast_seek_to(state, fast_seek_find(state, state->pos), 0, &err) == -1) {
+            state->err = err;
+            state->err_info = NULL;
+            return -1;
+        }
+        if (state->seek_pending) {
+            state->seek_pending = FALSE;
+            return gz_skip(state, state->skip);
+        }
+        return 0;
+    }
+
+    if (seg->start->compression == GZIP_AFTER_HEADER)
+        pi->check = (guint32)crc32(0L, Z_NULL, 0);
+    pi->check = (guint32)crc32_combine(pi->check, seg->first_crc, seg->first_len);
+
+    /* report any error once the data before it has been read */
+    if (seg->err != 0) {
+        state->err = seg->err;
+        state->err_info = seg->err_info;
+    } else if (seg->first_end && pi->check != seg->trailer_crc &&
+               !state->dont_check_crc) {
+        state->err = WTAP_ERR_DECOMPRESS;
+        state->err_info = "bad CRC";
+    }
+    if (seg->first_end)
+        pi->check = seg->last_crc;
+
+    if (seg->data != NULL && seg->have > pi->skip) {
+        pi->cur = seg;
+        state->out.buf = seg->data;
+        state->out.next = seg->data + pi->skip;
+        state->out.avail = seg->have - pi->skip;
+    }
+    pi->skip = 0;
+    state->raw_pos = seg->in_end;
+    return 0;
+}
+#endif /* HAVE_ZLIB */
+
+/*
+ * Stop the inflating threads, if they're running.  The decompressor isn't
+ * where the reader is, so the caller has to set it up again.
+ */
+static void
+parallel_inflate_stop(
+#ifdef HAVE_ZLIB
+    FILE_T state)
+#else
+    FILE_T state _U_)
+#endif
+{
+#ifdef HAVE_ZLIB
+    struct parallel_inflate *pi = state->pi;
+    guint i;
+
+    if (pi == NULL)
+        return;
+
+    g_mutex_lock(&pi->mutex);
+    pi->stop = TRUE;
+    g_cond_broadcast(&pi->cond);
+    g_mutex_unlock(&pi->mutex);
+    for (i = 0; i < pi->nthreads; i++)
+        g_thread_join(pi->threads[i]);
+
+    state->out.buf = pi->out_buf;
+    buf_reset(&state->out);
+    for (i = 0; i < pi->nsegs; i++)
+        g_free(pi->segs[i].data);
+    g_mutex_clear(&pi->io_mutex);
+    g_cond_clear(&pi->cond);
+    g_mutex_clear(&pi->mutex);
+    g_free(pi->threads);
+    g_free(pi->segs);
+    g_free(pi);
+    state->pi = NULL;
+#endif
+}
+
+static int /* gz_make */
+fill_out_buffer(FILE_T state)
+{
+#ifdef HAVE_ZLIB
+    if (state->pi != NULL)
+        return parallel_inflate_fill(state);
+#endif
+    if (state->compression == UNKNOWN) {           /* look for gzip header */
+        if (gz_head(state) == -1)
+            return -1;
+        if (state->out.avail != 0)                /* got some data from gz_head() */
+            return 0;
+    }
+    if (state->compression == UNCOMPRESSED) {           /* straight copy */
+#ifdef HAVE_MMAP
+        if (state->map_size != 0) {
+            if (state->pos < state->map_size) {
+                map_out_buffer(state);
+                return 0;
+            }
+            if (state->out_buf != NULL && map_leave(state) == -1)
+                return -1;
+        }
+#endif
+        if (buf_read(state, &state->out) < 0)
+            return -1;
+    }
+#ifdef HAVE_ZLIB
+    else if (state->compression == ZLIB) {      /* decompress */
+        if (state->inflate_threads != 0 && state->index_out_size != 0 &&
+            state->pos >= SPAN) {
+            if (parallel_inflate_start(state))
+                return parallel_inflate_fill(state);
+            state->inflate_threads = 0;
+        }
+        zlib_read(state, state->out.buf, state->size << 1);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    else if (state->compression == ZSTD) {
+        zstd_read(state, state->out.buf, state->size << 1);
+    }
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    else if (state->compression == LZ4) {
+        lz4_read(state, state->out.buf, state->size << 1);
+    }
+#endif
+    return 0;
+}
+
+static int
+gz_skip(FILE_T state, gint64 len)
+{
+    guint n;
 
     /* skip over len bytes or reach end-of-file, whichever comes first */
     while (len)
@@ -923,9 +2139,7 @@ file_fdopen(int fd)
      * being 8K, or APFS, where st_blksize is big on at least some
      * versions of macOS).
      */
-#ifdef _STATBUF_ST_BLKSIZE
     ws_statb64 st;
-#endif
     int want = GZBUFSIZE;
     FILE_T state;
 
@@ -969,6 +2183,15 @@ file_fdopen(int fd)
     }
 #endif
 
+    /*
+     * Read ahead of regular files only; a thread reading ahead of a
+     * pipe could be stuck waiting for data when we're closed.
+     */
+    if (read_ahead_chunks != 0 && ws_fstat64(fd, &st) >= 0 &&
+        S_ISREG(st.st_mode))
+        state->read_ahead = read_ahead_chunks;
+    state->inflate_threads = inflate_thread_count;
+
     /* allocate buffers */
     state->in.buf = (unsigned char *)g_try_malloc((gsize)want);
     state->in.next = state->in.buf;
@@ -1035,6 +2258,10 @@ file_open(const char *path)
         return NULL;
     }
 
+#ifdef HAVE_MMAP
+    map_file(ft);
+#endif
+
 #ifdef HAVE_ZLIB
     /*
      * If this file's name ends in ".caz", it's probably a compressed
@@ -1060,9 +2287,481 @@ file_open(const char *path)
 }
 
 void
-file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek)
 {
     stream->fast_seek = seek;
+
+    /* Reading ahead of random reads would be wasted, as would inflating
+       ahead of them. */
+    if (random_flag) {
+        read_ahead_stop(stream);
+        stream->read_ahead = 0;
+        stream->inflate_threads = 0;
+    }
+}
+
+void
+wtap_set_write_gzip_index(gboolean write)
+{
+    write_gzip_index = write;
+}
+
+void
+wtap_set_inflate_threads(guint threads)
+{
+    inflate_thread_count = threads;
+}
+
+gboolean
+file_gzip_index_to_write(void)
+{
+    return write_gzip_index;
+}
+
+/*
+ * Points are only worth keeping for a file that isn't read at random if
+ * they're to be written to its index, or if it has an index that can be
+ * used to inflate it in parallel.
+ */
+gboolean
+file_gzip_index_wanted(const char *path)
+{
+    gchar *index_path;
+    ws_statb64 statb;
+    gboolean exists;
+
+    if (write_gzip_index)
+        return TRUE;
+    if (inflate_thread_count == 0)
+        return FALSE;
+    index_path = g_strconcat(path, GZIP_INDEX_SUFFIX, NULL);
+    exists = ws_stat64(index_path, &statb) == 0;
+    g_free(index_path);
+    return exists;
+}
+
+#ifdef HAVE_ZLIB
+/*
+ * A gzip index is a "<capture file>.gzidx" file holding the fast seek
+ * points of a gzip-compressed file, found when it was last read to the
+ * end, so that it can be read from anywhere in it, or inflated in
+ * parallel, as soon as it's opened again.  It's tied to the capture file
+ * by the file's size, its modification time and a hash of its beginning,
+ * and is ignored if any of those don't match.
+ *
+ * All values are little-endian.  Header:
+ *
+ *     0  magic number
+ *     8  version
+ *    12  number of points
+ *    16  size of the capture file
+ *    24  modification time of the capture file, in seconds
+ *    32  SHA-256 hash of the beginning of the capture file
+ *    64  length of the uncompressed data
+ *    72  reserved
+ *
+ * followed by the points:
+ *
+ *     0  offset in the uncompressed data
+ *     8  offset in the capture file
+ *    16  type of point (GZIP_INDEX_ value)
+ *    20  number of bits of the byte before that offset that are still
+ *        to be inflated
+ *    24  CRC of the gzip member's data up to the point
+ *    28  length of the gzip member's data up to the point
+ *    32  length of the window that follows, compressed with zlib, or 0
+ */
+#define GZIP_INDEX_VERSION      1
+#define GZIP_INDEX_HEADER_SIZE  80
+#define GZIP_INDEX_POINT_SIZE   36
+
+#define GZIP_INDEX_MEMBER       0       /* start of a gzip member's data */
+#define GZIP_INDEX_DEFLATE      1       /* within a deflate stream */
+#define GZIP_INDEX_UNCOMPRESSED 2       /* uncompressed data */
+
+#define GZIP_INDEX_HASH_SIZE    32      /* SHA-256 */
+#define GZIP_INDEX_HASH_LEN     65536   /* bytes of the file hashed */
+
+static const guint8 gzip_index_magic[8] = { 0x89, 'W', 'S', 'G', 'Z', 'I', '\r', '\n' };
+
+/*
+ * Get what ties an index to the capture file: the file's size, its
+ * modification time and a SHA-256 hash of its first GZIP_INDEX_HASH_LEN
+ * bytes.
+ */
+static gboolean
+gzip_index_file_identity(const char *filename, guint64 *size, gint64 *mtime,
+                         guint8 hash[GZIP_INDEX_HASH_SIZE], int *err)
+{
+    ws_statb64  statb;
+    FILE       *fh;
+    guint8     *buf;
+    size_t      nread;
+    GChecksum  *checksum;
+    gsize       hash_len = GZIP_INDEX_HASH_SIZE;
+
+    if (ws_stat64(filename, &statb) != 0) {
+        *err = errno;
+        return FALSE;
+    }
+    *size = (guint64)statb.st_size;
+    *mtime = (gint64)statb.st_mtime;
+
+    fh = ws_fopen(filename, "rb");
+    if (fh == NULL) {
+        *err = errno;
+        return FALSE;
+    }
+    buf = (guint8 *)g_malloc(GZIP_INDEX_HASH_LEN);
+    nread = fread(buf, 1, GZIP_INDEX_HASH_LEN, fh);
+    if (ferror(fh)) {
+        *err = errno;
+        g_free(buf);
+        fclose(fh);
+        return FALSE;
+    }
+    fclose(fh);
+
+    checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    g_checksum_update(checksum, buf, nread);
+    g_checksum_get_digest(checksum, hash, &hash_len);
+    g_checksum_free(checksum);
+    g_free(buf);
+    return TRUE;
+}
+#endif /* HAVE_ZLIB */
+
+gboolean
+file_read_gzip_index(FILE_T stream, const char *path)
+{
+#ifdef HAVE_ZLIB
+    gchar *index_path;
+    FILE *fh;
+    guint8 header[GZIP_INDEX_HEADER_SIZE];
+    guint8 entry[GZIP_INDEX_POINT_SIZE];
+    guint8 hash[GZIP_INDEX_HASH_SIZE];
+    guint8 *window = NULL;
+    guint64 size;
+    gint64 mtime, out, in, prev_out = -1;
+    guint32 count, i, bits, window_len;
+    uLongf window_size;
+    struct fast_seek_point *point;
+    struct zlib_fast_seek_point *zpoint;
+    int err;
+
+    g_free(stream->index_path);
+    stream->index_path = g_strdup(path);
+    if (stream->fast_seek == NULL || stream->fast_seek->len != 0)
+        return FALSE;
+
+    index_path = g_strconcat(path, GZIP_INDEX_SUFFIX, NULL);
+    fh = ws_fopen(index_path, "rb");
+    g_free(index_path);
+    if (fh == NULL)
+        return FALSE;
+
+    /* Is it an index, and is it still the file we indexed? */
+    if (fread(header, 1, sizeof header, fh) != sizeof header ||
+        memcmp(header, gzip_index_magic, sizeof gzip_index_magic) != 0 ||
+        pletoh32(&header[8]) != GZIP_INDEX_VERSION ||
+        !gzip_index_file_identity(path, &size, &mtime, hash, &err) ||
+        pletoh64(&header[16]) != size ||
+        (gint64)pletoh64(&header[24]) != mtime ||
+        memcmp(&header[32], hash, GZIP_INDEX_HASH_SIZE) != 0) {
+        fclose(fh);
+        return FALSE;
+    }
+
+    count = pletoh32(&header[12]);
+    window = (guint8 *)g_malloc(compressBound(ZLIB_WINSIZE));
+    for (i = 0; i < count; i++) {
+        if (fread(entry, 1, sizeof entry, fh) != sizeof entry)
+            goto invalid;
+        out = (gint64)pletoh64(&entry[0]);
+        in = (gint64)pletoh64(&entry[8]);
+        bits = pletoh32(&entry[20]);
+        window_len = pletoh32(&entry[32]);
+        if (out <= prev_out || in < 0 || bits > 7)
+            goto invalid;
+        prev_out = out;
+
+        switch (pletoh32(&entry[16])) {
+
+        case GZIP_INDEX_MEMBER:
+        case GZIP_INDEX_UNCOMPRESSED:
+            if (window_len != 0)
+                goto invalid;
+            point = g_new(struct fast_seek_point, 1);
+            point->compression = pletoh32(&entry[16]) == GZIP_INDEX_MEMBER ?
+                GZIP_AFTER_HEADER : UNCOMPRESSED;
+            break;
+
+        case GZIP_INDEX_DEFLATE:
+            if (window_len > compressBound(ZLIB_WINSIZE) ||
+                fread(window, 1, window_len, fh) != window_len)
+                goto invalid;
+#ifndef HAVE_INFLATEPRIME
+            /* we can't start from here */
+            if (bits != 0)
+                continue;
+#endif
+            zpoint = g_new(struct zlib_fast_seek_point, 1);
+            window_size = ZLIB_WINSIZE;
+            if (uncompress(zpoint->window, &window_size, window, window_len) != Z_OK ||
+                window_size != ZLIB_WINSIZE) {
+                g_free(zpoint);
+                goto invalid;
+            }
+#ifdef HAVE_INFLATEPRIME
+            zpoint->bits = bits;
+#endif
+            zpoint->adler = pletoh32(&entry[24]);
+            zpoint->total_out = pletoh32(&entry[28]);
+            point = &zpoint->point;
+            point->compression = ZLIB;
+            break;
+
+        default:
+            goto invalid;
+        }
+        point->out = out;
+        point->in = in;
+        g_ptr_array_add(stream->fast_seek, point);
+    }
+    if ((gint64)pletoh64(&header[64]) < prev_out)
+        goto invalid;
+
+    stream->index_out_size = (gint64)pletoh64(&header[64]);
+    g_free(window);
+    fclose(fh);
+    return TRUE;
+
+invalid:
+    /* use none of it */
+    for (i = 0; i < stream->fast_seek->len; i++)
+        g_free(stream->fast_seek->pdata[i]);
+    g_ptr_array_set_size(stream->fast_seek, 0);
+    g_free(window);
+    fclose(fh);
+    return FALSE;
+#else
+    g_free(stream->index_path);
+    stream->index_path = g_strdup(path);
+    return FALSE;
+#endif
+}
+
+void
+file_write_gzip_index(
+#ifdef HAVE_ZLIB
+    FILE_T stream)
+#else
+    FILE_T stream _U_)
+#endif
+{
+#ifdef HAVE_ZLIB
+    gchar *index_path, *tmp_path;
+    FILE *fh;
+    guint8 header[GZIP_INDEX_HEADER_SIZE];
+    guint8 entry[GZIP_INDEX_POINT_SIZE];
+    guint8 *window;
+    uLongf window_len;
+    guint64 size;
+    gint64 mtime;
+    struct fast_seek_point *point;
+    struct zlib_fast_seek_point *zpoint;
+    guint i;
+    int err;
+    gboolean ok;
+
+    /*
+     * Only for a gzip file that doesn't have an index and that we've
+     * read to the end, so that we have all of its points.
+     */
+    if (!write_gzip_index || stream->index_path == NULL ||
+        stream->fast_seek == NULL || stream->fast_seek->len == 0 ||
+        stream->index_out_size != 0 ||
+        file_get_compression_type(stream) != WTAP_GZIP_COMPRESSED ||
+        !stream->eof || stream->in.avail != 0 || stream->out.avail != 0 ||
+        stream->err != 0 || stream->seek_pending)
+        return;
+
+    /* written to a temporary file first, as with record indexes */
+    tmp_path = g_strconcat(stream->index_path, GZIP_INDEX_SUFFIX, ".tmp", NULL);
+    fh = ws_fopen(tmp_path, "wb");
+    if (fh == NULL) {
+        g_free(tmp_path);
+        return;
+    }
+
+    memset(header, 0, sizeof header);
+    memcpy(header, gzip_index_magic, sizeof gzip_index_magic);
+    phtole32(&header[8], GZIP_INDEX_VERSION);
+    phtole32(&header[12], stream->fast_seek->len);
+    ok = gzip_index_file_identity(stream->index_path, &size, &mtime,
+                                  &header[32], &err);
+    phtole64(&header[16], size);
+    phtole64(&header[24], (guint64)mtime);
+    phtole64(&header[64], (guint64)stream->pos);
+    ok = ok && fwrite(header, 1, sizeof header, fh) == sizeof header;
+
+    window = (guint8 *)g_malloc(compressBound(ZLIB_WINSIZE));
+    for (i = 0; ok && i < stream->fast_seek->len; i++) {
+        point = (struct fast_seek_point *)stream->fast_seek->pdata[i];
+        memset(entry, 0, sizeof entry);
+        phtole64(&entry[0], (guint64)point->out);
+        phtole64(&entry[8], (guint64)point->in);
+        window_len = 0;
+        if (point->compression == ZLIB) {
+            zpoint = (struct zlib_fast_seek_point *)point;
+            phtole32(&entry[16], GZIP_INDEX_DEFLATE);
+#ifdef HAVE_INFLATEPRIME
+            phtole32(&entry[20], zpoint->bits);
+#endif
+            phtole32(&entry[24], zpoint->adler);
+            phtole32(&entry[28], zpoint->total_out);
+            window_len = compressBound(ZLIB_WINSIZE);
+            ok = compress(window, &window_len, zpoint->window, ZLIB_WINSIZE) == Z_OK;
+        } else if (point->compression == GZIP_AFTER_HEADER) {
+            phtole32(&entry[16], GZIP_INDEX_MEMBER);
+        } else if (point->compression == UNCOMPRESSED) {
+            phtole32(&entry[16], GZIP_INDEX_UNCOMPRESSED);
+        } else {
+            /* not a gzip file after all */
+            ok = FALSE;
+        }
+        phtole32(&entry[32], (guint32)window_len);
+        ok = ok && fwrite(entry, 1, sizeof entry, fh) == sizeof entry &&
+            fwrite(window, 1, window_len, fh) == window_len;
+    }
+    g_free(window);
+
+    if (fclose(fh) == EOF)
+        ok = FALSE;
+    if (ok) {
+        index_path = g_strconcat(stream->index_path, GZIP_INDEX_SUFFIX, NULL);
+        /* rename() doesn't replace an existing file on Windows. */
+        ws_unlink(index_path);
+        ok = ws_rename(tmp_path, index_path) == 0;
+        g_free(index_path);
+    }
+    if (!ok)
+        ws_unlink(tmp_path);
+    g_free(tmp_path);
+
+    /* one's enough */
+    stream->index_out_size = stream->pos;
+#endif
+}
+
+/*
+ * Seek to offset from the current position, starting at the fast seek
+ * point here, at or before it.
+ */
+static gint64
+fast_seek_to(FILE_T file, struct fast_seek_point *here, gint64 offset, int *err)
+{
+    gint64 off, off2;
+
+#ifdef HAVE_ZLIB
+    if (here->compression == ZLIB) {
+#ifdef HAVE_INFLATEPRIME
+        off = here->in - (((struct zlib_fast_seek_point *)here)->bits ? 1 : 0);
+#else
+        off = here->in;
+#endif
+        off2 = here->out;
+    } else
+#endif
+    if (here->compression == UNCOMPRESSED) {
+        off2 = (file->pos + offset);
+        off = here->in + (off2 - here->out);
+    } else {
+        /* start of a gzip member, or of a zstd or lz4 frame */
+        off = here->in;
+        off2 = here->out;
+    }
+
+    parallel_inflate_stop(file);
+    if (read_ahead_stop(file) == -1 ||
+        ws_lseek64(file->fd, off, SEEK_SET) == -1) {
+        *err = errno;
+        return -1;
+    }
+    fast_seek_reset(file);
+
+    file->raw_pos = off;
+    buf_reset(&file->out);
+    file->eof = FALSE;
+    file->seek_pending = FALSE;
+    file->err = 0;
+    file->err_info = NULL;
+    buf_reset(&file->in);
+
+#ifdef HAVE_ZLIB
+    if (here->compression == ZLIB) {
+        struct zlib_fast_seek_point *point = (struct zlib_fast_seek_point *)here;
+        z_stream *strm = &file->strm;
+
+        inflateReset(strm);
+        strm->adler = point->adler;
+        strm->total_out = point->total_out;
+#ifdef HAVE_INFLATEPRIME
+        if (point->bits) {
+            FILE_T state = file;
+            int ret = GZ_GETC();
+
+            if (ret == -1) {
+                if (state->err == 0) {
+                    /* EOF */
+                    *err = WTAP_ERR_SHORT_READ;
+                } else
+                    *err = state->err;
+                return -1;
+            }
+            (void)inflatePrime(strm, point->bits, ret >> (8 - point->bits));
+        }
+#endif
+        (void)inflateSetDictionary(strm, point->window, ZLIB_WINSIZE);
+        file->compression = ZLIB;
+    } else if (here->compression == GZIP_AFTER_HEADER) {
+        z_stream *strm = &file->strm;
+
+        inflateReset(strm);
+        strm->adler = crc32(0L, Z_NULL, 0);
+        file->compression = ZLIB;
+    } else
+#endif
+#ifdef HAVE_ZSTD
+    if (here->compression == ZSTD) {
+        if (zstd_reset(file) == -1) {
+            *err = file->err;
+            return -1;
+        }
+    } else
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    if (here->compression == LZ4) {
+        if (lz4_reset(file) == -1) {
+            *err = file->err;
+            return -1;
+        }
+    } else
+#endif
+        file->compression = here->compression;
+
+    offset = (file->pos + offset) - off2;
+    file->pos = off2;
+    /* g_print("OK! %ld\n", offset); */
+
+    if (offset) {
+        /* Don't skip forward yet, wait until we want to read from
+           the file; that way, if we do multiple seeks in a row,
+           all involving forward skips, they will be combined. */
+        file->seek_pending = TRUE;
+        file->skip = offset;
+    }
+    return file->pos + offset;
 }
 
 gint64
@@ -1093,19 +2792,49 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
             *err = file->err;
             return -1;
         }
-        if (offset == 0) {
-            /* We are done */
-            return file->pos;
-        }
-    } else if (whence == SEEK_SET)
-        offset -= file->pos;
-    else if (file->seek_pending) {
-        /* There's a forward-skip pending, so file->pos doesn't reflect
-           the actual file position, it represents the position from
-           which we're skipping; update the offset to include that. */
-        offset += file->skip;
+        if (offset == 0) {
+            /* We are done */
+            return file->pos;
+        }
+    } else if (whence == SEEK_SET)
+        offset -= file->pos;
+    else if (file->seek_pending) {
+        /* There's a forward-skip pending, so file->pos doesn't reflect
+           the actual file position, it represents the position from
+           which we're skipping; update the offset to include that. */
+        offset += file->skip;
+    }
+    file->seek_pending = FALSE;
+
+#ifdef HAVE_MMAP
+    /*
+     * If the file is mapped, it's not compressed; if we're seeking within
+     * the mapping, just move there, otherwise seek there in the file.
+     */
+    if (file->map_size != 0) {
+        if (file->pos + offset < 0) {
+            *err = EINVAL;
+            return -1;
+        }
+        file->err = 0;
+        file->err_info = NULL;
+        if (file->pos + offset <= file->map_size) {
+            file->pos += offset;
+            map_out_buffer(file);
+            return file->pos;
+        }
+        /* skip forward from the end of the mapping when we next read */
+        file->skip = file->pos + offset - file->map_size;
+        file->pos = file->map_size;
+        if (map_leave(file) == -1) {
+            *err = file->err;
+            return -1;
+        }
+        file->eof = FALSE;
+        file->seek_pending = TRUE;
+        return file->pos + file->skip;
     }
-    file->seek_pending = FALSE;
+#endif
 
     /*
      * Are we moving at all?
@@ -1178,94 +2907,15 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
      * XXX, profile
      */
     if ((here = fast_seek_find(file, file->pos + offset)) &&
-        (offset < 0 || offset > SPAN || here->compression == UNCOMPRESSED)) {
-        gint64 off, off2;
-
+        (offset < 0 || offset > SPAN || here->compression == UNCOMPRESSED ||
+         (fast_seek_at_frame(here) && here->out > file->pos))) {
         /*
          * Yes.  Use that data to do the seek.
          * Note that this will be true only if file_set_random_access()
          * has been called on this file, which should never be the case
          * for a pipe.
          */
-#ifdef HAVE_ZLIB
-        if (here->compression == ZLIB) {
-#ifdef HAVE_INFLATEPRIME
-            off = here->in - (here->data.zlib.bits ? 1 : 0);
-#else
-            off = here->in;
-#endif
-            off2 = here->out;
-        } else if (here->compression == GZIP_AFTER_HEADER) {
-            off = here->in;
-            off2 = here->out;
-        } else
-#endif
-        {
-            off2 = (file->pos + offset);
-            off = here->in + (off2 - here->out);
-        }
-
-        if (ws_lseek64(file->fd, off, SEEK_SET) == -1) {
-            *err = errno;
-            return -1;
-        }
-        fast_seek_reset(file);
-
-        file->raw_pos = off;
-        buf_reset(&file->out);
-        file->eof = FALSE;
-        file->seek_pending = FALSE;
-        file->err = 0;
-        file->err_info = NULL;
-        buf_reset(&file->in);
-
-#ifdef HAVE_ZLIB
-        if (here->compression == ZLIB) {
-            z_stream *strm = &file->strm;
-
-            inflateReset(strm);
-            strm->adler = here->data.zlib.adler;
-            strm->total_out = here->data.zlib.total_out;
-#ifdef HAVE_INFLATEPRIME
-            if (here->data.zlib.bits) {
-                FILE_T state = file;
-                int ret = GZ_GETC();
-
-                if (ret == -1) {
-                    if (state->err == 0) {
-                        /* EOF */
-                        *err = WTAP_ERR_SHORT_READ;
-                    } else
-                        *err = state->err;
-                    return -1;
-                }
-                (void)inflatePrime(strm, here->data.zlib.bits, ret >> (8 - here->data.zlib.bits));
-            }
-#endif
-            (void)inflateSetDictionary(strm, here->data.zlib.window, ZLIB_WINSIZE);
-            file->compression = ZLIB;
-        } else if (here->compression == GZIP_AFTER_HEADER) {
-            z_stream *strm = &file->strm;
-
-            inflateReset(strm);
-            strm->adler = crc32(0L, Z_NULL, 0);
-            file->compression = ZLIB;
-        } else
-#endif
-            file->compression = here->compression;
-
-        offset = (file->pos + offset) - off2;
-        file->pos = off2;
-        /* g_print("OK! %ld\n", offset); */
-
-        if (offset) {
-            /* Don't skip forward yet, wait until we want to read from
-               the file; that way, if we do multiple seeks in a row,
-               all involving forward skips, they will be combined. */
-            file->seek_pending = TRUE;
-            file->skip = offset;
-        }
-        return file->pos + offset;
+        return fast_seek_to(file, here, offset, err);
     }
 
     /*
@@ -1285,7 +2935,8 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /*
          * Yes.  Just seek there within the file.
          */
-        if (ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
+        if (read_ahead_stop(file) == -1 ||
+            ws_lseek64(file->fd, offset - file->out.avail, SEEK_CUR) == -1) {
             *err = errno;
             return -1;
         }
@@ -1319,7 +2970,9 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
         /* rewind, then skip to offset */
 
         /* back up and start over */
-        if (ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
+        parallel_inflate_stop(file);
+        if (read_ahead_stop(file) == -1 ||
+            ws_lseek64(file->fd, file->start, SEEK_SET) == -1) {
             *err = errno;
             return -1;
         }
@@ -1361,6 +3014,14 @@ file_tell(FILE_T stream)
 gint64
 file_tell_raw(FILE_T stream)
 {
+#ifdef HAVE_MMAP
+    /*
+     * While the output buffer is in the mapping, only what has been
+     * consumed from it has been read from the file.
+     */
+    if (stream->out_buf != NULL)
+        return stream->start + stream->pos;
+#endif
     return stream->raw_pos;
 }
 
@@ -1381,6 +3042,12 @@ file_iscompressed(FILE_T stream)
     return stream->is_compressed;
 }
 
+wtap_compression_type
+file_get_compression_type(FILE_T stream)
+{
+    return stream->is_compressed ? stream->compression_type : WTAP_UNCOMPRESSED;
+}
+
 int
 file_read(void *buf, unsigned int len, FILE_T file)
 {
@@ -1442,6 +3109,41 @@ file_read(void *buf, unsigned int len, FILE_T file)
     return (int)got;
 }
 
+/*
+ * Reads len bytes without copying them, if they're in a memory mapping of
+ * the file; returns a pointer to them, valid until the file is closed, or
+ * NULL if they have to be read with file_read().
+ */
+#ifdef HAVE_MMAP
+const guint8 *
+file_read_ptr(FILE_T file, unsigned int len)
+{
+    const guint8 *ptr;
+
+    if (file->map_size == 0 || file->seek_pending || file->err != 0 ||
+        file->pos + len > file->map_size)
+        return NULL;
+
+    /* make sure the window has all of it */
+    if (file->out_buf == NULL || file->out.avail < len)
+        map_out_buffer(file);
+    if (file->out.avail < len)
+        return NULL;
+
+    ptr = file->out.next;
+    file->out.next += len;
+    file->out.avail -= len;
+    file->pos += len;
+    return ptr;
+}
+#else
+const guint8 *
+file_read_ptr(FILE_T file _U_, unsigned int len _U_)
+{
+    return NULL;
+}
+#endif
+
 /*
  * XXX - this *peeks* at next byte, not a character.
  */
@@ -1624,6 +3326,8 @@ file_clearerr(FILE_T stream)
 void
 file_fdclose(FILE_T file)
 {
+    parallel_inflate_stop(file);
+    read_ahead_stop(file);
     ws_close(file->fd);
     file->fd = -1;
 }
@@ -1636,6 +3340,19 @@ file_fdreopen(FILE_T file, const char *path)
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
     file->fd = fd;
+#ifdef HAVE_MMAP
+    /*
+     * Read the new file from its descriptor; the old mapping is kept
+     * until we're closed, as data that was read from it may still be
+     * in use.
+     */
+    if (map_leave(file) == -1) {
+        file->fd = -1;
+        ws_close(fd);
+        return FALSE;
+    }
+    file->map_size = 0;
+#endif
     return TRUE;
 }
 
@@ -1644,15 +3361,33 @@ file_close(FILE_T file)
 {
     int fd = file->fd;
 
+    parallel_inflate_stop(file);
+    read_ahead_stop(file);
+
+#ifdef HAVE_MMAP
+    if (file->out_buf != NULL)
+        file->out.buf = file->out_buf;
+    if (file->map != NULL)
+        munmap(file->map - file->start, file->map_len);
+#endif
+
     /* free memory and close file */
     if (file->size) {
 #ifdef HAVE_ZLIB
         inflateEnd(&(file->strm));
+#endif
+#ifdef HAVE_ZSTD
+        ZSTD_freeDStream(file->zstd);
+#endif
+#ifdef HAVE_LZ4FRAME_H
+        if (file->lz4 != NULL)
+            LZ4F_freeDecompressionContext(file->lz4);
 #endif
         g_free(file->out.buf);
         g_free(file->in.buf);
     }
     g_free(file->fast_seek_cur);
+    g_free(file->index_path);
     file->err = 0;
     file->err_info = NULL;
     g_free(file);
@@ -1954,6 +3689,364 @@ gzwfile_geterr(GZWFILE_T state)
 }
 #endif
 
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+/*
+ * Writing zstd or lz4: the data is compressed in frames of up to
+ * FRAME_SIZE bytes, each of which can be decompressed without the ones
+ * before it, and a zstd file ends with a seek table in the zstd seekable
+ * format, listing the frames.  Flushing ends the current frame early.
+ */
+#define FRAME_SIZE (1024 * 1024)
+
+#define ZSTD_WRITE_LEVEL 3      /* zstd's default */
+
+/* internal zstd or lz4 file state data structure for writing */
+struct wtap_frame_writer {
+    int fd;                     /* file descriptor */
+    wtap_compression_type type; /* WTAP_ZSTD_COMPRESSED or WTAP_LZ4_COMPRESSED */
+    unsigned char *in;          /* data for the current frame */
+    guint have;                 /* number of bytes of it */
+    unsigned char *out;         /* compressed frame */
+    size_t out_size;            /* size of the buffer for it */
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *zstd;            /* zstd compression context */
+    GArray *seek_table;         /* compressed and decompressed size of each frame */
+#endif
+    int err;                    /* error code */
+    const char *err_info;       /* additional error information string for some errors */
+};
+
+FRAMEWFILE_T
+framewfile_open(const char *path, wtap_compression_type type)
+{
+    int fd;
+    FRAMEWFILE_T state;
+    int save_errno;
+
+    fd = ws_open(path, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666);
+    if (fd == -1)
+        return NULL;
+    state = framewfile_fdopen(fd, type);
+    if (state == NULL) {
+        save_errno = errno;
+        ws_close(fd);
+        errno = save_errno;
+    }
+    return state;
+}
+
+static void
+framewfile_free(FRAMEWFILE_T state)
+{
+#ifdef HAVE_ZSTD
+    if (state->zstd != NULL)
+        ZSTD_freeCCtx(state->zstd);
+    if (state->seek_table != NULL)
+        g_array_free(state->seek_table, TRUE);
+#endif
+    g_free(state->out);
+    g_free(state->in);
+    g_free(state);
+}
+
+FRAMEWFILE_T
+framewfile_fdopen(int fd, wtap_compression_type type)
+{
+    FRAMEWFILE_T state;
+
+    /* allocate wtap_frame_writer structure to return */
+    state = g_new0(struct wtap_frame_writer, 1);
+    state->fd = fd;
+    state->type = type;
+
+    switch (type) {
+#ifdef HAVE_ZSTD
+    case WTAP_ZSTD_COMPRESSED:
+        state->zstd = ZSTD_createCCtx();
+        state->seek_table = g_array_new(FALSE, FALSE, sizeof(guint32));
+        state->out_size = ZSTD_compressBound(FRAME_SIZE);
+        break;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    case WTAP_LZ4_COMPRESSED:
+        state->out_size = LZ4F_compressFrameBound(FRAME_SIZE, NULL);
+        break;
+#endif
+    default:
+        g_free(state);
+        errno = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+        return NULL;
+    }
+
+    state->in = (unsigned char *)g_try_malloc(FRAME_SIZE);
+    state->out = (unsigned char *)g_try_malloc(state->out_size);
+    if (state->in == NULL || state->out == NULL
+#ifdef HAVE_ZSTD
+        || (type == WTAP_ZSTD_COMPRESSED && state->zstd == NULL)
+#endif
+        ) {
+        framewfile_free(state);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    /* return stream */
+    return state;
+}
+
+/* Write out len bytes from buf, or fail. */
+static int
+frame_write(FRAMEWFILE_T state, const void *buf, size_t len)
+{
+    ssize_t got;
+
+    got = ws_write(state->fd, buf, (unsigned int)len);
+    if (got < 0) {
+        state->err = errno;
+        return -1;
+    }
+    if ((size_t)got != len) {
+        state->err = WTAP_ERR_SHORT_WRITE;
+        return -1;
+    }
+    return 0;
+}
+
+/* Compress the data for the current frame, if any, and write the frame
+   out.  Return -1, and set state->err and possibly state->err_info, on
+   failure; return 0 on success. */
+static int
+frame_comp(FRAMEWFILE_T state)
+{
+    size_t len;
+
+    if (state->have == 0)
+        return 0;
+
+    switch (state->type) {
+#ifdef HAVE_ZSTD
+    case WTAP_ZSTD_COMPRESSED:
+        len = ZSTD_compressCCtx(state->zstd, state->out, state->out_size,
+                                state->in, state->have, ZSTD_WRITE_LEVEL);
+        if (ZSTD_isError(len)) {
+            state->err = WTAP_ERR_INTERNAL;
+            state->err_info = ZSTD_getErrorName(len);
+            return -1;
+        }
+        break;
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    case WTAP_LZ4_COMPRESSED:
+        len = LZ4F_compressFrame(state->out, state->out_size,
+                                 state->in, state->have, NULL);
+        if (LZ4F_isError(len)) {
+            state->err = WTAP_ERR_INTERNAL;
+            state->err_info = LZ4F_getErrorName(len);
+            return -1;
+        }
+        break;
+#endif
+    default:
+        state->err = WTAP_ERR_INTERNAL;
+        state->err_info = "unknown compression type";
+        return -1;
+    }
+
+    if (frame_write(state, state->out, len) == -1)
+        return -1;
+#ifdef HAVE_ZSTD
+    if (state->seek_table != NULL) {
+        guint32 sizes[2];
+
+        sizes[0] = (guint32)len;
+        sizes[1] = state->have;
+        g_array_append_vals(state->seek_table, sizes, 2);
+    }
+#endif
+    state->have = 0;
+    return 0;
+}
+
+#ifdef HAVE_ZSTD
+/* Write the seek table, in a skippable frame, after the last frame. */
+static int
+zstd_write_seek_table(FRAMEWFILE_T state)
+{
+    guint frames = state->seek_table->len / 2;
+    guint8 *table, *p;
+    gsize len;
+    guint i;
+    int ret;
+
+    len = 8 + (gsize)frames * 8 + ZSTD_SEEK_TABLE_FOOTER_SIZE;
+    table = (guint8 *)g_malloc(len);
+    phtole32(table, ZSTD_SKIPPABLE_MAGIC);
+    phtole32(table + 4, (guint32)(len - 8));
+    for (i = 0, p = table + 8; i < frames; i++, p += 8) {
+        phtole32(p, g_array_index(state->seek_table, guint32, 2 * i));
+        phtole32(p + 4, g_array_index(state->seek_table, guint32, 2 * i + 1));
+    }
+    phtole32(p, frames);
+    p[4] = 0;                   /* no checksums */
+    phtole32(p + 5, ZSTD_SEEKABLE_MAGIC);
+
+    ret = frame_write(state, table, len);
+    g_free(table);
+    return ret;
+}
+#endif
+
+/* Write out len bytes from buf.  Return 0, and set state->err, on
+   failure or on an attempt to write 0 bytes (in which case state->err
+   is 0); return the number of bytes written on success. */
+guint
+framewfile_write(FRAMEWFILE_T state, const void *buf, guint len)
+{
+    guint put = len;
+    guint n;
+
+    /* check that there's no error */
+    if (state->err != 0)
+        return 0;
+
+    /* if len is zero, avoid unnecessary operations */
+    if (len == 0)
+        return 0;
+
+    /* copy to the frame, compress when full */
+    do {
+        n = FRAME_SIZE - state->have;
+        if (n > len)
+            n = len;
+        memcpy(state->in + state->have, buf, n);
+        state->have += n;
+        buf = (const char *)buf + n;
+        len -= n;
+        if (state->have == FRAME_SIZE && frame_comp(state) == -1)
+            return 0;
+    } while (len);
+
+    return put;
+}
+
+/* Flush out what we've written so far, ending the current frame.  Returns
+   -1, and sets state->err, on failure; returns 0 on success. */
+int
+framewfile_flush(FRAMEWFILE_T state)
+{
+    /* check that there's no error */
+    if (state->err != 0)
+        return -1;
+
+    return frame_comp(state);
+}
+
+/* Flush out all data written, and close the file.  Returns a Wiretap
+   error on failure; returns 0 on success. */
+int
+framewfile_close(FRAMEWFILE_T state)
+{
+    int ret = 0;
+
+    if (state->err != 0 || frame_comp(state) == -1)
+        ret = state->err;
+#ifdef HAVE_ZSTD
+    if (ret == 0 && state->seek_table != NULL &&
+        zstd_write_seek_table(state) == -1)
+        ret = state->err;
+#endif
+    if (ws_close(state->fd) == -1 && ret == 0)
+        ret = errno;
+    framewfile_free(state);
+    return ret;
+}
+
+int
+framewfile_geterr(FRAMEWFILE_T state)
+{
+    return state->err;
+}
+#endif /* HAVE_ZSTD || HAVE_LZ4FRAME_H */
+
+#define COMPRESS_FD_READ_SIZE 65536
+
+gboolean
+wtap_compress_fd(int in_fd, int out_fd, wtap_compression_type compression_type,
+                 int *err)
+{
+    guint8 *buf;
+    ssize_t nread = 0;
+    int ret = 0;
+
+    switch (compression_type) {
+#ifdef HAVE_ZLIB
+    case WTAP_GZIP_COMPRESSED:
+    {
+        GZWFILE_T gz = gzwfile_fdopen(out_fd);
+        int close_ret;
+
+        if (gz == NULL) {
+            *err = errno;
+            ws_close(out_fd);
+            return FALSE;
+        }
+        buf = (guint8 *)g_malloc(COMPRESS_FD_READ_SIZE);
+        while ((nread = ws_read(in_fd, buf, COMPRESS_FD_READ_SIZE)) > 0) {
+            if (gzwfile_write(gz, buf, (guint)nread) != (guint)nread)
+                break;
+        }
+        if (nread < 0)
+            ret = errno;
+        close_ret = gzwfile_close(gz);
+        if (ret == 0)
+            ret = close_ret;
+        g_free(buf);
+        break;
+    }
+#endif
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4FRAME_H)
+#ifdef HAVE_ZSTD
+    case WTAP_ZSTD_COMPRESSED:
+#endif
+#ifdef HAVE_LZ4FRAME_H
+    case WTAP_LZ4_COMPRESSED:
+#endif
+    {
+        FRAMEWFILE_T frame = framewfile_fdopen(out_fd, compression_type);
+        int close_ret;
+
+        if (frame == NULL) {
+            *err = errno;
+            ws_close(out_fd);
+            return FALSE;
+        }
+        buf = (guint8 *)g_malloc(COMPRESS_FD_READ_SIZE);
+        while ((nread = ws_read(in_fd, buf, COMPRESS_FD_READ_SIZE)) > 0) {
+            if (framewfile_write(frame, buf, (guint)nread) != (guint)nread)
+                break;
+        }
+        if (nread < 0)
+            ret = errno;
+        close_ret = framewfile_close(frame);
+        if (ret == 0)
+            ret = close_ret;
+        g_free(buf);
+        break;
+    }
+#endif
+    default:
+        ws_close(out_fd);
+        *err = WTAP_ERR_COMPRESSION_NOT_SUPPORTED;
+        return FALSE;
+    }
+
+    if (ret != 0) {
+        *err = ret;
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
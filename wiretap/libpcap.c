@@ -852,11 +852,22 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.caplen = packet_size;
 	rec->rec_header.packet_header.len = orig_size;
 
+	if (wth->metadata_only && fh == wth->fh) {
+		/* The data won't be looked at; just get past it. */
+		return wtap_skip_packet_bytes(fh, packet_size, err, err_info);
+	}
+
 	/*
-	 * Read the packet data.
+	 * Read the packet data, in place if it's memory-mapped and we
+	 * don't modify it.
 	 */
-	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
-		return FALSE;	/* failed */
+	if (pcap_read_post_process_modifies(wth->file_encap, libpcap->byte_swapped)) {
+		if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
+			return FALSE;	/* failed */
+	} else {
+		if (!wtap_read_packet_bytes_nocopy(fh, buf, packet_size, err, err_info))
+			return FALSE;	/* failed */
+	}
 
 	pcap_read_post_process(wth->file_type_subtype, wth->file_encap,
 	    rec, ws_buffer_start_ptr(buf), libpcap->byte_swapped, -1);
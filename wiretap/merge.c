@@ -21,6 +21,11 @@
 #include <unistd.h>
 #endif
 
+#ifndef _WIN32
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
 #include <string.h>
 #include "merge.h"
 #include "wtap_opttypes.h"
@@ -28,6 +33,7 @@
 #include "wtap-int.h"
 
 #include <wsutil/filesystem.h>
+#include <wsutil/file_util.h>
 #include "wsutil/os_version_info.h"
 
 
@@ -70,6 +76,45 @@ merge_idb_merge_mode_to_string(const int mode)
     return idb_merge_mode_strings[(int)IDB_MERGE_MODE_MAX];
 }
 
+/*
+ * Input files that are opened at once if there's no limit we can find,
+ * and file descriptors left for everything else if there is.
+ */
+#define MERGE_DEFAULT_MAX_OPEN_FILES    1000
+#define MERGE_RESERVED_FILES            64
+
+static guint merge_max_open_files;
+
+void
+merge_set_max_open_files(const guint max_files)
+{
+    merge_max_open_files = max_files;
+}
+
+static guint
+merge_get_max_open_files(void)
+{
+    guint max_files = merge_max_open_files;
+#ifndef _WIN32
+    struct rlimit rl;
+#endif
+
+    if (max_files == 0) {
+        max_files = MERGE_DEFAULT_MAX_OPEN_FILES;
+#ifndef _WIN32
+        if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+            if (rl.rlim_cur > MERGE_RESERVED_FILES)
+                max_files = (guint)MIN(rl.rlim_cur - MERGE_RESERVED_FILES, G_MAXUINT);
+            else
+                max_files = (guint)rl.rlim_cur / 2;
+        }
+#endif
+    }
+
+    /* Merging fewer than two files at a time gets nowhere. */
+    return MAX(max_files, 2);
+}
+
 
 static void
 cleanup_in_file(merge_in_file_t *in_file)
@@ -207,24 +252,132 @@ merge_select_frame_type(int in_file_count, merge_in_file_t in_files[])
 }
 
 /*
- * returns TRUE if first argument is earlier than second
+ * The files that have a record to be merged, kept in a binary min-heap
+ * ordered the way records are merged, so that finding the next record
+ * takes time proportional to the log, rather than to the number, of the
+ * input files.
+ */
+typedef struct {
+    merge_in_file_t *in_files;
+    guint           *entries;   /* indices into in_files */
+    guint            count;
+    gboolean         filled;    /* the first record of each file was read */
+    GArray  *const  *no_ts;     /* for each file, the numbers of its records
+                                   that have no time stamp, or NULL; see
+                                   merge_heap_restore_no_ts() */
+    guint           *no_ts_next; /* for each file, the next one of those */
+} merge_heap_t;
+
+/*
+ * Returns TRUE if the record of the a'th file is to be merged before that
+ * of the b'th file.
+ *
+ * Records with no time stamp are treated as earlier than all other
+ * records.  Yes, this means you won't get a chronological merge of those
+ * records, but you obviously *can't* get that.  Records with the same
+ * time stamp are taken from the last file first, as they always have
+ * been.
  */
 static gboolean
-is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
+merge_heap_is_earlier(const merge_in_file_t in_files[], guint a, guint b)
 {
-    if (l->secs > r->secs) {  /* left is later */
-        return FALSE;
-    } else if (l->secs < r->secs) { /* left is earlier */
+    const wtap_rec *rec_a = &in_files[a].rec;
+    const wtap_rec *rec_b = &in_files[b].rec;
+    int cmp;
+
+    if (!(rec_a->presence_flags & WTAP_HAS_TS)) {
+        if (!(rec_b->presence_flags & WTAP_HAS_TS))
+            return a < b;
         return TRUE;
-    } else if (l->nsecs > r->nsecs) { /* tv_sec equal, l.usec later */
+    }
+    if (!(rec_b->presence_flags & WTAP_HAS_TS))
         return FALSE;
+
+    cmp = nstime_cmp(&rec_a->ts, &rec_b->ts);
+    if (cmp != 0)
+        return cmp < 0;
+    return a > b;
+}
+
+static void
+merge_heap_sift_up(merge_heap_t *heap, guint pos)
+{
+    guint entry = heap->entries[pos];
+    guint parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!merge_heap_is_earlier(heap->in_files, entry, heap->entries[parent]))
+            break;
+        heap->entries[pos] = heap->entries[parent];
+        pos = parent;
     }
-    /* either one < two or one == two
-     * either way, return one
-     */
+    heap->entries[pos] = entry;
+}
+
+static void
+merge_heap_sift_down(merge_heap_t *heap, guint pos)
+{
+    guint entry = heap->entries[pos];
+    guint child;
+
+    for (;;) {
+        child = 2 * pos + 1;
+        if (child >= heap->count)
+            break;
+        if (child + 1 < heap->count &&
+            merge_heap_is_earlier(heap->in_files, heap->entries[child + 1],
+                                  heap->entries[child]))
+            child++;
+        if (!merge_heap_is_earlier(heap->in_files, heap->entries[child], entry))
+            break;
+        heap->entries[pos] = heap->entries[child];
+        pos = child;
+    }
+    heap->entries[pos] = entry;
+}
+
+/*
+ * Reads the next record of a file.  Returns TRUE if a record was read,
+ * and FALSE at EOF or on an error, in which case *err is non-zero.
+ */
+static gboolean
+merge_read_in_file(merge_in_file_t *in_file, int *err, gchar **err_info)
+{
+    gint64 data_offset;
+
+    if (!wtap_read(in_file->wth, &in_file->rec, &in_file->frame_buffer,
+                   err, err_info, &data_offset)) {
+        in_file->state = (*err != 0) ? GOT_ERROR : AT_EOF;
+        return FALSE;
+    }
+    in_file->state = RECORD_PRESENT;
     return TRUE;
 }
 
+/*
+ * pcapng files always have a time stamp, so a record that had none
+ * when it was merged to a temporary file has one of 0 when it's read
+ * back; if the record just read from the i'th file is one of those,
+ * take it away again, so that it's merged as it would have been if all
+ * the files had been merged at once.
+ */
+static void
+merge_heap_restore_no_ts(merge_heap_t *heap, guint i)
+{
+    merge_in_file_t *in_file = &heap->in_files[i];
+    GArray *records;
+
+    if (heap->no_ts == NULL || (records = heap->no_ts[i]) == NULL ||
+        heap->no_ts_next[i] >= records->len ||
+        g_array_index(records, guint32, heap->no_ts_next[i]) != in_file->packet_num + 1)
+        return;
+
+    heap->no_ts_next[i]++;
+    in_file->rec.presence_flags &= ~WTAP_HAS_TS;
+    nstime_set_zero(&in_file->rec.ts);
+}
+
 /** Read the next packet, in chronological order, from the set of files to
  * be merged.
  *
@@ -237,8 +390,8 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * On an EOF (meaning all the files are at EOF), set *err to 0 and return
  * NULL.
  *
+ * @param heap heap of the input files
  * @param in_file_count number of entries in in_files
- * @param in_files input file array
  * @param err wiretap error, if failed
  * @param err_info wiretap error string, if failed
  * @return pointer to merge_in_file_t for file from which that packet
@@ -246,80 +399,66 @@ is_earlier(nstime_t *l, nstime_t *r) /* XXX, move to nstime.c */
  * all files
  */
 static merge_in_file_t *
-merge_read_packet(int in_file_count, merge_in_file_t in_files[],
+merge_read_packet(merge_heap_t *heap, int in_file_count,
                   int *err, gchar **err_info)
 {
+    merge_in_file_t *in_file;
     int i;
-    int ei = -1;
-    nstime_t tv = NSTIME_INIT_MAX;
-    wtap_rec *rec;
-
-    /*
-     * Make sure we have a record available from each file that's not at
-     * EOF, and search for the record with the earliest time stamp or
-     * with no time stamp (those records are treated as earlier than
-     * all other records).  Yes, this means you won't get a chronological
-     * merge of those records, but you obviously *can't* get that.
-     */
-    for (i = 0; i < in_file_count; i++) {
-        gint64 data_offset;
 
-        if (in_files[i].state == RECORD_NOT_PRESENT) {
-            /*
-             * No packet available, and we haven't seen an error or EOF yet,
-             * so try to read the next packet.
-             */
-            if (!wtap_read(in_files[i].wth, &in_files[i].rec,
-                           &in_files[i].frame_buffer, err, err_info,
-                           &data_offset)) {
-                if (*err != 0) {
-                    in_files[i].state = GOT_ERROR;
-                    return &in_files[i];
-                }
-                in_files[i].state = AT_EOF;
-            } else
-                in_files[i].state = RECORD_PRESENT;
-        }
-
-        if (in_files[i].state == RECORD_PRESENT) {
-            rec = &in_files[i].rec;
-            if (!(rec->presence_flags & WTAP_HAS_TS)) {
-                /*
-                 * No time stamp.  Pick this record, and stop looking.
-                 */
-                ei = i;
-                break;
-            }
-            if (is_earlier(&rec->ts, &tv)) {
-                /*
-                 * This record's time stamp is earlier than any of the
-                 * records we've seen so far.  Pick it, for now, but
-                 * keep looking.
-                 */
-                tv = rec->ts;
-                ei = i;
+    if (!heap->filled) {
+        /*
+         * Read the first record of each file, and put the files that
+         * aren't empty in the heap.
+         */
+        for (i = 0; i < in_file_count; i++) {
+            if (!merge_read_in_file(&heap->in_files[i], err, err_info)) {
+                if (*err != 0)
+                    return &heap->in_files[i];
+                continue;
             }
+            merge_heap_restore_no_ts(heap, i);
+            heap->entries[heap->count] = i;
+            merge_heap_sift_up(heap, heap->count++);
+        }
+        heap->filled = TRUE;
+    } else if (heap->count > 0) {
+        /*
+         * The record we returned last time came from the file at the
+         * top of the heap; replace it with the next one from that file,
+         * or drop the file if it has no more.
+         */
+        in_file = &heap->in_files[heap->entries[0]];
+        if (!merge_read_in_file(in_file, err, err_info)) {
+            if (*err != 0)
+                return in_file;
+            heap->entries[0] = heap->entries[--heap->count];
+        } else {
+            merge_heap_restore_no_ts(heap, heap->entries[0]);
         }
+        if (heap->count > 0)
+            merge_heap_sift_down(heap, 0);
     }
 
-    if (ei == -1) {
+    if (heap->count == 0) {
         /* All the streams are at EOF.  Return an EOF indication. */
         *err = 0;
         return NULL;
     }
 
+    in_file = &heap->in_files[heap->entries[0]];
+
     /* We'll need to read another packet from this file. */
-    in_files[ei].state = RECORD_NOT_PRESENT;
+    in_file->state = RECORD_NOT_PRESENT;
 
     /* Count this packet. */
-    in_files[ei].packet_num++;
+    in_file->packet_num++;
 
     /*
      * Return a pointer to the merge_in_file_t of the file from which the
      * packet was read.
      */
     *err = 0;
-    return &in_files[ei];
+    return in_file;
 }
 
 /** Read the next packet, in file sequence order, from the set of files
@@ -837,12 +976,19 @@ map_rec_interface_id(wtap_rec *rec, const merge_in_file_t *in_file)
     return TRUE;
 }
 
+/*
+ * If no_ts_out isn't NULL, the numbers of the records written without a
+ * time stamp are appended to it; if no_ts_in isn't NULL, it has, for
+ * each input file, the numbers of its records that are to be treated as
+ * having none, or NULL.
+ */
 static merge_result
 merge_process_packets(wtap_dumper *pdh, const int file_type,
                       merge_in_file_t *in_files, const guint in_file_count,
                       const gboolean do_append, guint snaplen,
                       merge_progress_callback_t* cb,
                       GArray *dsb_combined,
+                      GArray *no_ts_out, GArray *const *no_ts_in,
                       int *err, gchar **err_info, guint *err_fileno,
                       guint32 *err_framenum)
 {
@@ -851,6 +997,14 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     int                 count = 0;
     gboolean            stop_flag = FALSE;
     wtap_rec *rec,      snap_rec;
+    merge_heap_t        heap;
+
+    heap.in_files = in_files;
+    heap.entries = do_append ? NULL : g_new(guint, in_file_count);
+    heap.count = 0;
+    heap.filled = FALSE;
+    heap.no_ts = no_ts_in;
+    heap.no_ts_next = no_ts_in ? g_new0(guint, in_file_count) : NULL;
 
     for (;;) {
         *err = 0;
@@ -860,7 +1014,7 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
                                                err_info);
         }
         else {
-            in_file = merge_read_packet(in_file_count, in_files, err,
+            in_file = merge_read_packet(&heap, in_file_count, err,
                                         err_info);
         }
 
@@ -940,8 +1094,16 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
             status = MERGE_ERR_CANT_WRITE_OUTFILE;
             break;
         }
+        if (no_ts_out != NULL && !(rec->presence_flags & WTAP_HAS_TS)) {
+            guint32 record_num = (guint32)count;
+
+            g_array_append_val(no_ts_out, record_num);
+        }
     }
 
+    g_free(heap.entries);
+    g_free(heap.no_ts_next);
+
     if (cb)
         cb->callback_func(MERGE_EVENT_DONE, count, in_files, in_file_count, cb->data);
 
@@ -978,15 +1140,20 @@ merge_process_packets(wtap_dumper *pdh, const int file_type,
     return status;
 }
 
+/*
+ * Merges the files with all of them open at once; no_ts_out and no_ts_in
+ * are as for merge_process_packets().
+ */
 static merge_result
-merge_files_common(const gchar* out_filename, /* normal output mode */
-                   gchar **out_filenamep, const char *pfx, /* tempfile mode  */
-                   const int file_type, const char *const *in_filenames,
-                   const guint in_file_count, const gboolean do_append,
-                   const idb_merge_mode mode, guint snaplen,
-                   const gchar *app_name, merge_progress_callback_t* cb,
-                   int *err, gchar **err_info, guint *err_fileno,
-                   guint32 *err_framenum)
+merge_files_group(const gchar* out_filename, /* normal output mode */
+                  gchar **out_filenamep, const char *pfx, /* tempfile mode  */
+                  const int file_type, const char *const *in_filenames,
+                  const guint in_file_count, const gboolean do_append,
+                  const idb_merge_mode mode, guint snaplen,
+                  const gchar *app_name, merge_progress_callback_t* cb,
+                  GArray *no_ts_out, GArray *const *no_ts_in,
+                  int *err, gchar **err_info, guint *err_fileno,
+                  guint32 *err_framenum)
 {
     merge_in_file_t    *in_files = NULL;
     int                 frame_type = WTAP_ENCAP_PER_PACKET;
@@ -1078,7 +1245,8 @@ merge_files_common(const gchar* out_filename, /* normal output mode */
         cb->callback_func(MERGE_EVENT_READY_TO_MERGE, 0, in_files, in_file_count, cb->data);
 
     status = merge_process_packets(pdh, file_type, in_files, in_file_count,
-                                   do_append, snaplen, cb, dsb_combined, err, err_info,
+                                   do_append, snaplen, cb, dsb_combined,
+                                   no_ts_out, no_ts_in, err, err_info,
                                    err_fileno, err_framenum);
 
     g_free(in_files);
@@ -1091,6 +1259,171 @@ merge_files_common(const gchar* out_filename, /* normal output mode */
     return status;
 }
 
+static void
+merge_free_no_ts(gpointer data)
+{
+    g_array_free((GArray *)data, TRUE);
+}
+
+static void
+merge_remove_temp_files(GPtrArray *temp_files)
+{
+    guint i;
+
+    for (i = 0; i < temp_files->len; i++)
+        ws_unlink((const char *)g_ptr_array_index(temp_files, i));
+    g_ptr_array_free(temp_files, TRUE);
+}
+
+/*
+ * Merges the files in groups of at most max_files, each to a temporary
+ * pcapng file, then merges those files the same way, until there are few
+ * enough of them to be merged to the output in one go; only the files of
+ * one group are open at any time.
+ *
+ * The records are merged in the same order as if all the files had been
+ * merged at once; for that, the records written to each temporary file
+ * without a time stamp are remembered, as pcapng gives them one.  The
+ * interfaces are merged in the same way too, except that in the "all" IDB
+ * merge mode the IDBs of a group are merged if all the files of that
+ * group have the same ones, rather than only if all the files do.
+ */
+static merge_result
+merge_files_batched(const gchar* out_filename, /* normal output mode */
+                    gchar **out_filenamep, const char *pfx, /* tempfile mode  */
+                    const int file_type, const char *const *in_filenames,
+                    const guint in_file_count, const gboolean do_append,
+                    const idb_merge_mode mode, guint snaplen,
+                    const gchar *app_name, merge_progress_callback_t* cb,
+                    const guint max_files,
+                    int *err, gchar **err_info, guint *err_fileno,
+                    guint32 *err_framenum)
+{
+    GPtrArray    *temp_files = NULL;    /* files merged at the previous level */
+    GPtrArray    *next_files;
+    GPtrArray    *no_ts = NULL;         /* their records without time stamps */
+    GPtrArray    *next_no_ts;
+    GArray       *group_no_ts;
+    guint        *first_in = NULL;      /* first input file of each of those */
+    guint        *next_first_in;
+    const char *const *names = in_filenames;
+    guint         count = in_file_count;
+    guint         num_groups, group, start, group_count;
+    gchar        *temp_name;
+    merge_result  status = MERGE_OK;
+
+    while (count > max_files) {
+        num_groups = (count + max_files - 1) / max_files;
+        next_files = g_ptr_array_new_with_free_func(g_free);
+        next_no_ts = g_ptr_array_new_with_free_func(merge_free_no_ts);
+        next_first_in = g_new(guint, num_groups);
+
+        merge_debug("merge_files: merging %u files in %u groups", count, num_groups);
+
+        /* Spread the files evenly over the groups. */
+        start = 0;
+        for (group = 0; group < num_groups; group++) {
+            group_count = count / num_groups + (group < count % num_groups ? 1 : 0);
+
+            temp_name = NULL;
+            group_no_ts = g_array_new(FALSE, FALSE, sizeof(guint32));
+            g_ptr_array_add(next_no_ts, group_no_ts);
+            *err_fileno = 0;
+            *err_framenum = 0;
+            status = merge_files_group(NULL, &temp_name, "merge",
+                                       WTAP_FILE_TYPE_SUBTYPE_PCAPNG,
+                                       names + start, group_count, do_append,
+                                       mode, snaplen, app_name, cb,
+                                       group_no_ts,
+                                       no_ts ? (GArray *const *)no_ts->pdata + start : NULL,
+                                       err, err_info, err_fileno, err_framenum);
+            if (temp_name != NULL)
+                g_ptr_array_add(next_files, temp_name);
+            if (status != MERGE_OK) {
+                *err_fileno += start;
+                break;
+            }
+            next_first_in[group] = first_in ? first_in[start] : start;
+            start += group_count;
+        }
+
+        if (status != MERGE_OK) {
+            /*
+             * Report the input file of the error; for an intermediate
+             * file, that's the first of the files merged to it.
+             */
+            if (first_in) {
+                *err_fileno = first_in[*err_fileno];
+                *err_framenum = 0;
+            }
+            merge_remove_temp_files(next_files);
+            g_ptr_array_free(next_no_ts, TRUE);
+            g_free(next_first_in);
+            break;
+        }
+
+        if (temp_files)
+            merge_remove_temp_files(temp_files);
+        if (no_ts)
+            g_ptr_array_free(no_ts, TRUE);
+        g_free(first_in);
+        temp_files = next_files;
+        no_ts = next_no_ts;
+        first_in = next_first_in;
+        names = (const char *const *)temp_files->pdata;
+        count = num_groups;
+    }
+
+    if (status == MERGE_OK) {
+        *err_fileno = 0;
+        *err_framenum = 0;
+        status = merge_files_group(out_filename, out_filenamep, pfx,
+                                   file_type, names, count, do_append, mode,
+                                   snaplen, app_name, cb, NULL,
+                                   no_ts ? (GArray *const *)no_ts->pdata : NULL,
+                                   err, err_info, err_fileno, err_framenum);
+        if (status != MERGE_OK && first_in) {
+            *err_fileno = first_in[*err_fileno];
+            *err_framenum = 0;
+        }
+    }
+
+    if (temp_files)
+        merge_remove_temp_files(temp_files);
+    if (no_ts)
+        g_ptr_array_free(no_ts, TRUE);
+    g_free(first_in);
+
+    return status;
+}
+
+static merge_result
+merge_files_common(const gchar* out_filename, /* normal output mode */
+                   gchar **out_filenamep, const char *pfx, /* tempfile mode  */
+                   const int file_type, const char *const *in_filenames,
+                   const guint in_file_count, const gboolean do_append,
+                   const idb_merge_mode mode, guint snaplen,
+                   const gchar *app_name, merge_progress_callback_t* cb,
+                   int *err, gchar **err_info, guint *err_fileno,
+                   guint32 *err_framenum)
+{
+    guint max_files = merge_get_max_open_files();
+
+    if (in_file_count > max_files) {
+        return merge_files_batched(out_filename, out_filenamep, pfx,
+                                   file_type, in_filenames, in_file_count,
+                                   do_append, mode, snaplen, app_name, cb,
+                                   max_files, err, err_info, err_fileno,
+                                   err_framenum);
+    }
+
+    return merge_files_group(out_filename, out_filenamep, pfx,
+                             file_type, in_filenames, in_file_count,
+                             do_append, mode, snaplen, app_name, cb,
+                             NULL, NULL, err, err_info, err_fileno,
+                             err_framenum);
+}
+
 /*
  * Merges the files to an output file whose name is supplied as an argument,
  * based on given input, and invokes callback during execution. Returns
@@ -91,6 +91,19 @@ WS_DLL_PUBLIC const char*
 merge_idb_merge_mode_to_string(const int mode);
 
 
+/** Sets the largest number of input files that are open at once.
+ *
+ * If there are more input files than that, the merge_files() routines merge
+ * them in groups to temporary files, and then merge those, so that merging
+ * tens of thousands of files doesn't run out of file descriptors.
+ *
+ * @param max_files The number of files, or 0 (the default) to derive it
+ * from the limit on open files of the process.
+ */
+WS_DLL_PUBLIC void
+merge_set_max_open_files(const guint max_files);
+
+
 /** @struct merge_progress_callback_t
  *
  * @brief Callback information for merging.
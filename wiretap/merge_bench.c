@@ -0,0 +1,197 @@
+/* merge_bench.c
+ * Times the merging of capture files as their number grows
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Usage: merge_bench [records] [max open files] [file count ...]
+ *
+ * For each file count (10, 100, 1000 and 10000 by default), writes that
+ * many pcap files with the given total number of records between them,
+ * with the time stamps of the files interleaved so that every record
+ * comes from a different file than the one before it, then merges them
+ * with merge_files() and prints the time taken per record.  With the
+ * merge heap, that grows with the log of the number of files; it used to
+ * grow linearly.
+ *
+ * Counts above the maximum number of open files (by default, derived
+ * from the limit of the process; see "ulimit -n") are merged in groups.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/privileges.h>
+
+#include <wiretap/wtap.h>
+#include <wiretap/merge.h>
+
+#define DEFAULT_RECORDS		200000
+#define PACKET_LEN		60
+
+static const guint default_counts[] = { 10, 100, 1000, 10000 };
+
+static void
+put_le32(guint8 *p, guint32 v)
+{
+	p[0] = (guint8)v;
+	p[1] = (guint8)(v >> 8);
+	p[2] = (guint8)(v >> 16);
+	p[3] = (guint8)(v >> 24);
+}
+
+/* Writes a pcap file of records whose time stamps, in microseconds, are
+ * first, first + step, first + 2 * step, ... */
+static gboolean
+write_file(const char *name, guint records, guint64 first, guint64 step)
+{
+	guint8	hdr[24], rec[16], data[PACKET_LEN];
+	guint64	ts = first;
+	guint	i;
+	FILE	*fh;
+
+	fh = ws_fopen(name, "wb");
+	if (!fh)
+		return FALSE;
+
+	put_le32(hdr, 0xa1b2c3d4);
+	hdr[4] = 2; hdr[5] = 0;		/* version 2.4 */
+	hdr[6] = 4; hdr[7] = 0;
+	put_le32(hdr + 8, 0);		/* thiszone */
+	put_le32(hdr + 12, 0);		/* sigfigs */
+	put_le32(hdr + 16, 65535);	/* snaplen */
+	put_le32(hdr + 20, 1);		/* LINKTYPE_ETHERNET */
+	fwrite(hdr, 1, sizeof hdr, fh);
+
+	memset(data, 0, sizeof data);
+	for (i = 0; i < records; i++, ts += step) {
+		put_le32(rec, (guint32)(ts / 1000000));
+		put_le32(rec + 4, (guint32)(ts % 1000000));
+		put_le32(rec + 8, PACKET_LEN);
+		put_le32(rec + 12, PACKET_LEN);
+		memcpy(data, &i, sizeof i);
+		fwrite(rec, 1, sizeof rec, fh);
+		fwrite(data, 1, sizeof data, fh);
+	}
+
+	return fclose(fh) == 0;
+}
+
+static void
+bench_count(const char *dir, guint records, guint count)
+{
+	char		**names;
+	char		*out_name;
+	guint		per_file;
+	guint		i;
+	gint64		start, elapsed;
+	merge_result	status;
+	int		err;
+	gchar		*err_info = NULL;
+	guint		err_fileno;
+	guint32		err_framenum;
+
+	if (count == 0)
+		return;
+	per_file = records / count;
+	if (per_file == 0)
+		per_file = 1;
+
+	names = g_new0(char *, count + 1);
+	for (i = 0; i < count; i++) {
+		names[i] = g_strdup_printf("%s" G_DIR_SEPARATOR_S "in%05u.pcap", dir, i);
+		if (!write_file(names[i], per_file, 1600000000000000ULL + i, count)) {
+			fprintf(stderr, "merge_bench: can't write %s\n", names[i]);
+			goto done;
+		}
+	}
+	out_name = g_strdup_printf("%s" G_DIR_SEPARATOR_S "out.pcap", dir);
+
+	start = g_get_monotonic_time();
+	status = merge_files(out_name, WTAP_FILE_TYPE_SUBTYPE_PCAP,
+			(const char *const *)names, count, FALSE,
+			IDB_MERGE_MODE_ALL_SAME, 0, "merge_bench", NULL,
+			&err, &err_info, &err_fileno, &err_framenum);
+	elapsed = g_get_monotonic_time() - start;
+
+	if (status != MERGE_OK) {
+		fprintf(stderr, "merge_bench: merging %u files failed: status %d, error %d (%s)\n",
+			count, status, err, err_info ? err_info : "");
+		g_free(err_info);
+	} else {
+		printf("%6u files %8u records %10.3f s %8.1f ns/record\n",
+			count, per_file * count, elapsed / 1e6,
+			elapsed * 1000.0 / ((double)per_file * count));
+	}
+
+	ws_unlink(out_name);
+	g_free(out_name);
+done:
+	for (i = 0; i < count && names[i]; i++)
+		ws_unlink(names[i]);
+	g_strfreev(names);
+}
+
+int
+main(int argc, char **argv)
+{
+	guint	records = DEFAULT_RECORDS;
+	gchar	*dir;
+	GError	*error = NULL;
+	guint	i;
+
+	if (argc > 1)
+		records = (guint)strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		merge_set_max_open_files((guint)strtoul(argv[2], NULL, 10));
+
+	init_process_policies();
+	g_free(init_progfile_dir(argv[0]));
+	wtap_init(FALSE);
+
+	dir = g_dir_make_tmp("merge_bench_XXXXXX", &error);
+	if (!dir) {
+		fprintf(stderr, "merge_bench: %s\n", error->message);
+		g_error_free(error);
+		return 1;
+	}
+
+	if (argc > 3) {
+		for (i = 3; i < (guint)argc; i++)
+			bench_count(dir, records, (guint)strtoul(argv[i], NULL, 10));
+	} else {
+		for (i = 0; i < G_N_ELEMENTS(default_counts); i++)
+			bench_count(dir, records, default_counts[i]);
+	}
+
+	ws_remove(dir);
+	g_free(dir);
+	wtap_cleanup();
+	free_progdirs();
+	return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
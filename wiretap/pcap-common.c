@@ -2342,6 +2342,27 @@ pcap_read_post_process(int file_type, int wtap_encap,
 	}
 }
 
+/*
+ * Returns TRUE if pcap_read_post_process() modifies the packet data for
+ * the encapsulation, in which case it mustn't be read in place from a
+ * mapping of the file, as it would be modified again if it were reread.
+ */
+gboolean
+pcap_read_post_process_modifies(int wtap_encap, gboolean bytes_swapped)
+{
+	switch (wtap_encap) {
+
+	case WTAP_ENCAP_SLL:
+	case WTAP_ENCAP_USB_LINUX:
+	case WTAP_ENCAP_USB_LINUX_MMAPPED:
+	case WTAP_ENCAP_NFLOG:
+		return bytes_swapped;
+
+	default:
+		return FALSE;
+	}
+}
+
 gboolean
 wtap_encap_requires_phdr(int wtap_encap)
 {
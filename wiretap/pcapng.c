@@ -1136,11 +1136,32 @@ pcapng_read_decryption_secrets_block(FILE_T fh, pcapng_block_header_t *bh,
     return TRUE;
 }
 
+/* Set the packet block options of a record to their defaults. */
+static void
+pcapng_reset_packet_options(wtap_rec *rec)
+{
+    g_free(rec->opt_comment);   /* Free memory from an earlier read. */
+    rec->opt_comment = NULL;
+    rec->rec_header.packet_header.drop_count  = -1;
+    rec->rec_header.packet_header.pack_flags  = 0;
+    rec->rec_header.packet_header.packet_id  = 0;
+    rec->rec_header.packet_header.interface_queue  = 0;
+    if (rec->packet_verdict != NULL) {
+        g_ptr_array_free(rec->packet_verdict, TRUE);
+        rec->packet_verdict = NULL;
+    }
+}
+
+/*
+ * If skip_data is set, only the metadata of the packet is wanted; the
+ * packet data and the options are skipped.
+ */
 static gboolean
 pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                          const section_info_t *section_info,
                          wtapng_block_t *wblock,
-                         int *err, gchar **err_info, gboolean enhanced)
+                         int *err, gchar **err_info, gboolean enhanced,
+                         gboolean skip_data)
 {
     int bytes_read;
     guint block_read;
@@ -1335,10 +1356,28 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->ts.secs = (time_t)(ts / iface_info.time_units_per_second);
     wblock->rec->ts.nsecs = (int)(((ts % iface_info.time_units_per_second) * 1000000000) / iface_info.time_units_per_second);
 
-    /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
-        return FALSE;
+    if (skip_data) {
+        pcapng_reset_packet_options(wblock->rec);
+        if (!wtap_skip_packet_bytes(fh, block_total_length -
+                                    (guint32)sizeof(pcapng_block_header_t) -
+                                    block_read -
+                                    (guint32)sizeof(bh->block_total_length),
+                                    err, err_info))
+            return FALSE;
+        wblock->internal = FALSE;
+        return TRUE;
+    }
+
+    /* "(Enhanced) Packet Block" read capture data, in place if we can */
+    if (pcap_read_post_process_modifies(iface_info.wtap_encap, section_info->byte_swapped)) {
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    } else {
+        if (!wtap_read_packet_bytes_nocopy(fh, wblock->frame_buffer,
+                                           packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+    }
     block_read += packet.cap_len - pseudo_header_len;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -1349,16 +1388,7 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     }
 
     /* Option defaults */
-    g_free(wblock->rec->opt_comment);   /* Free memory from an earlier read. */
-    wblock->rec->opt_comment = NULL;
-    wblock->rec->rec_header.packet_header.drop_count  = -1;
-    wblock->rec->rec_header.packet_header.pack_flags  = 0;
-    wblock->rec->rec_header.packet_header.packet_id  = 0;
-    wblock->rec->rec_header.packet_header.interface_queue  = 0;
-    if (wblock->rec->packet_verdict != NULL) {
-        g_ptr_array_free(wblock->rec->packet_verdict, TRUE);
-        wblock->rec->packet_verdict = NULL;
-    }
+    pcapng_reset_packet_options(wblock->rec);
 
     /* FCS length default */
     fcslen = iface_info.fcslen;
@@ -1591,7 +1621,8 @@ static gboolean
 pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                                 const section_info_t *section_info,
                                 wtapng_block_t *wblock,
-                                int *err, gchar **err_info)
+                                int *err, gchar **err_info,
+                                gboolean skip_data)
 {
     interface_info_t iface_info;
     pcapng_simple_packet_block_t spb;
@@ -1724,10 +1755,24 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
 
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
-    /* "Simple Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                simple_packet.cap_len, err, err_info))
-        return FALSE;
+    if (skip_data) {
+        if (!wtap_skip_packet_bytes(fh, simple_packet.cap_len + padding,
+                                    err, err_info))
+            return FALSE;
+        wblock->internal = FALSE;
+        return TRUE;
+    }
+
+    /* "Simple Packet Block" read capture data, in place if we can */
+    if (pcap_read_post_process_modifies(iface_info.wtap_encap, section_info->byte_swapped)) {
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    simple_packet.cap_len, err, err_info))
+            return FALSE;
+    } else {
+        if (!wtap_read_packet_bytes_nocopy(fh, wblock->frame_buffer,
+                                           simple_packet.cap_len, err, err_info))
+            return FALSE;
+    }
 
     /* jump over potential padding bytes at end of the packet data */
     if ((simple_packet.cap_len % 4) != 0) {
@@ -2618,6 +2663,7 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
     block_return_val ret;
     pcapng_block_header_t bh;
     guint32 block_total_length;
+    gboolean skip_data = wth->metadata_only && fh == wth->fh;
 
     wblock->block = NULL;
 
@@ -2723,15 +2769,15 @@ pcapng_read_block(wtap *wth, FILE_T fh, pcapng_t *pn,
                     return PCAPNG_BLOCK_ERROR;
                 break;
             case(BLOCK_TYPE_PB):
-                if (!pcapng_read_packet_block(fh, &bh, section_info, wblock, err, err_info, FALSE))
+                if (!pcapng_read_packet_block(fh, &bh, section_info, wblock, err, err_info, FALSE, skip_data))
                     return PCAPNG_BLOCK_ERROR;
                 break;
             case(BLOCK_TYPE_SPB):
-                if (!pcapng_read_simple_packet_block(fh, &bh, section_info, wblock, err, err_info))
+                if (!pcapng_read_simple_packet_block(fh, &bh, section_info, wblock, err, err_info, skip_data))
                     return PCAPNG_BLOCK_ERROR;
                 break;
             case(BLOCK_TYPE_EPB):
-                if (!pcapng_read_packet_block(fh, &bh, section_info, wblock, err, err_info, TRUE))
+                if (!pcapng_read_packet_block(fh, &bh, section_info, wblock, err, err_info, TRUE, skip_data))
                     return PCAPNG_BLOCK_ERROR;
                 break;
             case(BLOCK_TYPE_NRB):
@@ -0,0 +1,150 @@
+/* read_test.c
+ * Checks how far into a capture file reading it is reported to have got,
+ * including while the file is read through a memory mapping
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <glib.h>
+
+#include <wsutil/buffer.h>
+#include <wsutil/file_util.h>
+
+#include <wiretap/wtap.h>
+
+#define PCAP_HEADER_LEN		24
+#define PCAP_RECORD_HEADER_LEN	16
+
+static const guint record_lens[] = {
+	60, 1514, 14, 65535, 9000, 0, 42, 200000, 64,
+};
+
+static void
+append_guint32(GByteArray *bytes, guint32 val)
+{
+	g_byte_array_append(bytes, (const guint8 *)&val, sizeof val);
+}
+
+static void
+append_guint16(GByteArray *bytes, guint16 val)
+{
+	g_byte_array_append(bytes, (const guint8 *)&val, sizeof val);
+}
+
+/* Writes an uncompressed pcap file with the records above. */
+static gchar *
+write_capture(void)
+{
+	GByteArray	*bytes = g_byte_array_new();
+	gchar		*filename;
+	guint8		*data;
+	guint		i, j;
+	int		fd;
+
+	append_guint32(bytes, 0xa1b2c3d4);
+	append_guint16(bytes, 2);
+	append_guint16(bytes, 4);
+	append_guint32(bytes, 0);
+	append_guint32(bytes, 0);
+	append_guint32(bytes, 262144);
+	append_guint32(bytes, 1);	/* LINKTYPE_ETHERNET */
+
+	data = (guint8 *)g_malloc(262144);
+	for (i = 0; i < G_N_ELEMENTS(record_lens); i++) {
+		for (j = 0; j < record_lens[i]; j++)
+			data[j] = (guint8)(i * 31 + j);
+		append_guint32(bytes, 1600000000 + i);
+		append_guint32(bytes, i);
+		append_guint32(bytes, record_lens[i]);
+		append_guint32(bytes, record_lens[i]);
+		g_byte_array_append(bytes, data, record_lens[i]);
+	}
+	g_free(data);
+
+	fd = g_file_open_tmp("read_test_XXXXXX.pcap", &filename, NULL);
+	g_assert_true(fd != -1);
+	ws_close(fd);
+	g_assert_true(g_file_set_contents(filename, (const gchar *)bytes->data,
+				bytes->len, NULL));
+	g_byte_array_free(bytes, TRUE);
+	return filename;
+}
+
+/*
+ * After every record, wtap_read_so_far() should be where that record
+ * ends; when the file isn't mapped, it may be further on, as data is
+ * read ahead into a buffer.
+ */
+static void
+read_test_so_far(void)
+{
+	gchar		*filename;
+	wtap		*wth;
+	wtap_rec	rec;
+	Buffer		buf;
+	gint64		data_offset, end;
+	guint		i;
+	int		err;
+	gchar		*err_info;
+
+	filename = write_capture();
+	wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+	g_assert_nonnull(wth);
+
+	wtap_rec_init(&rec);
+	ws_buffer_init(&buf, 1514);
+	end = PCAP_HEADER_LEN;
+	for (i = 0; i < G_N_ELEMENTS(record_lens); i++) {
+		g_assert_true(wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset));
+		g_assert_cmpint(data_offset, ==, end);
+		end += PCAP_RECORD_HEADER_LEN + record_lens[i];
+#ifdef HAVE_MMAP
+		g_assert_cmpint(wtap_read_so_far(wth), ==, end);
+#else
+		g_assert_cmpint(wtap_read_so_far(wth), >=, end);
+#endif
+	}
+	g_assert_false(wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset));
+	g_assert_cmpint(err, ==, 0);
+	g_assert_cmpint(wtap_read_so_far(wth), ==, end);
+	ws_buffer_free(&buf);
+	wtap_rec_cleanup(&rec);
+
+	wtap_close(wth);
+	ws_unlink(filename);
+	g_free(filename);
+}
+
+int
+main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+	wtap_init(FALSE);
+
+	g_test_add_func("/wtap_read/so_far",	read_test_so_far);
+
+	ret = g_test_run();
+	wtap_cleanup();
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
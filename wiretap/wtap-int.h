@@ -71,6 +71,7 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    gboolean                    metadata_only;          /**< wtap_read() needn't read the data of records */
 };
 
 struct wtap_dumper;
@@ -116,8 +117,18 @@ struct wtap_dumper {
      */
     const GArray            *dsbs_growing;          /**< A reference to an array of DSBs (of type wtap_block_t) */
     guint                   dsbs_growing_written;   /**< Number of already processed DSBs in dsbs_growing. */
+
+    /*
+     * Writes smaller than the buffer are collected here and handed to
+     * the stream (and, for compressed output, the compressor) in one
+     * piece, rather than a few bytes of header and padding at a time.
+     */
+    guint8                  *write_buf;      /**< allocated on the first write */
+    size_t                  write_buf_len;   /**< bytes in it not yet written out */
 };
 
+#define WTAP_DUMP_WRITE_BUF_SIZE    65536
+
 WS_DLL_PUBLIC gboolean wtap_dump_file_write(wtap_dumper *wdh, const void *buf,
     size_t bufsize, int *err);
 WS_DLL_PUBLIC gint64 wtap_dump_file_seek(wtap_dumper *wdh, gint64 offset, int whence, int *err);
@@ -317,6 +328,27 @@ gboolean
 wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
     gchar **err_info);
 
+/*
+ * Like wtap_read_packet_bytes(), but, if the data is in a memory mapping
+ * of the file, make the Buffer refer to it rather than copying it; see
+ * ws_buffer_lend().  Modifying the data in place is safe, as the mapping
+ * is private, but reading the data of the buffer after the file has been
+ * closed is not.
+ */
+WS_DLL_PUBLIC
+gboolean
+wtap_read_packet_bytes_nocopy(FILE_T fh, Buffer *buf, guint length, int *err,
+    gchar **err_info);
+
+/*
+ * Skip packet data instead of reading it, for a sequential read with
+ * wth->metadata_only set.  As with wtap_read_packet_bytes(), a short
+ * read is an error.
+ */
+WS_DLL_PUBLIC
+gboolean
+wtap_skip_packet_bytes(FILE_T fh, guint length, int *err, gchar **err_info);
+
 /*
  * Implementation of wth->subtype_read that reads the full file contents
  * as a single packet.
@@ -343,6 +375,7 @@ wtap_add_idb(wtap *wth, wtap_block_t idb);
  */
 void
 wtapng_process_dsb(wtap *wth, wtap_block_t dsb);
+
 #endif /* __WTAP_INT_H__ */
 
 /*
@@ -1368,6 +1368,7 @@ wtap_sequential_close(wtap *wth)
 		(*wth->subtype_sequential_close)(wth);
 
 	if (wth->fh != NULL) {
+		file_write_gzip_index(wth->fh);
 		file_close(wth->fh);
 		wth->fh = NULL;
 	}
@@ -1453,6 +1454,12 @@ void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secr
 	}
 }
 
+void
+wtap_set_metadata_only(wtap *wth, gboolean metadata_only)
+{
+	wth->metadata_only = metadata_only;
+}
+
 void
 wtapng_process_dsb(wtap *wth, wtap_block_t dsb)
 {
@@ -1607,6 +1614,43 @@ wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
 	    err_info);
 }
 
+/*
+ * Read packet data into a Buffer, without copying it if the file is
+ * memory-mapped.
+ */
+gboolean
+wtap_read_packet_bytes_nocopy(FILE_T fh, Buffer *buf, guint length, int *err,
+    gchar **err_info)
+{
+	const guint8 *data;
+
+	data = file_read_ptr(fh, length);
+	if (data == NULL)
+		return wtap_read_packet_bytes(fh, buf, length, err, err_info);
+	ws_buffer_lend(buf, data, length);
+	return TRUE;
+}
+
+gboolean
+wtap_skip_packet_bytes(FILE_T fh, guint length, int *err, gchar **err_info)
+{
+	guint8 last;
+
+	if (length == 0)
+		return TRUE;
+
+	/*
+	 * Seek over all but the last byte, and read that one, so that a
+	 * file that's been cut short in the middle of the data is noticed.
+	 * Seeking forward just moves the position in a memory-mapped file,
+	 * and is done with a skip, combined with any following ones, in
+	 * other files.
+	 */
+	if (length > 1 && file_seek(fh, length - 1, SEEK_CUR, err) == -1)
+		return FALSE;
+	return wtap_read_bytes(fh, &last, 1, err, err_info);
+}
+
 /*
  * Return an approximation of the amount of data we've read sequentially
  * from the file so far.  (gint64, in case that's 64 bits.)
@@ -1817,6 +1817,19 @@ typedef void (*wtap_new_secrets_callback_t)(guint32 secrets_type, const void *se
 WS_DLL_PUBLIC
 void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secrets);
 
+/**
+ * Tell wtap_read() that only the metadata of records (their type, time
+ * stamp, lengths, encapsulation and interface) will be looked at, not
+ * their data.  For file types that can do so (currently pcap and pcapng),
+ * the data, and for pcapng the options of packet blocks, are then skipped
+ * rather than read, and the contents of the Buffer passed to wtap_read()
+ * are undefined.  Other metadata in the file, such as interface
+ * descriptions, name resolution and decryption secrets, is read as usual.
+ * wtap_seek_read() isn't affected.
+ */
+WS_DLL_PUBLIC
+void wtap_set_metadata_only(wtap *wth, gboolean metadata_only);
+
 /** Read the next record in the file, filling in *phdr and *buf.
  *
  * @wth a wtap * returned by a call that opened a file for reading.
@@ -1869,7 +1882,10 @@ void wtap_rec_cleanup(wtap_rec *rec);
  */
 typedef enum {
     WTAP_UNCOMPRESSED,
-    WTAP_GZIP_COMPRESSED
+    WTAP_GZIP_COMPRESSED,
+    WTAP_ZSTD_COMPRESSED,       /* written in the zstd seekable format */
+    WTAP_LZ4_COMPRESSED,
+    WTAP_UNKNOWN_COMPRESSION
 } wtap_compression_type;
 
 WS_DLL_PUBLIC
@@ -1881,6 +1897,60 @@ const char *wtap_compression_type_extension(wtap_compression_type compression_ty
 WS_DLL_PUBLIC
 GSList *wtap_get_all_compression_type_extensions_list(void);
 
+/*
+ * Look up a type of compression by the name used for it on the command
+ * line ("gzip", "zstd", "lz4" or "none"); returns WTAP_UNKNOWN_COMPRESSION
+ * if there's no such type, or it isn't supported in this build.
+ */
+WS_DLL_PUBLIC
+wtap_compression_type wtap_name_to_compression_type(const char *name);
+
+/*
+ * Get a list of the names of the supported types of compression, other
+ * than "none", in the order in which they should be offered.  Free the
+ * list, but not the names, with g_slist_free().
+ */
+WS_DLL_PUBLIC
+GSList *wtap_get_all_compression_type_names_list(void);
+
+/*
+ * Compress everything that can be read from in_fd into out_fd, which is
+ * closed.  This is for compressing files other than through a
+ * wtap_dumper, such as finished ring buffer files.
+ *
+ * Returns TRUE on success; on failure, returns FALSE and puts an errno
+ * value or a WTAP_ERR_ value into *err.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_compress_fd(int in_fd, int out_fd,
+    wtap_compression_type compression_type, int *err);
+
+/*
+ * Read up to the given number of megabytes of each regular file opened
+ * from now on ahead of where it's being read, in a separate thread, so
+ * that reading the file overlaps processing the data already read;
+ * 0, the default, turns that off.
+ */
+WS_DLL_PUBLIC
+void wtap_set_read_ahead(guint mbytes);
+
+/*
+ * Once a gzip-compressed file opened from now on has been read to the end,
+ * write the places it can be read from into a "<file>.gzidx" file next to
+ * it, so that the next time it's opened it can be read from anywhere in it
+ * without being read from the start first.
+ */
+WS_DLL_PUBLIC
+void wtap_set_write_gzip_index(gboolean write);
+
+/*
+ * Inflate gzip-compressed files opened from now on that have a
+ * "<file>.gzidx" index in the given number of threads, when they're read
+ * from start to end; 0, the default, turns that off.
+ */
+WS_DLL_PUBLIC
+void wtap_set_inflate_threads(guint threads);
+
 /*** get various information snippets about the current file ***/
 
 /** Return an approximation of the amount of data we've read sequentially
@@ -71,6 +71,22 @@ extern "C" {
   #define WS_RETNONNULL
 #endif
 
+/*
+ * WS_THREAD_LOCAL, before a static or global variable, means "each
+ * thread gets its own copy of this variable".
+ */
+#if defined(_MSC_VER)
+  #define WS_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+  /* This includes clang */
+  #define WS_THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+  #define WS_THREAD_LOCAL _Thread_local
+#else
+  /* Sun C, IBM XL C and HP aCC all understand the GCC spelling. */
+  #define WS_THREAD_LOCAL __thread
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
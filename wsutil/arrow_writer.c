@@ -0,0 +1,867 @@
+/* arrow_writer.c
+ * Routines for writing columns of values as an Apache Arrow IPC stream.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "arrow_writer.h"
+
+/*
+ * A stream is a schema message, then dictionary and record batch
+ * messages, then an end-of-stream marker.  Each message is
+ *
+ *   0xFFFFFFFF, the length of the metadata, the metadata (a Message
+ *   flatbuffer, padded to 8 bytes), and the body (the buffers of the
+ *   arrays, each padded to 8 bytes)
+ *
+ * all little-endian.  The flatbuffers are few and small, so they are
+ * built with the minimal builder below rather than with generated code;
+ * the table and field numbers are those of Schema.fbs and Message.fbs in
+ * the Arrow sources.
+ */
+
+#define ARROW_CONTINUATION          0xFFFFFFFFU
+#define ARROW_METADATA_V5           4
+
+/* MessageHeader */
+#define ARROW_HEADER_SCHEMA         1
+#define ARROW_HEADER_DICTIONARY     2
+#define ARROW_HEADER_RECORD_BATCH   3
+
+/* Type */
+#define ARROW_TYPE_INT              2
+#define ARROW_TYPE_FLOATING_POINT   3
+#define ARROW_TYPE_BINARY           4
+#define ARROW_TYPE_UTF8             5
+#define ARROW_TYPE_BOOL             6
+#define ARROW_TYPE_TIMESTAMP        10
+#define ARROW_TYPE_DURATION         18
+
+#define ARROW_PRECISION_DOUBLE      2
+#define ARROW_UNIT_NANOSECOND       3
+
+/*
+ * Flatbuffers are built back to front: an object is referred to by its
+ * distance from the end of the buffer, and is complete before anything
+ * that refers to it is started.
+ */
+typedef gsize fb_ref;
+
+#define FB_MAX_FIELDS   8
+
+typedef struct {
+    guint8     *buf;
+    gsize       size;
+    gsize       len;            /* used, at the end of buf */
+    gsize       minalign;
+    gsize       table_start;
+    guint       num_fields;
+    fb_ref      field_at[FB_MAX_FIELDS];    /* 0 if not set */
+} fb_builder;
+
+static void
+fb_init(fb_builder *b)
+{
+    memset(b, 0, sizeof *b);
+    b->minalign = 8;
+}
+
+static void
+fb_free(fb_builder *b)
+{
+    g_free(b->buf);
+}
+
+static guint8 *
+fb_make_room(fb_builder *b, gsize n)
+{
+    if (b->len + n > b->size) {
+        gsize new_size = MAX(b->size * 2, b->len + n + 256);
+        guint8 *new_buf = (guint8 *)g_malloc(new_size);
+
+        if (b->len > 0) {
+            memcpy(new_buf + new_size - b->len, b->buf + b->size - b->len, b->len);
+        }
+        g_free(b->buf);
+        b->buf = new_buf;
+        b->size = new_size;
+    }
+    b->len += n;
+    return b->buf + b->size - b->len;
+}
+
+static void
+fb_put(fb_builder *b, const void *data, gsize n)
+{
+    memcpy(fb_make_room(b, n), data, n);
+}
+
+static void
+fb_pad(fb_builder *b, gsize n)
+{
+    if (n > 0) {
+        memset(fb_make_room(b, n), 0, n);
+    }
+}
+
+/* Pads so that, once additional bytes are added, the data is aligned. */
+static void
+fb_prep(fb_builder *b, gsize align, gsize additional)
+{
+    if (align > b->minalign) {
+        b->minalign = align;
+    }
+    fb_pad(b, (align - (b->len + additional) % align) % align);
+}
+
+static void
+fb_scalar(fb_builder *b, gsize size, guint64 value)
+{
+    guint8 bytes[8];
+
+    for (gsize i = 0; i < size; i++) {
+        bytes[i] = (guint8)(value >> (8 * i));
+    }
+    fb_prep(b, size, 0);
+    fb_put(b, bytes, size);
+}
+
+static void
+fb_uoffset(fb_builder *b, fb_ref ref)
+{
+    fb_prep(b, 4, 0);
+    fb_scalar(b, 4, b->len + 4 - ref);
+}
+
+static fb_ref
+fb_string(fb_builder *b, const char *str)
+{
+    gsize len = strlen(str);
+
+    fb_prep(b, 4, len + 1);
+    fb_pad(b, 1);
+    fb_put(b, str, len);
+    fb_scalar(b, 4, len);
+    return b->len;
+}
+
+static fb_ref
+fb_offset_vector(fb_builder *b, const fb_ref *refs, guint n)
+{
+    fb_prep(b, 4, 4 * (gsize)n);
+    for (guint i = n; i-- > 0; ) {
+        fb_uoffset(b, refs[i]);
+    }
+    fb_scalar(b, 4, n);
+    return b->len;
+}
+
+/* A vector of structs of two longs (FieldNode and Buffer). */
+static fb_ref
+fb_pair_vector(fb_builder *b, const gint64 *pairs, guint n)
+{
+    fb_prep(b, 8, 16 * (gsize)n);
+    for (guint i = n; i-- > 0; ) {
+        fb_scalar(b, 8, (guint64)pairs[2 * i + 1]);
+        fb_scalar(b, 8, (guint64)pairs[2 * i]);
+    }
+    fb_scalar(b, 4, n);
+    return b->len;
+}
+
+static void
+fb_start_table(fb_builder *b)
+{
+    b->table_start = b->len;
+    b->num_fields = 0;
+    memset(b->field_at, 0, sizeof b->field_at);
+}
+
+static void
+fb_set_field(fb_builder *b, guint id)
+{
+    g_assert(id < FB_MAX_FIELDS);
+    b->field_at[id] = b->len;
+    if (id >= b->num_fields) {
+        b->num_fields = id + 1;
+    }
+}
+
+static void
+fb_field_scalar(fb_builder *b, guint id, gsize size, guint64 value)
+{
+    fb_scalar(b, size, value);
+    fb_set_field(b, id);
+}
+
+static void
+fb_field_offset(fb_builder *b, guint id, fb_ref ref)
+{
+    fb_uoffset(b, ref);
+    fb_set_field(b, id);
+}
+
+static fb_ref
+fb_end_table(fb_builder *b)
+{
+    fb_ref table, vtable;
+    gint32 soffset;
+
+    /* The offset of the vtable, which goes just before the table. */
+    fb_scalar(b, 4, 0);
+    table = b->len;
+
+    for (guint id = b->num_fields; id-- > 0; ) {
+        fb_scalar(b, 2, b->field_at[id] ? table - b->field_at[id] : 0);
+    }
+    fb_scalar(b, 2, table - b->table_start);
+    fb_scalar(b, 2, 4 + 2 * b->num_fields);
+    vtable = b->len;
+
+    soffset = GINT32_TO_LE((gint32)(vtable - table));
+    memcpy(b->buf + b->size - table, &soffset, 4);
+    return table;
+}
+
+static fb_ref
+fb_empty_table(fb_builder *b)
+{
+    fb_start_table(b);
+    return fb_end_table(b);
+}
+
+static void
+fb_finish(fb_builder *b, fb_ref root)
+{
+    fb_prep(b, b->minalign, 4);
+    fb_uoffset(b, root);
+}
+
+/*
+ * Columns.
+ */
+typedef struct {
+    char               *name;
+    arrow_column_type   type;
+    gboolean            set;            /* in the current row */
+    guint               null_count;
+    GByteArray         *validity;
+    GByteArray         *values;         /* values, indices or bytes */
+    GByteArray         *offsets;        /* of the bytes of binary and plain string columns */
+    /*
+     * String columns are collected as dictionary indices until the first
+     * batch is written; then they are either kept that way or turned into
+     * plain string columns.
+     */
+    gboolean            dictionary;
+    GHashTable         *dict_index;     /* string -> index + 1 */
+    GPtrArray          *dict_values;    /* the strings, by index */
+    guint               dict_written;   /* entries already in the stream */
+    gboolean            dict_started;   /* a dictionary batch was written */
+} arrow_column_t;
+
+struct arrow_writer {
+    FILE       *fh;
+    guint       batch_rows;
+    guint       rows;                   /* in the current batch */
+    GArray     *columns;                /* arrow_column_t */
+    gboolean    schema_written;
+    gboolean    error;
+};
+
+static gboolean
+column_is_variable(const arrow_column_t *col)
+{
+    return col->type == ARROW_COLUMN_BINARY ||
+        (col->type == ARROW_COLUMN_STRING && !col->dictionary);
+}
+
+/* Bytes per value; 0 for bit-packed booleans and variable-length values. */
+static guint
+column_width(const arrow_column_t *col)
+{
+    switch (col->type) {
+        case ARROW_COLUMN_UINT32:
+        case ARROW_COLUMN_INT32:
+            return 4;
+        case ARROW_COLUMN_UINT64:
+        case ARROW_COLUMN_INT64:
+        case ARROW_COLUMN_DOUBLE:
+        case ARROW_COLUMN_TIMESTAMP:
+        case ARROW_COLUMN_DURATION:
+            return 8;
+        case ARROW_COLUMN_STRING:
+            return col->dictionary ? 4 : 0;
+        default:
+            return 0;
+    }
+}
+
+static void
+append_bit(GByteArray *bits, guint index, gboolean value)
+{
+    if (index % 8 == 0) {
+        guint8 zero = 0;
+        g_byte_array_append(bits, &zero, 1);
+    }
+    if (value) {
+        bits->data[index / 8] |= (guint8)(1 << (index % 8));
+    }
+}
+
+static void
+append_le(GByteArray *array, guint64 value, guint width)
+{
+    guint8 bytes[8];
+
+    for (guint i = 0; i < width; i++) {
+        bytes[i] = (guint8)(value >> (8 * i));
+    }
+    g_byte_array_append(array, bytes, width);
+}
+
+static void
+append_offset(arrow_column_t *col)
+{
+    append_le(col->offsets, col->values->len, 4);
+}
+
+static void
+reset_column(arrow_column_t *col)
+{
+    g_byte_array_set_size(col->validity, 0);
+    g_byte_array_set_size(col->values, 0);
+    g_byte_array_set_size(col->offsets, 0);
+    if (column_is_variable(col)) {
+        append_offset(col);
+    }
+    col->null_count = 0;
+}
+
+arrow_writer *
+arrow_writer_new(FILE *fh, guint batch_rows)
+{
+    arrow_writer *writer = g_new0(arrow_writer, 1);
+
+    writer->fh = fh;
+    writer->batch_rows = batch_rows ? batch_rows : ARROW_WRITER_DEFAULT_BATCH_ROWS;
+    writer->columns = g_array_new(FALSE, TRUE, sizeof(arrow_column_t));
+    return writer;
+}
+
+guint
+arrow_writer_add_column(arrow_writer *writer, const char *name, arrow_column_type type)
+{
+    arrow_column_t col;
+
+    g_assert(writer->rows == 0 && !writer->schema_written);
+
+    memset(&col, 0, sizeof col);
+    col.name = g_strdup(name);
+    col.type = type;
+    col.validity = g_byte_array_new();
+    col.values = g_byte_array_new();
+    col.offsets = g_byte_array_new();
+    if (type == ARROW_COLUMN_STRING) {
+        col.dictionary = TRUE;
+        col.dict_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        col.dict_values = g_ptr_array_new();
+    }
+    reset_column(&col);
+    g_array_append_val(writer->columns, col);
+    return writer->columns->len - 1;
+}
+
+static arrow_column_t *
+start_value(arrow_writer *writer, guint column, gboolean valid)
+{
+    arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, column);
+
+    g_assert(!col->set);
+    col->set = TRUE;
+    append_bit(col->validity, writer->rows, valid);
+    if (!valid) {
+        col->null_count++;
+    }
+    return col;
+}
+
+void
+arrow_writer_append_null(arrow_writer *writer, guint column)
+{
+    arrow_column_t *col = start_value(writer, column, FALSE);
+    guint width = column_width(col);
+
+    if (width) {
+        append_le(col->values, 0, width);
+    } else if (col->type == ARROW_COLUMN_BOOL) {
+        append_bit(col->values, writer->rows, FALSE);
+    } else {
+        append_offset(col);
+    }
+}
+
+void
+arrow_writer_append_uint(arrow_writer *writer, guint column, guint64 value)
+{
+    arrow_column_t *col = start_value(writer, column, TRUE);
+
+    if (col->type == ARROW_COLUMN_BOOL) {
+        append_bit(col->values, writer->rows, value != 0);
+    } else {
+        g_assert(col->type == ARROW_COLUMN_UINT32 || col->type == ARROW_COLUMN_UINT64);
+        append_le(col->values, value, column_width(col));
+    }
+}
+
+void
+arrow_writer_append_int(arrow_writer *writer, guint column, gint64 value)
+{
+    arrow_column_t *col = start_value(writer, column, TRUE);
+
+    g_assert(col->type == ARROW_COLUMN_INT32 || col->type == ARROW_COLUMN_INT64 ||
+             col->type == ARROW_COLUMN_TIMESTAMP || col->type == ARROW_COLUMN_DURATION);
+    append_le(col->values, (guint64)value, column_width(col));
+}
+
+void
+arrow_writer_append_double(arrow_writer *writer, guint column, double value)
+{
+    arrow_column_t *col = start_value(writer, column, TRUE);
+    guint64 bits;
+
+    g_assert(col->type == ARROW_COLUMN_DOUBLE);
+    memcpy(&bits, &value, sizeof bits);
+    append_le(col->values, bits, 8);
+}
+
+void
+arrow_writer_append_bytes(arrow_writer *writer, guint column, const guint8 *data, gsize len)
+{
+    arrow_column_t *col = start_value(writer, column, TRUE);
+
+    g_assert(column_is_variable(col));
+    if (len != 0)
+        g_byte_array_append(col->values, data, (guint)len);
+    append_offset(col);
+}
+
+void
+arrow_writer_append_string(arrow_writer *writer, guint column, const char *str)
+{
+    arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, column);
+    guint index;
+
+    g_assert(col->type == ARROW_COLUMN_STRING);
+    if (!col->dictionary) {
+        arrow_writer_append_bytes(writer, column, (const guint8 *)str, strlen(str));
+        return;
+    }
+
+    start_value(writer, column, TRUE);
+    index = GPOINTER_TO_UINT(g_hash_table_lookup(col->dict_index, str));
+    if (index == 0) {
+        char *copy = g_strdup(str);
+
+        g_ptr_array_add(col->dict_values, copy);
+        g_hash_table_insert(col->dict_index, copy, GUINT_TO_POINTER(col->dict_values->len));
+        index = col->dict_values->len;
+    }
+    append_le(col->values, index - 1, 4);
+}
+
+/*
+ * Messages.
+ */
+static void
+write_bytes(arrow_writer *writer, const void *data, gsize len)
+{
+    if (len > 0 && fwrite(data, 1, len, writer->fh) != len) {
+        writer->error = TRUE;
+    }
+}
+
+static void
+write_message(arrow_writer *writer, fb_builder *b, guint8 header_type, fb_ref header, const GByteArray *body)
+{
+    guint32 prefix[2];
+
+    fb_start_table(b);
+    fb_field_scalar(b, 3, 8, body ? body->len : 0);     /* bodyLength */
+    fb_field_offset(b, 2, header);                      /* header */
+    fb_field_scalar(b, 0, 2, ARROW_METADATA_V5);        /* version */
+    fb_field_scalar(b, 1, 1, header_type);              /* header_type */
+    fb_finish(b, fb_end_table(b));
+
+    /* The length includes the padding, which fb_finish() has added. */
+    prefix[0] = GUINT32_TO_LE(ARROW_CONTINUATION);
+    prefix[1] = GUINT32_TO_LE((guint32)b->len);
+    write_bytes(writer, prefix, sizeof prefix);
+    write_bytes(writer, b->buf + b->size - b->len, b->len);
+    if (body) {
+        write_bytes(writer, body->data, body->len);
+    }
+}
+
+/* Adds a buffer to a message body, and its offset and length to the list. */
+static void
+add_buffer(GByteArray *body, GArray *buffers, const guint8 *data, gsize len)
+{
+    static const guint8 zeros[8];
+    gint64 pair[2];
+
+    pair[0] = body->len;
+    pair[1] = len;
+    g_array_append_vals(buffers, pair, 2);
+    g_byte_array_append(body, data, (guint)len);
+    g_byte_array_append(body, zeros, (8 - len % 8) % 8);
+}
+
+/* A RecordBatch table, given its nodes and buffers. */
+static fb_ref
+record_batch(fb_builder *b, gint64 length, GArray *nodes, GArray *buffers)
+{
+    fb_ref nodes_ref = fb_pair_vector(b, (gint64 *)(void *)nodes->data, nodes->len / 2);
+    fb_ref buffers_ref = fb_pair_vector(b, (gint64 *)(void *)buffers->data, buffers->len / 2);
+
+    fb_start_table(b);
+    fb_field_scalar(b, 0, 8, (guint64)length);         /* length */
+    fb_field_offset(b, 1, nodes_ref);                   /* nodes */
+    fb_field_offset(b, 2, buffers_ref);                 /* buffers */
+    return fb_end_table(b);
+}
+
+static fb_ref
+int_type(fb_builder *b, guint bit_width, gboolean is_signed)
+{
+    fb_start_table(b);
+    fb_field_scalar(b, 0, 4, bit_width);                /* bitWidth */
+    fb_field_scalar(b, 1, 1, is_signed);                /* is_signed */
+    return fb_end_table(b);
+}
+
+static fb_ref
+schema_field(fb_builder *b, const arrow_column_t *col, gint64 dict_id)
+{
+    fb_ref name, type, dictionary = 0, children;
+    guint8 type_type;
+
+    name = fb_string(b, col->name);
+    children = fb_offset_vector(b, NULL, 0);
+
+    switch (col->type) {
+        case ARROW_COLUMN_BOOL:
+            type_type = ARROW_TYPE_BOOL;
+            type = fb_empty_table(b);
+            break;
+        case ARROW_COLUMN_UINT32:
+        case ARROW_COLUMN_INT32:
+            type_type = ARROW_TYPE_INT;
+            type = int_type(b, 32, col->type == ARROW_COLUMN_INT32);
+            break;
+        case ARROW_COLUMN_UINT64:
+        case ARROW_COLUMN_INT64:
+            type_type = ARROW_TYPE_INT;
+            type = int_type(b, 64, col->type == ARROW_COLUMN_INT64);
+            break;
+        case ARROW_COLUMN_DOUBLE:
+            type_type = ARROW_TYPE_FLOATING_POINT;
+            fb_start_table(b);
+            fb_field_scalar(b, 0, 2, ARROW_PRECISION_DOUBLE);   /* precision */
+            type = fb_end_table(b);
+            break;
+        case ARROW_COLUMN_TIMESTAMP:
+        {
+            fb_ref timezone = fb_string(b, "UTC");
+
+            type_type = ARROW_TYPE_TIMESTAMP;
+            fb_start_table(b);
+            fb_field_offset(b, 1, timezone);                    /* timezone */
+            fb_field_scalar(b, 0, 2, ARROW_UNIT_NANOSECOND);    /* unit */
+            type = fb_end_table(b);
+            break;
+        }
+        case ARROW_COLUMN_DURATION:
+            type_type = ARROW_TYPE_DURATION;
+            fb_start_table(b);
+            fb_field_scalar(b, 0, 2, ARROW_UNIT_NANOSECOND);    /* unit */
+            type = fb_end_table(b);
+            break;
+        case ARROW_COLUMN_BINARY:
+            type_type = ARROW_TYPE_BINARY;
+            type = fb_empty_table(b);
+            break;
+        case ARROW_COLUMN_STRING:
+        default:
+            type_type = ARROW_TYPE_UTF8;
+            type = fb_empty_table(b);
+            break;
+    }
+
+    if (col->dictionary) {
+        fb_ref index_type = int_type(b, 32, TRUE);
+
+        fb_start_table(b);
+        fb_field_scalar(b, 0, 8, (guint64)dict_id);         /* id */
+        fb_field_offset(b, 1, index_type);                  /* indexType */
+        dictionary = fb_end_table(b);
+    }
+
+    fb_start_table(b);
+    fb_field_offset(b, 0, name);                            /* name */
+    fb_field_offset(b, 3, type);                            /* type */
+    if (dictionary) {
+        fb_field_offset(b, 4, dictionary);                  /* dictionary */
+    }
+    fb_field_offset(b, 5, children);                        /* children */
+    fb_field_scalar(b, 1, 1, TRUE);                         /* nullable */
+    fb_field_scalar(b, 2, 1, type_type);                    /* type_type */
+    return fb_end_table(b);
+}
+
+static void
+write_schema(arrow_writer *writer)
+{
+    fb_builder b;
+    guint num_columns = writer->columns->len;
+    fb_ref *fields = g_new(fb_ref, num_columns);
+    fb_ref fields_ref;
+
+    fb_init(&b);
+    for (guint i = 0; i < num_columns; i++) {
+        fields[i] = schema_field(&b, &g_array_index(writer->columns, arrow_column_t, i), i);
+    }
+    fields_ref = fb_offset_vector(&b, fields, num_columns);
+
+    fb_start_table(&b);
+    fb_field_offset(&b, 1, fields_ref);                     /* fields */
+    fb_field_scalar(&b, 0, 2, 0);                           /* endianness: Little */
+    write_message(writer, &b, ARROW_HEADER_SCHEMA, fb_end_table(&b), NULL);
+
+    fb_free(&b);
+    g_free(fields);
+}
+
+/* Writes the dictionary entries of a column that aren't in the stream yet;
+ * the first dictionary batch of a column is written even if it is empty. */
+static void
+write_dictionary(arrow_writer *writer, arrow_column_t *col, gint64 dict_id)
+{
+    guint first = col->dict_written;
+    guint count = col->dict_values->len - first;
+    GByteArray *offsets, *data, *body;
+    GArray *nodes, *buffers;
+    gint64 node[2];
+    fb_builder b;
+    fb_ref batch;
+
+    if (count == 0 && col->dict_started) {
+        return;
+    }
+
+    offsets = g_byte_array_new();
+    data = g_byte_array_new();
+    append_le(offsets, 0, 4);
+    for (guint i = first; i < col->dict_values->len; i++) {
+        const char *str = (const char *)g_ptr_array_index(col->dict_values, i);
+
+        g_byte_array_append(data, (const guint8 *)str, (guint)strlen(str));
+        append_le(offsets, data->len, 4);
+    }
+
+    body = g_byte_array_new();
+    nodes = g_array_new(FALSE, FALSE, sizeof(gint64));
+    buffers = g_array_new(FALSE, FALSE, sizeof(gint64));
+    node[0] = count;
+    node[1] = 0;
+    g_array_append_vals(nodes, node, 2);
+    add_buffer(body, buffers, NULL, 0);                     /* no nulls */
+    add_buffer(body, buffers, offsets->data, offsets->len);
+    add_buffer(body, buffers, data->data, data->len);
+
+    fb_init(&b);
+    batch = record_batch(&b, count, nodes, buffers);
+    fb_start_table(&b);
+    fb_field_scalar(&b, 0, 8, (guint64)dict_id);            /* id */
+    fb_field_offset(&b, 1, batch);                          /* data */
+    fb_field_scalar(&b, 2, 1, col->dict_started);           /* isDelta */
+    write_message(writer, &b, ARROW_HEADER_DICTIONARY, fb_end_table(&b), body);
+
+    col->dict_written = col->dict_values->len;
+    col->dict_started = TRUE;
+    fb_free(&b);
+    g_array_free(nodes, TRUE);
+    g_array_free(buffers, TRUE);
+    g_byte_array_free(body, TRUE);
+    g_byte_array_free(data, TRUE);
+    g_byte_array_free(offsets, TRUE);
+}
+
+/* Turns the indices collected for a string column into plain strings. */
+static void
+undo_dictionary(arrow_column_t *col, guint rows)
+{
+    GByteArray *indices = col->values;
+
+    col->dictionary = FALSE;
+    col->values = g_byte_array_new();
+    g_byte_array_set_size(col->offsets, 0);
+    append_offset(col);
+    for (guint row = 0; row < rows; row++) {
+        if (col->validity->data[row / 8] & (1 << (row % 8))) {
+            guint32 index = GUINT32_FROM_LE(((guint32 *)(void *)indices->data)[row]);
+            const char *str = (const char *)g_ptr_array_index(col->dict_values, index);
+
+            g_byte_array_append(col->values, (const guint8 *)str, (guint)strlen(str));
+        }
+        append_offset(col);
+    }
+    g_byte_array_free(indices, TRUE);
+
+    g_hash_table_destroy(col->dict_index);
+    col->dict_index = NULL;
+    g_ptr_array_free(col->dict_values, TRUE);
+    col->dict_values = NULL;
+}
+
+/*
+ * The schema is written with the first batch, as whether a string column
+ * is dictionary-encoded depends on how many different values it has: it
+ * is if they are at most half of the values.
+ */
+static void
+start_stream(arrow_writer *writer)
+{
+    for (guint i = 0; i < writer->columns->len; i++) {
+        arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, i);
+
+        if (col->dictionary &&
+                col->dict_values->len * 2 > writer->rows - col->null_count) {
+            undo_dictionary(col, writer->rows);
+        }
+    }
+    write_schema(writer);
+}
+
+static void
+write_batch(arrow_writer *writer)
+{
+    GByteArray *body = g_byte_array_new();
+    GArray *nodes = g_array_new(FALSE, FALSE, sizeof(gint64));
+    GArray *buffers = g_array_new(FALSE, FALSE, sizeof(gint64));
+    fb_builder b;
+
+    if (!writer->schema_written) {
+        start_stream(writer);
+    }
+    for (guint i = 0; i < writer->columns->len; i++) {
+        arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, i);
+
+        if (col->dictionary) {
+            write_dictionary(writer, col, i);
+        }
+    }
+    writer->schema_written = TRUE;
+
+    for (guint i = 0; i < writer->columns->len; i++) {
+        arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, i);
+        gint64 node[2];
+
+        node[0] = writer->rows;
+        node[1] = col->null_count;
+        g_array_append_vals(nodes, node, 2);
+        add_buffer(body, buffers, col->validity->data, col->validity->len);
+        if (column_is_variable(col)) {
+            add_buffer(body, buffers, col->offsets->data, col->offsets->len);
+        }
+        add_buffer(body, buffers, col->values->data, col->values->len);
+        reset_column(col);
+    }
+
+    fb_init(&b);
+    write_message(writer, &b, ARROW_HEADER_RECORD_BATCH,
+            record_batch(&b, writer->rows, nodes, buffers), body);
+    writer->rows = 0;
+
+    fb_free(&b);
+    g_array_free(nodes, TRUE);
+    g_array_free(buffers, TRUE);
+    g_byte_array_free(body, TRUE);
+}
+
+gboolean
+arrow_writer_end_row(arrow_writer *writer)
+{
+    for (guint i = 0; i < writer->columns->len; i++) {
+        arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, i);
+
+        if (!col->set) {
+            arrow_writer_append_null(writer, i);
+        }
+        col->set = FALSE;
+    }
+
+    if (++writer->rows == writer->batch_rows) {
+        write_batch(writer);
+    }
+    return !writer->error;
+}
+
+gboolean
+arrow_writer_finish(arrow_writer *writer)
+{
+    guint32 end_of_stream[2] = { GUINT32_TO_LE(ARROW_CONTINUATION), 0 };
+
+    /* Even without rows, there has to be a schema. */
+    if (writer->rows > 0 || !writer->schema_written) {
+        write_batch(writer);
+    }
+    write_bytes(writer, end_of_stream, sizeof end_of_stream);
+    return !writer->error;
+}
+
+void
+arrow_writer_free(arrow_writer *writer)
+{
+    if (!writer) {
+        return;
+    }
+
+    for (guint i = 0; i < writer->columns->len; i++) {
+        arrow_column_t *col = &g_array_index(writer->columns, arrow_column_t, i);
+
+        g_free(col->name);
+        g_byte_array_free(col->validity, TRUE);
+        g_byte_array_free(col->values, TRUE);
+        g_byte_array_free(col->offsets, TRUE);
+        if (col->dict_index) {
+            g_hash_table_destroy(col->dict_index);
+        }
+        if (col->dict_values) {
+            g_ptr_array_free(col->dict_values, TRUE);
+        }
+    }
+    g_array_free(writer->columns, TRUE);
+    g_free(writer);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
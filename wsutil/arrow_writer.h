@@ -0,0 +1,137 @@
+/* arrow_writer.h
+ * Routines for writing columns of values as an Apache Arrow IPC stream.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __ARROW_WRITER_H__
+#define __ARROW_WRITER_H__
+
+#include "ws_symbol_export.h"
+#include <glib.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Writes rows of values to a file in the Apache Arrow IPC streaming format
+ * (https://arrow.apache.org/docs/format/Columnar.html), which analysis
+ * tools (pyarrow, pandas, Polars, DuckDB, ...) can read without parsing.
+ *
+ * Rows are collected column by column and written in record batches of
+ * a fixed number of rows.  The schema is written with the first batch;
+ * a string column whose values in that batch are mostly repeated is
+ * dictionary-encoded, with delta dictionaries in the batches after it.
+ *
+ * Example:
+ *
+ *  arrow_writer *writer = arrow_writer_new(stdout, 0);
+ *  arrow_writer_add_column(writer, "frame.number", ARROW_COLUMN_UINT32);
+ *  arrow_writer_add_column(writer, "http.host", ARROW_COLUMN_STRING);
+ *  arrow_writer_append_uint(writer, 0, 1);
+ *  arrow_writer_append_string(writer, 1, "www.example.com");
+ *  arrow_writer_end_row(writer);
+ *  arrow_writer_append_uint(writer, 0, 2);
+ *  arrow_writer_append_null(writer, 1);
+ *  arrow_writer_end_row(writer);
+ *  arrow_writer_finish(writer);
+ *  arrow_writer_free(writer);
+ */
+
+typedef enum {
+    ARROW_COLUMN_BOOL,
+    ARROW_COLUMN_UINT32,
+    ARROW_COLUMN_UINT64,
+    ARROW_COLUMN_INT32,
+    ARROW_COLUMN_INT64,
+    ARROW_COLUMN_DOUBLE,
+    ARROW_COLUMN_TIMESTAMP,     /**< nanoseconds since the epoch, UTC */
+    ARROW_COLUMN_DURATION,      /**< nanoseconds */
+    ARROW_COLUMN_BINARY,
+    ARROW_COLUMN_STRING         /**< UTF-8 */
+} arrow_column_type;
+
+/** Rows per record batch if 0 is given to arrow_writer_new(). */
+#define ARROW_WRITER_DEFAULT_BATCH_ROWS 65536
+
+typedef struct arrow_writer arrow_writer;
+
+/**
+ * Creates a writer; nothing is written until the first batch is full or
+ * arrow_writer_finish() is called.
+ */
+WS_DLL_PUBLIC arrow_writer *
+arrow_writer_new(FILE *fh, guint batch_rows);
+
+/**
+ * Adds a column; all the columns must be added before the first value.
+ * Returns the index of the column.
+ */
+WS_DLL_PUBLIC guint
+arrow_writer_add_column(arrow_writer *writer, const char *name, arrow_column_type type);
+
+/*
+ * Set the value of a column in the current row; a column that isn't set
+ * is null.  Only one value can be set for a column in a row, and the
+ * function must fit the type of the column: _uint for the unsigned and
+ * boolean columns, _int for the signed, timestamp and duration columns.
+ */
+WS_DLL_PUBLIC void
+arrow_writer_append_null(arrow_writer *writer, guint column);
+
+WS_DLL_PUBLIC void
+arrow_writer_append_uint(arrow_writer *writer, guint column, guint64 value);
+
+WS_DLL_PUBLIC void
+arrow_writer_append_int(arrow_writer *writer, guint column, gint64 value);
+
+WS_DLL_PUBLIC void
+arrow_writer_append_double(arrow_writer *writer, guint column, double value);
+
+WS_DLL_PUBLIC void
+arrow_writer_append_bytes(arrow_writer *writer, guint column, const guint8 *data, gsize len);
+
+WS_DLL_PUBLIC void
+arrow_writer_append_string(arrow_writer *writer, guint column, const char *str);
+
+/**
+ * Ends the current row, writing a batch if it is full.  Returns FALSE if
+ * writing failed.
+ */
+WS_DLL_PUBLIC gboolean
+arrow_writer_end_row(arrow_writer *writer);
+
+/**
+ * Writes the rows that are left and the end of the stream.  Returns FALSE
+ * if writing failed.
+ */
+WS_DLL_PUBLIC gboolean
+arrow_writer_finish(arrow_writer *writer);
+
+WS_DLL_PUBLIC void
+arrow_writer_free(arrow_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ARROW_WRITER_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
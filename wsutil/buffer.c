@@ -37,6 +37,7 @@ ws_buffer_init(Buffer* buffer, gsize space)
 	}
 	buffer->start = 0;
 	buffer->first_free = 0;
+	buffer->own_data = NULL;
 }
 
 /* Frees the memory used by a buffer */
@@ -44,6 +45,10 @@ void
 ws_buffer_free(Buffer* buffer)
 {
 	g_assert(buffer);
+	if (buffer->own_data) {
+		buffer->data = buffer->own_data;
+		buffer->own_data = NULL;
+	}
 	if (buffer->allocated == SMALL_BUFFER_SIZE) {
 		g_assert(buffer->data);
 		g_ptr_array_add(small_buffers, buffer->data);
@@ -54,6 +59,36 @@ ws_buffer_free(Buffer* buffer)
 	buffer->data = NULL;
 }
 
+/* Makes the buffer refer to data that it doesn't own; our own memory is
+	kept until the buffer is freed or needs space again. */
+void
+ws_buffer_lend(Buffer* buffer, const guint8 *data, gsize bytes)
+{
+	g_assert(buffer);
+	if (!buffer->own_data)
+		buffer->own_data = buffer->data;
+	buffer->data = (guint8 *)data;
+	buffer->start = 0;
+	buffer->first_free = bytes;
+}
+
+/* Stops referring to lent data, copying what's used of it to our own
+	memory. */
+static void
+ws_buffer_return_lent(Buffer* buffer)
+{
+	const guint8 *lent = buffer->data + buffer->start;
+	gsize space_used = buffer->first_free - buffer->start;
+
+	buffer->data = buffer->own_data;
+	buffer->own_data = NULL;
+	buffer->start = 0;
+	buffer->first_free = 0;
+	ws_buffer_assure_space(buffer, space_used);
+	memcpy(buffer->data, lent, space_used);
+	buffer->first_free = space_used;
+}
+
 /* Assures that there are 'space' bytes at the end of the used space
 	so that another routine can copy directly into the buffer space. After
 	doing that, the routine will also want to run
@@ -62,6 +97,8 @@ void
 ws_buffer_assure_space(Buffer* buffer, gsize space)
 {
 	g_assert(buffer);
+	if (buffer->own_data)
+		ws_buffer_return_lent(buffer);
 	gsize available_at_end = buffer->allocated - buffer->first_free;
 	gsize space_used;
 	gboolean space_at_beginning;
@@ -119,6 +156,11 @@ ws_buffer_remove_start(Buffer* buffer, gsize bytes)
 	buffer->start += bytes;
 
 	if (buffer->start == buffer->first_free) {
+		if (buffer->own_data) {
+			/* Nothing of the lent data is left to copy. */
+			buffer->data = buffer->own_data;
+			buffer->own_data = NULL;
+		}
 		buffer->start = 0;
 		buffer->first_free = 0;
 	}
@@ -23,6 +23,7 @@ typedef struct Buffer {
 	gsize	allocated;
 	gsize	start;
 	gsize	first_free;
+	guint8	*own_data;	/* our memory, while data is lent to us */
 } Buffer;
 
 WS_DLL_PUBLIC
@@ -35,6 +36,15 @@ WS_DLL_PUBLIC
 void ws_buffer_append(Buffer* buffer, guint8 *from, gsize bytes);
 WS_DLL_PUBLIC
 void ws_buffer_remove_start(Buffer* buffer, gsize bytes);
+/*
+ * Makes the buffer refer to data it doesn't own, such as a memory-mapped
+ * file, instead of copying it.  The buffer refers to it until it's
+ * emptied or freed, or until more space is asked of it, at which point
+ * what's left of the data is copied to the buffer's own memory; the data
+ * must stay valid until then.
+ */
+WS_DLL_PUBLIC
+void ws_buffer_lend(Buffer* buffer, const guint8 *data, gsize bytes);
 WS_DLL_PUBLIC
 void ws_buffer_cleanup(void);
 
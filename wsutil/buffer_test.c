@@ -0,0 +1,194 @@
+/* buffer_test.c
+ * Checks Buffers that are lent data they don't own
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/buffer.h>
+
+#define LENT_LEN	100
+
+static guint8 lent[LENT_LEN];
+
+static void
+fill_lent(void)
+{
+	int i;
+
+	for (i = 0; i < LENT_LEN; i++)
+		lent[i] = (guint8)i;
+}
+
+static void
+buffer_test_lend(void)
+{
+	Buffer	buf;
+	guint8	*own;
+
+	fill_lent();
+	ws_buffer_init(&buf, 1514);
+	own = buf.data;
+
+	ws_buffer_lend(&buf, lent, LENT_LEN);
+	g_assert_true(ws_buffer_start_ptr(&buf) == lent);
+	g_assert_cmpuint(ws_buffer_length(&buf), ==, LENT_LEN);
+
+	/* Lending again keeps the same memory of our own. */
+	ws_buffer_lend(&buf, lent + 10, LENT_LEN - 10);
+	g_assert_true(ws_buffer_start_ptr(&buf) == lent + 10);
+	g_assert_cmpuint(ws_buffer_length(&buf), ==, LENT_LEN - 10);
+	g_assert_true(buf.own_data == own);
+
+	ws_buffer_free(&buf);
+	g_assert_null(buf.data);
+	g_assert_null(buf.own_data);
+}
+
+/* Asking for space copies what's left of the lent data to our memory. */
+static void
+buffer_test_lend_grow(void)
+{
+	Buffer	buf;
+	guint8	*own;
+	guint8	more[] = { 0xaa, 0xbb, 0xcc };
+
+	fill_lent();
+	ws_buffer_init(&buf, 1514);
+	own = buf.data;
+
+	ws_buffer_lend(&buf, lent, LENT_LEN);
+	ws_buffer_remove_start(&buf, 20);
+	ws_buffer_append(&buf, more, sizeof more);
+
+	g_assert_true(buf.data == own);
+	g_assert_null(buf.own_data);
+	g_assert_cmpuint(ws_buffer_length(&buf), ==, LENT_LEN - 20 + sizeof more);
+	g_assert_true(memcmp(ws_buffer_start_ptr(&buf), lent + 20, LENT_LEN - 20) == 0);
+	g_assert_true(memcmp(ws_buffer_start_ptr(&buf) + LENT_LEN - 20, more, sizeof more) == 0);
+
+	/* The lent data is left alone. */
+	g_assert_cmpuint(lent[0], ==, 0);
+	g_assert_cmpuint(lent[LENT_LEN - 1], ==, LENT_LEN - 1);
+
+	ws_buffer_free(&buf);
+}
+
+/* Growing past our own memory while lent data is being copied. */
+static void
+buffer_test_lend_grow_large(void)
+{
+	Buffer	buf;
+	guint8	*big;
+	gsize	big_len = 64 * 1024;
+	gsize	i;
+
+	big = (guint8 *)g_malloc(big_len);
+	for (i = 0; i < big_len; i++)
+		big[i] = (guint8)(i * 7);
+
+	ws_buffer_init(&buf, 1514);
+	ws_buffer_lend(&buf, big, big_len);
+	ws_buffer_assure_space(&buf, 10);
+	g_assert_null(buf.own_data);
+	g_assert_true(buf.data != big);
+	g_assert_cmpuint(buf.allocated, >=, big_len + 10);
+	g_assert_cmpuint(ws_buffer_length(&buf), ==, big_len);
+	g_assert_true(memcmp(ws_buffer_start_ptr(&buf), big, big_len) == 0);
+	g_free(big);
+
+	ws_buffer_increase_length(&buf, 10);
+	g_assert_cmpuint(ws_buffer_length(&buf), ==, big_len + 10);
+	ws_buffer_free(&buf);
+}
+
+/* Emptying the buffer gives our memory back without copying anything. */
+static void
+buffer_test_lend_reclaim(void)
+{
+	Buffer	buf;
+	guint8	*own;
+
+	fill_lent();
+	ws_buffer_init(&buf, 1514);
+	own = buf.data;
+
+	ws_buffer_lend(&buf, lent, LENT_LEN);
+	ws_buffer_clean(&buf);
+	g_assert_true(buf.data == own);
+	g_assert_null(buf.own_data);
+	g_assert_cmpuint(ws_buffer_length(&buf), ==, 0);
+
+	/* It can be lent data again, and then used as usual. */
+	ws_buffer_lend(&buf, lent, LENT_LEN);
+	ws_buffer_remove_start(&buf, LENT_LEN);
+	g_assert_true(buf.data == own);
+	ws_buffer_append(&buf, lent, 10);
+	g_assert_true(memcmp(ws_buffer_start_ptr(&buf), lent, 10) == 0);
+
+	ws_buffer_free(&buf);
+}
+
+/* Freeing a buffer that's been lent data frees our memory, not the lent
+ * data; a small buffer's memory is handed to the next small buffer. */
+static void
+buffer_test_lend_free(void)
+{
+	Buffer	buf;
+	guint8	*own;
+
+	fill_lent();
+	ws_buffer_init(&buf, 1514);
+	own = buf.data;
+	ws_buffer_lend(&buf, lent, LENT_LEN);
+	ws_buffer_free(&buf);
+
+	ws_buffer_init(&buf, 1514);
+	g_assert_true(buf.data == own);
+	g_assert_null(buf.own_data);
+	ws_buffer_free(&buf);
+
+	ws_buffer_init(&buf, 64 * 1024);
+	ws_buffer_lend(&buf, lent, LENT_LEN);
+	ws_buffer_free(&buf);
+}
+
+int
+main(int argc, char **argv)
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/buffer/lend",			buffer_test_lend);
+	g_test_add_func("/buffer/lend_grow",		buffer_test_lend_grow);
+	g_test_add_func("/buffer/lend_grow_large",	buffer_test_lend_grow_large);
+	g_test_add_func("/buffer/lend_reclaim",		buffer_test_lend_reclaim);
+	g_test_add_func("/buffer/lend_free",		buffer_test_lend_free);
+
+	ret = g_test_run();
+	ws_buffer_cleanup();
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
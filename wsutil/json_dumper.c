@@ -14,6 +14,18 @@
 #include "json_dumper.h"
 
 #include <math.h>
+#include <stdarg.h>
+#include <string.h>
+
+/*
+ * SSE2 is part of x86-64, so it needs no flag and no check at run time;
+ * on 32-bit x86 it is used only if the compiler was told it can be.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_DUMPER_SSE2
+#include <emmintrin.h>
+#include "bits_ctz.h"
+#endif
 
 /*
  * json_dumper.state[current_depth] describes a nested element:
@@ -43,10 +55,92 @@ enum json_dumper_change {
 };
 
 static void
-json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
+flush_buffer(json_dumper *dumper)
+{
+    if (dumper->buffer_len > 0) {
+        fwrite(dumper->buffer, 1, dumper->buffer_len, dumper->output_file);
+        dumper->buffer_len = 0;
+    }
+}
+
+static inline void
+put_char(json_dumper *dumper, char c)
+{
+    if (dumper->buffer_len == JSON_DUMPER_BUFFER_SIZE) {
+        flush_buffer(dumper);
+    }
+    dumper->buffer[dumper->buffer_len++] = c;
+}
+
+static void
+put_mem(json_dumper *dumper, const char *data, size_t len)
+{
+    if (len > JSON_DUMPER_BUFFER_SIZE - dumper->buffer_len) {
+        flush_buffer(dumper);
+        if (len >= JSON_DUMPER_BUFFER_SIZE) {
+            // Not worth copying.
+            fwrite(data, 1, len, dumper->output_file);
+            return;
+        }
+    }
+    memcpy(dumper->buffer + dumper->buffer_len, data, len);
+    dumper->buffer_len += len;
+}
+
+static void
+put_string(json_dumper *dumper, const char *str)
+{
+    put_mem(dumper, str, strlen(str));
+}
+
+/*
+ * Returns the length of the leading part of str that can be copied as it
+ * is: up to a control character, a quote, a backslash, a slash (escaped
+ * after "<") or, if they are converted, a dot.
+ */
+static size_t
+json_plain_span(const guint8 *str, size_t len, gboolean dot_to_underscore)
+{
+    size_t i = 0;
+
+#ifdef JSON_DUMPER_SSE2
+    const __m128i max_cntrl = _mm_set1_epi8(0x1f);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i slash = _mm_set1_epi8('/');
+    /* Without the conversion, look for quotes twice instead. */
+    const __m128i dot = _mm_set1_epi8(dot_to_underscore ? '.' : '"');
+
+    for (; i + 16 <= len; i += 16) {
+        const __m128i block = _mm_loadu_si128((const __m128i *)(const void *)(str + i));
+        /* Unsigned block <= 0x1f, so that UTF-8 bytes are left alone. */
+        __m128i special = _mm_cmpeq_epi8(_mm_min_epu8(block, max_cntrl), block);
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(block, quote));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(block, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(block, slash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(block, dot));
+
+        guint32 mask = (guint32)_mm_movemask_epi8(special);
+        if (mask != 0) {
+            return i + ws_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        guint8 c = str[i];
+        if (c < 0x20 || c == '"' || c == '\\' || c == '/' || (dot_to_underscore && c == '.')) {
+            break;
+        }
+    }
+    return i;
+}
+
+static void
+json_puts_string(json_dumper *dumper, const char *str, gboolean dot_to_underscore)
 {
     if (!str) {
-        fputs("null", fp);
+        put_mem(dumper, "null", 4);
         return;
     }
 
@@ -55,25 +149,38 @@ json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
 
-    fputc('"', fp);
-    for (int i = 0; str[i]; i++) {
-        if ((guint)str[i] < 0x20) {
-            fputc('\\', fp);
-            fputs(json_cntrl[(guint)str[i]], fp);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
-            // Convert </script> to <\/script> to avoid breaking web pages.
-            fputs("\\/", fp);
-        } else {
-            if (str[i] == '\\' || str[i] == '"') {
-                fputc('\\', fp);
+    const guint8 *ustr = (const guint8 *)str;
+    size_t len = strlen(str);
+    size_t i = 0;
+
+    put_char(dumper, '"');
+    for (;;) {
+        size_t span = json_plain_span(ustr + i, len - i, dot_to_underscore);
+        put_mem(dumper, str + i, span);
+        i += span;
+        if (i == len) {
+            break;
+        }
+
+        guint8 c = ustr[i];
+        if (c < 0x20) {
+            put_char(dumper, '\\');
+            put_string(dumper, json_cntrl[c]);
+        } else if (c == '/') {
+            if (i > 0 && str[i - 1] == '<') {
+                // Convert </script> to <\/script> to avoid breaking web pages.
+                put_char(dumper, '\\');
             }
-            if (dot_to_underscore && str[i] == '.')
-                fputc('_', fp);
-            else
-                fputc(str[i], fp);
+            put_char(dumper, '/');
+        } else if (c == '.') {
+            put_char(dumper, '_');
+        } else {
+            put_char(dumper, '\\');
+            put_char(dumper, (char)c);
         }
+        i++;
     }
-    fputc('"', fp);
+    put_char(dumper, '"');
 }
 
 /**
@@ -100,6 +207,7 @@ json_dumper_bad(json_dumper *dumper, enum json_dumper_change change,
         /* Console output can be slow, disable log calls to speed up fuzzing. */
         return;
     }
+    flush_buffer(dumper);
     fflush(dumper->output_file);
     g_error("Bad json_dumper state: %s; change=%d type=%d depth=%d prev/curr/next state=%02x %02x %02x",
             what, change, type, dumper->current_depth, states[0], states[1], states[2]);
@@ -167,12 +275,12 @@ json_dumper_check_state(json_dumper *dumper, enum json_dumper_change change, enu
 }
 
 static void
-print_newline_indent(const json_dumper *dumper, int depth)
+print_newline_indent(json_dumper *dumper, int depth)
 {
     if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
-        fputc('\n', dumper->output_file);
+        put_char(dumper, '\n');
         for (int i = 0; i < depth; i++) {
-            fputs("  ", dumper->output_file);
+            put_mem(dumper, "  ", 2);
         }
     }
 }
@@ -208,7 +316,7 @@ prepare_token(json_dumper *dumper)
     }
 
     if (dumper->state[dumper->current_depth]) {
-        fputc(',', dumper->output_file);
+        put_char(dumper, ',');
     }
     print_newline_indent(dumper, dumper->current_depth);
 }
@@ -218,13 +326,13 @@ prepare_token(json_dumper *dumper)
  * necessary, it is preceded by newline and indentation).
  */
 static void
-finish_token(const json_dumper *dumper, char close_char)
+finish_token(json_dumper *dumper, char close_char)
 {
     // if the object/array was non-empty, add a newline and indentation.
     if (dumper->state[dumper->current_depth]) {
         print_newline_indent(dumper, dumper->current_depth - 1);
     }
-    fputc(close_char, dumper->output_file);
+    put_char(dumper, close_char);
 }
 
 void
@@ -235,7 +343,7 @@ json_dumper_begin_object(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    fputc('{', dumper->output_file);
+    put_char(dumper, '{');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_OBJECT;
     ++dumper->current_depth;
@@ -250,10 +358,10 @@ json_dumper_set_member_name(json_dumper *dumper, const char *name)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper->output_file, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
-    fputc(':', dumper->output_file);
+    json_puts_string(dumper, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
+    put_char(dumper, ':');
     if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
-        fputc(' ', dumper->output_file);
+        put_char(dumper, ' ');
     }
 
     dumper->state[dumper->current_depth - 1] |= JSON_DUMPER_HAS_NAME;
@@ -279,7 +387,7 @@ json_dumper_begin_array(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    fputc('[', dumper->output_file);
+    put_char(dumper, '[');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_ARRAY;
     ++dumper->current_depth;
@@ -306,7 +414,7 @@ json_dumper_value_string(json_dumper *dumper, const char *value)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper->output_file, value, FALSE);
+    json_puts_string(dumper, value, FALSE);
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
@@ -321,9 +429,9 @@ json_dumper_value_double(json_dumper *dumper, double value)
     prepare_token(dumper);
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE] = { 0 };
     if (isfinite(value) && g_ascii_dtostr(buffer, G_ASCII_DTOSTR_BUF_SIZE, value) && buffer[0]) {
-        fputs(buffer, dumper->output_file);
+        put_string(dumper, buffer);
     } else {
-        fputs("null", dumper->output_file);
+        put_mem(dumper, "null", 4);
     }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
@@ -337,7 +445,23 @@ json_dumper_value_va_list(json_dumper *dumper, const char *format, va_list ap)
     }
 
     prepare_token(dumper);
-    vfprintf(dumper->output_file, format, ap);
+
+    /* Format into the buffer if it fits, even if it has to be emptied. */
+    va_list ap_copy;
+    va_copy(ap_copy, ap);
+    size_t space = JSON_DUMPER_BUFFER_SIZE - dumper->buffer_len;
+    int len = vsnprintf(dumper->buffer + dumper->buffer_len, space, format, ap_copy);
+    va_end(ap_copy);
+    if (len >= 0 && (size_t)len < space) {
+        dumper->buffer_len += len;
+    } else {
+        flush_buffer(dumper);
+        if (len >= 0 && len < JSON_DUMPER_BUFFER_SIZE) {
+            dumper->buffer_len = vsnprintf(dumper->buffer, JSON_DUMPER_BUFFER_SIZE, format, ap);
+        } else {
+            vfprintf(dumper->output_file, format, ap);
+        }
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
@@ -352,14 +476,23 @@ json_dumper_value_anyf(json_dumper *dumper, const char *format, ...)
     va_end(ap);
 }
 
+void
+json_dumper_flush(json_dumper *dumper)
+{
+    flush_buffer(dumper);
+}
+
 gboolean
 json_dumper_finish(json_dumper *dumper)
 {
     if (!json_dumper_check_state(dumper, JSON_DUMPER_FINISH, JSON_DUMPER_TYPE_NONE)) {
+        // Don't hold back what was written before the error.
+        flush_buffer(dumper);
         return FALSE;
     }
 
-    fputc('\n', dumper->output_file);
+    put_char(dumper, '\n');
+    flush_buffer(dumper);
     dumper->state[0] = 0;
     return TRUE;
 }
@@ -376,7 +509,7 @@ json_dumper_begin_base64(json_dumper *dumper)
 
     prepare_token(dumper);
 
-    fputc('"', dumper->output_file);
+    put_char(dumper, '"');
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_BASE64;
     ++dumper->current_depth;
@@ -396,7 +529,7 @@ json_dumper_write_base64(json_dumper* dumper, const guchar *data, size_t len)
     while (len > 0) {
         gsize chunk_size = len < CHUNK_SIZE ? len : CHUNK_SIZE;
         gsize output_size = g_base64_encode_step(data, chunk_size, FALSE, buf, &dumper->base64_state, &dumper->base64_save);
-        fwrite(buf, 1, output_size, dumper->output_file);
+        put_mem(dumper, buf, output_size);
         data += chunk_size;
         len -= chunk_size;
     }
@@ -415,9 +548,9 @@ json_dumper_end_base64(json_dumper *dumper)
     gsize wrote;
 
     wrote = g_base64_encode_close(FALSE, buf, &dumper->base64_state, &dumper->base64_save);
-    fwrite(buf, 1, wrote, dumper->output_file);
+    put_mem(dumper, buf, wrote);
 
-    fputc('"', dumper->output_file);
+    put_char(dumper, '"');
 
     --dumper->current_depth;
 }
@@ -50,8 +50,11 @@ extern "C" {
 
 /** Maximum object/array nesting depth. */
 #define JSON_DUMPER_MAX_DEPTH   1100
+/** Size of the buffer in which output is collected before it is written. */
+#define JSON_DUMPER_BUFFER_SIZE 8192
 typedef struct json_dumper {
-    FILE   *output_file;    /**< Output file, must be set. */
+    FILE   *output_file;    /**< Output file, must be set. Output is buffered,
+                                 see json_dumper_flush(). */
 #define JSON_DUMPER_FLAGS_PRETTY_PRINT  (1 << 0)    /* Enable pretty printing. */
 #define JSON_DUMPER_DOT_TO_UNDERSCORE   (1 << 1)    /* Convert dots to underscores in keys */
     int     flags;
@@ -60,6 +63,8 @@ typedef struct json_dumper {
     gint    base64_state;
     gint    base64_save;
     guint8  state[JSON_DUMPER_MAX_DEPTH];
+    size_t  buffer_len;
+    char    buffer[JSON_DUMPER_BUFFER_SIZE];
 } json_dumper;
 
 WS_DLL_PUBLIC void
@@ -107,6 +112,16 @@ json_dumper_end_base64(json_dumper *dumper);
 WS_DLL_PUBLIC void
 json_dumper_write_base64(json_dumper *dumper, const guchar *data, size_t len);
 
+/**
+ * Writes out anything that is still buffered.  This is done by
+ * json_dumper_finish(); otherwise, output is only written when the buffer
+ * is full, so a caller that writes to output_file itself, or that wants
+ * a partial document to be seen (one element of a long array, say), must
+ * call this first.
+ */
+WS_DLL_PUBLIC void
+json_dumper_flush(json_dumper *dumper);
+
 /**
  * Finishes dumping data. Returns TRUE if everything is okay and FALSE if
  * something went wrong (open/close mismatch, missing values, etc.).
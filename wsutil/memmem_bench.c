@@ -0,0 +1,243 @@
+/* memmem_bench.c
+ * Times ws_memmem() against a byte-at-a-time search on packet payloads
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Usage: memmem_bench [iterations] [file ...]
+ *
+ * Searches a few corpora of 1460-byte payloads, each for a few needles,
+ * with ws_memmem() and with the loop epan_memmem() used to have, and
+ * prints the throughput of both.  The built-in corpora are HTTP text,
+ * random bytes as in encrypted traffic, and mostly zero bytes as in
+ * padded or sparse data; the contents of any files given (a capture
+ * file, say) are searched as another corpus.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/ws_memmem.h>
+
+#define DEFAULT_ITERATIONS	200
+#define PAYLOAD_LEN		1460
+#define CORPUS_LEN		(1024 * 1024)
+
+typedef struct {
+	const char	*name;
+	const guint8	*data;
+	gsize		len;
+} needle_t;
+
+#define NEEDLE(name, s)	{ name, (const guint8 *)s, sizeof s - 1 }
+
+static const needle_t needles[] = {
+	NEEDLE("CRLF CRLF", "\r\n\r\n"),
+	NEEDLE("Content-Type", "Content-Type: application/json"),
+	NEEDLE("HTTP/1.1 404", "HTTP/1.1 404"),
+	NEEDLE("TLS header", "\x16\x03\x03\x00"),
+	NEEDLE("00 01", "\x00\x01"),
+};
+
+static const char *http_text[] = {
+	"GET /index.html HTTP/1.1\r\nHost: www.example.com\r\n"
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:85.0) Gecko/20100101 Firefox/85.0\r\n"
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+	"Accept-Language: en-US,en;q=0.5\r\nAccept-Encoding: gzip, deflate\r\n"
+	"Connection: keep-alive\r\n\r\n",
+	"HTTP/1.1 200 OK\r\nDate: Mon, 01 Feb 2021 12:00:00 GMT\r\nServer: Apache\r\n"
+	"Content-Type: text/html; charset=UTF-8\r\nContent-Length: 1256\r\n\r\n",
+	"<!DOCTYPE html>\n<html>\n<head>\n<title>Example Domain</title>\n"
+	"<meta charset=\"utf-8\" />\n<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\" />\n"
+	"</head>\n<body>\n<div>\n<h1>Example Domain</h1>\n"
+	"<p>This domain is for use in illustrative examples in documents. You may use this\n"
+	"domain in literature without prior coordination or asking for permission.</p>\n"
+	"<p><a href=\"https://www.iana.org/domains/example\">More information...</a></p>\n"
+	"</div>\n</body>\n</html>\n",
+};
+
+/* The search epan_memmem() used to do. */
+static const guint8 *
+bytewise_memmem(const guint8 *haystack, gsize haystack_len,
+		const guint8 *needle, gsize needle_len)
+{
+	const guint8 *begin;
+	const guint8 *const last_possible = haystack + haystack_len - needle_len;
+
+	if (needle_len > haystack_len)
+		return NULL;
+
+	for (begin = haystack; begin <= last_possible; ++begin) {
+		if (begin[0] == needle[0] &&
+		    !memcmp(&begin[1], needle + 1, needle_len - 1))
+			return begin;
+	}
+	return NULL;
+}
+
+static guint32
+xorshift32(guint32 *state)
+{
+	guint32 x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static guint8 *
+make_http_corpus(void)
+{
+	guint8	*corpus = (guint8 *)g_malloc(CORPUS_LEN);
+	gsize	pos = 0, len;
+	guint	i = 0;
+
+	while (pos < CORPUS_LEN) {
+		len = MIN(strlen(http_text[i]), CORPUS_LEN - pos);
+		memcpy(corpus + pos, http_text[i], len);
+		pos += len;
+		i = (i + 1) % G_N_ELEMENTS(http_text);
+	}
+	return corpus;
+}
+
+static guint8 *
+make_random_corpus(void)
+{
+	guint8	*corpus = (guint8 *)g_malloc(CORPUS_LEN);
+	guint32	state = 2463534242U;
+	gsize	i;
+
+	for (i = 0; i < CORPUS_LEN; i++)
+		corpus[i] = (guint8)xorshift32(&state);
+	return corpus;
+}
+
+static guint8 *
+make_sparse_corpus(void)
+{
+	guint8	*corpus = (guint8 *)g_malloc0(CORPUS_LEN);
+	guint32	state = 88675123U;
+	gsize	i;
+
+	for (i = 0; i < CORPUS_LEN; i++) {
+		if (xorshift32(&state) % 16 == 0)
+			corpus[i] = (guint8)xorshift32(&state);
+	}
+	return corpus;
+}
+
+static double
+time_search(const guint8 *corpus, gsize corpus_len, const needle_t *needle,
+		long iterations, gboolean bytewise, long *hits)
+{
+	gint64	start, elapsed;
+	gsize	pos, len;
+	long	n;
+
+	*hits = 0;
+	start = g_get_monotonic_time();
+	for (n = 0; n < iterations; n++) {
+		for (pos = 0; pos < corpus_len; pos += PAYLOAD_LEN) {
+			len = MIN(PAYLOAD_LEN, corpus_len - pos);
+			if (bytewise ?
+			    bytewise_memmem(corpus + pos, len, needle->data, needle->len) != NULL :
+			    ws_memmem(corpus + pos, len, needle->data, needle->len) != NULL)
+				(*hits)++;
+		}
+	}
+	elapsed = g_get_monotonic_time() - start;
+
+	/* MB/s */
+	return elapsed ? (double)corpus_len * (double)iterations / (double)elapsed : 0.0;
+}
+
+static void
+bench_corpus(const char *name, const guint8 *corpus, gsize corpus_len, long iterations)
+{
+	double	bytewise_rate, rate;
+	long	bytewise_hits, hits;
+	guint	i;
+
+	printf("%s (%" G_GSIZE_FORMAT " bytes)\n", name, corpus_len);
+	for (i = 0; i < G_N_ELEMENTS(needles); i++) {
+		bytewise_rate = time_search(corpus, corpus_len, &needles[i],
+				iterations, TRUE, &bytewise_hits);
+		rate = time_search(corpus, corpus_len, &needles[i],
+				iterations, FALSE, &hits);
+		printf("  %-14s %9.1f MB/s  %9.1f MB/s  %5.1fx%s\n", needles[i].name,
+			bytewise_rate, rate, bytewise_rate ? rate / bytewise_rate : 0.0,
+			hits == bytewise_hits ? "" : "  (results differ!)");
+	}
+	printf("\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	long	iterations = DEFAULT_ITERATIONS;
+	guint8	*corpus;
+	gchar	*contents;
+	gsize	length;
+	GError	*err = NULL;
+	int	i;
+
+	if (argc > 1) {
+		iterations = strtol(argv[1], NULL, 10);
+		if (iterations <= 0) {
+			fprintf(stderr, "Usage: memmem_bench [iterations] [file ...]\n");
+			return 1;
+		}
+	}
+
+	printf("%ld iterations, %d-byte payloads; byte-at-a-time, ws_memmem\n\n",
+		iterations, PAYLOAD_LEN);
+
+	corpus = make_http_corpus();
+	bench_corpus("HTTP text", corpus, CORPUS_LEN, iterations);
+	g_free(corpus);
+
+	corpus = make_random_corpus();
+	bench_corpus("random bytes", corpus, CORPUS_LEN, iterations);
+	g_free(corpus);
+
+	corpus = make_sparse_corpus();
+	bench_corpus("mostly zero bytes", corpus, CORPUS_LEN, iterations);
+	g_free(corpus);
+
+	for (i = 2; i < argc; i++) {
+		if (!g_file_get_contents(argv[i], &contents, &length, &err)) {
+			fprintf(stderr, "memmem_bench: %s\n", err->message);
+			g_clear_error(&err);
+			continue;
+		}
+		bench_corpus(argv[i], (const guint8 *)contents, length, iterations);
+		g_free(contents);
+	}
+
+	return 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
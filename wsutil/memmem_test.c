@@ -0,0 +1,179 @@
+/* memmem_test.c
+ * Checks ws_memmem() against a byte-at-a-time search
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/ws_memmem.h>
+
+/* Longer than a few SIMD blocks, so that a needle can straddle them. */
+#define MAX_HAYSTACK_LEN	200
+#define MAX_NEEDLE_LEN		40
+
+static const guint8 *
+naive_memmem(const guint8 *haystack, size_t haystacklen,
+		const guint8 *needle, size_t needlelen)
+{
+	size_t i;
+
+	if (needlelen > haystacklen)
+		return NULL;
+	for (i = 0; i + needlelen <= haystacklen; i++) {
+		if (memcmp(haystack + i, needle, needlelen) == 0)
+			return haystack + i;
+	}
+	return NULL;
+}
+
+/*
+ * The haystack is copied to a buffer of exactly its size, so that reading
+ * past its end is caught by a memory checker.
+ */
+static void
+check_memmem(const guint8 *haystack, size_t haystacklen,
+		const guint8 *needle, size_t needlelen)
+{
+	guint8		*copy;
+	const guint8	*found, *expected;
+
+	copy = (guint8 *)g_malloc(haystacklen ? haystacklen : 1);
+	memcpy(copy, haystack, haystacklen);
+	found = ws_memmem(copy, haystacklen, needle, needlelen);
+	expected = naive_memmem(copy, haystacklen, needle, needlelen);
+	if (found != expected) {
+		g_test_message("haystack length %zu, needle length %zu: found at %td, expected at %td",
+				haystacklen, needlelen,
+				found ? found - copy : -1,
+				expected ? expected - copy : -1);
+	}
+	g_assert_true(found == expected);
+	g_free(copy);
+}
+
+static void
+memmem_test_empty_needle(void)
+{
+	static const guint8 haystack[] = "abc";
+	size_t len;
+
+	/* An empty needle is found at the start of any haystack, even an
+	 * empty one. */
+	for (len = 0; len < sizeof haystack; len++) {
+		g_assert_true(ws_memmem(haystack, len, (const guint8 *)"", 0) == haystack);
+	}
+}
+
+static void
+memmem_test_too_long(void)
+{
+	static const guint8 haystack[] = "abcd";
+
+	g_assert_null(ws_memmem(haystack, 4, (const guint8 *)"abcde", 5));
+	g_assert_null(ws_memmem(haystack, 0, (const guint8 *)"a", 1));
+	g_assert_true(ws_memmem(haystack, 4, (const guint8 *)"abcd", 4) == haystack);
+}
+
+/* Needles at the start and at the end of haystacks of every length. */
+static void
+memmem_test_edges(void)
+{
+	guint8	haystack[MAX_HAYSTACK_LEN];
+	guint8	needle[MAX_NEEDLE_LEN];
+	size_t	haystacklen, needlelen, i;
+
+	for (i = 0; i < MAX_NEEDLE_LEN; i++)
+		needle[i] = (guint8)('A' + i);
+
+	for (haystacklen = 1; haystacklen <= MAX_HAYSTACK_LEN; haystacklen++) {
+		for (needlelen = 1; needlelen <= MAX_NEEDLE_LEN && needlelen <= haystacklen; needlelen++) {
+			memset(haystack, 'x', haystacklen);
+			memcpy(haystack, needle, needlelen);
+			check_memmem(haystack, haystacklen, needle, needlelen);
+
+			memset(haystack, 'x', haystacklen);
+			memcpy(haystack + haystacklen - needlelen, needle, needlelen);
+			check_memmem(haystack, haystacklen, needle, needlelen);
+
+			/* Only the last byte of the needle is missing. */
+			haystack[haystacklen - 1] = 'x';
+			check_memmem(haystack, haystacklen, needle, needlelen);
+		}
+	}
+}
+
+/* Needles at every position, and partial matches before them. */
+static void
+memmem_test_positions(void)
+{
+	guint8	haystack[MAX_HAYSTACK_LEN];
+	size_t	needlelen, pos;
+	static const guint8 needle[] = "needle in the haystack";
+
+	for (needlelen = 1; needlelen < sizeof needle; needlelen++) {
+		for (pos = 0; pos + needlelen <= MAX_HAYSTACK_LEN; pos++) {
+			memset(haystack, 'n', MAX_HAYSTACK_LEN);
+			memcpy(haystack + pos, needle, needlelen);
+			check_memmem(haystack, MAX_HAYSTACK_LEN, needle, needlelen);
+			check_memmem(haystack, pos + needlelen, needle, needlelen);
+			if (pos > 0)
+				check_memmem(haystack + 1, pos + needlelen - 1, needle, needlelen);
+		}
+	}
+}
+
+static void
+memmem_test_random(void)
+{
+	guint8	haystack[MAX_HAYSTACK_LEN];
+	guint8	needle[MAX_NEEDLE_LEN];
+	size_t	haystacklen, needlelen, i;
+	int	n;
+
+	/* Few distinct bytes, so that there are many partial matches. */
+	for (n = 0; n < 100000; n++) {
+		haystacklen = g_test_rand_int_range(0, MAX_HAYSTACK_LEN + 1);
+		needlelen = g_test_rand_int_range(0, MAX_NEEDLE_LEN + 1);
+		for (i = 0; i < haystacklen; i++)
+			haystack[i] = (guint8)g_test_rand_int_range(0, 3);
+		for (i = 0; i < needlelen; i++)
+			needle[i] = (guint8)g_test_rand_int_range(0, 3);
+		check_memmem(haystack, haystacklen, needle, needlelen);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/ws_memmem/empty_needle",	memmem_test_empty_needle);
+	g_test_add_func("/ws_memmem/too_long",		memmem_test_too_long);
+	g_test_add_func("/ws_memmem/edges",		memmem_test_edges);
+	g_test_add_func("/ws_memmem/positions",		memmem_test_positions);
+	g_test_add_func("/ws_memmem/random",		memmem_test_random);
+
+	return g_test_run();
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -89,7 +89,7 @@ ws_cpuid(guint32 *CPUInfo _U_, int selector _U_)
 }
 #endif
 
-static int
+static inline int
 ws_cpuid_sse42(void)
 {
 	guint32 CPUInfo[4];
@@ -100,3 +100,39 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+static inline int
+ws_cpuid_avx2(void)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+	guint32 CPUInfo[4];
+	guint32 xcr0_lo, xcr0_hi;
+
+	if (!ws_cpuid(CPUInfo, 0))
+		return 0;
+	if (CPUInfo[0] < 7)
+		return 0;
+
+	/* in ECX bit 27 (OSXSAVE) and bit 28 (AVX) toggled on */
+	ws_cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & (3 << 27)) != (3 << 27))
+		return 0;
+
+	/* the OS saves the XMM and YMM registers */
+	__asm__ __volatile__("xgetbv"
+						: "=a" (xcr0_lo),
+							"=d" (xcr0_hi)
+						: "c" (0));
+	(void)xcr0_hi;
+	if ((xcr0_lo & 6) != 6)
+		return 0;
+
+	/* in EBX of leaf 7 bit 5 toggled on */
+	ws_cpuid(CPUInfo, 7);
+	return (CPUInfo[1] & (1 << 5));
+#else
+	/* No way to check that the OS saves the YMM registers. */
+	(void)ws_cpuid;
+	return 0;
+#endif
+}
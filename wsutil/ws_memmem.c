@@ -0,0 +1,130 @@
+/* ws_memmem.c
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+#include "ws_symbol_export.h"
+#include "ws_memmem.h"
+#include "ws_memmem_int.h"
+
+/*
+ * SSE2 is part of x86-64, so it needs no flag and no check at run time;
+ * on 32-bit x86 it is used only if the compiler was told it can be.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WS_MEMMEM_SSE2
+#include <emmintrin.h>
+#include "bits_ctz.h"
+#endif
+
+/*
+ * The whole needle is compared only where its first and its last bytes
+ * are in the right places; memchr() is usually vectorized already, so
+ * the search for the first byte is fast even here.
+ */
+const guint8 *
+ws_memmem_portable(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen)
+{
+    const guint8 *p = haystack;
+    const guint8 *last_possible;
+    guint8 first, last;
+
+    if (needlelen == 0)
+        return haystack;
+    if (needlelen > haystacklen)
+        return NULL;
+
+    first = needle[0];
+    last = needle[needlelen - 1];
+    last_possible = haystack + haystacklen - needlelen;
+
+    while (p <= last_possible) {
+        p = (const guint8 *)memchr(p, first, last_possible - p + 1);
+        if (p == NULL)
+            return NULL;
+        if (p[needlelen - 1] == last &&
+                memcmp(p + 1, needle + 1, needlelen - 1) == 0)
+            return p;
+        p++;
+    }
+
+    return NULL;
+}
+
+#ifdef WS_MEMMEM_SSE2
+static const guint8 *
+ws_memmem_sse2(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen)
+{
+    const __m128i first = _mm_set1_epi8((char)needle[0]);
+    const __m128i last = _mm_set1_epi8((char)needle[needlelen - 1]);
+    size_t i;
+
+    /* Each block holds 16 possible starts of the needle. */
+    for (i = 0; i + needlelen - 1 + 16 <= haystacklen; i += 16) {
+        const __m128i block_first = _mm_loadu_si128((const __m128i *)(const void *)(haystack + i));
+        const __m128i block_last = _mm_loadu_si128((const __m128i *)(const void *)(haystack + i + needlelen - 1));
+        guint32 mask = (guint32)_mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(first, block_first),
+                    _mm_cmpeq_epi8(last, block_last)));
+
+        while (mask != 0) {
+            size_t pos = i + ws_ctz(mask);
+
+            if (memcmp(haystack + pos + 1, needle + 1, needlelen - 2) == 0)
+                return haystack + pos;
+            mask &= mask - 1;
+        }
+    }
+
+    return ws_memmem_portable(haystack + i, haystacklen - i, needle, needlelen);
+}
+#endif
+
+#ifdef HAVE_AVX2
+/* Checked on first use; a race only means that it's checked twice. */
+static int use_avx2 = -1;
+#endif
+
+const guint8 *
+ws_memmem(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen)
+{
+    if (needlelen == 1)
+        return (const guint8 *)memchr(haystack, needle[0], haystacklen);
+    if (needlelen == 0 || needlelen > haystacklen)
+        return ws_memmem_portable(haystack, haystacklen, needle, needlelen);
+
+#ifdef HAVE_AVX2
+    if (use_avx2 < 0)
+        use_avx2 = ws_memmem_avx2_supported() ? 1 : 0;
+    if (use_avx2 && haystacklen - needlelen >= 32)
+        return ws_memmem_avx2(haystack, haystacklen, needle, needlelen);
+#endif
+#ifdef WS_MEMMEM_SSE2
+    if (haystacklen - needlelen >= 16)
+        return ws_memmem_sse2(haystack, haystacklen, needle, needlelen);
+#endif
+
+    return ws_memmem_portable(haystack, haystacklen, needle, needlelen);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,28 @@
+/* ws_memmem.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_MEMMEM_H__
+#define __WS_MEMMEM_H__
+
+#include <glib.h>
+
+#include "ws_symbol_export.h"
+
+/** Find the first occurrence of a needle in a haystack.
+ *
+ * Uses SSE2 or, if the CPU has it, AVX2 to look for the first and the
+ * last byte of the needle in a whole block of the haystack at a time,
+ * and compares the rest of the needle only where both of them match.
+ *
+ * @return A pointer to the first occurrence, or NULL if there is none.
+ * An empty needle matches at the start of the haystack.
+ */
+WS_DLL_PUBLIC const guint8 *ws_memmem(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen);
+
+#endif /* __WS_MEMMEM_H__ */
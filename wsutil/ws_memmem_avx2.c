@@ -0,0 +1,77 @@
+/* ws_memmem_avx2.c
+ * Substring search with AVX2 intrinsics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <string.h>
+
+#include <glib.h>
+#include <immintrin.h>
+#include "ws_cpuid.h"
+#include "bits_ctz.h"
+#include "ws_memmem.h"
+#include "ws_memmem_int.h"
+
+gboolean
+ws_memmem_avx2_supported(void)
+{
+    return ws_cpuid_avx2() != 0;
+}
+
+/*
+ * Compares the first byte of the needle with 32 bytes of the haystack,
+ * and the last byte of the needle with the 32 bytes needlelen - 1 further
+ * on; only where both match is the rest of the needle compared.
+ *
+ * The caller makes sure that 2 <= needlelen and that there is at least
+ * one whole block.
+ */
+const guint8 *
+ws_memmem_avx2(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen)
+{
+    const __m256i first = _mm256_set1_epi8((char)needle[0]);
+    const __m256i last = _mm256_set1_epi8((char)needle[needlelen - 1]);
+    size_t i;
+
+    for (i = 0; i + needlelen - 1 + 32 <= haystacklen; i += 32) {
+        const __m256i block_first = _mm256_loadu_si256((const __m256i *)(const void *)(haystack + i));
+        const __m256i block_last = _mm256_loadu_si256((const __m256i *)(const void *)(haystack + i + needlelen - 1));
+        guint32 mask = (guint32)_mm256_movemask_epi8(_mm256_and_si256(
+                    _mm256_cmpeq_epi8(first, block_first),
+                    _mm256_cmpeq_epi8(last, block_last)));
+
+        while (mask != 0) {
+            size_t pos = i + ws_ctz(mask);
+
+            if (memcmp(haystack + pos + 1, needle + 1, needlelen - 2) == 0)
+                return haystack + pos;
+            mask &= mask - 1;
+        }
+    }
+
+    return ws_memmem_portable(haystack + i, haystacklen - i, needle, needlelen);
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,20 @@
+/* ws_memmem_int.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_MEMMEM_INT_H__
+#define __WS_MEMMEM_INT_H__
+
+const guint8 *ws_memmem_portable(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen);
+
+#ifdef HAVE_AVX2
+gboolean ws_memmem_avx2_supported(void);
+const guint8 *ws_memmem_avx2(const guint8 *haystack, size_t haystacklen, const guint8 *needle, size_t needlelen);
+#endif
+
+#endif /* __WS_MEMMEM_INT_H__ */